@@ -262,6 +262,13 @@ class VariantQueryProcessor {
      */
     void binary_deserialize(Variant& variant, const VariantQueryConfig& query_config,
         const std::vector<uint8_t>& buffer, uint64_t& offset) const;
+    /*
+     * Create Variant from a buffer produced by Variant::compact_binary_serialize()
+     * Fields already present in variant are re-used, so deserializing a stream into the same Variant object
+     * does not allocate once the field objects exist
+     */
+    void compact_binary_deserialize(Variant& variant, const VariantQueryConfig& query_config,
+        const std::vector<uint8_t>& buffer, uint64_t& offset) const;
     /*
      * Function that, given an enum value from KnownVariantFieldsEnum
      * returns the schema idx for the given array 
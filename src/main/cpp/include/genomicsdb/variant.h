@@ -458,6 +458,12 @@ class Variant
      * Binary serialize into buffer
      */
     void binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset) const;
+    /*
+     * Compact, versioned alternative to binary_serialize() used for transferring Variants between processes
+     * Integers are varints, valid calls and present fields are bitmaps and call field data is grouped into
+     * one length prefixed section per queried field. Deserialize with VariantQueryProcessor::compact_binary_deserialize()
+     */
+    void compact_binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset, const VariantQueryConfig& query_config) const;
     /*
      * Deserialize header of Variant (column interval, num calls etc)
      */
@@ -807,6 +813,32 @@ void print_variants(const std::vector<Variant>& variants,
                     const std::vector<uint64_t>& queried_column_positions = std::vector<uint64_t>(),
                     bool output_directly=false);
 
+/*
+ * Prints variants in the default JSON format one at a time, so that callers which produce
+ * variants incrementally (for example, the streaming MPI gather) need not hold the full result set.
+ * Output is identical to print_variants() with the default output format
+ */
+class VariantsJSONStreamPrinter
+{
+  public:
+    VariantsJSONStreamPrinter(const VariantQueryConfig& query_config, const VidMapper* id_mapper=0)
+      : m_query_config(query_config), m_id_mapper(id_mapper), m_num_printed_variants(0ull)
+    { }
+    void print_header(std::ostream& fptr) const;
+    void print(std::ostream& fptr, const Variant& variant);
+    void print_trailer(std::ostream& fptr) const;
+    uint64_t get_num_printed_variants() const { return m_num_printed_variants; }
+  private:
+    const VariantQueryConfig& m_query_config;
+    const VidMapper* m_id_mapper;
+    uint64_t m_num_printed_variants;
+};
+
+#define COMPACT_VARIANT_SERIALIZATION_VERSION 1u
+//Per call flags in the compact format
+#define COMPACT_CALL_FLAG_INITIALIZED 1u
+#define COMPACT_CALL_FLAG_CONTAINS_DELETION 2u
+#define COMPACT_CALL_FLAG_REFERENCE_BLOCK 4u
 /*
  * Copies field from src to dst. Optimized to reduce #re-allocations
  * Handles the case where src and/or dst may be null
@@ -24,6 +24,7 @@
 #define VARIANT_FIELD_DATA_H
 
 #include <memory>
+#include <type_traits>
 #include "headers.h"
 #include "gt_common.h"
 #include "variant_cell.h"
@@ -88,6 +89,89 @@ bool is_tiledb_missing_value(const T value);
 #define RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, add_size) \
       if(offset + add_size > buffer.size()) \
         buffer.resize(offset + add_size + 1024u);
+
+/*
+ * Helpers for the compact wire format (see Variant::compact_binary_serialize()) - integers are stored
+ * as LEB128 varints, signed values are zigzag encoded first so that small negative values stay short
+ */
+#define COMPACT_SERIALIZATION_MAX_VARINT_LENGTH 10u
+//Caller must ensure buffer has space for COMPACT_SERIALIZATION_MAX_VARINT_LENGTH bytes
+inline void compact_write_varint(uint8_t* buffer, uint64_t& offset, uint64_t value)
+{
+  while(value >= 0x80u)
+  {
+    buffer[offset++] = static_cast<uint8_t>(value | 0x80u);
+    value >>= 7;
+  }
+  buffer[offset++] = static_cast<uint8_t>(value);
+}
+inline void compact_serialize_varint(std::vector<uint8_t>& buffer, uint64_t& offset, const uint64_t value)
+{
+  RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, COMPACT_SERIALIZATION_MAX_VARINT_LENGTH);
+  compact_write_varint(&(buffer[0]), offset, value);
+}
+inline uint64_t compact_deserialize_varint(const uint8_t* buffer, uint64_t& offset)
+{
+  uint64_t value = 0ull;
+  for(auto shift=0u;shift<64u;shift+=7u)
+  {
+    auto byte = buffer[offset++];
+    value |= (static_cast<uint64_t>(byte & 0x7fu) << shift);
+    if(!(byte & 0x80u))
+      break;
+  }
+  return value;
+}
+inline uint64_t zigzag_encode(const int64_t value)
+{ return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+inline int64_t zigzag_decode(const uint64_t value)
+{ return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1u); }
+
+//Elements of integral types wider than a byte are stored as varints, everything else as raw bytes
+template<class DataType, bool use_varint=(std::is_integral<DataType>::value && (sizeof(DataType) > 1u))>
+class CompactElementCodec
+{
+  public:
+    static void serialize(std::vector<uint8_t>& buffer, uint64_t& offset, const DataType* data, const size_t num_elements)
+    {
+      uint64_t data_size = num_elements*sizeof(DataType);
+      RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, data_size);
+      if(data_size)
+        memcpy(&(buffer[offset]), data, data_size);
+      offset += data_size;
+    }
+    static void deserialize(const uint8_t* buffer, uint64_t& offset, DataType* data, const size_t num_elements)
+    {
+      uint64_t data_size = num_elements*sizeof(DataType);
+      if(data_size)
+        memcpy(data, buffer+offset, data_size);
+      offset += data_size;
+    }
+};
+
+template<class DataType>
+class CompactElementCodec<DataType, true>
+{
+  public:
+    static void serialize(std::vector<uint8_t>& buffer, uint64_t& offset, const DataType* data, const size_t num_elements)
+    {
+      uint64_t max_size = num_elements*COMPACT_SERIALIZATION_MAX_VARINT_LENGTH;
+      RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, max_size);
+      auto buffer_ptr = &(buffer[0]);
+      for(auto i=0ull;i<num_elements;++i)
+        compact_write_varint(buffer_ptr, offset, std::is_signed<DataType>::value
+            ? zigzag_encode(static_cast<int64_t>(data[i])) : static_cast<uint64_t>(data[i]));
+    }
+    static void deserialize(const uint8_t* buffer, uint64_t& offset, DataType* data, const size_t num_elements)
+    {
+      for(auto i=0ull;i<num_elements;++i)
+      {
+        auto value = compact_deserialize_varint(buffer, offset);
+        data[i] = static_cast<DataType>(std::is_signed<DataType>::value ? zigzag_decode(value) : value);
+      }
+    }
+};
+
 /*
  * Base class for variant field data - not sure whether I will add any functionality here
  */
@@ -107,6 +191,9 @@ class VariantFieldBase
     virtual void print_Cotton_JSON(std::ostream& fptr) const { ; }
     virtual void binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset) const = 0;
     virtual void binary_deserialize(const char* buffer, uint64_t& offset, unsigned length_descriptor, unsigned num_elements) = 0;
+    /* Compact wire format - see Variant::compact_binary_serialize() */
+    virtual void compact_binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset) const = 0;
+    virtual void compact_binary_deserialize(const uint8_t* buffer, uint64_t& offset, unsigned length_descriptor, unsigned num_elements) = 0;
     /* Get pointer(s) to data with number of elements */
     virtual std::type_index get_C_pointers(unsigned& size, void** ptr, bool& allocated) = 0;
     /* Get raw pointer(s) to data */
@@ -182,6 +269,14 @@ class VariantFieldData : public VariantFieldBase
       *(reinterpret_cast<DataType*>(&(buffer[offset]))) = m_data;
       offset += sizeof(DataType);
     }
+    virtual void compact_binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset) const
+    {
+      CompactElementCodec<DataType>::serialize(buffer, offset, &m_data, 1u);
+    }
+    virtual void compact_binary_deserialize(const uint8_t* buffer, uint64_t& offset, unsigned length_descriptor, unsigned num_elements)
+    {
+      CompactElementCodec<DataType>::deserialize(buffer, offset, &m_data, 1u);
+    }
     virtual DataType& get() { return m_data; }
     virtual const DataType& get() const { return m_data; }
     virtual std::type_index get_C_pointers(unsigned& size, void** ptr, bool& allocated)
@@ -276,6 +371,17 @@ class VariantFieldData<std::string> : public VariantFieldBase
       memcpy(&(buffer[offset]), &(m_data[0]), str_length);
       offset += str_length;
     }
+    virtual void compact_binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset) const
+    {
+      compact_serialize_varint(buffer, offset, m_data.length());
+      CompactElementCodec<char>::serialize(buffer, offset, m_data.c_str(), m_data.length());
+    }
+    virtual void compact_binary_deserialize(const uint8_t* buffer, uint64_t& offset, unsigned length_descriptor, unsigned num_elements)
+    {
+      auto str_length = compact_deserialize_varint(buffer, offset);
+      m_data.assign(reinterpret_cast<const char*>(buffer+offset), str_length);
+      offset += str_length;
+    }
     virtual std::type_index get_C_pointers(unsigned& size, void** ptr, bool& allocated)
     {
       size = 1u;
@@ -423,6 +529,21 @@ class VariantFieldPrimitiveVectorData : public VariantFieldBase
       memcpy(&(buffer[offset]), &(m_data[0]), data_length);
       offset += data_length;
     }
+    //#elements is stored only for variable length fields
+    virtual void compact_binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset) const
+    {
+      if(m_length_descriptor != BCF_VL_FIXED)
+        compact_serialize_varint(buffer, offset, m_data.size());
+      CompactElementCodec<DataType>::serialize(buffer, offset, m_data.size() ? &(m_data[0]) : 0, m_data.size());
+    }
+    virtual void compact_binary_deserialize(const uint8_t* buffer, uint64_t& offset, unsigned length_descriptor, unsigned num_elements)
+    {
+      m_length_descriptor = length_descriptor;
+      if(length_descriptor != BCF_VL_FIXED)
+        num_elements = compact_deserialize_varint(buffer, offset);
+      m_data.resize(num_elements);
+      CompactElementCodec<DataType>::deserialize(buffer, offset, m_data.size() ? &(m_data[0]) : 0, num_elements);
+    }
     virtual std::type_index get_C_pointers(unsigned& size, void** ptr, bool& allocated)
     {
       size = m_data.size();
@@ -493,19 +614,29 @@ class VariantFieldALTData : public VariantFieldBase
         ptr = static_cast<const char*>(base_ptr + sizeof(int));
         offset += sizeof(int);
       }
-      //Create copy for use in strtok
-      char* tmp = strndup(ptr, num_elements);
-      assert(strnlen(tmp, num_elements+1) == num_elements); //last element should be 0
-      //Tokenize
-      char* saveptr = 0;
-      char* argptr = tmp;
-      m_data.clear();
-      while(auto curr_token = strtok_r(argptr, TILEDB_ALT_ALLELE_SEPARATOR, &saveptr))
+      auto length = strnlen(ptr, num_elements);
+      assert(length == num_elements);
+      //Tokenize without a temporary copy - strings already in m_data are re-used to avoid allocations
+      //Empty tokens are skipped (same as strtok)
+      auto num_tokens = 0ull;
+      auto token_begin = ptr;
+      auto end_ptr = ptr + length;
+      while(token_begin < end_ptr)
       {
-        m_data.push_back(curr_token);
-        argptr = 0;
+        auto token_end = static_cast<const char*>(memchr(token_begin, TILEDB_ALT_ALLELE_SEPARATOR[0], end_ptr-token_begin));
+        if(token_end == 0)
+          token_end = end_ptr;
+        if(token_end > token_begin)
+        {
+          if(num_tokens < m_data.size())
+            m_data[num_tokens].assign(token_begin, token_end-token_begin);
+          else
+            m_data.emplace_back(token_begin, token_end-token_begin);
+          ++num_tokens;
+        }
+        token_begin = token_end+1;
       }
-      free(tmp);
+      m_data.resize(num_tokens);
       offset += num_elements*sizeof(char);
     }
     virtual std::vector<std::string>& get() { return m_data; }
@@ -575,6 +706,28 @@ class VariantFieldALTData : public VariantFieldBase
       //string length
       *(reinterpret_cast<int*>(&(buffer[str_length_offset]))) = offset - str_begin_offset;
     }
+    //#alleles followed by length prefixed alleles
+    virtual void compact_binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset) const
+    {
+      compact_serialize_varint(buffer, offset, m_data.size());
+      for(auto& val : m_data)
+      {
+        compact_serialize_varint(buffer, offset, val.length());
+        CompactElementCodec<char>::serialize(buffer, offset, val.c_str(), val.length());
+      }
+    }
+    virtual void compact_binary_deserialize(const uint8_t* buffer, uint64_t& offset, unsigned length_descriptor, unsigned num_elements)
+    {
+      auto num_alleles = compact_deserialize_varint(buffer, offset);
+      //Strings already in m_data are re-used to avoid allocations
+      m_data.resize(num_alleles);
+      for(auto& val : m_data)
+      {
+        auto str_length = compact_deserialize_varint(buffer, offset);
+        val.assign(reinterpret_cast<const char*>(buffer+offset), str_length);
+        offset += str_length;
+      }
+    }
     virtual std::type_index get_C_pointers(unsigned& size, void** ptr, bool& allocated)
     {
       size = m_data.size();
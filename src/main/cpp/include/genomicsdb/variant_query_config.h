@@ -88,6 +88,7 @@ class VariantQueryConfig
       m_query_rows.clear();
       m_query_column_intervals.clear();
       m_array_row_idx_to_query_row_idx.clear();
+      update_compact_serialization_schema_hash();
     }
     /**
      * Function that specifies which attributes to query from each cell
@@ -165,6 +166,7 @@ class VariantQueryConfig
       attribute_info.m_length_descriptor = length_descriptor;
       attribute_info.m_num_elements = num_elements;
       attribute_info.m_VCF_field_combine_operation = VCF_field_combine_operation;
+      update_compact_serialization_schema_hash();
     }
     int get_length_descriptor_for_query_attribute_idx(const unsigned query_idx) const
     {
@@ -186,6 +188,12 @@ class VariantQueryConfig
      */
     void reorder_query_fields();
     unsigned get_first_normal_field_query_idx() const { return m_first_normal_field_query_idx; }
+    /*
+     * Hash of the queried attributes (names, length descriptors) stored in every Variant serialized in the
+     * compact format - data produced with a different query configuration is rejected while deserializing.
+     * Kept up to date by the functions that modify the queried attributes
+     */
+    inline uint32_t get_compact_serialization_schema_hash() const { return m_compact_serialization_schema_hash; }
     //Query idx <--> known fields mapping
     void resize_LUT(unsigned num_known_fields)
     { m_query_idx_known_variant_field_enum_LUT.resize_luts_if_needed(get_num_queried_attributes(), num_known_fields); }
@@ -331,7 +339,10 @@ class VariantQueryConfig
      * @param all_rows if true, invalidates all mappings, else invalidates mapping for rows in m_query_rows only
      */
     void invalidate_array_row_idx_to_query_row_idx_map(bool all_rows);
+    void update_compact_serialization_schema_hash();
     std::vector<VariantQueryFieldInfo> m_query_attributes_info_vec;
+    //See get_compact_serialization_schema_hash()
+    uint32_t m_compact_serialization_schema_hash;
     //Map from query name to index in m_query_attributes_info_vec
     std::unordered_map<std::string, unsigned> m_query_attribute_name_to_query_idx;
     //Flag that tracks whether book-keeping is done
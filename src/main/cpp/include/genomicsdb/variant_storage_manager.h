@@ -41,11 +41,45 @@ class VariantStorageManagerException : public std::exception {
     std::string msg_;
 };
 
+/*
+ * Distinct strings of a dictionary encoded attribute (REF, ALT, ID) - cells of the attribute
+ * store the int code of the string. Codes are dense and never change once assigned
+ */
+class StringDictionary
+{
+  public:
+    StringDictionary() : m_offsets(1u, 0ull), m_num_persisted_strings(0ull) { }
+    //Returns the code of the string, the string is added if seen for the first time
+    int get_or_add_code(const char* str, const size_t length);
+    //Appends a string read from disk - codes follow the order of the calls
+    void append_persisted_string(const char* str, const size_t length);
+    inline size_t size() const { return m_offsets.size()-1u; }
+    inline bool is_valid_code(const int code) const { return code >= 0 && static_cast<size_t>(code) < size(); }
+    inline const char* get_string_ptr(const int code) const { return m_data.data()+m_offsets[code]; }
+    inline size_t get_string_length(const int code) const { return m_offsets[code+1]-m_offsets[code]; }
+    //Strings added since the dictionary was read from/written to disk
+    inline bool is_modified() const { return m_num_persisted_strings != size(); }
+    inline void mark_persisted() { m_num_persisted_strings = size(); }
+  private:
+    //All strings back to back, string i is [m_offsets[i], m_offsets[i+1])
+    std::vector<char> m_data;
+    std::vector<size_t> m_offsets;
+    //Built on the first insertion - dictionaries opened for reading never need it
+    std::unordered_map<std::string, int> m_string_to_code;
+    std::string m_tmp_string;
+    size_t m_num_persisted_strings;
+};
+
 class VariantArrayCellIterator
 {
   public:
+    /*
+     * dictionaries - one entry per queried attribute, non-null entries point to the dictionary
+     * of a dictionary encoded attribute (may be empty if no queried attribute is encoded)
+     */
     VariantArrayCellIterator(TileDB_CTX* tiledb_ctx, const VariantArraySchema& variant_array_schema,
-        const std::string& array_path, const int64_t* range, const std::vector<int>& attribute_ids, const size_t buffer_size);
+        const std::string& array_path, const int64_t* range, const std::vector<int>& attribute_ids, const size_t buffer_size,
+        const std::vector<const StringDictionary*>& dictionaries=std::vector<const StringDictionary*>());
     ~VariantArrayCellIterator()
     {
       if(m_tiledb_array_iterator)
@@ -105,6 +139,8 @@ class VariantArrayCellIterator
     std::vector<const void*> m_buffer_pointers;
     //Buffer sizes
     std::vector<size_t> m_buffer_sizes;
+    //Dictionaries of dictionary encoded queried attributes, indexed by query idx
+    std::vector<const StringDictionary*> m_dictionaries;
 #ifdef DEBUG
     int64_t m_last_row;
     int64_t m_last_column;
@@ -142,6 +178,9 @@ class VariantArrayInfo
           throw VariantStorageManagerException("Error while writing to array "+m_name);
         memset(&(m_buffer_offsets[0]), 0, m_buffer_offsets.size()*sizeof(size_t));
       }
+      //Dictionaries must be on disk before the fragment referring to the new codes is committed
+      if(m_mode == TILEDB_ARRAY_WRITE || m_mode == TILEDB_ARRAY_WRITE_UNSORTED)
+        write_dictionaries_if_modified();
       if(m_tiledb_array)
       {
         if(consolidate_tiledb_array)
@@ -166,7 +205,7 @@ class VariantArrayInfo
     const VariantArraySchema& get_schema() const { return m_schema; }
     const std::string& get_array_name() const { return m_name; }
     void write_cell(const void* ptr);
-    //Read #valid rows from metadata if available, else set from schema (array domain)
+    //Read #valid rows (and the END copy mode) from metadata if available, else set from schema (array domain)
     void read_row_bounds_from_metadata();
     /*
      * Update #valid rows in the metadata
@@ -178,7 +217,23 @@ class VariantArrayInfo
     {
       return (m_max_valid_row_idx_in_array - m_schema.dim_domains()[0].first + 1);
     }
+    /*
+     * Record in the metadata that END copies of interval cells in this array carry only
+     * co-ordinates and END (the begin column) - all other attributes are null
+     */
+    void enable_lightweight_end_copies(const std::string& metadata_filename);
+    inline bool has_lightweight_end_copies() const { return m_lightweight_end_copies; }
+    /*
+     * Record in the metadata that cells of the given variable length string attributes store
+     * int codes into per-array dictionaries instead of the strings
+     */
+    void enable_dictionary_encoding(const std::string& metadata_filename, const std::vector<std::string>& attribute_names);
+    //Dictionary of the attribute with the given schema idx, null if the attribute is not dictionary encoded
+    const StringDictionary* get_dictionary(const int schema_idx) const;
   private:
+    void read_dictionaries();
+    void write_dictionaries_if_modified();
+    std::string get_dictionaries_filename() const;
     int m_idx;
     int m_mode;
     std::string m_name;
@@ -196,6 +251,13 @@ class VariantArrayInfo
     //Max valid row idx in array
     int64_t m_max_valid_row_idx_in_array;
     bool m_metadata_contains_max_valid_row_idx_in_array;
+    //END copies carry only co-ordinates and END
+    bool m_lightweight_end_copies;
+    //Schema idxs of dictionary encoded attributes and their dictionaries
+    std::vector<int> m_dictionary_encoded_attribute_idxs;
+    std::vector<StringDictionary> m_dictionaries;
+    //Codes written for the current cell, one per dictionary encoded attribute
+    std::vector<int> m_encoded_values;
 #ifdef DEBUG
     int64_t m_last_row;
     int64_t m_last_column;
@@ -252,6 +314,17 @@ class VariantStorageManager
      * Update row bounds in the metadata
      */
     void update_row_bounds_in_array(const int ad, const int64_t lb_row_idx, const int64_t max_valid_row_idx_in_array);
+    /*
+     * END copies of interval cells carry only co-ordinates and END - the payload must be
+     * fetched from the begin cell
+     */
+    void enable_lightweight_end_copies(const int ad);
+    bool has_lightweight_end_copies(const int ad) const;
+    /*
+     * Cells of the given string attributes store codes into per-array dictionaries - decoded
+     * by the cell iterator, so readers see the strings
+     */
+    void enable_dictionary_encoding(const int ad, const std::vector<std::string>& attribute_names);
     /*
      * Return workspace path
      */
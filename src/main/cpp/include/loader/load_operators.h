@@ -54,33 +54,42 @@ class LoadOperatorException : public std::exception {
 class LoaderOperatorBase
 {
   public:
+    /*
+     * If loader_config is not NULL, the parsed configuration is shared and loader_config_file
+     * is not read again
+     */
     LoaderOperatorBase(
       const std::string& loader_config_file,
       const size_t num_callsets,
       const int partition_idx,
-      const bool vid_mapper_file_required = true)
-      : m_column_partition(0, INT64_MAX-1), m_row_partition(0, INT64_MAX-1)
+      const bool vid_mapper_file_required = true,
+      std::shared_ptr<const JSONLoaderConfig> loader_config = nullptr)
+      : m_column_partition(0, INT64_MAX-1), m_row_partition(0, INT64_MAX-1),
+      m_loader_json_config(std::move(loader_config))
     {
       m_crossed_column_partition_begin = false;
       m_first_cell = true;
       m_partition_idx = partition_idx;
-      m_loader_json_config.set_vid_mapper_file_required(
-        vid_mapper_file_required);
 #ifdef DUPLICATE_CELL_AT_END
       m_cell_copies.resize(num_callsets, 0);
       m_last_end_position_for_row.resize(num_callsets, -1ll);
 #endif
       //Parse loader JSON
-      m_loader_json_config.read_from_file(loader_config_file);
+      if(!m_loader_json_config)
+      {
+        auto loader_json_config = std::make_shared<JSONLoaderConfig>(vid_mapper_file_required);
+        loader_json_config->read_from_file(loader_config_file);
+        m_loader_json_config = loader_json_config;
+      }
       //Partitioning information
-      m_row_partition = RowRange(0, m_loader_json_config.get_max_num_rows_in_array()-1);
-      if(m_loader_json_config.is_partitioned_by_row())
+      m_row_partition = RowRange(0, m_loader_json_config->get_max_num_rows_in_array()-1);
+      if(m_loader_json_config->is_partitioned_by_row())
       {
-        m_row_partition = m_loader_json_config.get_row_partition(partition_idx);
-        m_row_partition.second = std::min(m_row_partition.second, static_cast<int64_t>(m_loader_json_config.get_max_num_rows_in_array()-1));
+        m_row_partition = m_loader_json_config->get_row_partition(partition_idx);
+        m_row_partition.second = std::min(m_row_partition.second, static_cast<int64_t>(m_loader_json_config->get_max_num_rows_in_array()-1));
       }
       else
-        m_column_partition = m_loader_json_config.get_column_partition(partition_idx);
+        m_column_partition = m_loader_json_config->get_column_partition(partition_idx);
     }
     virtual ~LoaderOperatorBase() { ; }
     /*
@@ -132,7 +141,7 @@ class LoaderOperatorBase
     //End position of last cell seen for current row
     std::vector<int64_t> m_last_end_position_for_row;
 #endif
-    JSONLoaderConfig m_loader_json_config;
+    std::shared_ptr<const JSONLoaderConfig> m_loader_json_config;
 };
 
 class LoaderArrayWriter : public LoaderOperatorBase
@@ -142,7 +151,8 @@ class LoaderArrayWriter : public LoaderOperatorBase
       const VidMapper* id_mapper,
       const std::string& config_filename,
       int rank,
-      const bool vid_mapper_file_required);
+      const bool vid_mapper_file_required,
+      std::shared_ptr<const JSONLoaderConfig> loader_config=nullptr);
     virtual ~LoaderArrayWriter()
     {
       if(m_schema)
@@ -168,6 +178,13 @@ class LoaderArrayWriter : public LoaderOperatorBase
      * and adds to PQ again
      */
     void write_top_element_to_disk();
+    /*
+     * Null out every attribute after END in an END copy cell - the copy then carries only the
+     * co-ordinates and END (the begin column). Updates the cell size in the buffer
+     */
+    void strip_payload_from_end_copy(uint8_t* copy_ptr) const;
+    //END copies carry only co-ordinates and END - fixed when the array is created
+    bool m_lightweight_end_copies;
     //Mimics behavior of program heap for cell copies - minimizes number of frees/reallocations
     std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> m_memory_manager;
     //For use in priority queue
@@ -195,7 +212,8 @@ class LoaderCombinedGVCFOperator : public LoaderOperatorBase
 {
   public:
     LoaderCombinedGVCFOperator(const VidMapper* id_mapper, const std::string& config_filename, bool handle_spanning_deletions,
-        int partition_idx, const ColumnRange& partition_range);
+        int partition_idx, const ColumnRange& partition_range,
+        std::shared_ptr<const JSONLoaderConfig> loader_config=nullptr);
     virtual ~LoaderCombinedGVCFOperator()
     {
       clear();
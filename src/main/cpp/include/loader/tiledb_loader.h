@@ -89,7 +89,7 @@ class LoaderConverterMessageExchange
     std::vector<int64_t> m_idx_offset_per_division;
 };
 
-class VCF2TileDBLoaderConverterBase : public JSONLoaderConfig
+class VCF2TileDBLoaderConverterBase
 {
   public:
     VCF2TileDBLoaderConverterBase(
@@ -98,15 +98,23 @@ class VCF2TileDBLoaderConverterBase : public JSONLoaderConfig
       const int64_t lb_callset_row_idx=0,
       const int64_t ub_callset_row_idx=INT64_MAX-1,
       bool vidmap_file_required=true);
+    //Shares a loader configuration already parsed by the caller instead of re-reading the file
+    VCF2TileDBLoaderConverterBase(
+      std::shared_ptr<const JSONLoaderConfig> loader_config,
+      int idx,
+      const int64_t lb_callset_row_idx=0,
+      const int64_t ub_callset_row_idx=INT64_MAX-1);
+    inline const std::shared_ptr<const JSONLoaderConfig>& get_loader_config() const { return m_loader_config; }
     inline int64_t get_column_partition_end() const
     {
-      return JSONLoaderConfig::get_column_partition(m_idx).second;
+      return m_loader_config->get_column_partition(m_idx).second;
     }
     inline int64_t get_column_partition_begin() const
     {
-      return JSONLoaderConfig::get_column_partition(m_idx).first;
+      return m_loader_config->get_column_partition(m_idx).first;
     }
-    inline ColumnRange get_column_partition() const { return JSONLoaderConfig::get_column_partition(m_idx); }
+    inline ColumnRange get_column_partition() const { return m_loader_config->get_column_partition(m_idx); }
+    inline RowRange get_row_bounds() const { return RowRange(m_lb_callset_row_idx, m_ub_callset_row_idx); }
     void clear();
   protected:
     void resize_circular_buffers(unsigned num_entries)
@@ -115,8 +123,17 @@ class VCF2TileDBLoaderConverterBase : public JSONLoaderConfig
       m_ping_pong_buffers.resize(num_entries);
     }
     void determine_num_callsets_owned(const VidMapper* vid_mapper, const bool from_loader);
+  private:
+    void initialize_from_loader_config(const int64_t lb_callset_row_idx, const int64_t ub_callset_row_idx);
   protected:
     int m_idx;
+    //Parsed loader JSON - shared with the converter and the loader operators
+    std::shared_ptr<const JSONLoaderConfig> m_loader_config;
+    //Row bounds of the loader JSON narrowed by the bounds passed to the constructor
+    int64_t m_lb_callset_row_idx;
+    int64_t m_ub_callset_row_idx;
+    unsigned m_num_entries_in_circular_buffer;
+    int64_t m_max_size_per_callset;
     //Ping-pong buffers
     //Note that these buffers may remain at size 0, if the ping pong buffers are owned by a different object
     std::vector<std::vector<uint8_t>> m_ping_pong_buffers;
@@ -132,17 +149,30 @@ class VCF2TileDBLoaderConverterBase : public JSONLoaderConfig
 };
 
 #ifdef HTSDIR
+class VCFReaderHandlePool;
+
 class VCF2TileDBConverter : public VCF2TileDBLoaderConverterBase
 {
   public:
     //If vid_mapper==0, build from scratch
+    //If all_column_partitions, file handlers span every column partition of the loader JSON - required by
+    //print_all_partitions_single_pass
     VCF2TileDBConverter(
       const std::string& config_filename,
       int idx,
       VidMapper* vid_mapper=0,
       std::vector<std::vector<uint8_t>>* buffers=0,
       std::vector<LoaderConverterMessageExchange>* exchange_vector=0,
-      bool vid_mapper_file_required=true);
+      bool vid_mapper_file_required=true,
+      bool all_column_partitions=false);
+    //Uses the configuration already parsed by the caller (typically the loader)
+    VCF2TileDBConverter(
+      std::shared_ptr<const JSONLoaderConfig> loader_config,
+      int idx,
+      VidMapper* vid_mapper=0,
+      std::vector<std::vector<uint8_t>>* buffers=0,
+      std::vector<LoaderConverterMessageExchange>* exchange_vector=0,
+      bool all_column_partitions=false);
     //Delete copy constructor
     VCF2TileDBConverter(const VCF2TileDBConverter& other) = delete;
     //Delete move constructor
@@ -178,8 +208,17 @@ class VCF2TileDBConverter : public VCF2TileDBLoaderConverterBase
      * Print all included partitions
      */
     void print_all_partitions(const std::string& results_directory, const std::string& output_type, const int rank);
+    /*
+     * Print every column partition of the loader JSON, reading each file only once
+     * Re-uses the file handlers of the converter - must be constructed with all_column_partitions=true
+     */
+    void print_all_partitions_single_pass(const std::string& results_directory, const std::string& output_type);
   private:
     void clear();
+    void common_constructor_initialization(
+      VidMapper* vid_mapper,
+      std::vector<std::vector<uint8_t>>* buffers,
+      std::vector<LoaderConverterMessageExchange>* exchange_vector);
     void initialize_column_batch_objects();
     void initialize_file2binary_objects();
     File2TileDBBinaryBase* create_file2tiledb_object(const FileInfo& file_info, const uint64_t local_file_idx,
@@ -206,6 +245,12 @@ class VCF2TileDBConverter : public VCF2TileDBLoaderConverterBase
     //Data structure for exchanging info between loader and converter
     //If standalone, points to owned exchanges, else must point to those owned by VCF2TileDBLoader
     std::vector<LoaderConverterMessageExchange*> m_exchanges;
+    //htslib thread pool shared by all VCF/BCF readers for BGZF decompression - pool is NULL if disabled
+    htsThreadPool m_htslib_thread_pool;
+    //Idle VCF files kept open across batches - NULL if disabled
+    VCFReaderHandlePool* m_vcf_handle_pool;
+    //File handlers span all column partitions
+    bool m_all_column_partitions;
 };
 #endif
 
@@ -322,7 +367,8 @@ class VCF2TileDBLoader : public VCF2TileDBLoaderConverterBase
      */
     VCF2TileDBLoaderReadState* construct_read_state_object() const
     {
-      return new VCF2TileDBLoaderReadState(m_owned_exchanges.size(), m_do_ping_pong_buffering, m_offload_vcf_output_processing);
+      return new VCF2TileDBLoaderReadState(m_owned_exchanges.size(), m_loader_config->do_ping_pong_buffering(),
+          m_loader_config->offload_vcf_output_processing());
     }
     /*
      * Used when buffered streams are included in the load stage
@@ -361,7 +407,7 @@ class VCF2TileDBLoader : public VCF2TileDBLoaderConverterBase
     inline int64_t get_order_for_row_idx(const int64_t row_idx) const
     {
 #ifdef HTSDIR
-      return m_standalone_converter_process ? row_idx : m_converter->get_order_for_row_idx(row_idx);
+      return m_loader_config->is_standalone_converter_process() ? row_idx : m_converter->get_order_for_row_idx(row_idx);
 #else
       return row_idx;
 #endif
@@ -369,7 +415,7 @@ class VCF2TileDBLoader : public VCF2TileDBLoaderConverterBase
     inline int64_t get_designated_row_idx_for_order(const int64_t order) const
     {
 #ifdef HTSDIR
-      return m_standalone_converter_process ? order : m_converter->get_designated_row_idx_for_order(order);
+      return m_loader_config->is_standalone_converter_process() ? order : m_converter->get_designated_row_idx_for_order(order);
 #else
       return order;
 #endif
@@ -377,7 +423,7 @@ class VCF2TileDBLoader : public VCF2TileDBLoaderConverterBase
     inline size_t get_num_order_values() const
     {
 #ifdef HTSDIR
-      return m_standalone_converter_process ? m_num_callsets_owned : m_converter->get_num_order_values();
+      return m_loader_config->is_standalone_converter_process() ? m_num_callsets_owned : m_converter->get_num_order_values();
 #else
       return m_num_callsets_owned;
 #endif
@@ -272,6 +272,13 @@ class File2TileDBBinaryBase
      * Create histogram
      */
     void create_histogram(uint64_t max_histogram_range, unsigned num_bins);
+    /*
+     * Estimate the histogram from the index of the file without reading records
+     * num_bins_to_sample - #densest bins whose counts are obtained by reading records
+     * Files without an index are read fully
+     */
+    virtual void create_histogram_from_index(uint64_t max_histogram_range, unsigned num_bins, unsigned num_bins_to_sample)
+    { create_histogram(max_histogram_range, num_bins); }
     UniformHistogram* get_histogram() { return m_histogram; }
     GenomicsDBImportReaderBase* get_base_reader_ptr(const unsigned column_partition_idx)
     {
@@ -316,6 +323,17 @@ class File2TileDBBinaryBase
     void print_partition(File2TileDBBinaryColumnPartitionBase& partition_info,
         const std::string& results_directory, const std::string& output_type,
         const unsigned partition_idx, const bool close_file);
+    /*
+     * Single pass mode - the file is walked once in column order and every record is dispatched
+     * to all partitions whose column interval overlaps the record. Needs a reader shared by all
+     * partitions, so it is ignored when each partition has its own reader
+     */
+    void set_single_pass_partitions(const bool val) { m_single_pass_partitions = val && !m_parallel_partitions; }
+    bool is_single_pass_partitions() const { return m_single_pass_partitions; }
+    /*
+     * Print data for all partitions, reading each record once
+     */
+    void print_all_partitions_single_pass(const std::string& results_directory, const std::string& output_type, const int rank);
     /*
      * Opens the file for partition - useful when printing data for a specific partition (splitting files)
      * Must be implemented by sub-classes
@@ -342,6 +360,24 @@ class File2TileDBBinaryBase
     {
       throw File2TileDBBinaryException("Unimplemented operation");
     }
+    /*
+     * Column interval [begin, end] spanned by the current record of the reader used by partition_info
+     * Must be implemented by sub-classes that support single pass reads
+     */
+    virtual void get_column_interval_of_record(File2TileDBBinaryColumnPartitionBase& partition_info,
+        int64_t& begin, int64_t& end)
+    {
+      throw File2TileDBBinaryException("Unimplemented operation");
+    }
+    /*
+     * Prints the current record of the reader used by cursor_info to the output file of partition_info
+     * Must be implemented by sub-classes that support single pass reads
+     */
+    virtual void write_record_to_partition(File2TileDBBinaryColumnPartitionBase& cursor_info,
+        File2TileDBBinaryColumnPartitionBase& partition_info)
+    {
+      throw File2TileDBBinaryException("Unimplemented operation");
+    }
   protected:
     inline int64_t get_enabled_idx_for_local_callset_idx(int64_t local_callset_idx) const
     {
@@ -352,6 +388,7 @@ class File2TileDBBinaryBase
     bool m_parallel_partitions;
     bool m_noupdates;
     bool m_close_file;
+    bool m_single_pass_partitions;
     bool m_treat_deletions_as_intervals;
     bool m_get_data_from_file;
     VidMapper* m_vid_mapper;
@@ -53,7 +53,8 @@ class LineBasedTextFileException : public std::exception {
     std::string msg_;
 };
 
-//Line based reader
+//Line based reader - the file is memory mapped, lines point directly into the mapping
+//Multiple readers of the same file (parallel partitions) share pages through the page cache
 class LineBasedTextFileReader : public FileReaderBase
 {
   public:
@@ -67,30 +68,41 @@ class LineBasedTextFileReader : public FileReaderBase
     void add_reader();
     void remove_reader();
     void read_and_advance();
-    void seek(const fpos_t& pos)
-    {
-      assert(m_fptr);
-      auto status = fsetpos(m_fptr, &pos);
-      assert(status == 0);
-    }
-    void get_position(fpos_t& pos) const
+    /*
+     * Next call to read_and_advance() returns the line beginning at offset
+     */
+    void seek(const size_t offset)
     {
-      assert(m_fptr);
-      auto status = fgetpos(m_fptr, &pos);
-      assert(status == 0);
+      assert(offset <= m_file_size);
+      m_next_line_offset = offset;
     }
-    inline const char* get_line() const { return m_is_record_valid ? m_line_buffer : 0; }
+    //Offset of the line returned by the last call to read_and_advance(), file size if no valid line
+    size_t get_position() const { return m_is_record_valid ? m_line_offset : m_file_size; }
+    size_t get_file_size() const { return m_file_size; }
+    /*
+     * Offset of the first byte of the line containing offset (file must be mapped)
+     */
+    size_t get_line_begin(const size_t offset) const;
+    /*
+     * Offset of the first byte after the line (including newline) beginning at offset (file must be mapped)
+     */
+    size_t get_line_end(const size_t offset) const;
+    const char* get_data(const size_t offset) const { assert(m_data && offset <= m_file_size); return m_data+offset; }
+    inline const char* get_line() const { return m_is_record_valid ? m_data+m_line_offset : 0; }
     inline size_t get_line_length() const  { return m_is_record_valid ? m_line_length : 0ull; }
   private:
-    FILE* m_fptr;
-    char* m_line_buffer;
-    size_t m_line_buffer_size;
-    //Line length excluding newline
+    const char* m_data;
+    size_t m_file_size;
+    //Offset of current line
+    size_t m_line_offset;
+    //Offset where the next line begins
+    size_t m_next_line_offset;
+    //Line length including newline
     size_t m_line_length;
 };
 
 /*
- * Abstract base class for text formats - only contains fpos_t
+ * Abstract base class for text formats - only contains the file offset
  */
 class LineBasedTextFile2TileDBBinaryColumnPartition : public File2TileDBBinaryColumnPartitionBase
 {
@@ -98,7 +110,7 @@ class LineBasedTextFile2TileDBBinaryColumnPartition : public File2TileDBBinaryCo
     LineBasedTextFile2TileDBBinaryColumnPartition() : File2TileDBBinaryColumnPartitionBase()
     {
       m_initialized_file_position_to_partition_begin = false;
-      memset(&m_file_position, 0, sizeof(fpos_t));
+      m_file_position = 0;
     }
     //Delete copy constructor
     LineBasedTextFile2TileDBBinaryColumnPartition(const LineBasedTextFile2TileDBBinaryColumnPartition& other) = delete;
@@ -115,7 +127,8 @@ class LineBasedTextFile2TileDBBinaryColumnPartition : public File2TileDBBinaryCo
     { m_initialized_file_position_to_partition_begin = val; }
   protected:
     bool m_initialized_file_position_to_partition_begin;
-    fpos_t m_file_position;
+    //Offset of the current line in the file
+    size_t m_file_position;
 };
 
 class CSV2TileDBBinaryColumnPartition : public LineBasedTextFile2TileDBBinaryColumnPartition
@@ -281,6 +294,15 @@ class CSV2TileDBBinary : public LineBasedTextFile2TileDBBinary
      * Returns true if (store_in_buffer && buffer is full)
      */
     bool parse_line(const char* line, CSV2TileDBBinaryColumnPartition& csv_partition_info, const unsigned max_token_idx, const bool store_in_buffer);
+    /*
+     * Fast path for the column (second token) of a line - avoids libcsv when only the position is needed
+     * Row and column values are plain integers and never quoted
+     */
+    int64_t get_column_from_line(const char* line, const size_t line_length) const;
+    /*
+     * The CSV is sorted by column - binary search for the first line with column >= column_begin
+     */
+    size_t find_first_line_with_column_at_least(const LineBasedTextFileReader& reader, const int64_t column_begin) const;
     /*
      * CSV handling functions - token and end of line
      */
@@ -68,14 +68,16 @@ class BroadCombinedGVCFOperator : public GA4GHOperator
     void clear();
     void switch_contig();
     virtual void operate(Variant& variant, const VariantQueryConfig& query_config);
+    void write_combined_record(const Variant& variant);
     inline bool overflow() const { return m_vcf_adapter->overflow(); }
     bool handle_VCF_field_combine_operation(const Variant& variant,
         const INFO_tuple_type& curr_tuple, void*& result_ptr, unsigned& num_result_elements);
     void handle_INFO_fields(const Variant& variant);
     void handle_FORMAT_fields(const Variant& variant);
     void handle_deletions(Variant& variant, const VariantQueryConfig& query_config);
+    void invalidate_INFO_fields_of_spanning_deletions(Variant& variant);
     void merge_ID_field(const Variant& variant, const unsigned query_idx);
-  private:
+  protected:
     bool m_use_missing_values_not_vector_end;
     const VariantQueryConfig* m_query_config;
     VCFAdapter* m_vcf_adapter;
@@ -103,18 +105,60 @@ class BroadCombinedGVCFOperator : public GA4GHOperator
     std::vector<int> m_MIN_DP_vector;
     //DP_FORMAT values
     std::vector<int> m_DP_FORMAT_vector;
-    //Used for handling deletions - remapping PL/AD where a deletion is replaced with *
-    CombineAllelesLUT m_reduced_alleles_LUT;
-    //vector of field pointers used for handling remapped fields when dealing with spanning deletions
-    //avoids re-allocation overhead
-    std::vector<std::unique_ptr<VariantFieldBase>> m_spanning_deletions_remapped_fields;
-    std::vector<int> m_spanning_deletion_remapped_GT;
     //Allowed bases
     static const std::unordered_set<char> m_legal_bases;
     //For profiling
     Timer m_bcf_t_creation_timer;
 };
 
+/*
+ * Produces the partially combined records (see PartialCombineOperator) of one row partition
+ */
+class PartialCombinedGVCFSource
+{
+  public:
+    virtual ~PartialCombinedGVCFSource() = default;
+    /*
+     * Fills partial with the next record of the partition - records are returned in column order
+     * Returns false if the partition has no more records
+     */
+    virtual bool next(Variant& partial) = 0;
+};
+
+/*
+ * Second level of the combine for arrays partitioned by rows - merges the allele lists of the partially
+ * combined records of all partitions, remaps the allele dependent fields of the calls and writes the
+ * combined records. The query config must contain the rows of all partitions
+ */
+class BroadCombinedGVCFPartialsReducer : public BroadCombinedGVCFOperator
+{
+  public:
+    BroadCombinedGVCFPartialsReducer(VCFAdapter& vcf_adapter, const VidMapper& id_mapper, const VariantQueryConfig& query_config,
+        const unsigned max_diploid_alt_alleles_that_can_be_genotyped=MAX_DIPLOID_ALT_ALLELES_THAT_CAN_BE_GENOTYPED,
+        const bool use_missing_values_only_not_vector_end=false);
+    /*
+     * Returns false if the VCF adapter buffer is full before all records are written - call again after
+     * emptying the buffer (same sources, in the same order)
+     */
+    bool reduce(const std::vector<PartialCombinedGVCFSource*>& sources);
+  private:
+    void combine_partials(const int64_t begin, const int64_t end);
+    void copy_call_fields(VariantCall& partial_call, const uint64_t call_idx, const bool remap_fields);
+  private:
+    //Current record of every partition
+    std::vector<Variant> m_partials;
+    std::vector<bool> m_is_partial_valid;
+    std::vector<bool> m_is_source_done;
+    int64_t m_next_position;
+    //Allele lists of the partitions that contain the current position
+    std::vector<const std::string*> m_partials_reference_alleles;
+    std::vector<const std::vector<std::string>*> m_partials_alt_alleles;
+    //Maps alleles of each partition to the merged alleles - partition idx is the input idx
+    CombineAllelesLUT m_partials_alleles_LUT;
+    //Calls set by the previous record
+    std::vector<uint64_t> m_valid_call_idxs;
+};
+
 #endif //ifdef HTSDIR
 
 #endif
@@ -0,0 +1,136 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COLUMNAR_EXPORT_H
+#define COLUMNAR_EXPORT_H
+
+#include "variant_operations.h"
+#include "vid_mapper.h"
+#include "parquet_file.h"
+
+//Exceptions thrown
+class ColumnarExportException : public std::exception {
+  public:
+    ColumnarExportException(const std::string m="") : msg_("ColumnarExportException : "+m) { ; }
+    ~ColumnarExportException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+enum ColumnarExportLayoutEnum
+{
+  COLUMNAR_EXPORT_LAYOUT_NESTED=0,
+  COLUMNAR_EXPORT_LAYOUT_LONG
+};
+
+/*
+ * Writes the sites produced by scan_and_operate into a Parquet file (see ParquetFileWriter)
+ * Site columns: contig, pos, end (1-based, like VCF), ref, alt (merged ALT alleles joined by ',', null if there
+ * are none) and INFO.<name>
+ * for every queried INFO field that combines to a single int or float value (sum/mean/median in the vid mapping)
+ * Call columns: FORMAT.GT (as a string, eg "0/1") and FORMAT.<name> for every queried single valued int or float
+ * FORMAT field (and DP). Missing values are nulls
+ * In the nested layout, every site is a row and the call columns are lists with one element per queried row (in
+ * query row order, null if the sample has no call at the site). In the long layout, every valid call is a row -
+ * the site columns are repeated and the columns site_idx (site number within the file) and sample are added
+ * Sample names in query row order are stored in the footer metadata under "samples", separated by tabs
+ * Scan with handle_spanning_deletions=true, as for BroadCombinedGVCFOperator
+ */
+class ColumnarExportOperator : public GA4GHOperator
+{
+  public:
+    ColumnarExportOperator(const std::string& filename, const VidMapper& id_mapper, const VariantQueryConfig& query_config,
+        const ColumnarExportLayoutEnum layout=COLUMNAR_EXPORT_LAYOUT_NESTED,
+        const uint64_t row_group_num_sites=65536ull, const uint64_t row_group_max_num_calls=16ull*1024ull*1024ull,
+        const unsigned max_diploid_alt_alleles_that_can_be_genotyped=MAX_DIPLOID_ALT_ALLELES_THAT_CAN_BE_GENOTYPED);
+    virtual void operate(Variant& variant, const VariantQueryConfig& query_config);
+    /*
+     * Writes the last row group and the footer
+     */
+    void finalize();
+    uint64_t get_num_sites() const { return m_num_sites; }
+  private:
+    void update_contig(const int64_t column);
+    void compute_INFO_values(const Variant& variant);
+    //Appends the values of the current site to the site columns
+    void add_site_values();
+    void add_call_values(const Variant& variant, const uint64_t call_idx_in_variant);
+    void flush_row_group();
+  private:
+    class FieldColumn
+    {
+      public:
+        FieldColumn(const unsigned query_idx, const unsigned column_idx, const unsigned variant_type_enum,
+            const int combine_operation)
+          : m_query_idx(query_idx), m_column_idx(column_idx), m_variant_type_enum(variant_type_enum),
+          m_combine_operation(combine_operation)
+        {
+          m_is_valid = false;
+          m_value = 0;
+        }
+        unsigned m_query_idx;
+        unsigned m_column_idx;
+        unsigned m_variant_type_enum;
+        int m_combine_operation;
+        //INFO value at the current site - an int or the bits of a float
+        bool m_is_valid;
+        int32_t m_value;
+    };
+    ParquetFileWriter m_writer;
+    const VidMapper* m_vid_mapper;
+    const VariantQueryConfig* m_query_config;
+    ColumnarExportLayoutEnum m_layout;
+    uint64_t m_row_group_num_sites;
+    uint64_t m_row_group_max_num_calls;
+    //Column idxs
+    unsigned m_contig_column_idx;
+    unsigned m_pos_column_idx;
+    unsigned m_end_column_idx;
+    unsigned m_ref_column_idx;
+    unsigned m_alt_column_idx;
+    unsigned m_GT_column_idx;
+    unsigned m_site_idx_column_idx;
+    unsigned m_sample_column_idx;
+    std::vector<FieldColumn> m_INFO_columns;
+    std::vector<FieldColumn> m_FORMAT_columns;
+    //Current contig
+    std::string m_curr_contig_name;
+    int64_t m_curr_contig_begin_position;
+    int64_t m_curr_contig_end_position;
+    //Current site
+    int64_t m_curr_pos;
+    int64_t m_curr_end;
+    std::string m_curr_alt;
+    //Counters
+    uint64_t m_num_sites;
+    uint64_t m_num_sites_in_row_group;
+    uint64_t m_num_calls_in_row_group;
+    uint64_t m_num_rows_in_row_group;
+    std::vector<std::string> m_sample_names;
+    //Avoids re-allocation
+    std::string m_tmp_string;
+};
+
+#endif
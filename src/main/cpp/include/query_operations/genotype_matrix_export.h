@@ -0,0 +1,130 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GENOTYPE_MATRIX_EXPORT_H
+#define GENOTYPE_MATRIX_EXPORT_H
+
+#include "variant_operations.h"
+#include "vid_mapper.h"
+#include <fstream>
+
+//Exceptions thrown
+class GenotypeMatrixExportException : public std::exception {
+  public:
+    GenotypeMatrixExportException(const std::string m="") : msg_("GenotypeMatrixExportException : "+m) { ; }
+    ~GenotypeMatrixExportException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+/*
+ * PLINK_BED - PLINK 1 variant-major .bed, 2 bits per genotype (hom A1=00, missing=01, het=10, hom A2=11)
+ * DOSAGE - 1 signed byte per genotype, the number of copies of the ALT allele, -1 for missing
+ */
+enum GenotypeMatrixFormatEnum
+{
+  GENOTYPE_MATRIX_FORMAT_PLINK_BED=0,
+  GENOTYPE_MATRIX_FORMAT_DOSAGE
+};
+
+/*
+ * SPLIT - one matrix row per ALT allele, counting copies of that allele only
+ * ALT_COUNT - one matrix row per site, counting copies of any exported ALT allele (not <NON_REF> or *). Only with
+ * the DOSAGE format - PLINK variants have a single A1 allele
+ */
+enum GenotypeMatrixMultiAllelicEnum
+{
+  GENOTYPE_MATRIX_MULTIALLELIC_SPLIT=0,
+  GENOTYPE_MATRIX_MULTIALLELIC_ALT_COUNT
+};
+
+#define GENOTYPE_MATRIX_MISSING_DOSAGE -1
+
+/*
+ * Writes a variants x samples genotype matrix for the sites produced by scan_and_operate
+ * <prefix>.bed or <prefix>.dosage - the matrix, one row per variant in scan order, samples in query row order
+ * <prefix>.bim - variant table (contig, id, 0, 1-based position, ALT, REF) - same layout as PLINK's .bim
+ * <prefix>.fam - sample table (name, name, 0, 0, 0, -9) - same layout as PLINK's .fam
+ * Sites with no ALT allele other than <NON_REF> and * (reference blocks) are skipped. Rows are buffered in blocks
+ * of block_num_variants and each block is packed by num_threads threads before it is written
+ * Scan with handle_spanning_deletions=true - samples whose deletion spans the site are missing unless homozygous REF
+ */
+class GenotypeMatrixExportOperator : public SingleVariantOperatorBase
+{
+  public:
+    GenotypeMatrixExportOperator(const std::string& prefix, const VidMapper& id_mapper, const VariantQueryConfig& query_config,
+        const GenotypeMatrixFormatEnum format=GENOTYPE_MATRIX_FORMAT_PLINK_BED,
+        const GenotypeMatrixMultiAllelicEnum multiallelic_mode=GENOTYPE_MATRIX_MULTIALLELIC_SPLIT,
+        const uint64_t block_num_variants=4096ull, const unsigned num_threads=1u);
+    ~GenotypeMatrixExportOperator();
+    virtual void operate(Variant& variant, const VariantQueryConfig& query_config);
+    /*
+     * Writes the last block and closes the files
+     */
+    void finalize();
+    uint64_t get_num_variants() const { return m_num_variants; }
+    uint64_t get_num_samples() const { return m_num_samples; }
+  private:
+    void update_contig(const int64_t column);
+    //Fills m_GT_vec with GT of the call remapped to the merged alleles, returns false if the genotype is unknown
+    bool get_merged_GT(const Variant& variant, const uint64_t call_idx_in_variant);
+    //Copies row site_row_idx of m_site_dosages into the block and writes the variant table line
+    void add_variant_row(const unsigned site_row_idx, const std::string& alt);
+    void flush_block();
+  private:
+    const VidMapper* m_vid_mapper;
+    GenotypeMatrixFormatEnum m_format;
+    GenotypeMatrixMultiAllelicEnum m_multiallelic_mode;
+    uint64_t m_block_num_variants;
+    unsigned m_num_threads;
+    unsigned m_GT_query_idx;
+    bool m_finalized;
+    std::string m_prefix;
+    std::ofstream m_matrix_fptr;
+    std::ofstream m_variants_fptr;
+    uint64_t m_num_samples;
+    uint64_t m_num_variants;
+    //Current contig
+    std::string m_curr_contig_name;
+    int64_t m_curr_contig_begin_position;
+    int64_t m_curr_contig_end_position;
+    int64_t m_curr_position;
+    //ALT alleles included in the matrix (no <NON_REF> or *), idx in m_merged_alt_alleles+1
+    std::vector<unsigned> m_exported_allele_idxs;
+    //Indexed by merged allele idx, true for the alleles in m_exported_allele_idxs
+    std::vector<bool> m_is_exported_allele;
+    //Alt allele counts of the current site - one row per exported row of the site
+    std::vector<int8_t> m_site_dosages;
+    //Alt allele counts of the current block - variant major, GENOTYPE_MATRIX_MISSING_DOSAGE for missing
+    std::vector<int8_t> m_block_dosages;
+    uint64_t m_num_variants_in_block;
+    //Packed bytes of the current block
+    std::vector<uint8_t> m_block_buffer;
+    //Avoids re-allocation
+    std::vector<int> m_GT_vec;
+    std::string m_tmp_string;
+};
+
+#endif
@@ -94,6 +94,10 @@ class VariantOperations
      */
     static void merge_reference_allele(const Variant& variant, const VariantQueryConfig& query_config,
         std::string& merged_reference_allele);
+    /*
+     * Merges a single REF allele into merged_reference_allele
+     */
+    static void merge_reference_allele(const std::string& curr_reference_allele, std::string& merged_reference_allele);
     /*
      * Obtains a merged ALT list as defined in BCF spec
      */
@@ -101,6 +105,15 @@ class VariantOperations
         const VariantQueryConfig& query_config,
         const std::string& merged_reference_allele,
         CombineAllelesLUT& alleles_LUT, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists);
+    /*
+     * Obtains a merged ALT list from allele lists that are already merged, for example the lists of
+     * partially combined records (see PartialCombineOperator). Input i in alleles_LUT corresponds to
+     * reference_alleles[i] and alt_alleles[i] - inputs with null alt_alleles[i] are skipped
+     */
+    static void merge_alt_alleles(const std::vector<const std::string*>& reference_alleles,
+        const std::vector<const std::vector<std::string>*>& alt_alleles,
+        const std::string& merged_reference_allele,
+        CombineAllelesLUT& alleles_LUT, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists);
     /*
      * Remaps GT field of Calls in the combined Variant based on new allele order
      */
@@ -351,6 +364,11 @@ class GA4GHOperator : public SingleVariantOperatorBase
     Variant& get_remapped_variant() { return m_remapped_variant; }
     void copy_back_remapped_fields(Variant& variant) const;
     bool too_many_alt_alleles_for_genotype_length_fields(unsigned num_alt_alleles) const { return num_alt_alleles > m_max_diploid_alt_alleles_that_can_be_genotyped; }
+    /*
+     * Calls with deletions that begin before the current position are reduced to REF="N", ALT="*, <NON_REF>"
+     * and their allele dependent fields are remapped. Modifies the original Variant object
+     */
+    void reduce_spanning_deletions(Variant& variant, const VariantQueryConfig& query_config);
   protected:
     Variant m_remapped_variant;
     //Query idxs of fields that need to be remmaped - PL, AD etc
@@ -359,10 +377,40 @@ class GA4GHOperator : public SingleVariantOperatorBase
     unsigned m_GT_query_idx;
     //Get handler based on type of field
     std::unique_ptr<VariantFieldHandlerBase>& get_handler_for_type(std::type_index ty);
+    //Set REF and ALT common fields of m_remapped_variant to the merged alleles
+    void set_merged_alleles_in_remapped_variant();
     //Handlers for various fields
     std::vector<std::unique_ptr<VariantFieldHandlerBase>> m_field_handlers;
     //Max alt alleles that can be handled for computing the PL fields - default 50
     unsigned m_max_diploid_alt_alleles_that_can_be_genotyped;
+    //Used for handling deletions - remapping PL/AD where a deletion is replaced with *
+    CombineAllelesLUT m_reduced_alleles_LUT;
+    //vector of field pointers used for handling remapped fields when dealing with spanning deletions
+    //avoids re-allocation overhead
+    std::vector<std::unique_ptr<VariantFieldBase>> m_spanning_deletions_remapped_fields;
+    std::vector<int> m_spanning_deletion_remapped_GT;
+};
+
+/*
+ * First level of the combine for arrays partitioned by rows - every partition produces partially combined records
+ * for its own calls: the merged REF and ALT alleles are common fields and the allele dependent fields (and GT) of
+ * each call are remapped to the merged alleles. Records are compact serialized (see Variant::compact_binary_serialize())
+ * into the buffer. BroadCombinedGVCFPartialsReducer merges the partially combined records of all partitions.
+ * Scan with handle_spanning_deletions=true, as for BroadCombinedGVCFOperator
+ */
+class PartialCombineOperator : public GA4GHOperator
+{
+  public:
+    PartialCombineOperator(const VariantQueryConfig& query_config, std::vector<uint8_t>& buffer, const uint64_t buffer_size_limit,
+        const unsigned max_diploid_alt_alleles_that_can_be_genotyped=MAX_DIPLOID_ALT_ALLELES_THAT_CAN_BE_GENOTYPED);
+    virtual void operate(Variant& variant, const VariantQueryConfig& query_config);
+    bool overflow() const { return m_num_valid_bytes >= m_buffer_size_limit; }
+    uint64_t get_num_valid_bytes() const { return m_num_valid_bytes; }
+    void reset_buffer() { m_num_valid_bytes = 0ull; }
+  private:
+    std::vector<uint8_t>* m_buffer;
+    uint64_t m_num_valid_bytes;
+    uint64_t m_buffer_size_limit;
 };
 
 class SingleCellOperatorBase
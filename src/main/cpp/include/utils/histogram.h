@@ -97,6 +97,8 @@ class Histogram
     const_iterator end() const { return HistogramIterator(this, m_histogram_bins.size(), m_histogram_bins.size()); }
     uint64_t get_total() const { return m_total; }
     void add_value(uint64_t value);
+    //Adds count occurrences of value
+    void add_count(uint64_t value, uint64_t count);
     void add_interval(uint64_t lo, uint64_t hi);
     void print(std::ostream& fptr=std::cout) const;
     void reset_counters();
@@ -23,6 +23,7 @@
 #ifndef RUN_CONFIG_H
 #define RUN_CONFIG_H
 
+#include <memory>
 #include "variant_query_config.h"
 #include "vcf_adapter.h"
 #include "vid_mapper.h"
@@ -106,9 +107,10 @@ class JSONBasicQueryConfig : public JSONConfigBase
 {
   public:
     JSONBasicQueryConfig() : JSONConfigBase()  { }
-    void read_from_file(const std::string& filename, VariantQueryConfig& query_config, FileBasedVidMapper* id_mapper=0, int rank=0, JSONLoaderConfig* loader_config=0);
-    void update_from_loader(JSONLoaderConfig* loader_config, const int rank);
-    void subset_query_column_ranges_based_on_partition(const JSONLoaderConfig* loader_config, const int rank);
+    void read_from_file(const std::string& filename, VariantQueryConfig& query_config, FileBasedVidMapper* id_mapper=0, int rank=0,
+        const std::shared_ptr<const JSONLoaderConfig>& loader_config=nullptr);
+    void update_from_loader(const std::shared_ptr<const JSONLoaderConfig>& loader_config, const int rank);
+    void subset_query_column_ranges_based_on_partition(const std::shared_ptr<const JSONLoaderConfig>& loader_config, const int rank);
 };
 
 #define JSON_LOADER_PARTITION_INFO_BEGIN_FIELD_NAME "begin"
@@ -117,7 +119,7 @@ class JSONBasicQueryConfig : public JSONConfigBase
 class JSONLoaderConfig : public JSONConfigBase
 {
   public:
-    JSONLoaderConfig(bool vid_mapper_file_required = true);
+    explicit JSONLoaderConfig(bool vid_mapper_file_required = true);
     void read_from_file(const std::string& filename, FileBasedVidMapper* id_mapper=0, int rank=0);
     inline bool is_partitioned_by_row() const { return m_row_based_partitioning; }
     inline bool is_partitioned_by_column() const { return !m_row_based_partitioning; }
@@ -126,6 +128,15 @@ class JSONLoaderConfig : public JSONConfigBase
       return m_row_based_partitioning ? ColumnRange(0, INT64_MAX) : JSONConfigBase::get_column_partition(idx);
     }
     inline int64_t get_max_num_rows_in_array() const { return m_max_num_rows_in_array; }
+    inline bool is_standalone_converter_process() const { return m_standalone_converter_process; }
+    inline int get_num_converter_processes() const { return m_num_converter_processes; }
+    inline bool treat_deletions_as_intervals() const { return m_treat_deletions_as_intervals; }
+    inline bool produce_combined_vcf() const { return m_produce_combined_vcf; }
+    inline bool produce_tiledb_array() const { return m_produce_tiledb_array; }
+    inline bool do_ping_pong_buffering() const { return m_do_ping_pong_buffering; }
+    inline bool discard_vcf_index() const { return m_discard_vcf_index; }
+    inline int get_num_parallel_vcf_files() const { return m_num_parallel_vcf_files; }
+    inline int64_t get_per_partition_size() const { return m_per_partition_size; }
     inline bool offload_vcf_output_processing() const { return m_offload_vcf_output_processing; }
     inline bool ignore_cells_not_in_partition() const { return m_ignore_cells_not_in_partition; }
     inline bool compress_tiledb_array() const { return m_compress_tiledb_array; }
@@ -140,8 +151,14 @@ class JSONLoaderConfig : public JSONConfigBase
     inline void set_vid_mapper_file_required(bool val) {
       m_vid_mapper_file_required = val;
     }
+    inline bool is_vid_mapper_file_required() const { return m_vid_mapper_file_required; }
     inline bool fail_if_updating() const { return m_fail_if_updating; }
     inline bool consolidate_tiledb_array_after_load() const { return m_consolidate_tiledb_array_after_load; }
+    inline int get_num_htslib_decompression_threads() const { return m_num_htslib_decompression_threads; }
+    inline size_t get_vcf_handle_pool_size() const { return m_vcf_handle_pool_size; }
+    inline const std::vector<int>& get_reference_block_gq_bands() const { return m_reference_block_gq_bands; }
+    inline bool use_lightweight_end_copies() const { return m_lightweight_end_copies; }
+    inline const std::vector<std::string>& get_dictionary_encoded_fields() const { return m_dictionary_encoded_fields; }
   protected:
     bool m_standalone_converter_process;
     bool m_treat_deletions_as_intervals;
@@ -159,12 +176,14 @@ class JSONLoaderConfig : public JSONConfigBase
     bool m_ignore_cells_not_in_partition;
     //Flag that controls whether the VCF indexes should be discarded to reduce memory consumption
     bool m_discard_vcf_index;
-    unsigned m_num_entries_in_circular_buffer;
     //#VCF files to open/process in parallel
     int m_num_parallel_vcf_files;
+    //#threads in the htslib pool shared by all VCF/BCF readers for BGZF decompression, 0 - inline decompression
+    int m_num_htslib_decompression_threads;
+    //Max #idle VCF/BCF files (with their headers and indexes) kept open between batches, 0 - close immediately
+    size_t m_vcf_handle_pool_size;
     int m_num_converter_processes;
     int64_t m_per_partition_size;
-    int64_t m_max_size_per_callset;
     //max #rows - defining domain of the array
     int64_t m_max_num_rows_in_array;
     //segment size for TileDB array
@@ -179,6 +198,12 @@ class JSONLoaderConfig : public JSONConfigBase
     bool m_fail_if_updating;
     //consolidate TileDB array after load - merges fragments
     bool m_consolidate_tiledb_array_after_load;
+    //Upper (exclusive) GQ bounds - adjacent reference blocks in the same band are merged, empty - no merging
+    std::vector<int> m_reference_block_gq_bands;
+    //END copies of interval cells store only co-ordinates and END (begin column), all other attributes are null
+    bool m_lightweight_end_copies;
+    //String fields (REF, ALT, ID) stored as codes into per-array dictionaries
+    std::vector<std::string> m_dictionary_encoded_fields;
 };
 
 #ifdef HTSDIR
@@ -217,7 +242,8 @@ class JSONVCFAdapterQueryConfig : public JSONVCFAdapterConfig, public JSONBasicQ
     void read_from_file(const std::string& filename, VariantQueryConfig& query_config,
         VCFAdapter& vcf_adapter, FileBasedVidMapper* id_mapper,
         std::string output_format="", int rank=0,
-        const size_t combined_vcf_records_buffer_size_limit=0u);
+        const size_t combined_vcf_records_buffer_size_limit=0u,
+        const std::shared_ptr<const JSONLoaderConfig>& loader_config=nullptr);
 };
 
 
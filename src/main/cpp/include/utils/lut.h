@@ -25,6 +25,7 @@
 
 #include <assert.h>
 #include <vector>
+#include <string>
 #include <stdlib.h>
 
 #define lut_missing_value -1ll
@@ -335,6 +336,21 @@ class MergedAllelesIdxLUT
       return LUTBase<inputs_2_merged_LUT_is_input_ordered, merged_2_inputs_LUT_is_input_ordered>::is_missing_value(
           static_cast<int>(val));
     }
+  public:
+    /*
+     * Open addressing hash table of the merged ALT alleles, reused across sites by
+     * VariantOperations::merge_alt_alleles() - each slot holds a merged allele idx (0 = empty slot).
+     * Size is a power of 2
+     */
+    std::vector<unsigned> m_merged_allele_hash_table;
+    //Scratch space of VariantOperations::merge_alt_alleles(), reused across sites
+    //Alleles of each input (call), null for invalid calls
+    std::vector<const std::string*> m_input_reference_alleles;
+    std::vector<const std::vector<std::string>*> m_input_alt_alleles;
+    //Idx of NON_REF in the ALT list of each input, -1 if absent
+    std::vector<int> m_input_non_reference_allele_idx;
+    //Input ALT allele extended with the suffix of the merged REF
+    std::string m_suffixed_allele;
   private:
     int64_t m_max_num_alleles;
 };
@@ -0,0 +1,265 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef PARQUET_FILE_H
+#define PARQUET_FILE_H
+
+#include "headers.h"
+
+//Exceptions thrown
+class ParquetFileException : public std::exception {
+  public:
+    ParquetFileException(const std::string m="") : msg_("ParquetFileException : "+m) { ; }
+    ~ParquetFileException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+/*
+ * Minimal native Parquet support - the subset needed for exports (see ColumnarExportOperator)
+ *
+ * "PAR1" <column chunks of row group 0> <column chunks of row group 1> ... <FileMetaData> <uint32 metadata length> "PAR1"
+ *
+ * Every column chunk is uncompressed and holds an optional dictionary page followed by a single v1 data page.
+ * FileMetaData and page headers use the Thrift compact protocol. Values are encoded as:
+ *   BYTE_ARRAY - RLE_DICTIONARY if there are at most half as many distinct values as values, PLAIN otherwise
+ *   INT64 - DELTA_BINARY_PACKED
+ *   INT32, FLOAT - PLAIN
+ * Missing values are nulls - definition levels (and repetition levels of list columns) are RLE/bit-packed hybrid
+ * encoded. The reader handles files produced by the writer, it is not a general purpose Parquet reader
+ */
+#define PARQUET_MAGIC "PAR1"
+#define PARQUET_MAGIC_LENGTH 4u
+
+//Values match the Parquet Type enum
+enum ParquetPhysicalTypeEnum
+{
+  PARQUET_TYPE_INT32=1,
+  PARQUET_TYPE_INT64=2,
+  PARQUET_TYPE_FLOAT=4,
+  PARQUET_TYPE_BYTE_ARRAY=6
+};
+
+//Values match the Parquet Encoding enum
+enum ParquetEncodingEnum
+{
+  PARQUET_ENCODING_PLAIN=0,
+  PARQUET_ENCODING_PLAIN_DICTIONARY=2,
+  PARQUET_ENCODING_RLE=3,
+  PARQUET_ENCODING_DELTA_BINARY_PACKED=5,
+  PARQUET_ENCODING_RLE_DICTIONARY=8
+};
+
+/*
+ * REQUIRED - one non-null value per row
+ * OPTIONAL - one value or null per row
+ * LIST - a list of nullable values per row, written as the standard 3-level list
+ *   required group <name> (LIST) { repeated group list { optional <type> element; } }
+ */
+enum ParquetRepetitionEnum
+{
+  PARQUET_REPETITION_REQUIRED=0,
+  PARQUET_REPETITION_OPTIONAL,
+  PARQUET_REPETITION_LIST
+};
+
+/*
+ * Values of one column within a row group. Every entry (value, null or empty list) has a slot in m_values so that
+ * entries can be accessed by idx - fixed width values are stored as bit patterns, strings as idxs into a
+ * dictionary built while appending. Used by the writer to encode and by the reader to decode chunks
+ */
+class ParquetColumn
+{
+  public:
+    ParquetColumn(const std::string& name="", const ParquetPhysicalTypeEnum type=PARQUET_TYPE_INT32,
+        const ParquetRepetitionEnum repetition=PARQUET_REPETITION_REQUIRED)
+      : m_name(name), m_type(type), m_repetition(repetition)
+    {
+      clear();
+    }
+    void clear()
+    {
+      m_values.clear();
+      m_definition_levels.clear();
+      m_repetition_levels.clear();
+      m_dictionary.clear();
+      m_dictionary_map.clear();
+      m_num_rows = 0ull;
+      m_is_list_empty = false;
+    }
+    /*
+     * For LIST columns - starts the list of the next row, the following values are its elements
+     */
+    void begin_list();
+    void append_int32(const int32_t value) { append_entry(static_cast<uint32_t>(value), get_max_definition_level()); }
+    void append_int64(const int64_t value) { append_entry(static_cast<uint64_t>(value), get_max_definition_level()); }
+    void append_float(const float value)
+    {
+      uint32_t bits = 0u;
+      memcpy(&bits, &value, sizeof(float));
+      append_entry(bits, get_max_definition_level());
+    }
+    void append_string(const std::string& value);
+    void append_null();
+    //#entries - for LIST columns, elements of all rows (and one entry per empty list)
+    uint64_t size() const { return m_values.size(); }
+    uint64_t get_num_rows() const { return m_num_rows; }
+    bool is_null(const uint64_t idx) const
+    { return !m_definition_levels.empty() && m_definition_levels[idx] != get_max_definition_level(); }
+    //For LIST columns - entry of an empty list
+    bool is_empty_list(const uint64_t idx) const
+    { return m_repetition == PARQUET_REPETITION_LIST && m_definition_levels[idx] == 0u; }
+    //For LIST columns - true if the entry is the first element of a row
+    bool is_list_begin(const uint64_t idx) const
+    { return m_repetition == PARQUET_REPETITION_LIST && m_repetition_levels[idx] == 0u; }
+    int32_t get_int32(const uint64_t idx) const { return static_cast<int32_t>(static_cast<uint32_t>(m_values[idx])); }
+    int64_t get_int64(const uint64_t idx) const { return static_cast<int64_t>(m_values[idx]); }
+    float get_float(const uint64_t idx) const
+    {
+      auto bits = static_cast<uint32_t>(m_values[idx]);
+      float value = 0;
+      memcpy(&value, &bits, sizeof(float));
+      return value;
+    }
+    const std::string& get_string(const uint64_t idx) const { return m_dictionary[m_values[idx]]; }
+    const std::string& get_name() const { return m_name; }
+    ParquetPhysicalTypeEnum get_type() const { return m_type; }
+    ParquetRepetitionEnum get_repetition() const { return m_repetition; }
+    unsigned get_max_definition_level() const
+    { return (m_repetition == PARQUET_REPETITION_LIST) ? 2u : (m_repetition == PARQUET_REPETITION_OPTIONAL) ? 1u : 0u; }
+    unsigned get_max_repetition_level() const { return (m_repetition == PARQUET_REPETITION_LIST) ? 1u : 0u; }
+    /*
+     * Appends the dictionary page (if the values are dictionary encoded) and the data page to buffer at offset.
+     * Returns the encoding of the values, dictionary_page_size (including the page header) is 0 if there is
+     * no dictionary page
+     */
+    ParquetEncodingEnum encode_pages(std::vector<uint8_t>& buffer, uint64_t& offset, uint64_t& dictionary_page_size) const;
+    /*
+     * Decodes all pages of a column chunk with num_values entries
+     */
+    void decode_pages(const uint8_t* buffer, const uint64_t size, const uint64_t num_values);
+  private:
+    void append_entry(const uint64_t value, const unsigned definition_level);
+    void encode_values(std::vector<uint8_t>& buffer, uint64_t& offset, const ParquetEncodingEnum encoding) const;
+  private:
+    std::string m_name;
+    ParquetPhysicalTypeEnum m_type;
+    ParquetRepetitionEnum m_repetition;
+    std::vector<uint64_t> m_values;
+    std::vector<uint8_t> m_definition_levels;
+    std::vector<uint8_t> m_repetition_levels;
+    std::vector<std::string> m_dictionary;
+    std::unordered_map<std::string, uint64_t> m_dictionary_map;
+    uint64_t m_num_rows;
+    //For LIST columns - the last entry is the empty list added by begin_list()
+    bool m_is_list_empty;
+};
+
+//Location of a column chunk in the file
+class ParquetColumnChunkInfo
+{
+  public:
+    ParquetColumnChunkInfo()
+    {
+      m_dictionary_page_offset = -1ll;
+      m_data_page_offset = 0ll;
+      m_size = 0ll;
+      m_num_values = 0ll;
+      m_encoding = PARQUET_ENCODING_PLAIN;
+    }
+    int64_t get_begin_offset() const { return (m_dictionary_page_offset >= 0) ? m_dictionary_page_offset : m_data_page_offset; }
+    int64_t m_dictionary_page_offset;
+    int64_t m_data_page_offset;
+    int64_t m_size;
+    int64_t m_num_values;
+    ParquetEncodingEnum m_encoding;
+};
+
+class ParquetRowGroupInfo
+{
+  public:
+    int64_t m_num_rows;
+    std::vector<ParquetColumnChunkInfo> m_chunks;
+};
+
+class ParquetFileWriter
+{
+  public:
+    ParquetFileWriter(const std::string& filename);
+    ~ParquetFileWriter();
+    /*
+     * Columns must be added before the first row group is written
+     */
+    unsigned add_column(const std::string& name, const ParquetPhysicalTypeEnum type, const ParquetRepetitionEnum repetition);
+    ParquetColumn& get_column(const unsigned idx) { return m_columns[idx]; }
+    //Stored in the key_value_metadata of the footer
+    void set_key_value_metadata(const std::string& key, const std::string& value);
+    /*
+     * Writes the chunks of all columns, then clears them. Every column must hold num_rows rows
+     */
+    void write_row_group(const uint64_t num_rows);
+    /*
+     * Writes the footer and closes the file - no further row groups can be written
+     */
+    void finalize();
+  private:
+    std::string m_filename;
+    std::ofstream m_fptr;
+    bool m_finalized;
+    uint64_t m_file_offset;
+    std::vector<ParquetColumn> m_columns;
+    std::vector<std::pair<std::string, std::string>> m_key_value_metadata;
+    std::vector<ParquetRowGroupInfo> m_row_groups;
+    std::vector<uint8_t> m_buffer;
+};
+
+/*
+ * Reads the footer on construction, column chunks on demand
+ */
+class ParquetFileReader
+{
+  public:
+    ParquetFileReader(const std::string& filename);
+    int64_t get_num_rows() const { return m_num_rows; }
+    uint64_t get_num_row_groups() const { return m_row_groups.size(); }
+    const ParquetRowGroupInfo& get_row_group_info(const uint64_t row_group_idx) const { return m_row_groups[row_group_idx]; }
+    unsigned get_num_columns() const { return m_columns.size(); }
+    const ParquetColumn& get_column_schema(const unsigned idx) const { return m_columns[idx]; }
+    //Returns false if no column has this name
+    bool get_column_idx(const std::string& name, unsigned& idx) const;
+    //Returns false if the key is not in the footer
+    bool get_key_value_metadata(const std::string& key, std::string& value) const;
+    void read_column_chunk(const uint64_t row_group_idx, const unsigned column_idx, ParquetColumn& column);
+  private:
+    std::string m_filename;
+    std::ifstream m_fptr;
+    int64_t m_num_rows;
+    std::vector<ParquetColumn> m_columns;
+    std::vector<std::pair<std::string, std::string>> m_key_value_metadata;
+    std::vector<ParquetRowGroupInfo> m_row_groups;
+    std::vector<uint8_t> m_buffer;
+};
+
+#endif
@@ -172,6 +172,9 @@ class FieldInfo
       m_length_descriptor = BCF_VL_FIXED;
       m_num_elements = 1;
       m_VCF_field_combine_operation = VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_UNKNOWN_OPERATION;
+      //No quantization
+      m_quantization_cap = INT_MAX;
+      m_quantization_bin_size = 1;
     }
     void set_info(const std::string& name, int idx)
     {
@@ -192,6 +195,18 @@ class FieldInfo
     int m_length_descriptor;
     int m_num_elements;
     int m_VCF_field_combine_operation;
+    //Lossy quantization of integer fields at import - non-negative values are capped and rounded down
+    //to a multiple of the bin size. Missing/vector end values (negative) are untouched
+    bool is_quantized() const { return (m_quantization_cap != INT_MAX || m_quantization_bin_size > 1); }
+    inline int quantize(const int val) const
+    {
+      if(val < 0)
+        return val;
+      auto result = std::min(val, m_quantization_cap);
+      return (m_quantization_bin_size > 1) ? (result/m_quantization_bin_size)*m_quantization_bin_size : result;
+    }
+    int m_quantization_cap;
+    int m_quantization_bin_size;
 };
 
 /*
@@ -537,6 +552,13 @@ class VidMapper
         const int rank, const bool is_zero_based);
     std::vector<ContigIntervalTuple> get_contig_intervals_for_column_partition(
         const int64_t column_partition_begin, const int64_t column_partition_end, const bool is_zero_based) const;
+    /*
+     * Versioned binary snapshot of the mapping state - contigs (with the sorted offset tables), fields,
+     * files and callsets. FileBasedVidMapper accepts a snapshot in place of the vid JSON file and
+     * loads it without any JSON parsing or validation passes
+     */
+    void write_binary_snapshot(const std::string& filename) const;
+    static bool is_binary_snapshot(const std::string& filename);
   protected:
     //Is initialized
     bool m_is_initialized;
@@ -551,6 +573,11 @@ class VidMapper
     //sorted vectors of pair<contig begin/end, idx> 
     std::vector<std::pair<int64_t, int>> m_contig_begin_2_idx;
     std::vector<std::pair<int64_t, int>> m_contig_end_2_idx;
+    //Eytzinger (breadth first, 1-based) layout of m_contig_begin_2_idx - the top levels of every search
+    //share a few cache lines. Built by build_contig_search_index() once m_contig_begin_2_idx is sorted
+    std::vector<int64_t> m_contig_begin_eytzinger;
+    std::vector<int> m_contig_idx_eytzinger;
+    void build_contig_search_index();
     //field mapping
     std::unordered_map<std::string, int> m_field_name_to_idx;
     std::vector<FieldInfo> m_field_idx_to_info;
@@ -670,6 +697,12 @@ class FileBasedVidMapper : public VidMapper
         const std::string& filename,
         const std::vector<BufferStreamInfo>& buffer_stream_info_vec,
         const bool is_file);
+    void load_binary_snapshot(const std::string& filename);
+    //filename may be NULL if the callset has no data source
+    void add_callset(const std::string& callset_name, const int64_t row_idx,
+        const char* filename, const int64_t idx_in_file);
+    void check_for_missing_callsets(const std::string& filename) const;
+    void initialize_buffer_streams(const std::vector<BufferStreamInfo>& buffer_stream_info_vec);
 
     int64_t m_lb_callset_row_idx;
     int64_t m_ub_callset_row_idx;
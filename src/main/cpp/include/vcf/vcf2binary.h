@@ -28,9 +28,11 @@
 #include "headers.h"
 #include "vid_mapper.h"
 #include "htslib/synced_bcf_reader.h"
+#include "htslib/thread_pool.h"
 #include "gt_common.h"
 #include "histogram.h"
 #include "tiledb_loader_file_base.h" 
+#include <mutex>
 
 //Exceptions thrown 
 class VCF2BinaryException : public std::exception {
@@ -99,12 +101,55 @@ class VCFBufferReader : public BufferReaderBase, public VCFReaderBase
     bool m_is_bcf;
 };
 
+class VCFReader;
+
+/*
+ * Bounded pool of VCFReader objects whose handles (file, index, header) are idle but still open
+ * A reader that is done with its file releases it to the pool instead of closing it; if the reader
+ * acquires the file again before being evicted, the re-open and header/index parsing are skipped
+ * Eviction is cost-aware (GreedyDual): priority = inflation value at insertion + cost, lowest priority
+ * evicted first. Readers with large headers survive longer, but stale entries are eventually evicted
+ */
+class VCFReaderHandlePool
+{
+  public:
+    VCFReaderHandlePool(const size_t capacity) : m_capacity(capacity), m_inflation_value(0) { }
+    //Delete copy and move constructors
+    VCFReaderHandlePool(const VCFReaderHandlePool& other) = delete;
+    VCFReaderHandlePool(VCFReaderHandlePool&& other) = delete;
+    /*
+     * Reader handles are kept open. May close handles of other idle readers (or this reader) to
+     * stay within capacity
+     */
+    void release(VCFReader* reader, const uint64_t cost);
+    /*
+     * Returns true if the handles of the reader are still open - reader is removed from the pool
+     * Returns false if the handles were closed on eviction
+     */
+    bool acquire(VCFReader* reader);
+    /*
+     * Called when the reader is destroyed
+     */
+    void forget(VCFReader* reader);
+  private:
+    void erase(VCFReader* reader);
+  private:
+    size_t m_capacity;
+    uint64_t m_inflation_value;
+    std::multimap<uint64_t, VCFReader*> m_priority_to_reader;
+    std::unordered_map<VCFReader*, std::multimap<uint64_t, VCFReader*>::iterator> m_reader_to_entry;
+    std::mutex m_mutex;
+};
+
 //Wrapper around VCF's file I/O functions
 //Capability of using index only during seek to minimize memory consumption
 class VCFReader : public FileReaderBase, public VCFReaderBase
 {
   public:
-    VCFReader();
+    /*
+     * thread_pool - if non-NULL, BGZF decompression for this file runs on the (shared) htslib thread pool
+     */
+    VCFReader(htsThreadPool* thread_pool=0, VCFReaderHandlePool* handle_pool=0);
     //Delete move and copy constructors
     VCFReader(const VCFReader& other) = delete;
     VCFReader(VCFReader&& other) = delete;
@@ -118,10 +163,41 @@ class VCFReader : public FileReaderBase, public VCFReaderBase
     void read_and_advance();
     //Helper functions
     void seek_read_advance(const char* contig, const int pos, bool discard_index);
+    /*
+     * Closes file, index and header of the synced reader - called directly or on eviction from the handle pool
+     */
+    void close_handles();
+  private:
+    /*
+     * Re-open at the BGZF virtual offset saved by remove_reader() - avoids an index lookup
+     * Returns false if the saved position cannot be used, the caller must fall back to the index
+     */
+    bool resume_from_virtual_offset(const char* contig, const int pos);
+    void invalidate_resume_position() { m_resume_virtual_offset = -1; }
+    void save_resume_position();
+    void attach_thread_pool(htsFile* fptr);
   private:
     bcf_srs_t* m_indexed_reader;
     htsFile* m_fptr;
+    htsThreadPool* m_thread_pool;
+    VCFReaderHandlePool* m_handle_pool;
     kstring_t m_vcf_file_buffer;
+    //BGZF virtual offset of the current record, -1 if unknown (record obtained through the indexed reader)
+    int64_t m_current_record_virtual_offset;
+    //Saved when the file handle is closed - record at this offset is the first one read after re-opening
+    int64_t m_resume_virtual_offset;
+    int m_resume_contig_idx;
+    int64_t m_resume_position;
+};
+
+//FORMAT fields combined when adjacent reference blocks are merged into a GQ band
+enum ReferenceBlockFieldsEnum
+{
+  REFERENCE_BLOCK_GQ_IDX=0,
+  REFERENCE_BLOCK_MIN_DP_IDX,
+  REFERENCE_BLOCK_DP_IDX,
+  REFERENCE_BLOCK_PL_IDX,
+  REFERENCE_BLOCK_NUM_FIELDS
 };
 
 class VCFColumnPartition : public File2TileDBBinaryColumnPartitionBase
@@ -144,6 +220,14 @@ class VCFColumnPartition : public File2TileDBBinaryColumnPartitionBase
       if(m_vcf_get_buffer == 0)
         throw VCF2BinaryException("Malloc failure");
       m_split_output_fptr = 0;
+      m_reference_block_cell_end_buffer_offset = -1;
+      m_reference_block_end_column = -1;
+      m_reference_block_local_contig_idx = -1;
+      m_reference_block_gq_band = -1;
+      m_reference_block_END_buffer_offset = -1;
+      m_reference_block_field_buffer_offsets.resize(REFERENCE_BLOCK_NUM_FIELDS, -1);
+      m_reference_block_field_num_values.resize(REFERENCE_BLOCK_NUM_FIELDS, 0);
+      m_reference_block_field_values.resize(REFERENCE_BLOCK_NUM_FIELDS);
     }
     //Delete copy constructor
     VCFColumnPartition(const VCFColumnPartition& other) = delete;
@@ -174,6 +258,19 @@ class VCFColumnPartition : public File2TileDBBinaryColumnPartitionBase
     uint64_t m_vcf_get_buffer_size;
     //File pointer to output partition data - useful when splitting files
     htsFile* m_split_output_fptr;
+    //Reference block compaction - last cell in the buffer, if it is a reference block that can be extended
+    //Buffer offset at which the cell ends, -1 if the last cell cannot be extended
+    int64_t m_reference_block_cell_end_buffer_offset;
+    int64_t m_reference_block_end_column;
+    //TileDB columns are contiguous across contigs - blocks on different contigs must never be merged
+    int m_reference_block_local_contig_idx;
+    int m_reference_block_gq_band;
+    int64_t m_reference_block_END_buffer_offset;
+    //Buffer offset of the first value and #values of GQ, MIN_DP, DP and PL in the cell, -1 if not imported
+    std::vector<int64_t> m_reference_block_field_buffer_offsets;
+    std::vector<int> m_reference_block_field_num_values;
+    //Values of the record being merged
+    std::vector<std::vector<int>> m_reference_block_field_values;
 };
 
 class VCF2Binary : public File2TileDBBinaryBase 
@@ -183,7 +280,8 @@ class VCF2Binary : public File2TileDBBinaryBase
         unsigned file_idx, VidMapper& vid_mapper, const std::vector<ColumnRange>& partition_bounds,
         size_t max_size_per_callset,
         bool treat_deletions_as_intervals,
-        bool parallel_partitions=false, bool noupdates=true, bool close_file=false, bool discard_index=false);
+        bool parallel_partitions=false, bool noupdates=true, bool close_file=false, bool discard_index=false,
+        htsThreadPool* htslib_thread_pool=0, VCFReaderHandlePool* handle_pool=0);
     VCF2Binary(const std::string& stream_name, const std::vector<std::vector<std::string>>& vcf_fields,
         unsigned file_idx, const int64_t buffer_stream_idx,
         VidMapper& vid_mapper, const std::vector<ColumnRange>& partition_bounds,
@@ -226,18 +324,47 @@ class VCF2Binary : public File2TileDBBinaryBase
     bool seek_and_fetch_position(File2TileDBBinaryColumnPartitionBase& partition_info, bool& is_read_buffer_empty, bool force_seek, bool advance_reader);
     uint64_t get_num_callsets_in_record(const File2TileDBBinaryColumnPartitionBase& partition_info) const
     { return m_enabled_local_callset_idx_vec.size(); }
+    /*
+     * Record counts per bin are estimated from the compressed byte ranges in the tabix/CSI index and the
+     * #records per contig stored in the index. The num_bins_to_sample densest bins are counted exactly
+     */
+    void create_histogram_from_index(uint64_t max_histogram_range, unsigned num_bins, unsigned num_bins_to_sample);
+    /*
+     * Adjacent reference blocks whose GQ falls in the same band are merged into a single cell
+     * bands - sorted upper (exclusive) GQ bounds of each band, as in GATK's --gvcf-gq-bands; empty disables merging
+     */
+    void set_reference_block_gq_bands(const std::vector<int>& bands) { m_reference_block_gq_bands = bands; }
     //Helper functions
     void update_local_contig_idx(VCFColumnPartition& vcf_partition, const bcf1_t* line);
+    /*
+     * 0-based END column of the record - uses the END INFO field or deletion length
+     */
+    int64_t get_end_column_idx(VCFColumnPartition& vcf_partition, bcf_hdr_t* hdr, bcf1_t* line, const int64_t column_idx);
+    /*
+     * GQ band of the current record if it is a hom-ref block with <NON_REF> as the only ALT, -1 otherwise
+     */
+    int get_reference_block_gq_band(VCFColumnPartition& vcf_partition, bcf_hdr_t* hdr, bcf1_t* line, const int local_callset_idx);
+    /*
+     * Extends the last cell in the buffer to cover the current record, returns false if the cell cannot be extended
+     * The cell and the record must be on the same contig
+     * END is updated, GQ, MIN_DP and DP become the minimum of the values, PL the element-wise minimum
+     */
+    bool merge_into_last_reference_block(std::vector<uint8_t>& buffer, VCFColumnPartition& vcf_partition,
+        bcf_hdr_t* hdr, bcf1_t* line, const int local_callset_idx,
+        const int64_t column_idx, const int64_t end_column_idx, const int gq_band, const int64_t buffer_offset);
     //VCF->TileDB conversion functions
     bool convert_VCF_to_binary_for_callset(std::vector<uint8_t>& buffer, VCFColumnPartition& vcf_partition,
         size_t size_per_callset, uint64_t enabled_callsets_idx);
     /*
      * field_type_idx: BCF_HL_* 
      */
+    /*
+     * quantization_info - if non-NULL, values are quantized as specified in the vid mapping (integer fields only)
+     */
     template<class FieldType>
     bool convert_field_to_tiledb(std::vector<uint8_t>& buffer, VCFColumnPartition& vcf_partition, 
         int64_t& buffer_offset, const int64_t buffer_offset_limit, int local_callset_idx,
-        const std::string& field_name, unsigned field_type_idx);
+        const std::string& field_name, unsigned field_type_idx, const FieldInfo* quantization_info=0);
     //Print partitions of the file - useful when splitting files into partitions
     /*
      * Opens the file for partition - useful when printing data for a specific partition (splitting files)
@@ -252,9 +379,22 @@ class VCF2Binary : public File2TileDBBinaryBase
      * Closes the file for partition - useful when printing data for a specific partition (splitting files)
      */
     void close_partition_output_file(File2TileDBBinaryColumnPartitionBase& partition_info);
+    /*
+     * Single pass reads - column interval of the current record and printing the record into a partition
+     */
+    void get_column_interval_of_record(File2TileDBBinaryColumnPartitionBase& partition_info,
+        int64_t& begin, int64_t& end);
+    void write_record_to_partition(File2TileDBBinaryColumnPartitionBase& cursor_info,
+        File2TileDBBinaryColumnPartitionBase& partition_info);
   private:
     bool m_discard_index;
     bool m_import_ID_field;
+    //Shared htslib pool for BGZF decompression - not owned
+    htsThreadPool* m_htslib_thread_pool;
+    //Shared pool of idle open file handles - not owned
+    VCFReaderHandlePool* m_handle_pool;
+    //Upper GQ bounds for merging reference blocks, empty - no merging
+    std::vector<int> m_reference_block_gq_bands;
     //Vector of vector of strings, outer vector has 2 elements - 0 for INFO, 1 for FORMAT
     const std::vector<std::vector<std::string>>* m_vcf_fields; 
     //Local contig idx to global contig idx
@@ -30,6 +30,7 @@
 #include "htslib/vcf.h"
 #include "htslib/faidx.h"
 #include "timer.h"
+#include "vcf_text_formatter.h"
 
 enum VCFIndexType
 {
@@ -117,6 +118,10 @@ class VCFAdapter
     { return m_reference_genome_info.get_reference_base_at_position(contig, pos); }
     const bool produce_GT_field() const { return m_produce_GT_field; }
   protected:
+    /*
+     * Writes line to m_output_fptr - VCF text is produced by VCFTextFormatter instead of htslib's vcf_format
+     */
+    void write_line(bcf1_t* line);
     bool m_open_output;
     //Output file
     std::string m_output_filename;
@@ -134,6 +139,8 @@ class VCFAdapter
     bool m_produce_GT_field;
     //Index output VCF
     unsigned m_index_output_VCF;
+    //Re-used for every VCF text line
+    std::vector<uint8_t> m_text_buffer;
 #ifdef DO_PROFILING
     //Timer
     Timer m_vcf_serialization_timer;
@@ -0,0 +1,83 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef VCF_PARTS_CONCATENATOR_H
+#define VCF_PARTS_CONCATENATOR_H
+
+#ifdef HTSDIR
+
+#include "headers.h"
+#include "htslib/vcf.h"
+
+//Exceptions thrown
+class VCFPartsConcatenatorException : public std::exception {
+  public:
+    VCFPartsConcatenatorException(const std::string m="") : msg_("VCFPartsConcatenatorException : "+m) { ; }
+    ~VCFPartsConcatenatorException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+/*
+ * Combines BGZF compressed VCF/BCF files written independently for consecutive column ranges
+ * (one per MPI rank or column partition) into a single file without recompressing any data.
+ * BGZF blocks can be concatenated as is - the concatenator keeps the header of the first part,
+ * drops the header blocks of the remaining parts and the EOF marker block of all but the last part.
+ * The parts must have been written with the header in its own BGZF block(s) - VCFAdapter flushes
+ * the BGZF stream after the header for this reason. The contig, INFO and FORMAT dictionaries in the
+ * headers of all parts must match those of the first part.
+ *
+ * If every part has a tabix (.tbi) or CSI (.csi) index, the indexes are merged by shifting the
+ * virtual file offsets of each part by the position of its data in the combined file - the
+ * combined file need not be re-read to index it.
+ */
+class VCFPartsConcatenator
+{
+  public:
+    VCFPartsConcatenator(const std::vector<std::string>& part_filenames)
+      : m_part_filenames(part_filenames)
+    { }
+    void concatenate(const std::string& output_filename, const bool merge_part_indexes=true);
+  private:
+    struct PartInfo
+    {
+      PartInfo() : m_data_begin(0ull), m_data_end(0ull), m_shift(0ll) { }
+      //Compressed file offsets - [m_data_begin, m_data_end) is copied to the output
+      uint64_t m_data_begin;
+      uint64_t m_data_end;
+      //Offset of m_data_begin in the output file minus m_data_begin
+      int64_t m_shift;
+    };
+    void initialize_part_info(const unsigned part_idx, PartInfo& part_info) const;
+    void check_part_header(const unsigned part_idx, const bcf_hdr_t* first_hdr, const bcf_hdr_t* hdr) const;
+    void merge_indexes(const std::string& output_filename, const std::string& index_suffix) const;
+  private:
+    std::vector<std::string> m_part_filenames;
+    std::vector<PartInfo> m_part_info;
+};
+
+#endif //ifdef HTSDIR
+
+#endif
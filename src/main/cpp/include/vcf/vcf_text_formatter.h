@@ -0,0 +1,74 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef VCF_TEXT_FORMATTER_H
+#define VCF_TEXT_FORMATTER_H
+
+#include "headers.h"
+
+#ifdef HTSDIR
+#include "htslib/vcf.h"
+#endif
+
+//Upper bound on the #chars written by format_int32 and format_float
+#define VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH 32u
+
+//Exceptions thrown
+class VCFTextFormatterException : public std::exception {
+  public:
+    VCFTextFormatterException(const std::string m="") : msg_("VCFTextFormatterException : "+m) { ; }
+    ~VCFTextFormatterException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+/*
+ * Formats VCF text lines into a caller owned buffer that is re-used across lines. Produces the same bytes as
+ * htslib's vcf_format (kputw for ints, ksprintf("%g") for floats), without going through kstring/printf for
+ * every value - for 10k sample records, number formatting dominates the cost of text output
+ */
+class VCFTextFormatter
+{
+  public:
+    /*
+     * Writes the decimal representation of value at dst, returns #chars written - same as kputw
+     */
+    static unsigned format_int32(char* dst, const int32_t value);
+    /*
+     * Writes value at dst, returns #chars written - same as printf("%g", value)
+     * Uses integer digit generation for the common case, falls back to snprintf for values that are too large/small
+     * to scale exactly, NaN/inf and for values that lie (nearly) halfway between two 6 digit decimals
+     */
+    static unsigned format_float(char* dst, const float value);
+#ifdef HTSDIR
+    /*
+     * Appends the VCF line (including the trailing newline) for line at buffer[offset], resizing buffer as needed
+     * Returns the offset just past the line
+     */
+    static size_t format(const bcf_hdr_t* hdr, bcf1_t* line, std::vector<uint8_t>& buffer, size_t offset);
+#endif
+};
+
+#endif
@@ -768,7 +768,8 @@ void VariantQueryProcessor::gt_get_column_interval(
     start_column_forward_sweep = paging_info ? std::max<uint64_t>(paging_info->get_last_column(), start_column_forward_sweep) 
       : start_column_forward_sweep;
     VariantArrayCellIterator* forward_iter = 0;
-    gt_initialize_forward_iter(ad, query_config, query_config.get_column_interval(column_interval_idx).first+1, forward_iter);
+    //Cells in columns before the last column of the previous page were all handled in earlier pages - don't re-scan them
+    gt_initialize_forward_iter(ad, query_config, start_column_forward_sweep, forward_iter);
     //Used to store single call variants  - one variant per cell
     //Multiple variants could be merged later on
     Variant tmp_variant(&subset_query_config);
@@ -891,6 +892,10 @@ void VariantQueryProcessor::gt_get_column(
   //i.e. start at the smallest cell with co-ordinate >= col
   VariantArrayCellIterator* cell_iter = 0;
   gt_initialize_forward_iter(ad, query_config, query_config.get_column_interval(column_interval_idx).first, cell_iter);
+  //Lightweight END copies carry only co-ordinates and END - the payload of intervals spanning col
+  //is fetched from the begin cells after the sweep. begin column -> array rows
+  auto lightweight_end_copies = get_storage_manager()->has_lightweight_end_copies(ad);
+  std::map<int64_t, std::vector<int64_t>> begin_column_to_pending_rows;
 #endif //ifdef DUPLICATE_CELL_AT_END
   // Indicates how many rows have been filled.
   uint64_t filled_rows = 0;
@@ -918,6 +923,17 @@ void VariantQueryProcessor::gt_get_column(
     {
       auto curr_query_row_idx = query_config.get_query_row_idx_for_array_row_idx(cell.get_row());
       auto& curr_call = variant.get_call(curr_query_row_idx);
+#ifdef DUPLICATE_CELL_AT_END
+      auto END_v = *(cell.get_field_ptr_for_query_idx<int64_t>(query_config.get_query_idx_for_known_field_enum(GVCF_END_IDX)));
+      if(!(curr_call.is_initialized()) && lightweight_end_copies && cell.get_begin_column() > END_v)
+      {
+        //END copy without payload - END is the begin column of the interval
+        curr_call.mark_initialized(true);
+        begin_column_to_pending_rows[END_v].push_back(cell.get_row());
+        ++filled_rows;
+      }
+      else
+#endif
       if(!(curr_call.is_initialized()))
       {
         gt_fill_row(variant, cell.get_row(), cell.get_begin_column(), query_config, cell, stats_ptr
@@ -945,6 +961,31 @@ void VariantQueryProcessor::gt_get_column(
   //free(const_cast<void*>(cell.cell()));
   delete cell_iter;
 
+#ifdef DUPLICATE_CELL_AT_END
+  //One iterator per distinct begin column, restricted to that column and the pending rows
+  for(auto& entry : begin_column_to_pending_rows)
+  {
+    auto& rows = entry.second;
+    std::sort(rows.begin(), rows.end());
+    int64_t range[] = { rows.front(), rows.back(), entry.first, entry.first };
+    auto* begin_iter = get_storage_manager()->begin(ad, range, query_config.get_query_attributes_schema_idxs());
+    auto row_iter = rows.begin();
+    for(;!(begin_iter->end()) && row_iter != rows.end();++(*begin_iter))
+    {
+      auto& begin_cell = **begin_iter;
+      //Cells within a column are in row order
+      while(row_iter != rows.end() && *row_iter < begin_cell.get_row())
+        ++row_iter;
+      if(row_iter != rows.end() && *row_iter == begin_cell.get_row())
+      {
+        gt_fill_row(variant, begin_cell.get_row(), begin_cell.get_begin_column(), query_config, begin_cell, stats_ptr, true);
+        ++row_iter;
+      }
+    }
+    delete begin_iter;
+  }
+#endif
+
 #ifndef DUPLICATE_CELL_AT_END
   if(query_row_idx_in_order)
     query_row_idx_in_order->resize(num_valid_rows);
@@ -1029,6 +1070,126 @@ void VariantQueryProcessor::binary_deserialize(Variant& variant, const VariantQu
   }
 }
 
+void VariantQueryProcessor::compact_binary_deserialize(Variant& variant, const VariantQueryConfig& query_config,
+    const vector<uint8_t>& buffer, uint64_t& offset) const
+{
+  assert(offset < buffer.size());
+  auto base_ptr = &(buffer[0]);
+  //Header
+  auto version = base_ptr[offset];
+  offset += sizeof(uint8_t);
+  if(version != COMPACT_VARIANT_SERIALIZATION_VERSION)
+    throw VariantQueryProcessorException("Unknown compact Variant serialization version "+std::to_string(version));
+  uint32_t schema_hash = 0u;
+  memcpy(&schema_hash, base_ptr+offset, sizeof(uint32_t));
+  offset += sizeof(uint32_t);
+  if(schema_hash != query_config.get_compact_serialization_schema_hash())
+    throw VariantQueryProcessorException("Serialized Variant was produced with a different set of queried attributes");
+  auto col_begin = compact_deserialize_varint(base_ptr, offset);
+  auto col_end = col_begin + zigzag_decode(compact_deserialize_varint(base_ptr, offset));
+  auto num_calls = compact_deserialize_varint(base_ptr, offset);
+  auto num_call_fields = compact_deserialize_varint(base_ptr, offset);
+  auto num_common_fields = compact_deserialize_varint(base_ptr, offset);
+  if(num_calls > 0ull && num_call_fields != query_config.get_num_queried_attributes())
+    throw VariantQueryProcessorException("Serialized Variant has "+std::to_string(num_call_fields)
+        +" fields per call, query has "+std::to_string(query_config.get_num_queried_attributes())+" attributes");
+  variant.set_column_interval(col_begin, col_end);
+  variant.resize(num_calls, query_config.get_num_queried_attributes());
+  variant.resize_common_fields(num_common_fields);
+  auto valid_calls_bitmap = base_ptr+offset;
+  offset += (num_calls+7u)/8u;
+  //Row idxs
+  uint64_t row_idx = 0ull;
+  for(auto i=0ull;i<num_calls;++i)
+  {
+    row_idx += zigzag_decode(compact_deserialize_varint(base_ptr, offset));
+    variant.get_call(i).set_row_idx(row_idx);
+  }
+  //Call info - fields of invalid calls are invalidated as variant may be re-used
+  auto num_valid_calls = 0ull;
+  for(auto i=0ull;i<num_calls;++i)
+  {
+    auto& curr_call = variant.get_call(i);
+    auto is_valid_call = (valid_calls_bitmap[i >> 3] & (1u << (i & 7u))) != 0;
+    curr_call.mark_valid(is_valid_call);
+    if(is_valid_call)
+    {
+      ++num_valid_calls;
+      auto flags = base_ptr[offset];
+      offset += sizeof(uint8_t);
+      curr_call.mark_initialized((flags & COMPACT_CALL_FLAG_INITIALIZED) != 0u);
+      curr_call.set_contains_deletion((flags & COMPACT_CALL_FLAG_CONTAINS_DELETION) != 0u);
+      curr_call.set_is_reference_block((flags & COMPACT_CALL_FLAG_REFERENCE_BLOCK) != 0u);
+      auto call_col_begin = col_begin + zigzag_decode(compact_deserialize_varint(base_ptr, offset));
+      auto call_col_end = call_col_begin + zigzag_decode(compact_deserialize_varint(base_ptr, offset));
+      curr_call.set_column_interval(call_col_begin, call_col_end);
+    }
+    else
+    {
+      curr_call.mark_initialized(false);
+      curr_call.set_contains_deletion(false);
+      curr_call.set_is_reference_block(false);
+      for(auto& field_ptr : curr_call.get_all_fields())
+        if(field_ptr.get())
+          field_ptr->set_valid(false);
+    }
+  }
+  //Present fields bitmaps
+  auto num_bytes_per_call_bitmap = (num_call_fields+7u)/8u;
+  auto present_fields_bitmaps = base_ptr+offset;
+  offset += num_valid_calls*num_bytes_per_call_bitmap;
+  //Call field sections
+  for(auto j=0u;j<num_call_fields;++j)
+  {
+    uint32_t section_length = 0u;
+    memcpy(&section_length, base_ptr+offset, sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    auto section_end = offset + section_length;
+    unsigned length_descriptor = BCF_VL_FIXED;
+    unsigned num_elements = 1u;
+    auto valid_call_idx = 0ull;
+    for(auto i=0ull;i<num_calls;++i)
+    {
+      auto& curr_call = variant.get_call(i);
+      if(!curr_call.is_valid())
+        continue;
+      auto& field_ptr = curr_call.get_field(j);
+      auto curr_bitmap = present_fields_bitmaps + valid_call_idx*num_bytes_per_call_bitmap;
+      if(curr_bitmap[j >> 3] & (1u << (j & 7u)))
+      {
+        fill_field_prep(field_ptr, query_config, j, length_descriptor, num_elements);
+        field_ptr->compact_binary_deserialize(base_ptr, offset, length_descriptor, num_elements);
+      }
+      else
+        if(field_ptr.get())
+          field_ptr->set_valid(false);
+      ++valid_call_idx;
+    }
+    if(offset != section_end)
+      throw VariantQueryProcessorException("Corrupted compact Variant serialization - section for field "
+          +query_config.get_query_attribute_name(j)+" has unexpected length");
+  }
+  //Common fields in the Variant object
+  for(auto i=0u;i<num_common_fields;++i)
+  {
+    auto query_idx = compact_deserialize_varint(base_ptr, offset);
+    auto is_valid_field = (base_ptr[offset] != 0u);
+    offset += sizeof(uint8_t);
+    variant.set_query_idx_for_common_field(i, query_idx);
+    std::unique_ptr<VariantFieldBase>& field_ptr = variant.get_common_field(i);
+    if(is_valid_field)
+    {
+      unsigned length_descriptor = BCF_VL_FIXED;
+      unsigned num_elements = 1u;
+      fill_field_prep(field_ptr, query_config, query_idx, length_descriptor, num_elements);
+      field_ptr->compact_binary_deserialize(base_ptr, offset, length_descriptor, num_elements);
+    }
+    else
+      if(field_ptr.get())
+        field_ptr->set_valid(false);
+  }
+}
+
 void VariantQueryProcessor::gt_fill_row(
     Variant& variant, int64_t row, int64_t column,
     const VariantQueryConfig& query_config,
@@ -898,6 +898,115 @@ void Variant::binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset) c
   }
 }
 
+/*
+ * Layout:
+ * version[1 byte] schema_hash[uint32] col_begin col_end-col_begin num_calls num_call_fields num_common_fields
+ * valid calls bitmap
+ * row idx delta (zigzag) for every call
+ * flags[1 byte] col_begin-variant col_begin (zigzag) col_end-col_begin for every valid call
+ * present fields bitmap for every valid call
+ * for every call field - section length[uint32] + field data of valid calls with the field present
+ * for every common field - query idx, is_valid[1 byte] + field data if valid
+ * All integers other than those with explicit sizes are varints
+ */
+void Variant::compact_binary_serialize(std::vector<uint8_t>& buffer, uint64_t& offset, const VariantQueryConfig& query_config) const
+{
+  auto num_calls = get_num_calls();
+  unsigned num_call_fields = num_calls ? m_calls[0].get_num_fields() : 0u;
+  uint64_t add_size = sizeof(uint8_t) + sizeof(uint32_t);
+  RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, add_size);
+  buffer[offset] = COMPACT_VARIANT_SERIALIZATION_VERSION;
+  offset += sizeof(uint8_t);
+  auto schema_hash = query_config.get_compact_serialization_schema_hash();
+  memcpy(&(buffer[offset]), &schema_hash, sizeof(uint32_t));
+  offset += sizeof(uint32_t);
+  compact_serialize_varint(buffer, offset, m_col_begin);
+  compact_serialize_varint(buffer, offset, zigzag_encode(m_col_end - m_col_begin));
+  compact_serialize_varint(buffer, offset, num_calls);
+  compact_serialize_varint(buffer, offset, num_call_fields);
+  compact_serialize_varint(buffer, offset, get_num_common_fields());
+  //Valid calls bitmap
+  add_size = (num_calls+7u)/8u;
+  RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, add_size);
+  memset(&(buffer[offset]), 0, add_size);
+  for(auto i=0ull;i<num_calls;++i)
+    if(m_calls[i].is_valid())
+      buffer[offset + (i >> 3)] |= (1u << (i & 7u));
+  offset += add_size;
+  //Row idxs
+  uint64_t prev_row_idx = 0ull;
+  for(const auto& call : m_calls)
+  {
+    compact_serialize_varint(buffer, offset, zigzag_encode(call.get_row_idx() - prev_row_idx));
+    prev_row_idx = call.get_row_idx();
+  }
+  //Valid call info
+  auto num_valid_calls = 0ull;
+  for(const auto& call : m_calls)
+  {
+    if(!call.is_valid())
+      continue;
+    ++num_valid_calls;
+    add_size = sizeof(uint8_t);
+    RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, add_size);
+    buffer[offset] = (call.is_initialized() ? COMPACT_CALL_FLAG_INITIALIZED : 0u)
+      | (call.contains_deletion() ? COMPACT_CALL_FLAG_CONTAINS_DELETION : 0u)
+      | (call.is_reference_block() ? COMPACT_CALL_FLAG_REFERENCE_BLOCK : 0u);
+    offset += sizeof(uint8_t);
+    compact_serialize_varint(buffer, offset, zigzag_encode(call.get_column_begin() - m_col_begin));
+    compact_serialize_varint(buffer, offset, zigzag_encode(call.get_column_end() - call.get_column_begin()));
+  }
+  //Present fields bitmaps
+  auto num_bytes_per_call_bitmap = (num_call_fields+7u)/8u;
+  add_size = num_valid_calls*num_bytes_per_call_bitmap;
+  RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, add_size);
+  memset(&(buffer[offset]), 0, add_size);
+  for(const auto& call : m_calls)
+  {
+    if(!call.is_valid())
+      continue;
+    assert(call.get_num_fields() == num_call_fields);
+    for(auto j=0u;j<num_call_fields;++j)
+    {
+      auto& field = call.get_field(j);
+      if(field.get() && field->is_valid())
+        buffer[offset + (j >> 3)] |= (1u << (j & 7u));
+    }
+    offset += num_bytes_per_call_bitmap;
+  }
+  //One section per call field
+  for(auto j=0u;j<num_call_fields;++j)
+  {
+    add_size = sizeof(uint32_t);
+    RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, add_size);
+    auto section_length_offset = offset;
+    offset += sizeof(uint32_t);
+    for(const auto& call : m_calls)
+    {
+      if(!call.is_valid())
+        continue;
+      auto& field = call.get_field(j);
+      if(field.get() && field->is_valid())
+        field->compact_binary_serialize(buffer, offset);
+    }
+    uint32_t section_length = offset - section_length_offset - sizeof(uint32_t);
+    memcpy(&(buffer[section_length_offset]), &section_length, sizeof(uint32_t));
+  }
+  //Common fields
+  for(auto i=0u;i<get_num_common_fields();++i)
+  {
+    auto& curr_field = m_fields[i];
+    auto is_valid_field = (curr_field.get() && curr_field->is_valid());
+    compact_serialize_varint(buffer, offset, get_query_idx_for_common_field(i));
+    add_size = sizeof(uint8_t);
+    RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, add_size);
+    buffer[offset] = is_valid_field ? 1u : 0u;
+    offset += sizeof(uint8_t);
+    if(is_valid_field)
+      curr_field->compact_binary_serialize(buffer, offset);
+  }
+}
+
 void Variant::binary_deserialize_header(const std::vector<uint8_t>& buffer, uint64_t& offset, unsigned num_queried_attributes)
 {
   assert(offset + 3*sizeof(uint64_t) + sizeof(unsigned) <= buffer.size());
@@ -939,6 +1048,26 @@ bool move_call_to_variant_vector(const VariantQueryConfig& query_config, Variant
   return newly_inserted;
 }
 
+void VariantsJSONStreamPrinter::print_header(std::ostream& fptr) const
+{
+  fptr << "{\n" << json_indent_unit << "\"variants\": [\n";
+}
+
+void VariantsJSONStreamPrinter::print(std::ostream& fptr, const Variant& variant)
+{
+  static const auto indent_prefix = std::string(json_indent_unit)+json_indent_unit;
+  if(m_num_printed_variants > 0ull)
+    fptr << ",\n";
+  variant.print(fptr, &m_query_config, indent_prefix, m_id_mapper);
+  ++m_num_printed_variants;
+}
+
+void VariantsJSONStreamPrinter::print_trailer(std::ostream& fptr) const
+{
+  fptr << "\n"<< json_indent_unit << "]\n";
+  fptr << "}\n";
+}
+
 void print_variants(const std::vector<Variant>& variants,
                     const std::string& output_format,
                     const VariantQueryConfig& query_config,
@@ -983,18 +1112,11 @@ void print_variants(const std::vector<Variant>& variants,
     case DEFAULT_OUTPUT_FORMAT_IDX:
     default:
       {
-        optr << "{\n" << json_indent_unit << "\"variants\": [\n";
-        auto variant_idx = 0ull;
-        auto indent_prefix = std::string(json_indent_unit)+json_indent_unit;
+        VariantsJSONStreamPrinter printer(query_config, id_mapper);
+        printer.print_header(optr);
         for(const auto& variant : variants)
-        {
-          if(variant_idx > 0ull)
-            optr << ",\n";
-          variant.print(optr, &query_config, indent_prefix, id_mapper);
-          ++variant_idx;
-        }
-        optr << "\n"<< json_indent_unit << "]\n";
-        optr << "}\n";
+          printer.print(optr, variant);
+        printer.print_trailer(optr);
         break;
       }
   }
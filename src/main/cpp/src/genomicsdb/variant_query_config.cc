@@ -38,6 +38,7 @@ void VariantQueryConfig::add_attribute_to_query(const string& name, unsigned sch
     auto idx = m_query_attributes_info_vec.size();
     m_query_attributes_info_vec.emplace_back(name, schema_idx);
     m_query_attribute_name_to_query_idx[name] = idx;
+    update_compact_serialization_schema_hash();
   }
 }
 
@@ -172,5 +173,23 @@ void VariantQueryConfig::reorder_query_fields()
       ++m_first_normal_field_query_idx;
     }
   }
+  update_compact_serialization_schema_hash();
+}
+
+void VariantQueryConfig::update_compact_serialization_schema_hash()
+{
+  //FNV-1a
+  uint32_t hash = 2166136261u;
+  auto update_hash = [&hash](const void* data, const size_t num_bytes) {
+    auto ptr = reinterpret_cast<const uint8_t*>(data);
+    for(auto i=0ull;i<num_bytes;++i)
+      hash = (hash ^ ptr[i])*16777619u;
+  };
+  for(const auto& attribute_info : m_query_attributes_info_vec)
+  {
+    update_hash(attribute_info.m_name.c_str(), attribute_info.m_name.length()+1u);
+    update_hash(&(attribute_info.m_length_descriptor), sizeof(attribute_info.m_length_descriptor));
+  }
+  m_compact_serialization_schema_hash = hash;
 }
 
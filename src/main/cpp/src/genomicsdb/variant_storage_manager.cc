@@ -27,6 +27,7 @@
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw VariantStorageManagerException(#X);
 #define GET_METADATA_PATH(workspace, array) ((workspace)+'/'+(array)+"/genomicsdb_meta.json")
+#define GET_DICTIONARIES_PATH(workspace, array) ((workspace)+'/'+(array)+"/genomicsdb_dictionaries.json")
 
 const std::unordered_map<std::string, int> VariantStorageManager::m_mode_string_to_int = {
   { "r", TILEDB_ARRAY_READ },
@@ -36,19 +37,56 @@ const std::unordered_map<std::string, int> VariantStorageManager::m_mode_string_
 
 std::vector<const char*> VariantStorageManager::m_metadata_attributes = std::vector<const char*>({ "max_valid_row_idx_in_array" });
 
+//Schema idx of the attribute, -1 if the schema has no such attribute
+static int get_attribute_idx(const VariantArraySchema& schema, const std::string& name)
+{
+  for(auto i=0u;i<schema.attribute_num();++i)
+    if(schema.attribute_name(i) == name)
+      return i;
+  return -1;
+}
+
 //ceil(buffer_size/field_size)*field_size
 #define GET_ALIGNED_BUFFER_SIZE(buffer_size, field_size) ((((buffer_size)+(field_size)-1u)/(field_size))*(field_size))
 
+//StringDictionary functions
+int StringDictionary::get_or_add_code(const char* str, const size_t length)
+{
+  //Index strings read from disk
+  for(auto code=m_string_to_code.size();code<size();++code)
+    m_string_to_code.emplace(std::string(get_string_ptr(code), get_string_length(code)), code);
+  m_tmp_string.assign(str, length);
+  auto iter = m_string_to_code.find(m_tmp_string);
+  if(iter != m_string_to_code.end())
+    return (*iter).second;
+  VERIFY_OR_THROW(size() < static_cast<size_t>(INT_MAX) && "Too many distinct strings in dictionary");
+  auto code = static_cast<int>(size());
+  m_data.insert(m_data.end(), str, str+length);
+  m_offsets.push_back(m_data.size());
+  m_string_to_code.emplace(m_tmp_string, code);
+  return code;
+}
+
+void StringDictionary::append_persisted_string(const char* str, const size_t length)
+{
+  m_data.insert(m_data.end(), str, str+length);
+  m_offsets.push_back(m_data.size());
+  mark_persisted();
+}
+
 //VariantArrayCellIterator functions
 VariantArrayCellIterator::VariantArrayCellIterator(TileDB_CTX* tiledb_ctx, const VariantArraySchema& variant_array_schema,
-        const std::string& array_path, const int64_t* range, const std::vector<int>& attribute_ids, const size_t buffer_size)
+        const std::string& array_path, const int64_t* range, const std::vector<int>& attribute_ids, const size_t buffer_size,
+        const std::vector<const StringDictionary*>& dictionaries)
   : m_num_queried_attributes(attribute_ids.size()), m_tiledb_ctx(tiledb_ctx),
-  m_variant_array_schema(&variant_array_schema), m_cell(variant_array_schema, attribute_ids)
+  m_variant_array_schema(&variant_array_schema), m_cell(variant_array_schema, attribute_ids),
+  m_dictionaries(dictionaries)
 #ifdef DO_PROFILING
   , m_tiledb_timer()
   , m_tiledb_to_buffer_cell_timer()
 #endif
 {
+  VERIFY_OR_THROW(m_dictionaries.empty() || m_dictionaries.size() == attribute_ids.size());
   m_buffers.clear();
   std::vector<const char*> attribute_names(attribute_ids.size()+1u);  //+1 for the COORDS
   for(auto i=0ull;i<attribute_ids.size();++i)
@@ -110,6 +148,15 @@ const BufferVariantCell& VariantArrayCellIterator::operator*()
     auto status = tiledb_array_iterator_get_value(m_tiledb_array_iterator, i,
         reinterpret_cast<const void**>(&field_ptr), &field_size);
     VERIFY_OR_THROW(status == TILEDB_OK);
+    //Dictionary encoded attribute - point the cell to the string in the dictionary
+    if(!m_dictionaries.empty() && m_dictionaries[i] && field_size == sizeof(int))
+    {
+      int code = 0;
+      memcpy(&code, field_ptr, sizeof(int));
+      VERIFY_OR_THROW(m_dictionaries[i]->is_valid_code(code) && "Dictionary code out of bounds - dictionary file does not match the array");
+      field_ptr = reinterpret_cast<const uint8_t*>(m_dictionaries[i]->get_string_ptr(code));
+      field_size = m_dictionaries[i]->get_string_length(code);
+    }
     m_cell.set_field_ptr_for_query_idx(i, field_ptr);
     m_cell.set_field_size_in_bytes(i, field_size);
   }
@@ -182,6 +229,10 @@ VariantArrayInfo::VariantArrayInfo(VariantArrayInfo&& other)
     m_buffer_pointers[i] = reinterpret_cast<void*>(&(m_buffers[i][0]));
   m_metadata_contains_max_valid_row_idx_in_array = other.m_metadata_contains_max_valid_row_idx_in_array;
   m_max_valid_row_idx_in_array = other.m_max_valid_row_idx_in_array;
+  m_lightweight_end_copies = other.m_lightweight_end_copies;
+  m_dictionary_encoded_attribute_idxs = std::move(other.m_dictionary_encoded_attribute_idxs);
+  m_dictionaries = std::move(other.m_dictionaries);
+  m_encoded_values = std::move(other.m_encoded_values);
 #ifdef DEBUG
   m_last_row = other.m_last_row;
   m_last_column = other.m_last_column;
@@ -196,6 +247,17 @@ void VariantArrayInfo::write_cell(const void* ptr)
   m_last_row = m_cell.get_row();
   m_last_column = m_cell.get_begin_column();
 #endif
+  //Replace strings of dictionary encoded attributes with their codes
+  for(auto k=0u;k<m_dictionary_encoded_attribute_idxs.size();++k)
+  {
+    auto schema_idx = m_dictionary_encoded_attribute_idxs[k];
+    auto length = m_cell.get_field_size_in_bytes(schema_idx);
+    if(length == 0u)
+      continue;
+    m_encoded_values[k] = m_dictionaries[k].get_or_add_code(m_cell.get_field_ptr_for_query_idx<char>(schema_idx), length);
+    m_cell.set_field_ptr_for_query_idx(schema_idx, &(m_encoded_values[k]));
+    m_cell.set_field_size_in_bytes(schema_idx, sizeof(int));
+  }
   auto buffer_idx = 0ull;
   auto overflow = false;
   //First check if the current cell will fit into the buffers
@@ -261,6 +323,9 @@ void VariantArrayInfo::read_row_bounds_from_metadata()
 {
   //Compute value from array schema
   m_metadata_contains_max_valid_row_idx_in_array = false;
+  m_lightweight_end_copies = false;
+  m_dictionary_encoded_attribute_idxs.clear();
+  m_dictionaries.clear();
   const auto& dim_domains = m_schema.dim_domains();
   m_max_valid_row_idx_in_array = dim_domains[0].second;
   //Try reading from metadata
@@ -279,6 +344,24 @@ void VariantArrayInfo::read_row_bounds_from_metadata()
         m_max_valid_row_idx_in_array = json_doc["max_valid_row_idx_in_array"].GetInt64();
         m_metadata_contains_max_valid_row_idx_in_array = true;
       }
+      if(json_doc.HasMember("lightweight_end_copies") && json_doc["lightweight_end_copies"].IsBool())
+        m_lightweight_end_copies = json_doc["lightweight_end_copies"].GetBool();
+      if(json_doc.HasMember("dictionary_encoded_fields") && json_doc["dictionary_encoded_fields"].IsArray())
+      {
+        const auto& fields = json_doc["dictionary_encoded_fields"];
+        for(rapidjson::SizeType i=0;i<fields.Size();++i)
+        {
+          VERIFY_OR_THROW(fields[i].IsString());
+          auto schema_idx = get_attribute_idx(m_schema, fields[i].GetString());
+          if(schema_idx < 0)
+            throw VariantStorageManagerException(std::string("Dictionary encoded field ")+fields[i].GetString()
+                +" in metadata file "+m_metadata_filename+" is not an attribute of the array");
+          m_dictionary_encoded_attribute_idxs.push_back(schema_idx);
+        }
+        m_dictionaries.resize(m_dictionary_encoded_attribute_idxs.size());
+        m_encoded_values.resize(m_dictionary_encoded_attribute_idxs.size());
+        read_dictionaries();
+      }
     }
   }
 }
@@ -299,6 +382,15 @@ void VariantArrayInfo::update_row_bounds_in_array(TileDB_CTX* tiledb_ctx, const
     json_doc.SetObject();
     json_doc.AddMember("lb_row_idx", lb_row_idx, json_doc.GetAllocator());
     json_doc.AddMember("max_valid_row_idx_in_array", max_valid_row_idx_in_array, json_doc.GetAllocator());
+    if(m_lightweight_end_copies)
+      json_doc.AddMember("lightweight_end_copies", true, json_doc.GetAllocator());
+    if(!m_dictionary_encoded_attribute_idxs.empty())
+    {
+      rapidjson::Value fields(rapidjson::kArrayType);
+      for(auto schema_idx : m_dictionary_encoded_attribute_idxs)
+        fields.PushBack(rapidjson::StringRef(m_schema.attribute_name(schema_idx).c_str()), json_doc.GetAllocator());
+      json_doc.AddMember("dictionary_encoded_fields", fields, json_doc.GetAllocator());
+    }
     rapidjson::StringBuffer buffer;
     rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
     json_doc.Accept(writer);
@@ -309,6 +401,158 @@ void VariantArrayInfo::update_row_bounds_in_array(TileDB_CTX* tiledb_ctx, const
   }
 }
 
+void VariantArrayInfo::enable_lightweight_end_copies(const std::string& metadata_filename)
+{
+  m_lightweight_end_copies = true;
+  //Retain whatever the metadata file already contains
+  rapidjson::Document json_doc;
+  json_doc.SetObject();
+  {
+    std::ifstream ifs(metadata_filename.c_str());
+    if(ifs.is_open())
+    {
+      std::string str((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+      json_doc.Parse(str.c_str());
+      if(json_doc.HasParseError() || !json_doc.IsObject())
+        throw VariantStorageManagerException(std::string("Syntax error in corrupted JSON metadata file ")+metadata_filename);
+    }
+  }
+  if(json_doc.HasMember("lightweight_end_copies"))
+    json_doc["lightweight_end_copies"] = true;
+  else
+    json_doc.AddMember("lightweight_end_copies", true, json_doc.GetAllocator());
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  json_doc.Accept(writer);
+  auto* fptr = fopen(metadata_filename.c_str(), "w");
+  VERIFY_OR_THROW(fptr);
+  fwrite(reinterpret_cast<const void*>(buffer.GetString()), 1u, strlen(buffer.GetString()), fptr);
+  fclose(fptr);
+}
+
+void VariantArrayInfo::enable_dictionary_encoding(const std::string& metadata_filename,
+    const std::vector<std::string>& attribute_names)
+{
+  m_dictionary_encoded_attribute_idxs.clear();
+  for(const auto& name : attribute_names)
+  {
+    auto schema_idx = get_attribute_idx(m_schema, name);
+    if(schema_idx < 0 || !m_schema.is_variable_length_field(schema_idx)
+        || m_schema.type(schema_idx) != std::type_index(typeid(char)))
+      throw VariantStorageManagerException(std::string("Field ")+name
+          +" cannot be dictionary encoded - only variable length string attributes of the array can be");
+    if(std::find(m_dictionary_encoded_attribute_idxs.begin(), m_dictionary_encoded_attribute_idxs.end(), schema_idx)
+        == m_dictionary_encoded_attribute_idxs.end())
+      m_dictionary_encoded_attribute_idxs.push_back(schema_idx);
+  }
+  m_dictionaries.clear();
+  m_dictionaries.resize(m_dictionary_encoded_attribute_idxs.size());
+  m_encoded_values.resize(m_dictionary_encoded_attribute_idxs.size());
+  //Retain whatever the metadata file already contains
+  rapidjson::Document json_doc;
+  json_doc.SetObject();
+  {
+    std::ifstream ifs(metadata_filename.c_str());
+    if(ifs.is_open())
+    {
+      std::string str((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+      json_doc.Parse(str.c_str());
+      if(json_doc.HasParseError() || !json_doc.IsObject())
+        throw VariantStorageManagerException(std::string("Syntax error in corrupted JSON metadata file ")+metadata_filename);
+    }
+  }
+  if(json_doc.HasMember("dictionary_encoded_fields"))
+    json_doc.RemoveMember("dictionary_encoded_fields");
+  rapidjson::Value fields(rapidjson::kArrayType);
+  for(auto schema_idx : m_dictionary_encoded_attribute_idxs)
+    fields.PushBack(rapidjson::StringRef(m_schema.attribute_name(schema_idx).c_str()), json_doc.GetAllocator());
+  json_doc.AddMember("dictionary_encoded_fields", fields, json_doc.GetAllocator());
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  json_doc.Accept(writer);
+  auto* fptr = fopen(metadata_filename.c_str(), "w");
+  VERIFY_OR_THROW(fptr);
+  fwrite(reinterpret_cast<const void*>(buffer.GetString()), 1u, strlen(buffer.GetString()), fptr);
+  fclose(fptr);
+}
+
+const StringDictionary* VariantArrayInfo::get_dictionary(const int schema_idx) const
+{
+  for(auto k=0u;k<m_dictionary_encoded_attribute_idxs.size();++k)
+    if(m_dictionary_encoded_attribute_idxs[k] == schema_idx)
+      return &(m_dictionaries[k]);
+  return 0;
+}
+
+//Dictionaries live next to the metadata file, see GET_DICTIONARIES_PATH
+std::string VariantArrayInfo::get_dictionaries_filename() const
+{
+  return m_metadata_filename.substr(0u, m_metadata_filename.find_last_of('/')+1u)+"genomicsdb_dictionaries.json";
+}
+
+//JSON object - attribute name : list of strings, the position of a string is its code
+void VariantArrayInfo::read_dictionaries()
+{
+  std::ifstream ifs(get_dictionaries_filename().c_str());
+  if(!ifs.is_open()) //nothing written yet
+    return;
+  rapidjson::Document json_doc;
+  std::string str((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  json_doc.Parse(str.c_str());
+  if(json_doc.HasParseError() || !json_doc.IsObject())
+    throw VariantStorageManagerException(std::string("Syntax error in corrupted JSON dictionaries file ")+get_dictionaries_filename());
+  for(auto k=0u;k<m_dictionary_encoded_attribute_idxs.size();++k)
+  {
+    const auto& name = m_schema.attribute_name(m_dictionary_encoded_attribute_idxs[k]);
+    if(!json_doc.HasMember(name.c_str()))
+      continue;
+    const auto& strings = json_doc[name.c_str()];
+    VERIFY_OR_THROW(strings.IsArray());
+    for(rapidjson::SizeType i=0;i<strings.Size();++i)
+    {
+      VERIFY_OR_THROW(strings[i].IsString());
+      m_dictionaries[k].append_persisted_string(strings[i].GetString(), strings[i].GetStringLength());
+    }
+  }
+}
+
+void VariantArrayInfo::write_dictionaries_if_modified()
+{
+  auto modified = false;
+  for(const auto& dictionary : m_dictionaries)
+    modified = modified || dictionary.is_modified();
+  if(!modified)
+    return;
+  rapidjson::Document json_doc;
+  json_doc.SetObject();
+  for(auto k=0u;k<m_dictionary_encoded_attribute_idxs.size();++k)
+  {
+    const auto& dictionary = m_dictionaries[k];
+    rapidjson::Value strings(rapidjson::kArrayType);
+    strings.Reserve(dictionary.size(), json_doc.GetAllocator());
+    for(auto code=0u;code<dictionary.size();++code)
+      strings.PushBack(rapidjson::StringRef(dictionary.get_string_ptr(code), dictionary.get_string_length(code)),
+          json_doc.GetAllocator());
+    json_doc.AddMember(rapidjson::StringRef(m_schema.attribute_name(m_dictionary_encoded_attribute_idxs[k]).c_str()),
+        strings, json_doc.GetAllocator());
+  }
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  json_doc.Accept(writer);
+  //Write to a temporary file and rename - readers never see a partially written dictionary
+  auto filename = get_dictionaries_filename();
+  auto tmp_filename = filename+".tmp";
+  auto* fptr = fopen(tmp_filename.c_str(), "w");
+  VERIFY_OR_THROW(fptr);
+  auto length = buffer.GetSize();
+  auto num_written = fwrite(reinterpret_cast<const void*>(buffer.GetString()), 1u, length, fptr);
+  auto close_status = fclose(fptr);
+  if(num_written != length || close_status != 0 || rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    throw VariantStorageManagerException(std::string("Error while writing dictionaries file ")+filename);
+  for(auto& dictionary : m_dictionaries)
+    dictionary.mark_persisted();
+}
+
 //VariantStorageManager functions
 VariantStorageManager::VariantStorageManager(const std::string& workspace, const unsigned segment_size)
 {
@@ -490,6 +734,7 @@ void VariantStorageManager::delete_array(const std::string& array_name)
   if(array_exists)
   {
     remove(GET_METADATA_PATH(m_workspace, array_name).c_str());
+    remove(GET_DICTIONARIES_PATH(m_workspace, array_name).c_str());
     auto status = tiledb_delete(m_tiledb_ctx, (m_workspace+"/"+array_name).c_str());
     VERIFY_OR_THROW(status == TILEDB_OK);
   }
@@ -574,8 +819,18 @@ VariantArrayCellIterator* VariantStorageManager::begin(
   VERIFY_OR_THROW(static_cast<size_t>(ad) < m_open_arrays_info_vector.size() &&
       m_open_arrays_info_vector[ad].get_array_name().length());
   auto& curr_elem = m_open_arrays_info_vector[ad];
+  std::vector<const StringDictionary*> dictionaries;
+  for(auto i=0u;i<attribute_ids.size();++i)
+  {
+    auto dictionary = curr_elem.get_dictionary(attribute_ids[i]);
+    if(dictionary)
+    {
+      dictionaries.resize(attribute_ids.size(), 0);
+      dictionaries[i] = dictionary;
+    }
+  }
   return new VariantArrayCellIterator(m_tiledb_ctx, curr_elem.get_schema(), m_workspace+'/'+curr_elem.get_array_name(),
-      range, attribute_ids, m_segment_size);   
+      range, attribute_ids, m_segment_size, dictionaries);   
 }
 
 void VariantStorageManager::write_cell_sorted(const int ad, const void* ptr)
@@ -599,3 +854,26 @@ void VariantStorageManager::update_row_bounds_in_array(const int ad, const int64
   m_open_arrays_info_vector[ad].update_row_bounds_in_array(m_tiledb_ctx,
       GET_METADATA_PATH(m_workspace,m_open_arrays_info_vector[ad].get_array_name()), lb_row_idx, max_valid_row_idx_in_array);
 }
+
+void VariantStorageManager::enable_lightweight_end_copies(const int ad)
+{
+  assert(static_cast<size_t>(ad) < m_open_arrays_info_vector.size() &&
+      m_open_arrays_info_vector[ad].get_array_name().length());
+  m_open_arrays_info_vector[ad].enable_lightweight_end_copies(
+      GET_METADATA_PATH(m_workspace,m_open_arrays_info_vector[ad].get_array_name()));
+}
+
+void VariantStorageManager::enable_dictionary_encoding(const int ad, const std::vector<std::string>& attribute_names)
+{
+  assert(static_cast<size_t>(ad) < m_open_arrays_info_vector.size() &&
+      m_open_arrays_info_vector[ad].get_array_name().length());
+  m_open_arrays_info_vector[ad].enable_dictionary_encoding(
+      GET_METADATA_PATH(m_workspace,m_open_arrays_info_vector[ad].get_array_name()), attribute_names);
+}
+
+bool VariantStorageManager::has_lightweight_end_copies(const int ad) const
+{
+  assert(static_cast<size_t>(ad) < m_open_arrays_info_vector.size() &&
+      m_open_arrays_info_vector[ad].get_array_name().length());
+  return m_open_arrays_info_vector[ad].has_lightweight_end_copies();
+}
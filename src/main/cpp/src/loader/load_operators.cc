@@ -92,7 +92,7 @@ void LoaderOperatorBase::check_cell_coordinates(const int64_t row_idx, const int
   //   (b) begins after column partition OR
   //   (c) this is the first cell AND ends before partition
   //   )
-  if(!m_loader_json_config.ignore_cells_not_in_partition() && (outside_row_bounds
+  if(!m_loader_json_config->ignore_cells_not_in_partition() && (outside_row_bounds
         || begins_after_column_partition || (m_first_cell && ends_before_column_partition)
         )
       )
@@ -115,46 +115,62 @@ LoaderArrayWriter::LoaderArrayWriter(
   const VidMapper* id_mapper,
   const std::string& config_filename,
   int rank,
-  const bool vid_mapper_file_required)
+  const bool vid_mapper_file_required,
+  std::shared_ptr<const JSONLoaderConfig> loader_config)
     : LoaderOperatorBase(
         config_filename,
         id_mapper->get_num_callsets(),
         rank,
-        vid_mapper_file_required),
+        vid_mapper_file_required,
+        std::move(loader_config)),
         m_array_descriptor(-1),
         m_schema(0),
         m_storage_manager(0) {
+#ifdef DUPLICATE_CELL_AT_END
+  m_lightweight_end_copies = false;
+#endif
 
-  auto workspace = m_loader_json_config.get_workspace(rank);
-  auto array_name = m_loader_json_config.get_array_name(rank);
+  auto workspace = m_loader_json_config->get_workspace(rank);
+  auto array_name = m_loader_json_config->get_array_name(rank);
   //Schema
-  id_mapper->build_tiledb_array_schema(m_schema, array_name, m_loader_json_config.is_partitioned_by_row(), m_row_partition,
-      m_loader_json_config.compress_tiledb_array());
+  id_mapper->build_tiledb_array_schema(m_schema, array_name, m_loader_json_config->is_partitioned_by_row(), m_row_partition,
+      m_loader_json_config->compress_tiledb_array());
   //Disable synced writes
-  g_TileDB_enable_SYNC_write = m_loader_json_config.disable_synced_writes() ? 0 : 1;
+  g_TileDB_enable_SYNC_write = m_loader_json_config->disable_synced_writes() ? 0 : 1;
   //TileDB compression level
-  g_TileDB_compression_level = m_loader_json_config.get_tiledb_compression_level();
+  g_TileDB_compression_level = m_loader_json_config->get_tiledb_compression_level();
   //Storage manager
-  size_t segment_size = m_loader_json_config.get_segment_size();
+  size_t segment_size = m_loader_json_config->get_segment_size();
   m_storage_manager = new VariantStorageManager(workspace, segment_size);
-  if(m_loader_json_config.delete_and_create_tiledb_array())
+  if(m_loader_json_config->delete_and_create_tiledb_array())
     m_storage_manager->delete_array(array_name);
   //Open array in write mode
   m_array_descriptor = m_storage_manager->open_array(array_name, "w");
   //Check if array already exists
   //Array does not exist - define it first
+  auto array_created = false;
   if(m_array_descriptor < 0)
   {
-    VERIFY_OR_THROW(m_storage_manager->define_array(m_schema, m_loader_json_config.get_num_cells_per_tile()) == TILEDB_OK
+    array_created = true;
+    VERIFY_OR_THROW(m_storage_manager->define_array(m_schema, m_loader_json_config->get_num_cells_per_tile()) == TILEDB_OK
         && "Could not define TileDB array");
     //Open array in write mode
     m_array_descriptor = m_storage_manager->open_array(array_name, "w");
   }
   else
-    if(m_loader_json_config.fail_if_updating())
+    if(m_loader_json_config->fail_if_updating())
       throw LoadOperatorException(std::string("Array ")+workspace + "/" + array_name
           + " exists and flag \"fail_if_updating\" is set to true in the loader JSON configuration");
   VERIFY_OR_THROW(m_array_descriptor != -1 && "Could not open TileDB array for loading");
+  //Like the END copy mode, dictionary encoding is fixed when the array is created
+  if(array_created && !m_loader_json_config->get_dictionary_encoded_fields().empty())
+    m_storage_manager->enable_dictionary_encoding(m_array_descriptor, m_loader_json_config->get_dictionary_encoded_fields());
+#ifdef DUPLICATE_CELL_AT_END
+  //The END copy mode is recorded in the metadata when the array is created - updates follow the array, not the config
+  if(array_created && m_loader_json_config->use_lightweight_end_copies())
+    m_storage_manager->enable_lightweight_end_copies(m_array_descriptor);
+  m_lightweight_end_copies = m_storage_manager->has_lightweight_end_copies(m_array_descriptor);
+#endif
   m_storage_manager->update_row_bounds_in_array(m_array_descriptor, m_row_partition.first,
       std::min(m_row_partition.second, id_mapper->get_max_callset_row_idx()));
 }
@@ -179,12 +195,70 @@ void LoaderArrayWriter::write_top_element_to_disk()
     *(reinterpret_cast<int64_t*>(copy_ptr+sizeof(int64_t))) = top_element.m_begin_column;
     //END is after co-ordinates and cell_size
     *(reinterpret_cast<int64_t*>(copy_ptr+2*sizeof(int64_t)+sizeof(size_t))) = top_element.m_end_column;
+    if(m_lightweight_end_copies)
+      strip_payload_from_end_copy(copy_ptr);
     //Add to PQ again
     m_cell_wrapper_pq.push(top_element);
   }
   else  //no need to keep this cell anymore, free "heap"
     m_memory_manager.push(idx_in_vector);
 }
+
+template<class T>
+static size_t fill_with_tiledb_null_values(uint8_t* ptr, const int num_elements)
+{
+  for(auto i=0;i<num_elements;++i)
+    *(reinterpret_cast<T*>(ptr+i*sizeof(T))) = get_tiledb_null_value<T>();
+  return num_elements*sizeof(T);
+}
+
+void LoaderArrayWriter::strip_payload_from_end_copy(uint8_t* copy_ptr) const
+{
+  assert(m_schema && m_schema->attribute_num() > 0u);
+  //END is the first attribute - starts after co-ordinates and cell_size
+  //The new layout is never larger than the old one, so the buffer is rewritten in place
+  size_t offset = 2*sizeof(int64_t)+sizeof(size_t)+sizeof(int64_t);
+  for(auto i=VARIANT_ARRAY_SCHEMA_END_IDX+1u;i<m_schema->attribute_num();++i)
+  {
+    //Variable length field - #elements = 0
+    if(m_schema->is_variable_length_field(i))
+    {
+      *(reinterpret_cast<int*>(copy_ptr+offset)) = 0;
+      offset += sizeof(int);
+      continue;
+    }
+    auto num_elements = m_schema->val_num(i);
+    switch(VariantFieldTypeUtil::get_variant_field_type_enum_for_variant_field_type(m_schema->type(i)))
+    {
+      case VARIANT_FIELD_INT:
+        offset += fill_with_tiledb_null_values<int>(copy_ptr+offset, num_elements);
+        break;
+      case VARIANT_FIELD_UNSIGNED:
+        offset += fill_with_tiledb_null_values<unsigned>(copy_ptr+offset, num_elements);
+        break;
+      case VARIANT_FIELD_INT64_T:
+        offset += fill_with_tiledb_null_values<int64_t>(copy_ptr+offset, num_elements);
+        break;
+      case VARIANT_FIELD_UINT64_T:
+        offset += fill_with_tiledb_null_values<uint64_t>(copy_ptr+offset, num_elements);
+        break;
+      case VARIANT_FIELD_FLOAT:
+        offset += fill_with_tiledb_null_values<float>(copy_ptr+offset, num_elements);
+        break;
+      case VARIANT_FIELD_DOUBLE:
+        offset += fill_with_tiledb_null_values<double>(copy_ptr+offset, num_elements);
+        break;
+      case VARIANT_FIELD_CHAR:
+        offset += fill_with_tiledb_null_values<char>(copy_ptr+offset, num_elements);
+        break;
+      default:
+        throw LoadOperatorException(std::string("Unhandled type for attribute ")+m_schema->attribute_name(i)
+            +" while creating END copy of cell");
+    }
+  }
+  //cell size is after co-ordinates
+  *(reinterpret_cast<size_t*>(copy_ptr+2*sizeof(int64_t))) = offset;
+}
 #endif
 
 void LoaderArrayWriter::operate(const void* cell_ptr)
@@ -307,18 +381,20 @@ void LoaderArrayWriter::finish(const int64_t column_interval_end)
     write_top_element_to_disk();
 #endif
   if(m_storage_manager && m_array_descriptor >= 0)
-    m_storage_manager->close_array(m_array_descriptor, m_loader_json_config.consolidate_tiledb_array_after_load());
+    m_storage_manager->close_array(m_array_descriptor, m_loader_json_config->consolidate_tiledb_array_after_load());
 }
 
 #ifdef HTSDIR
 LoaderCombinedGVCFOperator::LoaderCombinedGVCFOperator(const VidMapper* id_mapper, const std::string& config_filename,
-    bool handle_spanning_deletions, int partition_idx, const ColumnRange& partition_range)
-  : LoaderOperatorBase(config_filename, id_mapper->get_num_callsets(), partition_idx), m_schema(0), m_query_processor(0), m_operator(0)
+    bool handle_spanning_deletions, int partition_idx, const ColumnRange& partition_range,
+    std::shared_ptr<const JSONLoaderConfig> loader_config)
+  : LoaderOperatorBase(config_filename, id_mapper->get_num_callsets(), partition_idx, true, std::move(loader_config)),
+  m_schema(0), m_query_processor(0), m_operator(0)
 {
   clear(); 
   //Loader configuration
-  if(!m_loader_json_config.is_partitioned_by_row())
-    m_column_partition = m_loader_json_config.get_column_partition(partition_idx);
+  if(!m_loader_json_config->is_partitioned_by_row())
+    m_column_partition = m_loader_json_config->get_column_partition(partition_idx);
   //initialize arguments
   m_vid_mapper = id_mapper;
   //initialize query processor
@@ -331,7 +407,7 @@ LoaderCombinedGVCFOperator::LoaderCombinedGVCFOperator(const VidMapper* id_mappe
   m_query_config.set_attributes_to_query(query_attributes);
   m_query_processor->do_query_bookkeeping(*m_schema, m_query_config, *m_vid_mapper, true);
   //Initialize VCF adapter
-  if(m_loader_json_config.offload_vcf_output_processing())
+  if(m_loader_json_config->offload_vcf_output_processing())
   {
     m_offload_vcf_output_processing = true;
     //2 entries in circular buffer, max #entries to use in each line_buffer
@@ -64,19 +64,41 @@ VCF2TileDBLoaderConverterBase::VCF2TileDBLoaderConverterBase(
   const int64_t lb_callset_row_idx,
   const int64_t ub_callset_row_idx,
   bool vid_mapper_file_required)
-  : JSONLoaderConfig(vid_mapper_file_required)
 {
   clear();
   m_idx = idx;
-  JSONLoaderConfig::read_from_file(config_filename, 0, m_idx);
+  auto loader_config = std::make_shared<JSONLoaderConfig>(vid_mapper_file_required);
+  loader_config->read_from_file(config_filename, 0, m_idx);
+  m_loader_config = loader_config;
+  initialize_from_loader_config(lb_callset_row_idx, ub_callset_row_idx);
+}
+
+VCF2TileDBLoaderConverterBase::VCF2TileDBLoaderConverterBase(
+  std::shared_ptr<const JSONLoaderConfig> loader_config,
+  int idx,
+  const int64_t lb_callset_row_idx,
+  const int64_t ub_callset_row_idx)
+  : m_loader_config(std::move(loader_config))
+{
+  VERIFY_OR_THROW(m_loader_config);
+  clear();
+  m_idx = idx;
+  initialize_from_loader_config(lb_callset_row_idx, ub_callset_row_idx);
+}
+
+void VCF2TileDBLoaderConverterBase::initialize_from_loader_config(const int64_t lb_callset_row_idx,
+    const int64_t ub_callset_row_idx)
+{
   //Override
-  m_lb_callset_row_idx = std::max(lb_callset_row_idx, m_lb_callset_row_idx);
-  m_ub_callset_row_idx = std::min(ub_callset_row_idx, m_ub_callset_row_idx);
-  if(m_produce_combined_vcf && m_row_based_partitioning)
+  auto row_bounds = m_loader_config->get_row_bounds();
+  m_lb_callset_row_idx = std::max(lb_callset_row_idx, row_bounds.first);
+  m_ub_callset_row_idx = std::min(ub_callset_row_idx, row_bounds.second);
+  if(m_loader_config->produce_combined_vcf() && m_loader_config->is_partitioned_by_row())
     throw VCF2TileDBException("Cannot partition by rows and produce combined gVCF");
+  m_max_size_per_callset = 0;
   //Size circular buffers - 3 needed in non-standalone converter mode
-  auto num_circular_buffers = m_do_ping_pong_buffering ? 3u : 1u;
-  auto num_exchanges = m_do_ping_pong_buffering ? 2u : 1u;
+  auto num_circular_buffers = m_loader_config->do_ping_pong_buffering() ? 3u : 1u;
+  auto num_exchanges = m_loader_config->do_ping_pong_buffering() ? 2u : 1u;
   resize_circular_buffers(num_circular_buffers);
   //Exchange structure
   m_owned_exchanges.resize(num_exchanges);
@@ -84,8 +106,6 @@ VCF2TileDBLoaderConverterBase::VCF2TileDBLoaderConverterBase(
 
 void VCF2TileDBLoaderConverterBase::clear()
 {
-  m_vid_mapping_file.clear();
-  m_callset_mapping_file.clear();
   m_ping_pong_buffers.clear();
   m_owned_exchanges.clear();
   m_num_callsets_in_owned_file.clear();
@@ -95,7 +115,7 @@ void VCF2TileDBLoaderConverterBase::clear()
 void VCF2TileDBLoaderConverterBase::determine_num_callsets_owned(const VidMapper* vid_mapper, const bool from_loader)
 {
   //If standalone or row partitioning, deal only with subset of files assigned to this converter
-  if((!from_loader && m_standalone_converter_process) || m_row_based_partitioning)
+  if((!from_loader && m_loader_config->is_standalone_converter_process()) || m_loader_config->is_partitioned_by_row())
   {
     //Get list of files handled by this converter
     auto& global_file_idx_vec = vid_mapper->get_global_file_idxs_owned_by(m_idx);
@@ -136,23 +156,60 @@ VCF2TileDBConverter::VCF2TileDBConverter(
   VidMapper* vid_mapper,
   std::vector<std::vector<uint8_t>>* buffers,
   std::vector<LoaderConverterMessageExchange>* exchange_vector,
-  bool vid_mapper_file_required)
+  bool vid_mapper_file_required,
+  bool all_column_partitions)
   : VCF2TileDBLoaderConverterBase(
       config_filename,
       idx,
       0,
       INT64_MAX-1,
       vid_mapper_file_required) {
+  m_all_column_partitions = all_column_partitions;
+  common_constructor_initialization(vid_mapper, buffers, exchange_vector);
+}
 
+VCF2TileDBConverter::VCF2TileDBConverter(
+  std::shared_ptr<const JSONLoaderConfig> loader_config,
+  int idx,
+  VidMapper* vid_mapper,
+  std::vector<std::vector<uint8_t>>* buffers,
+  std::vector<LoaderConverterMessageExchange>* exchange_vector,
+  bool all_column_partitions)
+  : VCF2TileDBLoaderConverterBase(
+      std::move(loader_config),
+      idx,
+      0,
+      INT64_MAX-1) {
+  m_all_column_partitions = all_column_partitions;
+  common_constructor_initialization(vid_mapper, buffers, exchange_vector);
+}
+
+void VCF2TileDBConverter::common_constructor_initialization(
+  VidMapper* vid_mapper,
+  std::vector<std::vector<uint8_t>>* buffers,
+  std::vector<LoaderConverterMessageExchange>* exchange_vector)
+{
   m_vid_mapper = 0;
   clear();
+  //BGZF blocks of input files are decompressed ahead of parsing by the pool threads
+  m_htslib_thread_pool.pool = 0;
+  m_htslib_thread_pool.qsize = 0;
+  auto num_htslib_decompression_threads = m_loader_config->get_num_htslib_decompression_threads();
+  if(num_htslib_decompression_threads > 0)
+  {
+    m_htslib_thread_pool.pool = hts_tpool_init(num_htslib_decompression_threads);
+    VERIFY_OR_THROW(m_htslib_thread_pool.pool && "Could not create htslib thread pool");
+  }
+  //Files closed at the end of a batch stay open (up to the pool size) - re-opening skips header and index parsing
+  auto vcf_handle_pool_size = m_loader_config->get_vcf_handle_pool_size();
+  m_vcf_handle_pool = (vcf_handle_pool_size > 0u) ? new VCFReaderHandlePool(vcf_handle_pool_size) : 0;
   //Converter processes run independent of loader when num_converter_processes > 0
-  if(m_standalone_converter_process)
+  if(m_loader_config->is_standalone_converter_process())
   {
-    VERIFY_OR_THROW(m_idx < m_num_converter_processes);
+    VERIFY_OR_THROW(m_idx < m_loader_config->get_num_converter_processes());
     //For standalone processes, must initialize VidMapper
-    m_vid_mapper = static_cast<VidMapper*>(new FileBasedVidMapper(m_vid_mapping_file, m_callset_mapping_file,
-          m_lb_callset_row_idx, m_ub_callset_row_idx, true));
+    m_vid_mapper = static_cast<VidMapper*>(new FileBasedVidMapper(m_loader_config->get_vid_mapping_filename(),
+          m_loader_config->get_callset_mapping_filename(), m_lb_callset_row_idx, m_ub_callset_row_idx, true));
     m_vid_mapper->verify_file_partitioning();
     //2 entries sufficient
     resize_circular_buffers(2u);
@@ -182,13 +239,13 @@ VCF2TileDBConverter::VCF2TileDBConverter(
       m_exchanges[i] = &((*exchange_vector)[i]);
   }
   determine_num_callsets_owned(m_vid_mapper, false);
-  m_max_size_per_callset = m_per_partition_size/m_num_callsets_owned;
+  m_max_size_per_callset = m_loader_config->get_per_partition_size()/m_num_callsets_owned;
   initialize_file2binary_objects();
   initialize_column_batch_objects();
   //Increase capacity to maximum once
   m_exhausted_buffer_stream_identifiers.reserve(m_file2binary_handlers.size()*m_partition_batch.size());
   //For standalone converter objects, allocate ping-pong buffers and exchange objects
-  if(m_standalone_converter_process)
+  if(m_loader_config->is_standalone_converter_process())
   {
     for(auto& x : m_ping_pong_buffers)
       x.resize(m_max_size_per_callset*m_num_callsets_owned*m_partition_batch.size());
@@ -206,9 +263,16 @@ VCF2TileDBConverter::~VCF2TileDBConverter()
     ptr = 0;
   }
   clear();
-  if(m_standalone_converter_process && m_vid_mapper)
+  if(m_loader_config->is_standalone_converter_process() && m_vid_mapper)
     delete m_vid_mapper;
   m_vid_mapper = 0;
+  //Readers using the pools are deleted above
+  if(m_vcf_handle_pool)
+    delete m_vcf_handle_pool;
+  m_vcf_handle_pool = 0;
+  if(m_htslib_thread_pool.pool)
+    hts_tpool_destroy(m_htslib_thread_pool.pool);
+  m_htslib_thread_pool.pool = 0;
 }
 
 void VCF2TileDBConverter::clear()
@@ -232,9 +296,12 @@ File2TileDBBinaryBase* VCF2TileDBConverter::create_file2tiledb_object(const File
             file_info.m_name, m_vcf_fields, local_file_idx, *m_vid_mapper,
             partition_bounds,
             m_max_size_per_callset,
-            m_treat_deletions_as_intervals,
-            false, false, false, m_discard_vcf_index
+            m_loader_config->treat_deletions_as_intervals(),
+            false, false, false, m_loader_config->discard_vcf_index(),
+            m_htslib_thread_pool.pool ? &m_htslib_thread_pool : 0,
+            m_vcf_handle_pool
             ));
+      dynamic_cast<VCF2Binary*>(file2binary_base_ptr)->set_reference_block_gq_bands(m_loader_config->get_reference_block_gq_bands());
       break;
     case VidFileTypeEnum::VCF_BUFFER_STREAM_TYPE:
     case VidFileTypeEnum::BCF_BUFFER_STREAM_TYPE:
@@ -247,7 +314,7 @@ File2TileDBBinaryBase* VCF2TileDBConverter::create_file2tiledb_object(const File
             file_info.m_buffer_capacity, (file_info.m_type == VidFileTypeEnum::BCF_BUFFER_STREAM_TYPE),
             &(file_info.m_initialization_buffer[0]), file_info.m_initialization_buffer_num_valid_bytes,
             m_max_size_per_callset,
-            m_treat_deletions_as_intervals
+            m_loader_config->treat_deletions_as_intervals()
           ));
       break;
     case VidFileTypeEnum::SORTED_CSV_FILE_TYPE:
@@ -256,7 +323,7 @@ File2TileDBBinaryBase* VCF2TileDBConverter::create_file2tiledb_object(const File
             file_info.m_name, local_file_idx, *m_vid_mapper,
             m_max_size_per_callset,
             partition_bounds,
-            m_treat_deletions_as_intervals,
+            m_loader_config->treat_deletions_as_intervals(),
             false, false, false
             ));
       break;
@@ -272,34 +339,60 @@ void VCF2TileDBConverter::initialize_file2binary_objects()
   //VCF fields
   m_vid_mapper->build_vcf_fields_vectors(m_vcf_fields);
   //If standalone or row partitioning, deal only with subset of files assigned to this converter
-  if(m_standalone_converter_process || m_row_based_partitioning)
+  std::vector<int64_t> global_file_idx_vec;
+  std::vector<ColumnRange> partition_bounds;
+  if(m_loader_config->is_standalone_converter_process() || m_loader_config->is_partitioned_by_row())
   {
-    auto partition_bounds = m_row_based_partitioning ? std::vector<ColumnRange>(1u, ColumnRange(0, INT64_MAX)) //row partition - single column range
-            : get_sorted_column_partitions();
+    VERIFY_OR_THROW(!m_all_column_partitions && "Single pass over all partitions not supported for standalone converters or row partitioning");
+    partition_bounds = m_loader_config->is_partitioned_by_row() ? std::vector<ColumnRange>(1u, ColumnRange(0, INT64_MAX)) //row partition - single column range
+            : m_loader_config->get_sorted_column_partitions();
     //Get list of files handled by this converter
-    auto& global_file_idx_vec = m_vid_mapper->get_global_file_idxs_owned_by(m_idx);
-    for(auto i=0ull;i<global_file_idx_vec.size();++i)
-    {
-      auto global_file_idx = global_file_idx_vec[i];
-      assert(static_cast<size_t>(m_vid_mapper->get_file_info(global_file_idx).m_local_file_idx) == i);
-      m_file2binary_handlers.emplace_back(create_file2tiledb_object(m_vid_mapper->get_file_info(global_file_idx), i, partition_bounds));
-    }
+    global_file_idx_vec = m_vid_mapper->get_global_file_idxs_owned_by(m_idx);
   }
   else
   {
     //Same process as loader - must read all files
     //Also, only 1 partition needs to be handled  - the column partition corresponding to the loader
-    auto partition_bounds = std::vector<ColumnRange>(1u, get_column_partition());
+    //When splitting files in a single pass, every partition is handled
+    partition_bounds = m_all_column_partitions ? m_loader_config->get_sorted_column_partitions()
+      : std::vector<ColumnRange>(1u, get_column_partition());
+    global_file_idx_vec.resize(m_vid_mapper->get_num_files());
     for(auto i=0ll;i<m_vid_mapper->get_num_files();++i)
-      m_file2binary_handlers.emplace_back(create_file2tiledb_object(m_vid_mapper->get_file_info(i), i, partition_bounds));
+      global_file_idx_vec[i] = i;
   }
+  //Headers are read and mapped to the vid mapping while constructing the handlers - done in parallel
+  //VidMapper is only queried here, so sharing it across threads is safe
+  m_file2binary_handlers.resize(global_file_idx_vec.size(), 0);
+  std::string error_message;
+#pragma omp parallel for default(shared) num_threads(m_loader_config->get_num_parallel_vcf_files()) schedule(dynamic)
+  for(auto i=0ull;i<global_file_idx_vec.size();++i)
+  {
+    auto global_file_idx = global_file_idx_vec[i];
+    assert(!(m_loader_config->is_standalone_converter_process() || m_loader_config->is_partitioned_by_row())
+        || static_cast<size_t>(m_vid_mapper->get_file_info(global_file_idx).m_local_file_idx) == i);
+    //Exceptions cannot propagate out of the parallel region
+    try
+    {
+      m_file2binary_handlers[i] = create_file2tiledb_object(m_vid_mapper->get_file_info(global_file_idx), i, partition_bounds);
+    }
+    catch(const std::exception& e)
+    {
+#pragma omp critical
+      {
+        if(error_message.empty())
+          error_message = e.what();
+      }
+    }
+  }
+  if(!error_message.empty())
+    throw VCF2TileDBException(error_message);
 }
 
 void VCF2TileDBConverter::initialize_column_batch_objects()
 {
   //If standalone converter process, initialize for all partitions
   //Else only allocate single column partition idx corresponding to the loader
-  auto num_column_partitions = m_standalone_converter_process ? get_sorted_column_partitions().size()
+  auto num_column_partitions = m_loader_config->is_standalone_converter_process() ? m_loader_config->get_sorted_column_partitions().size()
     : 1u;
   for(auto i=0u;i<num_column_partitions;++i)
     m_partition_batch.emplace_back(i, m_max_size_per_callset, m_num_callsets_in_owned_file, m_num_entries_in_circular_buffer);
@@ -337,7 +430,7 @@ void VCF2TileDBConverter::activate_next_batch(const unsigned exchange_idx, const
     auto row_idx = all_partitions_tiledb_row_idx_vec[idx_offset+i];
     int64_t local_file_idx = -1;
     //For non-standalone converters, global_file_idx == local_file_idx
-    auto status = (m_standalone_converter_process || m_row_based_partitioning)
+    auto status = (m_loader_config->is_standalone_converter_process() || m_loader_config->is_partitioned_by_row())
       ? m_vid_mapper->get_local_file_idx_for_row(row_idx, local_file_idx)
       : m_vid_mapper->get_global_file_idx_for_row(row_idx, local_file_idx);
     assert(status && local_file_idx >= 0 && static_cast<size_t>(local_file_idx) < m_file2binary_handlers.size());
@@ -345,7 +438,7 @@ void VCF2TileDBConverter::activate_next_batch(const unsigned exchange_idx, const
     m_partition_batch[partition_idx].activate_file(local_file_idx);
   }
   //Compute offsets in buffer if standalone, otherwise maintain offsets computed during initialization
-  if(m_standalone_converter_process)
+  if(m_loader_config->is_standalone_converter_process())
     m_partition_batch[partition_idx].update_buffer_offsets();
 }
 
@@ -370,7 +463,7 @@ void VCF2TileDBConverter::read_next_batch(const unsigned exchange_idx)
   size_t num_exhausted_buffer_streams = 0u;
   m_exhausted_buffer_stream_identifiers.resize(m_exhausted_buffer_stream_identifiers.capacity());
   //Set upper bound on #files to process in parallel
-#pragma omp parallel for default(shared) num_threads(m_num_parallel_vcf_files)
+#pragma omp parallel for default(shared) num_threads(m_loader_config->get_num_parallel_vcf_files())
   for(auto i=0u;i<m_file2binary_handlers.size();++i)
   {
     //#pragma omp critical
@@ -383,7 +476,7 @@ void VCF2TileDBConverter::read_next_batch(const unsigned exchange_idx)
   //No re-allocation as capacity doesn't change
   m_exhausted_buffer_stream_identifiers.resize(num_exhausted_buffer_streams);
   //For non-standalone converter processes, must simply advance read idx
-  if(!m_standalone_converter_process)
+  if(!m_loader_config->is_standalone_converter_process())
     for(auto& partition_batch : m_partition_batch)
       partition_batch.advance_read_idxs();
   curr_exchange.m_is_serviced = true;
@@ -419,7 +512,7 @@ void VCF2TileDBConverter::dump_latest_buffer(unsigned exchange_idx, std::ostream
           m_vid_mapper->get_local_file_idx_for_row(row_idx, local_file_idx);
         assert(status);
         auto& file_batch = m_partition_batch[partition_idx].get_partition_file_batch(local_file_idx);
-        auto order = m_standalone_converter_process ? i : m_tiledb_row_idx_to_order[row_idx];
+        auto order = m_loader_config->is_standalone_converter_process() ? i : m_tiledb_row_idx_to_order[row_idx];
         assert(order >= 0);
         auto offset = m_partition_batch[partition_idx].get_partition_begin_offset() + order*m_max_size_per_callset;
         for(auto j=0ll;j<m_max_size_per_callset;++j)
@@ -450,15 +543,32 @@ void VCF2TileDBConverter::create_and_print_histogram(const std::string& config_f
   uint64_t max_histogram_range = json_doc["max_histogram_range"].GetInt64();
   VERIFY_OR_THROW(json_doc.HasMember("num_bins") && json_doc["num_bins"].IsInt64());
   unsigned num_bins = json_doc["num_bins"].GetInt64();
+  //Estimate counts from the index of each file instead of reading all records
+  auto histogram_from_index = false;
+  if(json_doc.HasMember("histogram_from_index"))
+  {
+    VERIFY_OR_THROW(json_doc["histogram_from_index"].IsBool());
+    histogram_from_index = json_doc["histogram_from_index"].GetBool();
+  }
+  //#densest bins per file whose counts are obtained by reading records in index mode
+  unsigned histogram_num_bins_to_sample = 0u;
+  if(json_doc.HasMember("histogram_num_bins_to_sample"))
+  {
+    VERIFY_OR_THROW(json_doc["histogram_num_bins_to_sample"].IsInt64());
+    histogram_num_bins_to_sample = json_doc["histogram_num_bins_to_sample"].GetInt64();
+  }
   //Combined histogram
   UniformHistogram* combined_histogram =
     new UniformHistogram(0ull, max_histogram_range, num_bins);
 #pragma omp declare reduction ( l0_sum_up : UniformHistogram* : omp_out->sum_up_histogram(omp_in) ) \
   initializer(omp_priv = new UniformHistogram(*omp_orig))
-#pragma omp parallel for default(shared) num_threads(m_num_parallel_vcf_files) reduction(l0_sum_up : combined_histogram)
+#pragma omp parallel for default(shared) num_threads(m_loader_config->get_num_parallel_vcf_files()) reduction(l0_sum_up : combined_histogram)
   for(auto i=0u;i<m_file2binary_handlers.size();++i)
   {
-    m_file2binary_handlers[i]->create_histogram(max_histogram_range, num_bins);
+    if(histogram_from_index)
+      m_file2binary_handlers[i]->create_histogram_from_index(max_histogram_range, num_bins, histogram_num_bins_to_sample);
+    else
+      m_file2binary_handlers[i]->create_histogram(max_histogram_range, num_bins);
     combined_histogram->sum_up_histogram(m_file2binary_handlers[i]->get_histogram());
   }
   combined_histogram->print(fptr);
@@ -467,11 +577,23 @@ void VCF2TileDBConverter::create_and_print_histogram(const std::string& config_f
 
 void VCF2TileDBConverter::print_all_partitions(const std::string& results_directory, const std::string& output_type, const int rank)
 {
-#pragma omp parallel for default(shared) num_threads(m_num_parallel_vcf_files)
+#pragma omp parallel for default(shared) num_threads(m_loader_config->get_num_parallel_vcf_files())
   for(auto i=0u;i<m_file2binary_handlers.size();++i)
     m_file2binary_handlers[i]->print_all_partitions(results_directory, output_type, rank, true);
 }
 
+void VCF2TileDBConverter::print_all_partitions_single_pass(const std::string& results_directory, const std::string& output_type)
+{
+  VERIFY_OR_THROW(m_all_column_partitions && "Converter must be constructed with all_column_partitions=true");
+  //Handlers built in the constructor span all partitions - headers were parsed once there
+#pragma omp parallel for default(shared) num_threads(m_loader_config->get_num_parallel_vcf_files())
+  for(auto i=0u;i<m_file2binary_handlers.size();++i)
+  {
+    m_file2binary_handlers[i]->set_single_pass_partitions(true);
+    m_file2binary_handlers[i]->print_all_partitions(results_directory, output_type, -1, true);
+  }
+}
+
 #endif //ifdef HTSLIB
 
 //Loader functions
@@ -549,7 +671,6 @@ void VCF2TileDBLoader::common_constructor_initialization(
   m_previous_cell_row_idx = -1;
   m_previous_cell_column = -1;
   clear();
-  m_vid_mapper_file_required = true;
   if (using_vidmap_protobuf) {
     assert (vidmap_pb != NULL);
     assert (callsetmap_pb != NULL);
@@ -557,26 +678,25 @@ void VCF2TileDBLoader::common_constructor_initialization(
         new ProtoBufBasedVidMapper(vidmap_pb,
           callsetmap_pb,
           buffer_stream_info_vec));
-    m_vid_mapper_file_required = false;
   } else {
     m_vid_mapper = static_cast<VidMapper*>(
         new FileBasedVidMapper(
-          m_vid_mapping_file,
+          m_loader_config->get_vid_mapping_filename(),
           buffer_stream_info_vec,
-          m_callset_mapping_file,
+          m_loader_config->get_callset_mapping_filename(),
           buffer_stream_callset_mapping_json_string,
           m_lb_callset_row_idx, m_ub_callset_row_idx,
           true));
   }
   //partition files
-  if(m_row_based_partitioning)
-    m_vid_mapper->build_file_partitioning(m_idx, get_row_partition(idx));
-  if(m_standalone_converter_process)
+  if(m_loader_config->is_partitioned_by_row())
+    m_vid_mapper->build_file_partitioning(m_idx, m_loader_config->get_row_partition(idx));
+  if(m_loader_config->is_standalone_converter_process())
     m_vid_mapper->verify_file_partitioning();
   determine_num_callsets_owned(m_vid_mapper, true);
-  m_max_size_per_callset = m_per_partition_size/m_num_callsets_owned;
+  m_max_size_per_callset = m_loader_config->get_per_partition_size()/m_num_callsets_owned;
   //Converter processes run independent of loader when num_converter_processes > 0
-  if(m_standalone_converter_process)
+  if(m_loader_config->is_standalone_converter_process())
   {
     resize_circular_buffers(4u);
     //Allocate exchange objects
@@ -584,13 +704,13 @@ void VCF2TileDBLoader::common_constructor_initialization(
   else
   { 
 #ifdef HTSDIR
+    //Converter shares this object's parsed configuration and vid mapper
     m_converter = new VCF2TileDBConverter(
-                    config_filename,
+                    m_loader_config,
                     idx,
                     m_vid_mapper,
                     &m_ping_pong_buffers,
-                    &m_owned_exchanges,
-                    m_vid_mapper_file_required);
+                    &m_owned_exchanges);
 #endif
     //Num order values
     auto num_order_values = get_num_order_values();
@@ -605,7 +725,7 @@ void VCF2TileDBLoader::common_constructor_initialization(
   }
   //Allocate buffers
   for(auto i=0u;i<m_ping_pong_buffers.size();++i)
-    m_ping_pong_buffers[i].resize(m_per_partition_size);
+    m_ping_pong_buffers[i].resize(m_loader_config->get_per_partition_size());
   //Num order values
   auto num_order_values = get_num_order_values();
   //Circular buffer control
@@ -622,26 +742,27 @@ void VCF2TileDBLoader::common_constructor_initialization(
   }
   m_num_operators_overflow_in_last_round = 0u;
 #ifdef PRODUCE_BINARY_CELLS
-  if(m_produce_combined_vcf)
+  if(m_loader_config->produce_combined_vcf())
   {
 #ifdef HTSDIR
     //Operators
     m_operators.push_back(dynamic_cast<LoaderOperatorBase*>(
-          new LoaderCombinedGVCFOperator(m_vid_mapper, config_filename, m_treat_deletions_as_intervals, m_idx,
-            get_column_partition())));
+          new LoaderCombinedGVCFOperator(m_vid_mapper, config_filename, m_loader_config->treat_deletions_as_intervals(), m_idx,
+            get_column_partition(), m_loader_config)));
     m_operators_overflow.push_back(false);
 #else
     throw VCF2TileDBException("To produce VCFs, you need the htslib library - recompile with HTSDIR set");
 #endif //ifdef HTSDIR
   }
-  if(m_produce_tiledb_array)
+  if(m_loader_config->produce_tiledb_array())
   {
     m_operators.push_back(dynamic_cast<LoaderOperatorBase*>(
           new LoaderArrayWriter(
             m_vid_mapper,
             config_filename,
             m_idx,
-            m_vid_mapper_file_required)));
+            m_loader_config->is_vid_mapper_file_required(),
+            m_loader_config)));
     m_operators_overflow.push_back(false);
   }
 #endif //ifdef PRODUCE_BINARY_CELLS
@@ -650,7 +771,7 @@ void VCF2TileDBLoader::common_constructor_initialization(
 #ifdef HTSDIR
 void VCF2TileDBLoader::read_all()
 {
-  VCF2TileDBLoaderReadState read_state(m_owned_exchanges.size(), m_do_ping_pong_buffering, m_offload_vcf_output_processing);
+  VCF2TileDBLoaderReadState read_state(m_owned_exchanges.size(), m_loader_config->do_ping_pong_buffering(), m_loader_config->offload_vcf_output_processing());
   read_all(read_state);
   finish_read_all(read_state);
 }
@@ -711,7 +832,7 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
         //std::cerr << "Fetch thread id "<<omp_get_thread_num()<<" level "<<omp_get_active_level()<<"\n";
         fetch_timer.start();
         m_converter->read_next_batch(fetch_exchange_counter);
-        if(!m_do_ping_pong_buffering)
+        if(!m_loader_config->do_ping_pong_buffering())
           advance_write_idxs(fetch_exchange_counter);
         fetch_timer.stop();
       }
@@ -729,7 +850,7 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
         load_timer.stop();
       }
 #pragma omp section
-      if(m_offload_vcf_output_processing)
+      if(m_loader_config->offload_vcf_output_processing())
       {
         flush_output_timer.start();
         for(auto op : m_operators)
@@ -741,7 +862,7 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
     {
       sections_timer.stop();
       single_thread_phase_timer.start();
-      if(m_do_ping_pong_buffering)
+      if(m_loader_config->do_ping_pong_buffering())
         advance_write_idxs(fetch_exchange_counter);
       for(auto op : m_operators)
         op->post_operate_sequential();
@@ -951,7 +1072,7 @@ bool VCF2TileDBLoader::produce_cells_in_column_major_order(unsigned exchange_idx
           +std::to_string(m_previous_cell_row_idx)+", "+std::to_string(m_previous_cell_column)
           +" ] current cell: [ "+std::to_string(row_idx)+", "+std::to_string(column)+" ]");
     auto skip_cell = (column > get_column_partition_end());
-    if(skip_cell && !m_ignore_cells_not_in_partition)
+    if(skip_cell && !m_loader_config->ignore_cells_not_in_partition())
       throw VCF2TileDBException(std::string("Found cell that does not belong to the current partition. Partition bounds: [ ")
             + std::to_string(get_column_partition_begin()) + ", "
             + std::to_string(get_column_partition_end()) + " ] - current cell [ "
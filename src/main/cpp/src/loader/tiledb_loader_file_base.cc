@@ -215,6 +215,7 @@ File2TileDBBinaryBase::File2TileDBBinaryBase(const std::string& filename,
   m_parallel_partitions = parallel_partitions;
   m_noupdates = noupdates;
   m_close_file = close_file;
+  m_single_pass_partitions = false;
   m_get_data_from_file = (buffer_stream_idx < 0) ? true : false;
   //Callset mapping
   vid_mapper.get_local_tiledb_row_idx_vec(filename, m_local_callset_idx_to_tiledb_row_idx);
@@ -255,6 +256,7 @@ void File2TileDBBinaryBase::copy_simple_members(const File2TileDBBinaryBase& oth
   m_parallel_partitions = other.m_parallel_partitions;
   m_noupdates = other.m_noupdates;
   m_close_file = other.m_close_file;
+  m_single_pass_partitions = other.m_single_pass_partitions;
   m_treat_deletions_as_intervals = other.m_treat_deletions_as_intervals;
   m_get_data_from_file = other.m_get_data_from_file;
   m_file_idx = other.m_file_idx;
@@ -454,9 +456,14 @@ void File2TileDBBinaryBase::print_all_partitions(const std::string& results_dire
   //Open file handles if needed
   if(!m_parallel_partitions && m_close_file)
     m_base_reader_ptr->add_reader();
+  if(m_single_pass_partitions)
+    print_all_partitions_single_pass(results_directory, output_type, rank);
+  else
+  {
 #pragma omp parallel for if(m_parallel_partitions)
-  for(auto partition_idx=0u;partition_idx<m_base_partition_ptrs.size();++partition_idx)
-    print_partition(*(m_base_partition_ptrs[partition_idx]), results_directory, output_type, rank < 0 ? partition_idx : rank, close_file);
+    for(auto partition_idx=0u;partition_idx<m_base_partition_ptrs.size();++partition_idx)
+      print_partition(*(m_base_partition_ptrs[partition_idx]), results_directory, output_type, rank < 0 ? partition_idx : rank, close_file);
+  }
   //Close file handles if needed
   if(!m_parallel_partitions && close_file)
     m_base_reader_ptr->remove_reader();
@@ -480,3 +487,55 @@ void File2TileDBBinaryBase::print_partition(File2TileDBBinaryColumnPartitionBase
   if(m_parallel_partitions && close_file)
     partition_info.m_base_reader_ptr->remove_reader();
 }
+
+void File2TileDBBinaryBase::print_all_partitions_single_pass(const std::string& results_directory, const std::string& output_type,
+    const int rank)
+{
+  assert(!m_parallel_partitions && m_base_reader_ptr);
+  if(m_base_partition_ptrs.empty())
+    return;
+  //Partition idxs sorted by column begin - allows early exit while dispatching a record
+  std::vector<unsigned> sorted_partition_idxs(m_base_partition_ptrs.size());
+  int64_t cursor_begin = INT64_MAX;
+  int64_t cursor_end = -1;
+  for(auto partition_idx=0u;partition_idx<m_base_partition_ptrs.size();++partition_idx)
+  {
+    auto& partition_info = *(m_base_partition_ptrs[partition_idx]);
+    sorted_partition_idxs[partition_idx] = partition_idx;
+    cursor_begin = std::min(cursor_begin, partition_info.m_column_interval_begin);
+    cursor_end = std::max(cursor_end, partition_info.m_column_interval_end);
+    std::string output_filename = "";
+    auto status = open_partition_output_file(results_directory, output_filename, output_type, partition_info,
+        rank < 0 ? partition_idx : rank);
+    if(!status)
+      throw File2TileDBBinaryException(std::string("Could not open partition output file ")+output_filename);
+  }
+  std::sort(sorted_partition_idxs.begin(), sorted_partition_idxs.end(),
+      [this](const unsigned a, const unsigned b)
+      { return m_base_partition_ptrs[a]->m_column_interval_begin < m_base_partition_ptrs[b]->m_column_interval_begin; });
+  //Cursor spans the union of all partitions and drives the shared reader
+  auto cursor_ptr = create_new_column_partition_object();
+  cursor_ptr->initialize_base_class_members(cursor_begin, cursor_end, m_enabled_local_callset_idx_vec.size(), m_base_reader_ptr);
+  auto is_read_buffer_exhausted = false;
+  auto has_data = seek_and_fetch_position(*cursor_ptr, is_read_buffer_exhausted, m_close_file, false);
+  while(has_data)
+  {
+    int64_t record_begin = -1, record_end = -1;
+    get_column_interval_of_record(*cursor_ptr, record_begin, record_end);
+    //Records straddling partition boundaries go to every partition they overlap
+    for(auto partition_idx : sorted_partition_idxs)
+    {
+      auto& partition_info = *(m_base_partition_ptrs[partition_idx]);
+      if(partition_info.m_column_interval_begin > record_end)
+        break;
+      if(record_begin <= partition_info.m_column_interval_end)
+        write_record_to_partition(*cursor_ptr, partition_info);
+    }
+    has_data = seek_and_fetch_position(*cursor_ptr, is_read_buffer_exhausted, false, true);
+  }
+  //Reader is owned by this object, not the cursor
+  cursor_ptr->m_base_reader_ptr = 0;
+  delete cursor_ptr;
+  for(auto* partition_ptr : m_base_partition_ptrs)
+    close_partition_output_file(*partition_ptr);
+}
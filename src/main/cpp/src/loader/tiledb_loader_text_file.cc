@@ -30,6 +30,9 @@
 #include "tiledb_loader_text_file.h"
 #include "vcf.h"
 #include "variant_field_data.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw LineBasedTextFileException(#X);
 
@@ -38,65 +41,99 @@ std::string g_tmp_scratch_dir = "/tmp";
 LineBasedTextFileReader::LineBasedTextFileReader()
   : GenomicsDBImportReaderBase(true), FileReaderBase()
 {
-  m_fptr = 0;
-  m_line_buffer_size = 4096u;    //4KB
-  m_line_buffer = new char[m_line_buffer_size];
+  m_data = 0;
+  m_file_size = 0;
+  m_line_offset = 0;
+  m_next_line_offset = 0;
   m_line_length = 0;
 }
 
 LineBasedTextFileReader::~LineBasedTextFileReader()
 {
-  if(m_fptr)
-    fclose(m_fptr);
-  m_fptr = 0;
-  if(m_line_buffer && m_line_buffer_size)
-    delete[] m_line_buffer;
-  m_line_buffer = 0;
-  m_line_buffer_size = 0;
+  remove_reader();
+  m_file_size = 0;
   m_line_length = 0;
 }
 
 void LineBasedTextFileReader::initialize(const char* filename, bool open_file)
 {
   m_name = filename;
+  m_line_offset = 0;
+  m_next_line_offset = 0;
   add_reader();
   if(!open_file)
-  {
-    fclose(m_fptr);
-    m_fptr = 0;
-  }
+    remove_reader();
 }
 
 void LineBasedTextFileReader::add_reader()
 {
-  if(m_fptr)
+  if(m_data)
     return;
-  m_fptr = fopen(m_name.c_str(), "r");
-  if(m_fptr == 0)
+  auto fd = open(m_name.c_str(), O_RDONLY);
+  if(fd < 0)
     throw LineBasedTextFileException(std::string("Could not open file: ")+m_name);
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+  {
+    close(fd);
+    throw LineBasedTextFileException(std::string("Could not stat file: ")+m_name);
+  }
+  m_file_size = st.st_size;
+  //Empty file - nothing to map, every read returns an invalid record
+  if(m_file_size == 0u)
+  {
+    close(fd);
+    return;
+  }
+  auto ptr = mmap(0, m_file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  //The mapping keeps its own reference to the file
+  close(fd);
+  if(ptr == MAP_FAILED)
+    throw LineBasedTextFileException(std::string("Could not mmap file: ")+m_name);
+  madvise(ptr, m_file_size, MADV_SEQUENTIAL);
+  m_data = reinterpret_cast<const char*>(ptr);
 }
 
 void LineBasedTextFileReader::remove_reader()
 {
-  if(m_fptr)
-    fclose(m_fptr);
-  m_fptr = 0; 
+  //Offsets are retained - the next add_reader() continues from the same line
+  if(m_data)
+    munmap(const_cast<char*>(m_data), m_file_size);
+  m_data = 0;
+}
+
+size_t LineBasedTextFileReader::get_line_begin(const size_t offset) const
+{
+  assert(m_data && offset <= m_file_size);
+  //memrchr is not available on all platforms
+  auto line_begin = offset;
+  while(line_begin > 0u && m_data[line_begin-1u] != '\n')
+    --line_begin;
+  return line_begin;
+}
+
+size_t LineBasedTextFileReader::get_line_end(const size_t offset) const
+{
+  assert(m_data && offset <= m_file_size);
+  //memchr is vectorized in libc
+  auto ptr = reinterpret_cast<const char*>(memchr(m_data+offset, '\n', m_file_size-offset));
+  return ptr ? (ptr-m_data)+1u : m_file_size;
 }
 
 void LineBasedTextFileReader::read_and_advance()
 {
-  assert(m_fptr);
-  if(!feof(m_fptr))
+  if(m_data && m_next_line_offset < m_file_size)
   {
-    auto num_bytes_read = getline(&m_line_buffer, &m_line_buffer_size, m_fptr);
-    m_is_record_valid = (num_bytes_read < 0) ? false : true;
-    //m_line_length = (num_bytes_read > 0) ? ((m_line_buffer[num_bytes_read-1] == static_cast<uint8_t>('\n')) ? num_bytes_read-1 : num_bytes_read)
+    m_is_record_valid = true;
+    m_line_offset = m_next_line_offset;
+    m_next_line_offset = get_line_end(m_line_offset);
     //includes newline
-    m_line_length = m_is_record_valid ? num_bytes_read : 0ull; 
+    m_line_length = m_next_line_offset - m_line_offset;
   }
   else
   {
     m_is_record_valid = false;
+    m_line_offset = m_file_size;
     m_line_length = 0;
   }
 }
@@ -221,44 +258,75 @@ bool CSV2TileDBBinary::seek_and_fetch_position(File2TileDBBinaryColumnPartitionB
   assert(csv_reader_ptr);
   if(force_seek || !(csv_partition_info.is_initialized_file_position_to_partition_begin()))
   {
-    //Had previously sought file ptr to the column partition begin - now just use fpos_t
-    if(csv_partition_info.is_initialized_file_position_to_partition_begin())
-    {
-      csv_reader_ptr->seek(csv_partition_info.m_file_position);
-      csv_reader_ptr->read_and_advance();
-    }
-    else
+    //Had previously sought file ptr to the column partition begin - now just use the stored offset
+    if(!(csv_partition_info.is_initialized_file_position_to_partition_begin()))
     {
-      //First read
-      csv_reader_ptr->read_and_advance();
-      auto line = csv_reader_ptr->get_line();
-      while(line != 0)
-      {
-        parse_line(line, csv_partition_info, TileDBCSVFieldPosIdxEnum::TILEDB_CSV_COLUMN_POS_IDX, false);        //parse only till column idx
-        if(csv_partition_info.m_current_column_position >= csv_partition_info.m_column_interval_begin)
-          break;
-        csv_reader_ptr->read_and_advance();
-        line = csv_reader_ptr->get_line();
-      }
+      //First read - lines are sorted by column, binary search instead of parsing every preceding line
+      csv_partition_info.m_file_position = find_first_line_with_column_at_least(*csv_reader_ptr,
+          csv_partition_info.m_column_interval_begin);
       csv_partition_info.set_initialized_file_position_to_partition_begin(true);
     }
+    csv_reader_ptr->seek(csv_partition_info.m_file_position);
+    csv_reader_ptr->read_and_advance();
   }
   else
     if(advance_reader)
       csv_reader_ptr->read_and_advance();
   //Store file position
-  csv_reader_ptr->get_position(csv_partition_info.m_file_position);
+  csv_partition_info.m_file_position = csv_reader_ptr->get_position();
   auto line = csv_reader_ptr->get_line();
   if(line)
   {
-    //Parse line for column idx to check whether file pointer has gone beyond column_partition_end
-    parse_line(line, csv_partition_info, TileDBCSVFieldPosIdxEnum::TILEDB_CSV_COLUMN_POS_IDX, false);        //parse only till column idx
+    //Check whether file pointer has gone beyond column_partition_end
+    csv_partition_info.m_current_column_position = get_column_from_line(line, csv_reader_ptr->get_line_length());
     return (csv_partition_info.m_current_column_position <= csv_partition_info.m_column_interval_end);
   }
   else
     return false;
 }
 
+int64_t CSV2TileDBBinary::get_column_from_line(const char* line, const size_t line_length) const
+{
+  auto end_ptr = line+line_length;
+  auto ptr = reinterpret_cast<const char*>(memchr(line, ',', line_length));
+  //Blank lines (typically trailing) are treated as being past every column
+  if(ptr == 0 && std::all_of(line, end_ptr, [](const char c) { return isspace(c); }))
+    return INT64_MAX;
+  VERIFY_OR_THROW(ptr && "Could not parse column field");
+  ++ptr;
+  //Bounded parse - the line need not be null terminated
+  while(ptr < end_ptr && isspace(*ptr))
+    ++ptr;
+  auto is_negative = (ptr < end_ptr && *ptr == '-');
+  if(ptr < end_ptr && (*ptr == '-' || *ptr == '+'))
+    ++ptr;
+  auto digits_begin = ptr;
+  int64_t column = 0;
+  for(;ptr < end_ptr && *ptr >= '0' && *ptr <= '9';++ptr)
+    column = column*10 + (*ptr - '0');
+  VERIFY_OR_THROW((ptr != digits_begin) && "Could not parse column field");
+  return is_negative ? -column : column;
+}
+
+size_t CSV2TileDBBinary::find_first_line_with_column_at_least(const LineBasedTextFileReader& reader,
+    const int64_t column_begin) const
+{
+  //Invariant: every line beginning before low has column < column_begin, the line beginning at high (if any)
+  //has column >= column_begin
+  size_t low = 0u;
+  size_t high = reader.get_file_size();
+  while(low < high)
+  {
+    auto line_begin = reader.get_line_begin(low+(high-low)/2u);
+    auto line_end = reader.get_line_end(line_begin);
+    if(get_column_from_line(reader.get_data(line_begin), line_end-line_begin) < column_begin)
+      low = line_end;
+    else
+      high = line_begin;
+  }
+  return low;
+}
+
 template<class FieldType>
 void CSV2TileDBBinary::handle_field_token(const char* token_ptr,
     CSVLineParseStruct* csv_line_parse_ptr, CSV2TileDBBinaryColumnPartition& csv_partition_info,
@@ -179,9 +179,6 @@ BroadCombinedGVCFOperator::BroadCombinedGVCFOperator(VCFAdapter& vcf_adapter, co
   }
   bcf_hdr_sync(m_vcf_hdr);
   m_vcf_adapter->print_header();
-  //vector of field pointers used for handling remapped fields when dealing with spanning deletions
-  //Individual pointers will be allocated later
-  m_spanning_deletions_remapped_fields.resize(m_remapped_fields_query_idxs.size());
 }
 
 void BroadCombinedGVCFOperator::clear()
@@ -193,8 +190,6 @@ void BroadCombinedGVCFOperator::clear()
   m_FORMAT_fields_vec.clear();
   m_MIN_DP_vector.clear();
   m_DP_FORMAT_vector.clear();
-  m_spanning_deletions_remapped_fields.clear();
-  m_spanning_deletion_remapped_GT.clear();
 }
 
 bool BroadCombinedGVCFOperator::handle_VCF_field_combine_operation(const Variant& variant,
@@ -431,6 +426,12 @@ void BroadCombinedGVCFOperator::operate(Variant& variant, const VariantQueryConf
   //Handle spanning deletions - change ALT alleles in calls with deletions to *, <NON_REF>
   handle_deletions(variant, query_config);
   GA4GHOperator::operate(variant, query_config);
+  write_combined_record(variant);
+}
+
+//m_remapped_variant and the merged alleles must be valid for the current position
+void BroadCombinedGVCFOperator::write_combined_record(const Variant& variant)
+{
   //Moved to new contig
   if(static_cast<int64_t>(m_remapped_variant.get_column_begin()) >= m_next_contig_begin_position)
   {
@@ -525,114 +526,16 @@ void BroadCombinedGVCFOperator::switch_contig()
 //Modifies original Variant object
 void BroadCombinedGVCFOperator::handle_deletions(Variant& variant, const VariantQueryConfig& query_config)
 {
-  m_reduced_alleles_LUT.resize_luts_if_needed(variant.get_num_calls(), 10u);    //will not have more than 3 alleles anyway
-  m_reduced_alleles_LUT.reset_luts();
-  for(auto iter=variant.begin(), e=variant.end();iter != e;++iter)
+  reduce_spanning_deletions(variant, query_config);
+  invalidate_INFO_fields_of_spanning_deletions(variant);
+}
+
+void BroadCombinedGVCFOperator::invalidate_INFO_fields_of_spanning_deletions(Variant& variant)
+{
+  for(auto& curr_call : variant)
   {
-    auto& curr_call = *iter;
-    auto curr_call_idx_in_variant = iter.get_call_idx_in_variant();
-    //Deletion and not handled as spanning deletion 
-    //So replace the ALT with *,<NON_REF> and REF with "N"
-    //Remap PL, AD fields
     if(curr_call.contains_deletion() && variant.get_column_begin() > curr_call.get_column_begin())
     {
-      auto& ref_allele = get_known_field<VariantFieldString, true>(curr_call, query_config, GVCF_REF_IDX)->get();
-      auto& alt_alleles = get_known_field<VariantFieldALTData, true>(curr_call, query_config, GVCF_ALT_IDX)->get();
-      assert(alt_alleles.size() > 0u);
-      //Already handled as a spanning deletion, nothing to do
-      if(alt_alleles[0u] == g_vcf_SPANNING_DELETION)
-        continue;
-      //Reduced allele list will be REF="N", ALT="*, <NON_REF>"
-      m_reduced_alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, 0, 0);  //REF-REF mapping
-      //Need to find deletion allele with lowest PL value - this deletion allele is mapped to "*" allele
-      auto lowest_deletion_allele_idx = -1;
-      int lowest_PL_value = INT_MAX;
-      auto PL_field_ptr = get_known_field_if_queried<VariantFieldPrimitiveVectorData<int>, true>(curr_call, query_config, GVCF_PL_IDX);
-      auto has_NON_REF = false;
-      //PL field exists
-      if(PL_field_ptr)
-      {
-        auto& PL_vector = PL_field_ptr->get();
-        for(auto i=0u;i<alt_alleles.size();++i)
-        {
-          auto allele_idx = i+1;  //+1 for REF
-          if(VariantUtils::is_deletion(ref_allele, alt_alleles[i]))
-          {
-            unsigned gt_idx = bcf_alleles2gt(allele_idx, allele_idx);
-            assert(gt_idx < PL_vector.size());
-            if(PL_vector[gt_idx] < lowest_PL_value || lowest_deletion_allele_idx < 0)
-            {
-              lowest_PL_value = PL_vector[gt_idx];
-              lowest_deletion_allele_idx = allele_idx;
-            }
-          }
-          else
-            if(IS_NON_REF_ALLELE(alt_alleles[i]))
-            {
-              m_reduced_alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, allele_idx, 2);
-              has_NON_REF = true;
-            }
-        }
-      }
-      else      //PL field is not queried, simply use the first ALT allele
-        lowest_deletion_allele_idx = 1;
-      assert(lowest_deletion_allele_idx >= 1);    //should be an ALT allele
-      //first ALT allele in reduced list is *
-      m_reduced_alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, lowest_deletion_allele_idx, 1); 
-      if(has_NON_REF)
-      {
-        alt_alleles.resize(2u);
-        alt_alleles[1u] = TILEDB_NON_REF_VARIANT_REPRESENTATION;
-      }
-      else
-        alt_alleles.resize(1u); //only spanning deletion
-      ref_allele = "N"; //set to unknown REF for now
-      alt_alleles[0u] = g_vcf_SPANNING_DELETION;
-      unsigned num_reduced_alleles = alt_alleles.size() + 1u;   //+1 for REF
-      //Remap fields that need to be remapped
-      for(auto i=0u;i<m_remapped_fields_query_idxs.size();++i)
-      {
-        auto query_field_idx = m_remapped_fields_query_idxs[i];
-        auto length_descriptor = query_config.get_length_descriptor_for_query_attribute_idx(query_field_idx);
-        //field whose length is dependent on #alleles
-        assert(KnownFieldInfo::is_length_descriptor_allele_dependent(length_descriptor));
-        unsigned num_reduced_elements = KnownFieldInfo::get_num_elements_given_length_descriptor(length_descriptor, num_reduced_alleles-1u, 0u, 0u);     //#alt alleles
-        //Remapper for variant
-        RemappedVariant remapper_variant(variant, query_field_idx); 
-        auto& curr_field = curr_call.get_field(query_field_idx);
-        if(curr_field.get() && curr_field->is_valid())      //Not null
-        {
-          //Copy field to pass to remap function 
-          assert(i < m_spanning_deletions_remapped_fields.size());
-          copy_field(m_spanning_deletions_remapped_fields[i], curr_field);
-          curr_field->resize(num_reduced_elements);
-          //Get handler for current type
-          auto& handler = get_handler_for_type(curr_field->get_element_type());
-          assert(handler.get());
-          //Call remap function
-          handler->remap_vector_data(
-              m_spanning_deletions_remapped_fields[i], curr_call_idx_in_variant,
-              m_reduced_alleles_LUT, num_reduced_alleles, has_NON_REF,
-              length_descriptor, num_reduced_elements, remapper_variant);
-        }
-      }
-      //GT field
-      if(m_GT_query_idx != UNDEFINED_ATTRIBUTE_IDX_VALUE)
-      {
-
-        auto& original_GT_field = curr_call.get_field(m_GT_query_idx);
-        if(original_GT_field.get() && original_GT_field->is_valid())
-        {
-          auto& input_GT =
-            curr_call.get_field<VariantFieldPrimitiveVectorData<int>>(m_GT_query_idx)->get();
-          m_spanning_deletion_remapped_GT.resize(input_GT.size());
-          VariantOperations::remap_GT_field(input_GT, m_spanning_deletion_remapped_GT, m_reduced_alleles_LUT, curr_call_idx_in_variant,
-              num_reduced_alleles, has_NON_REF);
-          //Copy back
-          memcpy(&(input_GT[0]), &(m_spanning_deletion_remapped_GT[0]), input_GT.size()*sizeof(int));
-        }
-      }
-      //Invalidate INFO fields
       for(const auto& tuple : m_INFO_fields_vec)
       {
         auto query_idx = BCF_INFO_GET_QUERY_FIELD_IDX(tuple);
@@ -644,4 +547,181 @@ void BroadCombinedGVCFOperator::handle_deletions(Variant& variant, const Variant
   }
 }
 
+//BroadCombinedGVCFPartialsReducer functions
+BroadCombinedGVCFPartialsReducer::BroadCombinedGVCFPartialsReducer(VCFAdapter& vcf_adapter, const VidMapper& id_mapper,
+    const VariantQueryConfig& query_config,
+    const unsigned max_diploid_alt_alleles_that_can_be_genotyped, const bool use_missing_values_only_not_vector_end)
+: BroadCombinedGVCFOperator(vcf_adapter, id_mapper, query_config, max_diploid_alt_alleles_that_can_be_genotyped,
+    use_missing_values_only_not_vector_end)
+{
+  m_next_position = 0;
+  //Calls of all partitions are combined into m_remapped_variant
+  m_remapped_variant.set_query_config(&query_config);
+  m_remapped_variant.resize_based_on_query();
+}
+
+bool BroadCombinedGVCFPartialsReducer::reduce(const std::vector<PartialCombinedGVCFSource*>& sources)
+{
+  //First call
+  if(m_partials.size() != sources.size())
+  {
+    m_partials.clear();
+    m_partials.resize(sources.size());
+    m_is_partial_valid.assign(sources.size(), false);
+    m_is_source_done.assign(sources.size(), false);
+    m_next_position = 0;
+  }
+  while(true)
+  {
+    //Fetch next record from partitions whose current record was consumed
+    for(auto i=0ull;i<sources.size();++i)
+    {
+      if(!m_is_partial_valid[i] && !m_is_source_done[i])
+      {
+        assert(sources[i]);
+        if(sources[i]->next(m_partials[i]))
+          m_is_partial_valid[i] = true;
+        else
+          m_is_source_done[i] = true;
+      }
+    }
+    //The combined record begins at the smallest position not yet written which is covered by a partition
+    auto begin = INT64_MAX;
+    for(auto i=0ull;i<m_partials.size();++i)
+      if(m_is_partial_valid[i])
+        begin = std::min(begin, std::max(static_cast<int64_t>(m_partials[i].get_column_begin()), m_next_position));
+    if(begin == INT64_MAX)   //all partitions done
+      return true;
+    //and ends before the next partially combined record begins
+    auto end = INT64_MAX;
+    for(auto i=0ull;i<m_partials.size();++i)
+    {
+      if(m_is_partial_valid[i])
+      {
+        auto partial_begin = static_cast<int64_t>(m_partials[i].get_column_begin());
+        end = std::min(end, partial_begin <= begin ? static_cast<int64_t>(m_partials[i].get_column_end()) : partial_begin-1);
+      }
+    }
+    assert(end >= begin);
+    combine_partials(begin, end);
+    m_next_position = end+1;
+    for(auto i=0ull;i<m_partials.size();++i)
+      if(m_is_partial_valid[i] && static_cast<int64_t>(m_partials[i].get_column_end()) <= end)
+        m_is_partial_valid[i] = false;
+    if(overflow())
+      return false;
+  }
+}
+
+//A partially combined record that begins before begin contributes only its tail - it is a reference block,
+//records with deletions or variants are never longer than 1 position
+void BroadCombinedGVCFPartialsReducer::combine_partials(const int64_t begin, const int64_t end)
+{
+#ifdef DO_PROFILING
+  m_bcf_t_creation_timer.start();
+#endif
+  auto num_partitions = m_partials.size();
+  m_partials_reference_alleles.assign(num_partitions, 0);
+  m_partials_alt_alleles.assign(num_partitions, 0);
+  m_merged_reference_allele.resize(0u);
+  m_merged_alt_alleles.clear();
+  for(auto i=0ull;i<num_partitions;++i)
+  {
+    auto& partial = m_partials[i];
+    if(!m_is_partial_valid[i] || static_cast<int64_t>(partial.get_column_begin()) > begin)
+      continue;
+    auto* REF_ptr = dynamic_cast<VariantFieldString*>(partial.get_common_field(0u).get());
+    auto* ALT_ptr = dynamic_cast<VariantFieldALTData*>(partial.get_common_field(1u).get());
+    if(REF_ptr == 0 || ALT_ptr == 0)
+      throw BroadCombinedGVCFException("Partially combined record at column "+std::to_string(partial.get_column_begin())
+          +" does not have the merged REF and ALT alleles");
+    m_partials_reference_alleles[i] = &(REF_ptr->get());
+    m_partials_alt_alleles[i] = &(ALT_ptr->get());
+    //REF of a record that began earlier is useless
+    if(static_cast<int64_t>(partial.get_column_begin()) == begin)
+      VariantOperations::merge_reference_allele(REF_ptr->get(), m_merged_reference_allele);
+  }
+  if(m_merged_reference_allele.length() == 0u)
+    m_merged_reference_allele = "N";
+  m_partials_alleles_LUT.resize_luts_if_needed(num_partitions, 10u);
+  VariantOperations::merge_alt_alleles(m_partials_reference_alleles, m_partials_alt_alleles, m_merged_reference_allele,
+      m_partials_alleles_LUT, m_merged_alt_alleles, m_NON_REF_exists);
+  m_is_reference_block_only = (m_merged_reference_allele.length() == 1u && m_merged_alt_alleles.size() == 1u &&
+      m_merged_alt_alleles[0] == g_vcf_NON_REF);
+  m_remapping_needed = !m_is_reference_block_only;
+  unsigned num_merged_alleles = m_merged_alt_alleles.size()+1u;        //+1 for REF allele
+  //Invalidate calls from the previous record
+  for(auto call_idx : m_valid_call_idxs)
+    m_remapped_variant.get_call(call_idx).mark_valid(false);
+  m_valid_call_idxs.clear();
+  m_remapped_variant.set_column_interval(begin, end);
+  m_alleles_LUT.resize_luts_if_needed(m_remapped_variant.get_num_calls(), num_merged_alleles);
+  m_alleles_LUT.reset_luts();
+  for(auto i=0ull;i<num_partitions;++i)
+  {
+    if(m_partials_alt_alleles[i] == 0)
+      continue;
+    unsigned num_partial_alleles = m_partials_alt_alleles[i]->size()+1u;
+    //Fields of calls need to be remapped only if the allele order changed
+    auto remap_fields = (num_partial_alleles != num_merged_alleles);
+    for(auto j=0u;j<num_partial_alleles;++j)
+      remap_fields = remap_fields || (m_partials_alleles_LUT.get_merged_idx_for_input(i, j) != static_cast<int64_t>(j));
+    for(auto& partial_call : m_partials[i])
+    {
+      auto row_idx = partial_call.get_row_idx();
+      if(!m_query_config->is_queried_array_row_idx(row_idx))
+        throw BroadCombinedGVCFException("Row "+std::to_string(row_idx)
+            +" of a partially combined record is not part of the query");
+      auto call_idx = m_query_config->get_query_row_idx_for_array_row_idx(row_idx);
+      for(auto j=0u;j<num_partial_alleles;++j)
+        m_alleles_LUT.add_input_merged_idx_pair(call_idx, j, m_partials_alleles_LUT.get_merged_idx_for_input(i, j));
+      copy_call_fields(partial_call, call_idx, remap_fields);
+      m_valid_call_idxs.push_back(call_idx);
+    }
+  }
+  set_merged_alleles_in_remapped_variant();
+  invalidate_INFO_fields_of_spanning_deletions(m_remapped_variant);
+  write_combined_record(m_remapped_variant);
+}
+
+void BroadCombinedGVCFPartialsReducer::copy_call_fields(VariantCall& partial_call, const uint64_t call_idx,
+    const bool remap_fields)
+{
+  unsigned num_merged_alleles = m_merged_alt_alleles.size()+1u;        //+1 for REF allele
+  auto& combined_call = m_remapped_variant.get_call(call_idx);
+  combined_call.deep_copy_simple_members(partial_call);
+  for(auto query_field_idx=0u;query_field_idx<m_query_config->get_num_queried_attributes();++query_field_idx)
+  {
+    auto& combined_field = combined_call.get_field(query_field_idx);
+    auto& partial_field = partial_call.get_field(query_field_idx);
+    auto length_descriptor = m_query_config->get_length_descriptor_for_query_attribute_idx(query_field_idx);
+    copy_field(combined_field, partial_field);
+    if(!remap_fields || !combined_field.get() || !combined_field->is_valid()
+        || !(KnownFieldInfo::is_length_descriptor_allele_dependent(length_descriptor) || query_field_idx == m_GT_query_idx))
+      continue;
+    if(query_field_idx == m_GT_query_idx)
+    {
+      auto& input_GT = partial_call.get_field<VariantFieldPrimitiveVectorData<int>>(m_GT_query_idx)->get();
+      auto& output_GT = combined_call.get_field<VariantFieldPrimitiveVectorData<int>>(m_GT_query_idx)->get();
+      VariantOperations::remap_GT_field(input_GT, output_GT, m_alleles_LUT, call_idx, num_merged_alleles, m_NON_REF_exists);
+      continue;
+    }
+    //Fields such as PL are not written if the #alleles is above a threshold
+    if(KnownFieldInfo::is_length_descriptor_genotype_dependent(length_descriptor)
+        && too_many_alt_alleles_for_genotype_length_fields(num_merged_alleles-1u))
+    {
+      combined_field->set_valid(false);
+      continue;
+    }
+    unsigned num_merged_elements = KnownFieldInfo::get_num_elements_given_length_descriptor(length_descriptor,
+        num_merged_alleles-1u, 0u, 0u);  //#alt alleles
+    combined_field->resize(num_merged_elements);
+    auto& handler = get_handler_for_type(combined_field->get_element_type());
+    assert(handler.get());
+    RemappedVariant remapper_variant(m_remapped_variant, query_field_idx);
+    handler->remap_vector_data(partial_field, call_idx, m_alleles_LUT, num_merged_alleles, m_NON_REF_exists,
+        length_descriptor, num_merged_elements, remapper_variant);
+  }
+}
+
 #endif //ifdef HTSDIR
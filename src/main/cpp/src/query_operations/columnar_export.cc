@@ -0,0 +1,319 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "columnar_export.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw ColumnarExportException(#X);
+
+//ColumnarExportOperator functions
+ColumnarExportOperator::ColumnarExportOperator(const std::string& filename, const VidMapper& id_mapper,
+    const VariantQueryConfig& query_config, const ColumnarExportLayoutEnum layout,
+    const uint64_t row_group_num_sites, const uint64_t row_group_max_num_calls,
+    const unsigned max_diploid_alt_alleles_that_can_be_genotyped)
+  : GA4GHOperator(query_config, max_diploid_alt_alleles_that_can_be_genotyped), m_writer(filename)
+{
+  if(!id_mapper.is_initialized())
+    throw ColumnarExportException("Id mapper is not initialized");
+  m_vid_mapper = &id_mapper;
+  m_query_config = &query_config;
+  m_layout = layout;
+  m_row_group_num_sites = std::max<uint64_t>(row_group_num_sites, 1ull);
+  m_row_group_max_num_calls = std::max<uint64_t>(row_group_max_num_calls, 1ull);
+  m_curr_contig_begin_position = -1ll;
+  m_curr_contig_end_position = -1ll;
+  m_curr_pos = 0ll;
+  m_curr_end = 0ll;
+  m_num_sites = 0ull;
+  m_num_sites_in_row_group = 0ull;
+  m_num_calls_in_row_group = 0ull;
+  m_num_rows_in_row_group = 0ull;
+  m_GT_column_idx = UNDEFINED_ATTRIBUTE_IDX_VALUE;
+  m_site_idx_column_idx = UNDEFINED_ATTRIBUTE_IDX_VALUE;
+  m_sample_column_idx = UNDEFINED_ATTRIBUTE_IDX_VALUE;
+  //Call columns are lists in the nested layout
+  auto call_column_repetition = (m_layout == COLUMNAR_EXPORT_LAYOUT_NESTED) ? PARQUET_REPETITION_LIST
+    : PARQUET_REPETITION_OPTIONAL;
+  //Site columns
+  m_contig_column_idx = m_writer.add_column("contig", PARQUET_TYPE_BYTE_ARRAY, PARQUET_REPETITION_REQUIRED);
+  m_pos_column_idx = m_writer.add_column("pos", PARQUET_TYPE_INT64, PARQUET_REPETITION_REQUIRED);
+  m_end_column_idx = m_writer.add_column("end", PARQUET_TYPE_INT64, PARQUET_REPETITION_REQUIRED);
+  m_ref_column_idx = m_writer.add_column("ref", PARQUET_TYPE_BYTE_ARRAY, PARQUET_REPETITION_REQUIRED);
+  m_alt_column_idx = m_writer.add_column("alt", PARQUET_TYPE_BYTE_ARRAY, PARQUET_REPETITION_OPTIONAL);
+  //Call columns of the long layout
+  if(m_layout == COLUMNAR_EXPORT_LAYOUT_LONG)
+  {
+    m_site_idx_column_idx = m_writer.add_column("site_idx", PARQUET_TYPE_INT64, PARQUET_REPETITION_REQUIRED);
+    m_sample_column_idx = m_writer.add_column("sample", PARQUET_TYPE_BYTE_ARRAY, PARQUET_REPETITION_REQUIRED);
+  }
+  //Field columns - INFO and FORMAT fields are determined as in BroadCombinedGVCFOperator
+  for(auto i=0u;i<query_config.get_num_queried_attributes();++i)
+  {
+    auto* field_info = m_vid_mapper->get_field_info(query_config.get_query_attribute_name(i));
+    if(field_info == 0)
+      continue;
+    auto known_field_enum = query_config.is_defined_known_field_enum_for_query_idx(i) ? query_config.get_known_field_enum_for_query_idx(i)
+      : UNDEFINED_ATTRIBUTE_IDX_VALUE;
+    if(known_field_enum == GVCF_END_IDX)
+      continue;
+    if(known_field_enum == GVCF_GT_IDX)
+    {
+      m_GT_column_idx = m_writer.add_column("FORMAT.GT", PARQUET_TYPE_BYTE_ARRAY, call_column_repetition);
+      continue;
+    }
+    auto VCF_field_combine_operation = query_config.get_VCF_field_combine_operation_for_query_attribute_idx(i);
+    auto variant_type_enum = VariantFieldTypeUtil::get_variant_field_type_enum_for_variant_field_type(field_info->m_type_index);
+    auto is_numeric = (variant_type_enum == VARIANT_FIELD_INT || variant_type_enum == VARIANT_FIELD_FLOAT);
+    auto column_type = (variant_type_enum == VARIANT_FIELD_INT) ? PARQUET_TYPE_INT32 : PARQUET_TYPE_FLOAT;
+    auto is_DP_combined_as_FORMAT = (known_field_enum == GVCF_DP_IDX
+        && VCF_field_combine_operation == VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_DP);
+    auto add_to_INFO = (field_info->m_is_vcf_INFO_field && !is_DP_combined_as_FORMAT
+        && VCF_field_combine_operation != VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MOVE_TO_FORMAT);
+    auto add_to_FORMAT = (field_info->m_is_vcf_FORMAT_field ||
+        (field_info->m_is_vcf_INFO_field && (is_DP_combined_as_FORMAT
+          || VCF_field_combine_operation == VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MOVE_TO_FORMAT)));
+    if(add_to_INFO)
+    {
+      if(is_numeric && (VCF_field_combine_operation == VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_SUM
+            || VCF_field_combine_operation == VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEAN
+            || VCF_field_combine_operation == VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEDIAN))
+        m_INFO_columns.emplace_back(i, m_writer.add_column("INFO."+field_info->m_vcf_name, column_type, PARQUET_REPETITION_OPTIONAL),
+            variant_type_enum, VCF_field_combine_operation);
+      else
+        std::cerr << "WARNING: INFO field "<<field_info->m_vcf_name
+          <<" is not combined into a single int or float value - the field will NOT be exported\n";
+    }
+    //DP is exported once
+    if(add_to_FORMAT && (known_field_enum != GVCF_DP_IDX || is_DP_combined_as_FORMAT || !field_info->m_is_vcf_INFO_field))
+    {
+      if(is_numeric && query_config.get_length_descriptor_for_query_attribute_idx(i) == BCF_VL_FIXED
+          && query_config.get_num_elements_for_query_attribute_idx(i) == 1)
+        m_FORMAT_columns.emplace_back(i, m_writer.add_column("FORMAT."+field_info->m_vcf_name, column_type, call_column_repetition),
+            variant_type_enum, VCF_field_combine_operation);
+      else
+        std::cerr << "WARNING: FORMAT field "<<field_info->m_vcf_name
+          <<" is not a single int or float value - the field will NOT be exported\n";
+    }
+  }
+  //Sample names in query row order
+  m_sample_names.resize(query_config.get_num_rows_to_query());
+  for(auto i=0ull;i<m_sample_names.size();++i)
+  {
+    auto row_idx = query_config.get_array_row_idx_for_query_row_idx(i);
+    if(!m_vid_mapper->get_callset_name(row_idx, m_sample_names[i]))
+      m_sample_names[i] = std::to_string(row_idx);
+  }
+  m_tmp_string.clear();
+  for(auto i=0ull;i<m_sample_names.size();++i)
+  {
+    if(i > 0u)
+      m_tmp_string.push_back('\t');
+    m_tmp_string += m_sample_names[i];
+  }
+  m_writer.set_key_value_metadata("samples", m_tmp_string);
+}
+
+void ColumnarExportOperator::update_contig(const int64_t column)
+{
+  if(column >= m_curr_contig_begin_position && column < m_curr_contig_end_position)
+    return;
+  int64_t contig_position = -1ll;
+  if(!m_vid_mapper->get_contig_location(column, m_curr_contig_name, contig_position))
+    throw ColumnarExportException("Unknown contig for position "+std::to_string(column));
+  ContigInfo info;
+  VERIFY_OR_THROW(m_vid_mapper->get_contig_info(m_curr_contig_name, info));
+  m_curr_contig_begin_position = column - contig_position;
+  m_curr_contig_end_position = m_curr_contig_begin_position + info.m_length;
+}
+
+void ColumnarExportOperator::compute_INFO_values(const Variant& variant)
+{
+  for(auto& field_column : m_INFO_columns)
+  {
+    auto length_descriptor = m_query_config->get_length_descriptor_for_query_attribute_idx(field_column.m_query_idx);
+    auto& src_variant = (m_remapping_needed && KnownFieldInfo::is_length_descriptor_allele_dependent(length_descriptor))
+      ? m_remapped_variant : variant;
+    //Just need a 4-byte value, the contents could be a float or int (determined by the templated median function)
+    int32_t result = -1;
+    void* result_ptr = reinterpret_cast<void*>(&result);
+    auto num_valid_input_elements = 0u;
+    auto& handler = m_field_handlers[field_column.m_variant_type_enum];
+    assert(handler.get());
+    auto valid_result_found = false;
+    switch(field_column.m_combine_operation)
+    {
+      case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_SUM:
+        valid_result_found = handler->get_valid_sum(src_variant, *m_query_config, field_column.m_query_idx,
+            result_ptr, num_valid_input_elements);
+        break;
+      case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEAN:
+        valid_result_found = handler->get_valid_mean(src_variant, *m_query_config, field_column.m_query_idx,
+            result_ptr, num_valid_input_elements);
+        break;
+      default:
+        valid_result_found = handler->get_valid_median(src_variant, *m_query_config, field_column.m_query_idx,
+            result_ptr, num_valid_input_elements);
+        break;
+    }
+    field_column.m_is_valid = valid_result_found;
+    field_column.m_value = result;
+  }
+}
+
+void ColumnarExportOperator::add_site_values()
+{
+  m_writer.get_column(m_contig_column_idx).append_string(m_curr_contig_name);
+  m_writer.get_column(m_pos_column_idx).append_int64(m_curr_pos);
+  m_writer.get_column(m_end_column_idx).append_int64(m_curr_end);
+  m_writer.get_column(m_ref_column_idx).append_string(m_merged_reference_allele);
+  if(m_curr_alt.empty())
+    m_writer.get_column(m_alt_column_idx).append_null();
+  else
+    m_writer.get_column(m_alt_column_idx).append_string(m_curr_alt);
+  for(const auto& field_column : m_INFO_columns)
+  {
+    auto& column = m_writer.get_column(field_column.m_column_idx);
+    if(!field_column.m_is_valid)
+      column.append_null();
+    else if(field_column.m_variant_type_enum == VARIANT_FIELD_INT)
+      column.append_int32(field_column.m_value);
+    else
+      column.append_float(*(reinterpret_cast<const float*>(&(field_column.m_value))));
+  }
+  ++m_num_rows_in_row_group;
+}
+
+void ColumnarExportOperator::add_call_values(const Variant& variant, const uint64_t call_idx_in_variant)
+{
+  const auto& call = variant.get_call(call_idx_in_variant);
+  auto is_valid_call = call.is_valid();
+  if(m_layout == COLUMNAR_EXPORT_LAYOUT_LONG)
+  {
+    m_writer.get_column(m_site_idx_column_idx).append_int64(m_num_sites);
+    m_writer.get_column(m_sample_column_idx).append_string(m_sample_names[call_idx_in_variant]);
+  }
+  //GT is remapped to the merged alleles
+  if(m_GT_column_idx != UNDEFINED_ATTRIBUTE_IDX_VALUE)
+  {
+    auto& GT_variant = m_remapping_needed ? m_remapped_variant : variant;
+    auto* GT_field_ptr = is_valid_call
+      ? GT_variant.get_call(call_idx_in_variant).get_field<VariantFieldPrimitiveVectorData<int>>(m_GT_query_idx) : 0;
+    auto& column = m_writer.get_column(m_GT_column_idx);
+    if(GT_field_ptr && GT_field_ptr->is_valid())
+    {
+      //Missing alleles are '.', as in VCFs
+      m_tmp_string.clear();
+      const auto& GT_vector = GT_field_ptr->get();
+      for(auto i=0u;i<GT_vector.size();++i)
+      {
+        if(i > 0u)
+          m_tmp_string.push_back('/');
+        if(is_bcf_valid_value<int>(GT_vector[i]) && GT_vector[i] >= 0)
+          m_tmp_string += std::to_string(GT_vector[i]);
+        else
+          m_tmp_string.push_back('.');
+      }
+      column.append_string(m_tmp_string);
+    }
+    else
+      column.append_null();
+  }
+  for(const auto& field_column : m_FORMAT_columns)
+  {
+    const auto& field = call.get_field(field_column.m_query_idx);
+    auto is_valid_field = is_valid_call && field.get() && field->is_valid() && field->length() > 0u;
+    auto& column = m_writer.get_column(field_column.m_column_idx);
+    if(!is_valid_field)
+      column.append_null();
+    else if(field_column.m_variant_type_enum == VARIANT_FIELD_INT)
+      column.append_int32(*(reinterpret_cast<const int*>(field->get_raw_pointer())));
+    else
+      column.append_float(*(reinterpret_cast<const float*>(field->get_raw_pointer())));
+  }
+  ++m_num_calls_in_row_group;
+}
+
+void ColumnarExportOperator::operate(Variant& variant, const VariantQueryConfig& query_config)
+{
+  //Handle spanning deletions - change ALT alleles in calls with deletions to *, <NON_REF>
+  reduce_spanning_deletions(variant, query_config);
+  //INFO fields of calls with deletions that begin before this position do not contribute to the site values
+  for(auto& curr_call : variant)
+    if(curr_call.contains_deletion() && variant.get_column_begin() > curr_call.get_column_begin())
+      for(const auto& field_column : m_INFO_columns)
+      {
+        auto& field = curr_call.get_field(field_column.m_query_idx);
+        if(field.get())
+          field->set_valid(false);
+      }
+  GA4GHOperator::operate(variant, query_config);
+  auto column_begin = static_cast<int64_t>(m_remapped_variant.get_column_begin());
+  update_contig(column_begin);
+  //Positions are 1-based
+  m_curr_pos = column_begin - m_curr_contig_begin_position + 1;
+  m_curr_end = static_cast<int64_t>(m_remapped_variant.get_column_end()) - m_curr_contig_begin_position + 1;
+  m_curr_alt.clear();
+  for(auto i=0u;i<m_merged_alt_alleles.size();++i)
+  {
+    if(i > 0u)
+      m_curr_alt.push_back(',');
+    m_curr_alt += m_merged_alt_alleles[i];
+  }
+  compute_INFO_values(variant);
+  if(m_layout == COLUMNAR_EXPORT_LAYOUT_NESTED)
+  {
+    //One row per site, one list element per queried row
+    assert(variant.get_num_calls() == m_sample_names.size());
+    add_site_values();
+    if(m_GT_column_idx != UNDEFINED_ATTRIBUTE_IDX_VALUE)
+      m_writer.get_column(m_GT_column_idx).begin_list();
+    for(const auto& field_column : m_FORMAT_columns)
+      m_writer.get_column(field_column.m_column_idx).begin_list();
+    for(auto i=0ull;i<variant.get_num_calls();++i)
+      add_call_values(variant, i);
+  }
+  else
+    //One row per valid call
+    for(auto iter=variant.begin();iter!=variant.end();++iter)
+    {
+      add_site_values();
+      add_call_values(variant, iter.get_call_idx_in_variant());
+    }
+  ++m_num_sites;
+  ++m_num_sites_in_row_group;
+  if(m_num_sites_in_row_group >= m_row_group_num_sites || m_num_calls_in_row_group >= m_row_group_max_num_calls)
+    flush_row_group();
+}
+
+void ColumnarExportOperator::flush_row_group()
+{
+  if(m_num_rows_in_row_group > 0ull)
+    m_writer.write_row_group(m_num_rows_in_row_group);
+  m_num_sites_in_row_group = 0ull;
+  m_num_calls_in_row_group = 0ull;
+  m_num_rows_in_row_group = 0ull;
+}
+
+void ColumnarExportOperator::finalize()
+{
+  flush_row_group();
+  m_writer.finalize();
+}
@@ -0,0 +1,257 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "genotype_matrix_export.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw GenotypeMatrixExportException(#X);
+
+//PLINK 1 .bed header - magic number followed by 0x01 for variant-major order
+static const uint8_t g_plink_bed_header[] = { 0x6c, 0x1b, 0x01 };
+//2-bit PLINK codes indexed by #copies of the ALT allele (A1), followed by the code for missing
+static const uint8_t g_plink_bed_codes[] = { 3u, 2u, 0u, 1u };
+
+GenotypeMatrixExportOperator::GenotypeMatrixExportOperator(const std::string& prefix, const VidMapper& id_mapper,
+    const VariantQueryConfig& query_config, const GenotypeMatrixFormatEnum format,
+    const GenotypeMatrixMultiAllelicEnum multiallelic_mode, const uint64_t block_num_variants, const unsigned num_threads)
+  : SingleVariantOperatorBase()
+{
+  if(!id_mapper.is_initialized())
+    throw GenotypeMatrixExportException("Id mapper is not initialized");
+  m_vid_mapper = &id_mapper;
+  m_format = format;
+  m_multiallelic_mode = multiallelic_mode;
+  if(m_format == GENOTYPE_MATRIX_FORMAT_PLINK_BED && m_multiallelic_mode == GENOTYPE_MATRIX_MULTIALLELIC_ALT_COUNT)
+    throw GenotypeMatrixExportException("Multiallelic mode ALT_COUNT is not supported with the PLINK format - PLINK variants have a single A1 allele");
+  m_block_num_variants = std::max<uint64_t>(block_num_variants, 1ull);
+  m_num_threads = std::max(num_threads, 1u);
+  m_finalized = false;
+  m_prefix = prefix;
+  m_num_samples = query_config.get_num_rows_to_query();
+  if(m_num_samples == 0ull)
+    throw GenotypeMatrixExportException("No rows/samples to export in the genotype matrix");
+  m_num_variants = 0ull;
+  m_num_variants_in_block = 0ull;
+  m_curr_contig_begin_position = -1ll;
+  m_curr_contig_end_position = -1ll;
+  m_curr_position = -1ll;
+  m_GT_query_idx = UNDEFINED_ATTRIBUTE_IDX_VALUE;
+  for(auto i=0u;i<query_config.get_num_queried_attributes();++i)
+    if(query_config.is_defined_known_field_enum_for_query_idx(i) && query_config.get_known_field_enum_for_query_idx(i) == GVCF_GT_IDX)
+      m_GT_query_idx = i;
+  if(m_GT_query_idx == UNDEFINED_ATTRIBUTE_IDX_VALUE)
+    throw GenotypeMatrixExportException("GT must be one of the queried attributes to export a genotype matrix");
+  m_block_dosages.resize(m_block_num_variants*m_num_samples);
+  //Sample table
+  std::ofstream samples_fptr((prefix+".fam").c_str(), std::ios::out | std::ios::trunc);
+  if(!samples_fptr.is_open())
+    throw GenotypeMatrixExportException(std::string("Could not open sample table ")+prefix+".fam for writing");
+  for(auto i=0ull;i<m_num_samples;++i)
+  {
+    auto row_idx = query_config.get_array_row_idx_for_query_row_idx(i);
+    if(!m_vid_mapper->get_callset_name(row_idx, m_tmp_string))
+      m_tmp_string = std::to_string(row_idx);
+    samples_fptr << m_tmp_string << '\t' << m_tmp_string << "\t0\t0\t0\t-9\n";
+  }
+  samples_fptr.close();
+  //Variant table and matrix
+  m_variants_fptr.open((prefix+".bim").c_str(), std::ios::out | std::ios::trunc);
+  if(!m_variants_fptr.is_open())
+    throw GenotypeMatrixExportException(std::string("Could not open variant table ")+prefix+".bim for writing");
+  auto matrix_filename = prefix + ((m_format == GENOTYPE_MATRIX_FORMAT_PLINK_BED) ? ".bed" : ".dosage");
+  m_matrix_fptr.open(matrix_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if(!m_matrix_fptr.is_open())
+    throw GenotypeMatrixExportException(std::string("Could not open genotype matrix ")+matrix_filename+" for writing");
+  if(m_format == GENOTYPE_MATRIX_FORMAT_PLINK_BED)
+    m_matrix_fptr.write(reinterpret_cast<const char*>(g_plink_bed_header), sizeof(g_plink_bed_header));
+}
+
+GenotypeMatrixExportOperator::~GenotypeMatrixExportOperator()
+{
+  //Files are left without the last block if finalize() was never called
+  if(m_matrix_fptr.is_open())
+    m_matrix_fptr.close();
+  if(m_variants_fptr.is_open())
+    m_variants_fptr.close();
+}
+
+void GenotypeMatrixExportOperator::update_contig(const int64_t column)
+{
+  if(column >= m_curr_contig_begin_position && column < m_curr_contig_end_position)
+    return;
+  int64_t contig_position = -1ll;
+  if(!m_vid_mapper->get_contig_location(column, m_curr_contig_name, contig_position))
+    throw GenotypeMatrixExportException("Unknown contig for position "+std::to_string(column));
+  ContigInfo info;
+  VERIFY_OR_THROW(m_vid_mapper->get_contig_info(m_curr_contig_name, info));
+  m_curr_contig_begin_position = column - contig_position;
+  m_curr_contig_end_position = m_curr_contig_begin_position + info.m_length;
+}
+
+bool GenotypeMatrixExportOperator::get_merged_GT(const Variant& variant, const uint64_t call_idx_in_variant)
+{
+  const auto& call = variant.get_call(call_idx_in_variant);
+  if(!call.is_valid())
+    return false;
+  auto* GT_field_ptr = call.get_field<VariantFieldPrimitiveVectorData<int>>(m_GT_query_idx);
+  if(GT_field_ptr == 0 || !GT_field_ptr->is_valid())
+    return false;
+  const auto& input_GT = GT_field_ptr->get();
+  if(input_GT.empty())
+    return false;
+  m_GT_vec.resize(input_GT.size());
+  VariantOperations::remap_GT_field(input_GT, m_GT_vec, m_alleles_LUT, call_idx_in_variant,
+      m_merged_alt_alleles.size()+1u, m_NON_REF_exists);
+  for(auto allele_idx : m_GT_vec)
+    if(allele_idx < 0 || is_bcf_missing_value<int>(allele_idx) || is_tiledb_missing_value<int>(allele_idx))
+      return false;
+  //Deletion that began before this site - only a homozygous REF genotype says anything about this site
+  if(call.contains_deletion() && variant.get_column_begin() > call.get_column_begin())
+    for(auto allele_idx : m_GT_vec)
+      if(allele_idx != 0)
+        return false;
+  return true;
+}
+
+void GenotypeMatrixExportOperator::add_variant_row(const unsigned site_row_idx, const std::string& alt)
+{
+  if(m_num_samples > 0ull)
+    memcpy(&(m_block_dosages[m_num_variants_in_block*m_num_samples]), &(m_site_dosages[site_row_idx*m_num_samples]),
+        m_num_samples);
+  //PLINK .bim - contig, id, genetic distance, position, A1, A2
+  m_variants_fptr << m_curr_contig_name << '\t' << m_curr_contig_name << ':' << m_curr_position << ':'
+    << m_merged_reference_allele << ':' << alt << "\t0\t" << m_curr_position << '\t' << alt << '\t'
+    << m_merged_reference_allele << '\n';
+  ++m_num_variants;
+  ++m_num_variants_in_block;
+  if(m_num_variants_in_block == m_block_num_variants)
+    flush_block();
+}
+
+void GenotypeMatrixExportOperator::operate(Variant& variant, const VariantQueryConfig& query_config)
+{
+  SingleVariantOperatorBase::operate(variant, query_config);
+  if(m_is_reference_block_only)
+    return;
+  m_exported_allele_idxs.clear();
+  m_is_exported_allele.assign(m_merged_alt_alleles.size()+1u, false);
+  for(auto i=0u;i<m_merged_alt_alleles.size();++i)
+    if(m_merged_alt_alleles[i] != g_vcf_NON_REF && m_merged_alt_alleles[i] != g_vcf_SPANNING_DELETION)
+    {
+      m_exported_allele_idxs.push_back(i+1u);
+      m_is_exported_allele[i+1u] = true;
+    }
+  if(m_exported_allele_idxs.empty())
+    return;
+  auto column_begin = static_cast<int64_t>(variant.get_column_begin());
+  update_contig(column_begin);
+  m_curr_position = column_begin - m_curr_contig_begin_position + 1;
+  assert(variant.get_num_calls() == m_num_samples);
+  //Alt allele count of every sample for every exported row of this site
+  auto num_rows = (m_multiallelic_mode == GENOTYPE_MATRIX_MULTIALLELIC_SPLIT) ? m_exported_allele_idxs.size() : 1u;
+  m_site_dosages.resize(num_rows*m_num_samples);
+  for(auto i=0ull;i<m_num_samples;++i)
+  {
+    auto is_known = get_merged_GT(variant, i);
+    for(auto j=0u;j<num_rows;++j)
+    {
+      auto& dosage = m_site_dosages[j*m_num_samples+i];
+      dosage = GENOTYPE_MATRIX_MISSING_DOSAGE;
+      if(!is_known)
+        continue;
+      auto count = 0u;
+      for(auto allele_idx : m_GT_vec)
+        count += (m_multiallelic_mode == GENOTYPE_MATRIX_MULTIALLELIC_SPLIT)
+          ? (static_cast<unsigned>(allele_idx) == m_exported_allele_idxs[j] ? 1u : 0u)
+          : ((static_cast<size_t>(allele_idx) < m_is_exported_allele.size() && m_is_exported_allele[allele_idx]) ? 1u : 0u);
+      //PLINK stores haploid calls as homozygous diploid calls
+      if(m_format == GENOTYPE_MATRIX_FORMAT_PLINK_BED && m_GT_vec.size() == 1u)
+        count *= 2u;
+      if(count <= ((m_format == GENOTYPE_MATRIX_FORMAT_PLINK_BED) ? 2u : 127u))
+        dosage = count;
+    }
+  }
+  //Variant rows - a block may end in the middle of a site
+  if(m_multiallelic_mode == GENOTYPE_MATRIX_MULTIALLELIC_SPLIT)
+  {
+    for(auto j=0u;j<num_rows;++j)
+      add_variant_row(j, m_merged_alt_alleles[m_exported_allele_idxs[j]-1u]);
+  }
+  else
+  {
+    m_tmp_string.clear();
+    for(auto j=0u;j<m_exported_allele_idxs.size();++j)
+    {
+      if(j > 0u)
+        m_tmp_string.push_back(',');
+      m_tmp_string += m_merged_alt_alleles[m_exported_allele_idxs[j]-1u];
+    }
+    add_variant_row(0u, m_tmp_string);
+  }
+}
+
+void GenotypeMatrixExportOperator::flush_block()
+{
+  if(m_num_variants_in_block == 0ull)
+    return;
+  if(m_format == GENOTYPE_MATRIX_FORMAT_DOSAGE)
+    m_matrix_fptr.write(reinterpret_cast<const char*>(&(m_block_dosages[0])), m_num_variants_in_block*m_num_samples);
+  else
+  {
+    //Rows are byte aligned - pack the rows of the block in parallel
+    auto num_bytes_per_row = (m_num_samples+3ull)/4ull;
+    m_block_buffer.resize(m_num_variants_in_block*num_bytes_per_row+1u);
+    const auto num_samples = m_num_samples;
+#pragma omp parallel for default(shared) num_threads(m_num_threads) schedule(static)
+    for(auto i=0ull;i<m_num_variants_in_block;++i)
+    {
+      const auto* dosages = &(m_block_dosages[i*num_samples]);
+      auto* packed = &(m_block_buffer[i*num_bytes_per_row]);
+      for(auto j=0ull;j<num_bytes_per_row;++j)
+      {
+        uint8_t byte = 0u;
+        //Unused bits of the last byte are 0
+        for(auto k=0ull;k<4ull && 4ull*j+k<num_samples;++k)
+        {
+          auto dosage = dosages[4ull*j+k];
+          byte |= (g_plink_bed_codes[(dosage == GENOTYPE_MATRIX_MISSING_DOSAGE) ? 3 : dosage] << (2ull*k));
+        }
+        packed[j] = byte;
+      }
+    }
+    m_matrix_fptr.write(reinterpret_cast<const char*>(&(m_block_buffer[0])), m_num_variants_in_block*num_bytes_per_row);
+  }
+  if(!m_matrix_fptr.good())
+    throw GenotypeMatrixExportException(std::string("Error while writing the genotype matrix of ")+m_prefix);
+  m_num_variants_in_block = 0ull;
+}
+
+void GenotypeMatrixExportOperator::finalize()
+{
+  if(m_finalized)
+    return;
+  flush_block();
+  m_matrix_fptr.close();
+  m_variants_fptr.close();
+  if(m_matrix_fptr.fail() || m_variants_fptr.fail())
+    throw GenotypeMatrixExportException(std::string("Error while closing the genotype matrix files of ")+m_prefix);
+  m_finalized = true;
+}
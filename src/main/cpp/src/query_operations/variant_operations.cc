@@ -72,13 +72,8 @@ void* RemappedVariant::put_address(uint64_t input_call_idx, unsigned allele_or_g
 void VariantOperations::merge_reference_allele(const Variant& variant, const VariantQueryConfig& query_config, 
     std::string& merged_reference_allele)
 {
-  auto* longer_ref = &merged_reference_allele;
-  auto merged_ref_length = merged_reference_allele.length();
-  if(merged_ref_length == 0u)
-  {
+  if(merged_reference_allele.length() == 0u)
     merged_reference_allele = "N";
-    merged_ref_length = 1u;
-  }
   //assert(variant.get_query_config());
   //const VariantQueryConfig& query_config = *(variant.get_query_config());
   //Iterate over valid calls
@@ -88,36 +83,41 @@ void VariantOperations::merge_reference_allele(const Variant& variant, const Var
     if(curr_valid_call.get_column_begin() < variant.get_column_begin())
       continue;
     auto& curr_ref = get_known_field<VariantFieldString, true>(curr_valid_call, query_config, GVCF_REF_IDX)->get();
-    auto curr_ref_length = curr_ref.length();
-    auto* shorter_ref = &curr_ref;
-    const auto is_curr_ref_longer = (curr_ref_length > merged_ref_length);
-    if(is_curr_ref_longer)
-    {
-      longer_ref = const_cast<std::string*>(&curr_ref);
-      shorter_ref = &merged_reference_allele;
-    }
+    merge_reference_allele(curr_ref, merged_reference_allele);
+  }
+}
+
+void VariantOperations::merge_reference_allele(const std::string& curr_ref, std::string& merged_reference_allele)
+{
+  auto merged_ref_length = merged_reference_allele.length();
+  if(merged_ref_length == 0u)
+  {
+    merged_reference_allele = "N";
+    merged_ref_length = 1u;
+  }
+  auto curr_ref_length = curr_ref.length();
+  const auto is_curr_ref_longer = (curr_ref_length > merged_ref_length);
 #ifdef DEBUG
-    //sanity check only - the shorter ref must be a prefix of the longer ref (since they begin at the same location)
-    if(!CHECK_IN_THE_MIDDLE_REF(merged_reference_allele) && !CHECK_IN_THE_MIDDLE_REF(curr_ref) && longer_ref->find(*shorter_ref) != 0)
-    {
-      throw std::invalid_argument(std::string{"When combining variants at a given position, the shorter reference allele should be a prefix of the longer reference allele: \'"} + *shorter_ref + " , " + *longer_ref);
-    }
+  auto* longer_ref = is_curr_ref_longer ? &curr_ref : &merged_reference_allele;
+  auto* shorter_ref = is_curr_ref_longer ? &merged_reference_allele : &curr_ref;
+  //sanity check only - the shorter ref must be a prefix of the longer ref (since they begin at the same location)
+  if(!CHECK_IN_THE_MIDDLE_REF(merged_reference_allele) && !CHECK_IN_THE_MIDDLE_REF(curr_ref) && longer_ref->find(*shorter_ref) != 0)
+  {
+    throw std::invalid_argument(std::string{"When combining variants at a given position, the shorter reference allele should be a prefix of the longer reference allele: \'"} + *shorter_ref + " , " + *longer_ref);
+  }
 #endif
-    if(is_curr_ref_longer)
-    {
-      if(curr_ref_length >= merged_reference_allele.capacity())
-	merged_reference_allele.reserve(2*curr_ref_length+1);	//why 2, why not?
-      if(merged_ref_length > 0 && CHECK_IN_THE_MIDDLE_REF(merged_reference_allele))
-        merged_reference_allele = curr_ref;
-      else      //append remaining chars to merged reference
-        merged_reference_allele.append(curr_ref, merged_ref_length, curr_ref_length - merged_ref_length);
-      merged_ref_length = curr_ref_length;
-      longer_ref = &merged_reference_allele;
-    }
-    else
-      if(CHECK_IN_THE_MIDDLE_REF(merged_reference_allele) && !CHECK_IN_THE_MIDDLE_REF(curr_ref))
-        merged_reference_allele = curr_ref;
+  if(is_curr_ref_longer)
+  {
+    if(curr_ref_length >= merged_reference_allele.capacity())
+      merged_reference_allele.reserve(2*curr_ref_length+1);	//why 2, why not?
+    if(merged_ref_length > 0 && CHECK_IN_THE_MIDDLE_REF(merged_reference_allele))
+      merged_reference_allele = curr_ref;
+    else      //append remaining chars to merged reference
+      merged_reference_allele.append(curr_ref, merged_ref_length, curr_ref_length - merged_ref_length);
   }
+  else
+    if(CHECK_IN_THE_MIDDLE_REF(merged_reference_allele) && !CHECK_IN_THE_MIDDLE_REF(curr_ref))
+      merged_reference_allele = curr_ref;
 }
 
 /*
@@ -134,48 +134,90 @@ void VariantOperations::merge_alt_alleles(const Variant& variant,
     const VariantQueryConfig& query_config,
     const std::string& merged_reference_allele,
     CombineAllelesLUT& alleles_LUT, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists) {
-  // marking non_reference_allele as already seen will ensure it's not included in the middle
-  auto seen_alleles = std::unordered_map<std::string, int>{{g_vcf_NON_REF,-1}};
-  merged_alt_alleles.clear();
-  auto merged_reference_length = merged_reference_allele.length();
-  //invalidate all existing mappings in the LUT
-  alleles_LUT.reset_luts();
-  //vector to store idx mappings for NON_REF allele, update LUT at end as #ALT alleles are not known till end
-  //Set everything to -1 (invalid mapping)
-  auto input_non_reference_allele_idx = std::vector<int>(variant.get_num_calls(), -1);
-  auto merged_allele_idx = 1u;	//why 1, ref is index 0, alt begins at 1
-  NON_REF_exists = false;       //by default, assume NON_REF does not exist
-  //Get VariantQueryConfig
-  //assert(variant.get_query_config());
-  //const VariantQueryConfig& query_config = *(variant.get_query_config());
+  //Alleles of each call indexed by its idx in the variant - null for invalid calls
+  auto& reference_alleles = alleles_LUT.m_input_reference_alleles;
+  auto& alt_alleles = alleles_LUT.m_input_alt_alleles;
+  reference_alleles.assign(variant.get_num_calls(), 0);
+  alt_alleles.assign(variant.get_num_calls(), 0);
   //Iterate over valid calls
   for (auto valid_calls_iter=variant.begin();valid_calls_iter != variant.end();++valid_calls_iter)
   {
     const auto& curr_valid_call = *valid_calls_iter;
     //Not always in sequence, as invalid calls are skipped
     auto curr_call_idx_in_variant = valid_calls_iter.get_call_idx_in_variant();
-    const auto& curr_reference =
-      get_known_field<VariantFieldString, true>(curr_valid_call, query_config, GVCF_REF_IDX)->get();
-    const auto& curr_reference_length = curr_reference.length();
-    const auto& curr_allele_vector = 
-      get_known_field<VariantFieldALTData, true>(curr_valid_call, query_config, GVCF_ALT_IDX)->get();
-    auto is_suffix_needed = false;
-    auto suffix_length = 0u;
-    if(curr_reference_length < merged_reference_length)
-    {
-      is_suffix_needed = true;
-      suffix_length = merged_reference_length - curr_reference_length;
-    }
-    //mapping for reference allele 0 -> 0
-    alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, 0, 0);
-    auto input_allele_idx = 1u;	//why 1, ref is index 0, alt begins at 1
-    //copy of allele if needed
-    std::string copy_allele;
-    for (const auto& allele : curr_allele_vector)
+    reference_alleles[curr_call_idx_in_variant] =
+      &(get_known_field<VariantFieldString, true>(curr_valid_call, query_config, GVCF_REF_IDX)->get());
+    alt_alleles[curr_call_idx_in_variant] =
+      &(get_known_field<VariantFieldALTData, true>(curr_valid_call, query_config, GVCF_ALT_IDX)->get());
+  }
+  merge_alt_alleles(reference_alleles, alt_alleles, merged_reference_allele, alleles_LUT, merged_alt_alleles, NON_REF_exists);
+}
+
+//Slot of allele in the open addressing table - the slot either holds the merged idx of allele or is empty (0)
+static inline size_t find_merged_allele_slot(const std::vector<unsigned>& hash_table,
+    const std::vector<std::string>& merged_alt_alleles, const std::string& allele)
+{
+  assert(hash_table.size() > 0u && (hash_table.size() & (hash_table.size()-1u)) == 0u);
+  auto mask = hash_table.size()-1u;
+  auto slot = std::hash<std::string>()(allele) & mask;
+  while(hash_table[slot] != 0u && merged_alt_alleles[hash_table[slot]-1u] != allele)
+    slot = (slot+1u) & mask;
+  return slot;
+}
+
+//Keeps the load factor of the table at or below 1/2 when num_merged_alleles alleles are stored
+static void resize_merged_allele_hash_table_if_needed(std::vector<unsigned>& hash_table,
+    const std::vector<std::string>& merged_alt_alleles, const size_t num_merged_alleles)
+{
+  if(2u*num_merged_alleles <= hash_table.size())
+    return;
+  auto new_size = std::max<size_t>(hash_table.size(), 16u);
+  while(2u*num_merged_alleles > new_size)
+    new_size *= 2u;
+  hash_table.assign(new_size, 0u);
+  for(auto i=0u;i<merged_alt_alleles.size();++i)
+    hash_table[find_merged_allele_slot(hash_table, merged_alt_alleles, merged_alt_alleles[i])] = i+1u;
+}
+
+/*
+ * Same as merge_alt_alleles() above - the inputs are allele lists instead of calls, input idx i in the LUT
+ * corresponds to reference_alleles[i] and alt_alleles[i]. Null entries are skipped
+ * Alleles seen so far are exactly merged_alt_alleles (merged idx = position+1) - the hash table in the LUT maps
+ * them to their idx without copying the strings and is reused across sites
+ */
+void VariantOperations::merge_alt_alleles(const std::vector<const std::string*>& reference_alleles,
+    const std::vector<const std::vector<std::string>*>& alt_alleles,
+    const std::string& merged_reference_allele,
+    CombineAllelesLUT& alleles_LUT, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists)
+{
+  assert(reference_alleles.size() == alt_alleles.size());
+  merged_alt_alleles.clear();
+  auto merged_reference_length = merged_reference_allele.length();
+  alleles_LUT.reset_luts();
+  auto& input_non_reference_allele_idx = alleles_LUT.m_input_non_reference_allele_idx;
+  input_non_reference_allele_idx.assign(alt_alleles.size(), -1);
+  auto merged_allele_idx = 1u;	//REF is index 0
+  NON_REF_exists = false;
+  auto& hash_table = alleles_LUT.m_merged_allele_hash_table;
+  resize_merged_allele_hash_table_if_needed(hash_table, merged_alt_alleles, 1u);
+  std::fill(hash_table.begin(), hash_table.end(), 0u);
+  auto& copy_allele = alleles_LUT.m_suffixed_allele;
+  for(auto input_idx=0ull;input_idx<alt_alleles.size();++input_idx)
+  {
+    if(alt_alleles[input_idx] == 0)
+      continue;
+    assert(reference_alleles[input_idx]);
+    auto curr_reference_length = reference_alleles[input_idx]->length();
+    auto is_suffix_needed = (curr_reference_length < merged_reference_length);
+    auto suffix_length = is_suffix_needed ? merged_reference_length - curr_reference_length : 0u;
+    alleles_LUT.add_input_merged_idx_pair(input_idx, 0, 0);
+    auto input_allele_idx = 1u;
+    for(const auto& allele : *(alt_alleles[input_idx]))
     {
-      if(IS_NON_REF_ALLELE(allele))
+      //Lists produced by an earlier merge spell NON_REF out - NON_REF is never placed in the middle of the merged list
+      if(IS_NON_REF_ALLELE(allele) || allele == g_vcf_NON_REF)
       {
-        input_non_reference_allele_idx[curr_call_idx_in_variant] = input_allele_idx;
+        input_non_reference_allele_idx[input_idx] = input_allele_idx;
         NON_REF_exists = true;
       }
       else
@@ -185,44 +227,33 @@ void VariantOperations::merge_alt_alleles(const Variant& variant,
         {
           copy_allele = allele;
           copy_allele.append(merged_reference_allele, curr_reference_length, suffix_length);
-          allele_ptr = &copy_allele; //allele_ptr now points to a copy of var.alt()[l] (+suffix), hence it's safe to move later
+          allele_ptr = &copy_allele;
         }
-        const auto& iter_pos = seen_alleles.find(*allele_ptr);
-        if (iter_pos == seen_alleles.end()) { //allele seen for the first time
-          seen_alleles[*allele_ptr] = merged_allele_idx;
-          //always check whether LUT is big enough for alleles_LUT (since the #alleles in the merged variant is unknown)
-          //Most of the time this function will return quickly (just an if condition check)
-          alleles_LUT.resize_luts_if_needed(merged_allele_idx + 1); 
-          alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, input_allele_idx, merged_allele_idx);
-          if(is_suffix_needed)
-            merged_alt_alleles.push_back(std::move(*allele_ptr)); //allele_ptr points to a copy - use move
-          else
-            merged_alt_alleles.push_back(*allele_ptr);	//allele_ptr points to curr_allele_vector[input_allele_idx] - copy to vector
+        auto slot = find_merged_allele_slot(hash_table, merged_alt_alleles, *allele_ptr);
+        if(hash_table[slot] == 0u) //allele seen for the first time
+        {
+          alleles_LUT.resize_luts_if_needed(merged_allele_idx + 1);
+          alleles_LUT.add_input_merged_idx_pair(input_idx, input_allele_idx, merged_allele_idx);
+          merged_alt_alleles.push_back(*allele_ptr);
+          hash_table[slot] = merged_allele_idx;
           ++merged_allele_idx;
+          resize_merged_allele_hash_table_if_needed(hash_table, merged_alt_alleles, merged_alt_alleles.size()+1u);
         }
         else
-          alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, input_allele_idx, (*iter_pos).second);
+          alleles_LUT.add_input_merged_idx_pair(input_idx, input_allele_idx, hash_table[slot]);
       }
       ++input_allele_idx;
     }
   }
-  if(NON_REF_exists)    //if NON_REF allele exists
+  if(NON_REF_exists)
   {
-    // always want non_reference_allele to be last
+    //NON_REF is always the last allele
     merged_alt_alleles.push_back(g_vcf_NON_REF);
-    auto non_reference_allele_idx = merged_alt_alleles.size(); //why not -1, include reference allele also
-    //always check whether LUT is big enough for alleles_LUT (since the #alleles in the merged variant is unknown)
-    alleles_LUT.resize_luts_if_needed(non_reference_allele_idx + 1); 
-    //Add mappings for non_ref allele
-    //Iterate over valid calls
-    for (auto valid_calls_iter=variant.begin();valid_calls_iter != variant.end();++valid_calls_iter)
-    {
-      //Not always in sequence, as invalid calls are skipped
-      auto curr_call_idx_in_variant = valid_calls_iter.get_call_idx_in_variant();
-      if(input_non_reference_allele_idx[curr_call_idx_in_variant] >= 0)
-        alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, input_non_reference_allele_idx[curr_call_idx_in_variant],
-            non_reference_allele_idx);
-    }
+    auto non_reference_allele_idx = merged_alt_alleles.size();
+    alleles_LUT.resize_luts_if_needed(non_reference_allele_idx + 1);
+    for(auto input_idx=0ull;input_idx<alt_alleles.size();++input_idx)
+      if(input_non_reference_allele_idx[input_idx] >= 0)
+        alleles_LUT.add_input_merged_idx_pair(input_idx, input_non_reference_allele_idx[input_idx], non_reference_allele_idx);
   }
 }
 
@@ -419,6 +450,9 @@ GA4GHOperator::GA4GHOperator(const VariantQueryConfig& query_config, const unsig
   m_remapped_variant.resize_common_fields(2u);
   m_remapped_variant.set_common_field(0u, query_config.get_query_idx_for_known_field_enum(GVCF_REF_IDX), 0);
   m_remapped_variant.set_common_field(1u, query_config.get_query_idx_for_known_field_enum(GVCF_ALT_IDX), 0);
+  //vector of field pointers used for handling remapped fields when dealing with spanning deletions
+  //Individual pointers will be allocated later
+  m_spanning_deletions_remapped_fields.resize(m_remapped_fields_query_idxs.size());
 }
 
 std::unique_ptr<VariantFieldHandlerBase>& GA4GHOperator::get_handler_for_type(std::type_index ty)
@@ -503,6 +537,11 @@ void GA4GHOperator::operate(Variant& variant, const VariantQueryConfig& query_co
       }
     }
   }
+  set_merged_alleles_in_remapped_variant();
+}
+
+void GA4GHOperator::set_merged_alleles_in_remapped_variant()
+{
   uint64_t offset = 0;
   //Assign REF and ALT common fields
   auto& REF = m_remapped_variant.get_common_field(0u);
@@ -566,6 +605,158 @@ void GA4GHOperator::copy_back_remapped_fields(Variant& variant) const
 }
 
 
+//Modifies original Variant object
+void GA4GHOperator::reduce_spanning_deletions(Variant& variant, const VariantQueryConfig& query_config)
+{
+  m_reduced_alleles_LUT.resize_luts_if_needed(variant.get_num_calls(), 10u);    //will not have more than 3 alleles anyway
+  m_reduced_alleles_LUT.reset_luts();
+  for(auto iter=variant.begin(), e=variant.end();iter != e;++iter)
+  {
+    auto& curr_call = *iter;
+    auto curr_call_idx_in_variant = iter.get_call_idx_in_variant();
+    //Deletion and not handled as spanning deletion 
+    //So replace the ALT with *,<NON_REF> and REF with "N"
+    //Remap PL, AD fields
+    if(curr_call.contains_deletion() && variant.get_column_begin() > curr_call.get_column_begin())
+    {
+      auto& ref_allele = get_known_field<VariantFieldString, true>(curr_call, query_config, GVCF_REF_IDX)->get();
+      auto& alt_alleles = get_known_field<VariantFieldALTData, true>(curr_call, query_config, GVCF_ALT_IDX)->get();
+      assert(alt_alleles.size() > 0u);
+      //Already handled as a spanning deletion, nothing to do
+      if(alt_alleles[0u] == g_vcf_SPANNING_DELETION)
+        continue;
+      //Reduced allele list will be REF="N", ALT="*, <NON_REF>"
+      m_reduced_alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, 0, 0);  //REF-REF mapping
+      //Need to find deletion allele with lowest PL value - this deletion allele is mapped to "*" allele
+      auto lowest_deletion_allele_idx = -1;
+      int lowest_PL_value = INT_MAX;
+      auto PL_field_ptr = get_known_field_if_queried<VariantFieldPrimitiveVectorData<int>, true>(curr_call, query_config, GVCF_PL_IDX);
+      auto has_NON_REF = false;
+      //PL field exists
+      if(PL_field_ptr)
+      {
+        auto& PL_vector = PL_field_ptr->get();
+        for(auto i=0u;i<alt_alleles.size();++i)
+        {
+          auto allele_idx = i+1;  //+1 for REF
+          if(VariantUtils::is_deletion(ref_allele, alt_alleles[i]))
+          {
+            unsigned gt_idx = bcf_alleles2gt(allele_idx, allele_idx);
+            assert(gt_idx < PL_vector.size());
+            if(PL_vector[gt_idx] < lowest_PL_value || lowest_deletion_allele_idx < 0)
+            {
+              lowest_PL_value = PL_vector[gt_idx];
+              lowest_deletion_allele_idx = allele_idx;
+            }
+          }
+          else
+            if(IS_NON_REF_ALLELE(alt_alleles[i]))
+            {
+              m_reduced_alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, allele_idx, 2);
+              has_NON_REF = true;
+            }
+        }
+      }
+      else      //PL field is not queried, simply use the first ALT allele
+        lowest_deletion_allele_idx = 1;
+      assert(lowest_deletion_allele_idx >= 1);    //should be an ALT allele
+      //first ALT allele in reduced list is *
+      m_reduced_alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, lowest_deletion_allele_idx, 1); 
+      if(has_NON_REF)
+      {
+        alt_alleles.resize(2u);
+        alt_alleles[1u] = TILEDB_NON_REF_VARIANT_REPRESENTATION;
+      }
+      else
+        alt_alleles.resize(1u); //only spanning deletion
+      ref_allele = "N"; //set to unknown REF for now
+      alt_alleles[0u] = g_vcf_SPANNING_DELETION;
+      unsigned num_reduced_alleles = alt_alleles.size() + 1u;   //+1 for REF
+      //Remap fields that need to be remapped
+      for(auto i=0u;i<m_remapped_fields_query_idxs.size();++i)
+      {
+        auto query_field_idx = m_remapped_fields_query_idxs[i];
+        auto length_descriptor = query_config.get_length_descriptor_for_query_attribute_idx(query_field_idx);
+        //field whose length is dependent on #alleles
+        assert(KnownFieldInfo::is_length_descriptor_allele_dependent(length_descriptor));
+        unsigned num_reduced_elements = KnownFieldInfo::get_num_elements_given_length_descriptor(length_descriptor, num_reduced_alleles-1u, 0u, 0u);     //#alt alleles
+        //Remapper for variant
+        RemappedVariant remapper_variant(variant, query_field_idx); 
+        auto& curr_field = curr_call.get_field(query_field_idx);
+        if(curr_field.get() && curr_field->is_valid())      //Not null
+        {
+          //Copy field to pass to remap function 
+          assert(i < m_spanning_deletions_remapped_fields.size());
+          copy_field(m_spanning_deletions_remapped_fields[i], curr_field);
+          curr_field->resize(num_reduced_elements);
+          //Get handler for current type
+          auto& handler = get_handler_for_type(curr_field->get_element_type());
+          assert(handler.get());
+          //Call remap function
+          handler->remap_vector_data(
+              m_spanning_deletions_remapped_fields[i], curr_call_idx_in_variant,
+              m_reduced_alleles_LUT, num_reduced_alleles, has_NON_REF,
+              length_descriptor, num_reduced_elements, remapper_variant);
+        }
+      }
+      //GT field
+      if(m_GT_query_idx != UNDEFINED_ATTRIBUTE_IDX_VALUE)
+      {
+
+        auto& original_GT_field = curr_call.get_field(m_GT_query_idx);
+        if(original_GT_field.get() && original_GT_field->is_valid())
+        {
+          auto& input_GT =
+            curr_call.get_field<VariantFieldPrimitiveVectorData<int>>(m_GT_query_idx)->get();
+          m_spanning_deletion_remapped_GT.resize(input_GT.size());
+          VariantOperations::remap_GT_field(input_GT, m_spanning_deletion_remapped_GT, m_reduced_alleles_LUT, curr_call_idx_in_variant,
+              num_reduced_alleles, has_NON_REF);
+          //Copy back
+          memcpy(&(input_GT[0]), &(m_spanning_deletion_remapped_GT[0]), input_GT.size()*sizeof(int));
+        }
+      }
+    }
+  }
+}
+
+
+//PartialCombineOperator functions
+PartialCombineOperator::PartialCombineOperator(const VariantQueryConfig& query_config, std::vector<uint8_t>& buffer,
+    const uint64_t buffer_size_limit, const unsigned max_diploid_alt_alleles_that_can_be_genotyped)
+  : GA4GHOperator(query_config, max_diploid_alt_alleles_that_can_be_genotyped)
+{
+  m_buffer = &buffer;
+  m_num_valid_bytes = 0ull;
+  m_buffer_size_limit = buffer_size_limit;
+}
+
+void PartialCombineOperator::operate(Variant& variant, const VariantQueryConfig& query_config)
+{
+  reduce_spanning_deletions(variant, query_config);
+  GA4GHOperator::operate(variant, query_config);
+  auto num_merged_alt_alleles = m_merged_alt_alleles.size();
+  //m_remapped_variant only contains fields that were remapped - copy the other fields from the original variant
+  for(auto iter=m_remapped_variant.begin();iter!=m_remapped_variant.end();++iter)
+  {
+    auto& remapped_call = *iter;
+    auto& orig_call = variant.get_call(iter.get_call_idx_in_variant());
+    for(auto query_field_idx=0u;query_field_idx<query_config.get_num_queried_attributes();++query_field_idx)
+    {
+      auto length_descriptor = query_config.get_length_descriptor_for_query_attribute_idx(query_field_idx);
+      auto is_remapped_field = m_remapping_needed
+        && (KnownFieldInfo::is_length_descriptor_allele_dependent(length_descriptor) || query_field_idx == m_GT_query_idx);
+      auto& remapped_field = remapped_call.get_field(query_field_idx);
+      if(!is_remapped_field)
+        copy_field(remapped_field, orig_call.get_field(query_field_idx));
+      //Not remapped by GA4GHOperator - too many alleles, the reducer skips these fields as well
+      else if(KnownFieldInfo::is_length_descriptor_genotype_dependent(length_descriptor)
+          && too_many_alt_alleles_for_genotype_length_fields(num_merged_alt_alleles) && remapped_field.get())
+        remapped_field->set_valid(false);
+    }
+  }
+  m_remapped_variant.compact_binary_serialize(*m_buffer, m_num_valid_bytes, query_config);
+}
+
 //Single cell operators
 ColumnHistogramOperator::ColumnHistogramOperator(uint64_t begin, uint64_t end, uint64_t bin_size)
   : SingleCellOperatorBase()
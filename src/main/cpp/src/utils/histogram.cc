@@ -48,6 +48,16 @@ void Histogram::add_value(uint64_t value)
   ++m_total;
 }
 
+void Histogram::add_count(uint64_t value, uint64_t count)
+{
+  if(value < m_lo || value > m_hi)
+    throw HistogramException("Value "+std::to_string(value)+" is outsize the range of histogram ["+std::to_string(m_lo)
+        +","+std::to_string(m_hi)+"]"); 
+  unsigned bin_idx = get_bin_idx_for_value(value);
+  m_histogram_bins[bin_idx] += count;
+  m_total += count;
+}
+
 void Histogram::add_interval(uint64_t lo, uint64_t hi)
 {
   if(lo == hi)
@@ -82,14 +82,21 @@ void JSONConfigBase::read_from_file(const std::string& filename, const VidMapper
   m_json.Parse(str.c_str());
   if(m_json.HasParseError())
     throw RunConfigException(std::string("Syntax error in JSON file ")+filename);
-  FileBasedVidMapper tmp_vid_mapper;
-  //Null or un-initialized
+  //Null or un-initialized - record the mapping file names. The mappings themselves are loaded only if a
+  //contig name in this config must be resolved (see get_id_mapper below) - most loader/query configs
+  //specify TileDB columns and every component reading the config would otherwise re-parse the mappings
   if(id_mapper == 0 || !(id_mapper->is_initialized()))
-  {
-    read_and_initialize_vid_and_callset_mapping_if_available(&tmp_vid_mapper, rank);
-    if(tmp_vid_mapper.is_initialized())
-      id_mapper = &tmp_vid_mapper;
-  }
+    read_and_initialize_vid_and_callset_mapping_if_available(0, rank);
+  FileBasedVidMapper tmp_vid_mapper;
+  auto get_id_mapper = [&]() -> const VidMapper* {
+    if(id_mapper == 0 || !(id_mapper->is_initialized()))
+    {
+      read_and_initialize_vid_and_callset_mapping_if_available(&tmp_vid_mapper, rank);
+      if(tmp_vid_mapper.is_initialized())
+        id_mapper = &tmp_vid_mapper;
+    }
+    return id_mapper;
+  };
   //Workspace
   if(m_json.HasMember("workspace"))
   {
@@ -187,14 +194,15 @@ void JSONConfigBase::read_from_file(const std::string& filename, const VidMapper
           {
             ContigInfo contig_info;
             std::string contig_name = q3.GetString();
-            assert(id_mapper != 0);
-            if (!id_mapper->get_contig_info(contig_name, contig_info))
+            auto contig_id_mapper = get_id_mapper();
+            assert(contig_id_mapper != 0);
+            if (!contig_id_mapper->get_contig_info(contig_name, contig_info))
               throw VidMapperException("JSONConfigBase::read_from_file: Invalid contig name : " + contig_name );
             m_column_ranges[i][j].first = contig_info.m_tiledb_column_offset;
             m_column_ranges[i][j].second = contig_info.m_tiledb_column_offset + contig_info.m_length - 1;
           }
           else //must be object { "chr" : [ b , e ] }
-            extract_contig_interval_from_object(q3, id_mapper, m_column_ranges[i][j]);
+            extract_contig_interval_from_object(q3, get_id_mapper(), m_column_ranges[i][j]);
           if(m_column_ranges[i][j].first > m_column_ranges[i][j].second)
             std::swap<int64_t>(m_column_ranges[i][j].first, m_column_ranges[i][j].second);
         }
@@ -225,7 +233,7 @@ void JSONConfigBase::read_from_file(const std::string& filename, const VidMapper
           if(begin_json_value.IsInt64())
             m_column_ranges[partition_idx][0].first = begin_json_value.GetInt64();
           else
-            extract_contig_interval_from_object(begin_json_value, id_mapper, m_column_ranges[partition_idx][0]);
+            extract_contig_interval_from_object(begin_json_value, get_id_mapper(), m_column_ranges[partition_idx][0]);
           m_column_ranges[partition_idx][0].second = INT64_MAX-1;
           if(curr_partition_info_dict.HasMember(JSON_LOADER_PARTITION_INFO_END_FIELD_NAME))
           {
@@ -237,7 +245,7 @@ void JSONConfigBase::read_from_file(const std::string& filename, const VidMapper
             else
             {
               ColumnRange tmp_range;
-              extract_contig_interval_from_object(end_json_value, id_mapper, tmp_range);
+              extract_contig_interval_from_object(end_json_value, get_id_mapper(), tmp_range);
               m_column_ranges[partition_idx][0].second = tmp_range.first;
             }
           }
@@ -490,7 +498,7 @@ void JSONConfigBase::read_and_initialize_vid_and_callset_mapping_if_available(Fi
     (*id_mapper) = std::move(FileBasedVidMapper(vid_mapping_file, callset_mapping_file, m_lb_callset_row_idx, m_ub_callset_row_idx, false));
 }
 
-void JSONBasicQueryConfig::update_from_loader(JSONLoaderConfig* loader_config, const int rank)
+void JSONBasicQueryConfig::update_from_loader(const std::shared_ptr<const JSONLoaderConfig>& loader_config, const int rank)
 {
   if (!loader_config)
     return;
@@ -516,7 +524,8 @@ void JSONBasicQueryConfig::update_from_loader(JSONLoaderConfig* loader_config, c
     m_callset_mapping_file = loader_config->get_callset_mapping_filename();
 }
 
-void JSONBasicQueryConfig::subset_query_column_ranges_based_on_partition(const JSONLoaderConfig* loader_config, const int rank)
+void JSONBasicQueryConfig::subset_query_column_ranges_based_on_partition(const std::shared_ptr<const JSONLoaderConfig>& loader_config,
+    const int rank)
 {
   if(loader_config)
   {
@@ -540,7 +549,7 @@ void JSONBasicQueryConfig::subset_query_column_ranges_based_on_partition(const J
 }
 
 void JSONBasicQueryConfig::read_from_file(const std::string& filename, VariantQueryConfig& query_config,
-    FileBasedVidMapper* id_mapper, const int rank, JSONLoaderConfig* loader_config)
+    FileBasedVidMapper* id_mapper, const int rank, const std::shared_ptr<const JSONLoaderConfig>& loader_config)
 {
   //Need to parse here first because id_mapper initialization in read_and_initialize_vid_and_callset_mapping_if_available() requires
   //valid m_json object
@@ -613,14 +622,16 @@ JSONLoaderConfig::JSONLoaderConfig(
   m_row_based_partitioning = false;
   //Flag that controls whether the VCF indexes should be discarded to reduce memory consumption
   m_discard_vcf_index = true;
-  m_num_entries_in_circular_buffer = 1;
   m_num_converter_processes = 0;
   m_per_partition_size = 0;
-  m_max_size_per_callset = 0;
   //Array domain
   m_max_num_rows_in_array = INT64_MAX;
   //#VCF files to open/process in parallel
   m_num_parallel_vcf_files = 1;
+  //BGZF decompression inline by default
+  m_num_htslib_decompression_threads = 0;
+  //Idle VCF files closed immediately by default
+  m_vcf_handle_pool_size = 0u;
   //do ping-pong buffering
   m_do_ping_pong_buffering = true;
   //Offload VCF output processing to another thread
@@ -635,6 +646,9 @@ JSONLoaderConfig::JSONLoaderConfig(
   m_fail_if_updating = false;
   m_tiledb_compression_level = Z_DEFAULT_COMPRESSION;
   m_consolidate_tiledb_array_after_load = false;
+  m_reference_block_gq_bands.clear();
+  m_lightweight_end_copies = false;
+  m_dictionary_encoded_fields.clear();
 }
 
 void JSONLoaderConfig::read_from_file(const std::string& filename, FileBasedVidMapper* id_mapper, const int rank)
@@ -702,6 +716,14 @@ void JSONLoaderConfig::read_from_file(const std::string& filename, FileBasedVidM
   m_num_parallel_vcf_files = 1;
   if(m_json.HasMember("num_parallel_vcf_files"))
     m_num_parallel_vcf_files = m_json["num_parallel_vcf_files"].GetInt();
+  //#threads for BGZF decompression of VCF/BCF files
+  m_num_htslib_decompression_threads = 0;
+  if(m_json.HasMember("num_htslib_decompression_threads") && m_json["num_htslib_decompression_threads"].IsInt())
+    m_num_htslib_decompression_threads = std::max(m_json["num_htslib_decompression_threads"].GetInt(), 0);
+  //#idle VCF files kept open across batches
+  m_vcf_handle_pool_size = 0u;
+  if(m_json.HasMember("vcf_handle_pool_size") && m_json["vcf_handle_pool_size"].IsInt64())
+    m_vcf_handle_pool_size = std::max<int64_t>(m_json["vcf_handle_pool_size"].GetInt64(), 0);
   //do ping pong buffering
   m_do_ping_pong_buffering = true;
   if(m_json.HasMember("do_ping_pong_buffering"))
@@ -738,6 +760,35 @@ void JSONLoaderConfig::read_from_file(const std::string& filename, FileBasedVidM
   m_consolidate_tiledb_array_after_load = false;
   if(m_json.HasMember("consolidate_tiledb_array_after_load") && m_json["consolidate_tiledb_array_after_load"].IsBool())
     m_consolidate_tiledb_array_after_load = m_json["consolidate_tiledb_array_after_load"].GetBool();
+  //GQ bands for merging adjacent reference blocks at import
+  m_reference_block_gq_bands.clear();
+  if(m_json.HasMember("reference_block_gq_bands"))
+  {
+    const rapidjson::Value& bands = m_json["reference_block_gq_bands"];
+    VERIFY_OR_THROW(bands.IsArray() && "reference_block_gq_bands must be an array of integers");
+    for(rapidjson::SizeType i=0;i<bands.Size();++i)
+    {
+      VERIFY_OR_THROW(bands[i].IsInt() && "reference_block_gq_bands must be an array of integers");
+      m_reference_block_gq_bands.push_back(bands[i].GetInt());
+    }
+    std::sort(m_reference_block_gq_bands.begin(), m_reference_block_gq_bands.end());
+  }
+  //END copies of interval cells carry only co-ordinates and END - applies to newly created arrays only
+  m_lightweight_end_copies = false;
+  if(m_json.HasMember("lightweight_end_copies") && m_json["lightweight_end_copies"].IsBool())
+    m_lightweight_end_copies = m_json["lightweight_end_copies"].GetBool();
+  //Dictionary encoded string fields - applies to newly created arrays only
+  m_dictionary_encoded_fields.clear();
+  if(m_json.HasMember("dictionary_encoded_fields"))
+  {
+    const rapidjson::Value& fields = m_json["dictionary_encoded_fields"];
+    VERIFY_OR_THROW(fields.IsArray() && "dictionary_encoded_fields must be an array of field names");
+    for(rapidjson::SizeType i=0;i<fields.Size();++i)
+    {
+      VERIFY_OR_THROW(fields[i].IsString() && "dictionary_encoded_fields must be an array of field names");
+      m_dictionary_encoded_fields.push_back(fields[i].GetString());
+    }
+  }
 }
    
 #ifdef HTSDIR
@@ -852,9 +903,10 @@ void JSONVCFAdapterConfig::read_from_file(const std::string& filename,
 
 void JSONVCFAdapterQueryConfig::read_from_file(const std::string& filename, VariantQueryConfig& query_config,
         VCFAdapter& vcf_adapter, FileBasedVidMapper* id_mapper,
-        std::string output_format, const int rank, const size_t combined_vcf_records_buffer_size_limit)
+        std::string output_format, const int rank, const size_t combined_vcf_records_buffer_size_limit,
+        const std::shared_ptr<const JSONLoaderConfig>& loader_config)
 {
-  JSONBasicQueryConfig::read_from_file(filename, query_config, id_mapper, rank);
+  JSONBasicQueryConfig::read_from_file(filename, query_config, id_mapper, rank, loader_config);
   JSONVCFAdapterConfig::read_from_file(filename, vcf_adapter, output_format, rank, combined_vcf_records_buffer_size_limit);
 }
 #endif
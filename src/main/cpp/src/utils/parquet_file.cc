@@ -0,0 +1,1380 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "parquet_file.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw ParquetFileException(#X);
+
+//Thrift compact protocol types
+enum ThriftCompactTypeEnum
+{
+  THRIFT_COMPACT_BOOLEAN_TRUE=1,
+  THRIFT_COMPACT_BOOLEAN_FALSE,
+  THRIFT_COMPACT_BYTE,
+  THRIFT_COMPACT_I16,
+  THRIFT_COMPACT_I32,
+  THRIFT_COMPACT_I64,
+  THRIFT_COMPACT_DOUBLE,
+  THRIFT_COMPACT_BINARY,
+  THRIFT_COMPACT_LIST,
+  THRIFT_COMPACT_SET,
+  THRIFT_COMPACT_MAP,
+  THRIFT_COMPACT_STRUCT
+};
+
+//Values of the enums in parquet.thrift
+#define PARQUET_PAGE_TYPE_DATA_PAGE 0
+#define PARQUET_PAGE_TYPE_DICTIONARY_PAGE 2
+#define PARQUET_FIELD_REPETITION_REQUIRED 0
+#define PARQUET_FIELD_REPETITION_OPTIONAL 1
+#define PARQUET_FIELD_REPETITION_REPEATED 2
+#define PARQUET_CONVERTED_TYPE_UTF8 0
+#define PARQUET_CONVERTED_TYPE_LIST 3
+#define PARQUET_CODEC_UNCOMPRESSED 0
+//DELTA_BINARY_PACKED blocks of 128 values in 4 miniblocks
+#define PARQUET_DELTA_BLOCK_SIZE 128u
+#define PARQUET_DELTA_NUM_MINIBLOCKS 4u
+
+static inline uint64_t zigzag_encode_value(const int64_t value)
+{ return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+
+static inline int64_t zigzag_decode_value(const uint64_t value)
+{ return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1u); }
+
+static void write_bytes(std::vector<uint8_t>& buffer, uint64_t& offset, const void* data, const uint64_t size)
+{
+  if(offset + size > buffer.size())
+    buffer.resize(offset + size + 1024u);
+  if(size > 0u)
+    memcpy(&(buffer[offset]), data, size);
+  offset += size;
+}
+
+static void write_uint32(std::vector<uint8_t>& buffer, uint64_t& offset, const uint32_t value)
+{
+  write_bytes(buffer, offset, &value, sizeof(uint32_t));
+}
+
+static uint32_t read_uint32(const uint8_t* buffer, uint64_t& offset, const uint64_t size)
+{
+  VERIFY_OR_THROW(offset + sizeof(uint32_t) <= size);
+  uint32_t value = 0u;
+  memcpy(&value, buffer+offset, sizeof(uint32_t));
+  offset += sizeof(uint32_t);
+  return value;
+}
+
+//ULEB128
+static void write_varint(std::vector<uint8_t>& buffer, uint64_t& offset, uint64_t value)
+{
+  uint8_t bytes[10];
+  auto num_bytes = 0u;
+  while(value >= 0x80u)
+  {
+    bytes[num_bytes++] = static_cast<uint8_t>(value | 0x80u);
+    value >>= 7;
+  }
+  bytes[num_bytes++] = static_cast<uint8_t>(value);
+  write_bytes(buffer, offset, bytes, num_bytes);
+}
+
+static uint64_t read_varint(const uint8_t* buffer, uint64_t& offset, const uint64_t size)
+{
+  uint64_t value = 0ull;
+  for(auto shift=0u;shift<64u;shift+=7u)
+  {
+    VERIFY_OR_THROW(offset < size);
+    auto byte = buffer[offset++];
+    value |= (static_cast<uint64_t>(byte & 0x7fu) << shift);
+    if(!(byte & 0x80u))
+      break;
+  }
+  return value;
+}
+
+static unsigned get_bit_width(uint64_t max_value)
+{
+  auto bit_width = 0u;
+  for(;max_value;max_value>>=1)
+    ++bit_width;
+  return bit_width;
+}
+
+//Appends num_values values packed LSB first with bit_width bits each - num_values*bit_width must be a multiple of 8
+static void bit_pack(std::vector<uint8_t>& buffer, uint64_t& offset, const uint64_t* values, const uint64_t num_values,
+    const unsigned bit_width)
+{
+  auto num_bytes = (num_values*bit_width)/8u;
+  if(offset + num_bytes > buffer.size())
+    buffer.resize(offset + num_bytes + 1024u);
+  uint64_t bits = 0ull;
+  auto num_bits = 0u;
+  for(auto i=0ull;i<num_values;++i)
+  {
+    auto value = values[i];
+    //At most 32 bits at a time, so that bits never overflows
+    for(auto remaining=bit_width;remaining>0u;)
+    {
+      auto width = std::min(remaining, 32u);
+      bits |= ((value & ((1ull << width)-1ull)) << num_bits);
+      num_bits += width;
+      value >>= width;
+      remaining -= width;
+      for(;num_bits>=8u;num_bits-=8u)
+      {
+        buffer[offset++] = static_cast<uint8_t>(bits);
+        bits >>= 8;
+      }
+    }
+  }
+  assert(num_bits == 0u);
+}
+
+static void bit_unpack(const uint8_t* buffer, const uint64_t num_values, const unsigned bit_width, uint64_t* values)
+{
+  uint64_t bits = 0ull;
+  auto num_bits = 0u;
+  auto byte_idx = 0ull;
+  for(auto i=0ull;i<num_values;++i)
+  {
+    uint64_t value = 0ull;
+    for(auto num_read_bits=0u;num_read_bits<bit_width;)
+    {
+      if(num_bits == 0u)
+      {
+        bits = buffer[byte_idx++];
+        num_bits = 8u;
+      }
+      auto width = std::min(bit_width-num_read_bits, num_bits);
+      value |= ((bits & ((1ull << width)-1ull)) << num_read_bits);
+      bits >>= width;
+      num_bits -= width;
+      num_read_bits += width;
+    }
+    values[i] = value;
+  }
+}
+
+/*
+ * RLE/bit-packed hybrid encoding - runs of at least 8 equal values are RLE runs, everything else is bit-packed
+ * in groups of 8 values. Only the last group is padded
+ */
+template<class T>
+static void encode_rle_bit_packed_hybrid(std::vector<uint8_t>& buffer, uint64_t& offset, const std::vector<T>& values,
+    const unsigned bit_width)
+{
+  auto value_width = (bit_width+7u)/8u;
+  auto num_values = values.size();
+  auto get_run_length = [&](const uint64_t idx) {
+    auto run_end = idx+1u;
+    for(;run_end<num_values && values[run_end] == values[idx];++run_end);
+    return run_end-idx;
+  };
+  uint64_t group[8];
+  for(auto i=0ull;i<num_values;)
+  {
+    auto run_length = get_run_length(i);
+    if(run_length >= 8u)
+    {
+      write_varint(buffer, offset, run_length << 1);
+      uint64_t value = values[i];
+      write_bytes(buffer, offset, &value, value_width);
+      i += run_length;
+      continue;
+    }
+    //Groups of 8 values until an RLE run begins at a group boundary
+    auto end = i;
+    do
+      end += 8u;
+    while(end < num_values && get_run_length(end) < 8u);
+    write_varint(buffer, offset, (((end-i)/8u) << 1) | 1u);
+    for(;i<end;i+=8u)
+    {
+      for(auto j=0u;j<8u;++j)
+        group[j] = (i+j < num_values) ? static_cast<uint64_t>(values[i+j]) : 0ull;
+      bit_pack(buffer, offset, group, 8u, bit_width);
+    }
+  }
+}
+
+//Appends num_values values to values
+template<class T>
+static void decode_rle_bit_packed_hybrid(const uint8_t* buffer, uint64_t& offset, const uint64_t size,
+    const unsigned bit_width, const uint64_t num_values, std::vector<T>& values)
+{
+  auto value_width = (bit_width+7u)/8u;
+  auto num_total_values = values.size()+num_values;
+  uint64_t group[8];
+  while(values.size() < num_total_values)
+  {
+    auto header = read_varint(buffer, offset, size);
+    auto run_length = header >> 1;
+    VERIFY_OR_THROW(run_length > 0u);
+    if(header & 1u)
+    {
+      //run_length groups of 8 values
+      VERIFY_OR_THROW(bit_width == 0u || run_length <= (size-offset)/bit_width);
+      for(auto i=0ull;i<run_length;++i)
+      {
+        bit_unpack(buffer+offset, 8u, bit_width, group);
+        offset += bit_width;
+        for(auto j=0u;j<8u && values.size() < num_total_values;++j)
+          values.push_back(static_cast<T>(group[j]));
+      }
+    }
+    else
+    {
+      VERIFY_OR_THROW(offset + value_width <= size && run_length <= num_total_values-values.size());
+      uint64_t value = 0ull;
+      memcpy(&value, buffer+offset, value_width);
+      offset += value_width;
+      values.insert(values.end(), run_length, static_cast<T>(value));
+    }
+  }
+}
+
+//Levels are prefixed with their length in bytes
+template<class T>
+static void encode_levels(std::vector<uint8_t>& buffer, uint64_t& offset, const std::vector<T>& levels, const unsigned max_level)
+{
+  auto length_offset = offset;
+  write_uint32(buffer, offset, 0u);
+  encode_rle_bit_packed_hybrid(buffer, offset, levels, get_bit_width(max_level));
+  auto length = static_cast<uint32_t>(offset-length_offset-sizeof(uint32_t));
+  memcpy(&(buffer[length_offset]), &length, sizeof(uint32_t));
+}
+
+template<class T>
+static void decode_levels(const uint8_t* buffer, uint64_t& offset, const uint64_t size, const unsigned max_level,
+    const uint64_t num_values, std::vector<T>& levels)
+{
+  uint64_t length = read_uint32(buffer, offset, size);
+  VERIFY_OR_THROW(offset + length <= size);
+  uint64_t levels_offset = 0ull;
+  decode_rle_bit_packed_hybrid(buffer+offset, levels_offset, length, get_bit_width(max_level), num_values, levels);
+  for(auto level : levels)
+    VERIFY_OR_THROW(level <= max_level);
+  offset += length;
+}
+
+/*
+ * DELTA_BINARY_PACKED - header (block size, #miniblocks, #values, first value), followed by blocks of
+ * (min delta, bit width of each miniblock, bit-packed deltas - min delta). Differences wrap around
+ */
+static void encode_delta_binary_packed(std::vector<uint8_t>& buffer, uint64_t& offset, const std::vector<uint64_t>& values)
+{
+  const auto miniblock_size = PARQUET_DELTA_BLOCK_SIZE/PARQUET_DELTA_NUM_MINIBLOCKS;
+  write_varint(buffer, offset, PARQUET_DELTA_BLOCK_SIZE);
+  write_varint(buffer, offset, PARQUET_DELTA_NUM_MINIBLOCKS);
+  write_varint(buffer, offset, values.size());
+  write_varint(buffer, offset, zigzag_encode_value(values.empty() ? 0ll : static_cast<int64_t>(values[0u])));
+  uint64_t deltas[PARQUET_DELTA_BLOCK_SIZE];
+  uint8_t bit_widths[PARQUET_DELTA_NUM_MINIBLOCKS];
+  for(auto block_begin=1ull;block_begin<values.size();block_begin+=PARQUET_DELTA_BLOCK_SIZE)
+  {
+    auto num_deltas = std::min<uint64_t>(PARQUET_DELTA_BLOCK_SIZE, values.size()-block_begin);
+    auto min_delta = INT64_MAX;
+    for(auto i=0ull;i<num_deltas;++i)
+    {
+      deltas[i] = values[block_begin+i]-values[block_begin+i-1u];
+      min_delta = std::min(min_delta, static_cast<int64_t>(deltas[i]));
+    }
+    //Padding of the last miniblock
+    for(auto i=num_deltas;i<PARQUET_DELTA_BLOCK_SIZE;++i)
+      deltas[i] = static_cast<uint64_t>(min_delta);
+    for(auto i=0ull;i<PARQUET_DELTA_BLOCK_SIZE;++i)
+      deltas[i] -= static_cast<uint64_t>(min_delta);
+    write_varint(buffer, offset, zigzag_encode_value(min_delta));
+    //Widths of miniblocks without values are 0
+    for(auto i=0u;i<PARQUET_DELTA_NUM_MINIBLOCKS;++i)
+    {
+      uint64_t max_value = 0ull;
+      for(auto j=i*miniblock_size;j<(i+1u)*miniblock_size && j<num_deltas;++j)
+        max_value = std::max(max_value, deltas[j]);
+      bit_widths[i] = get_bit_width(max_value);
+    }
+    write_bytes(buffer, offset, bit_widths, PARQUET_DELTA_NUM_MINIBLOCKS);
+    for(auto i=0u;i<PARQUET_DELTA_NUM_MINIBLOCKS && i*miniblock_size<num_deltas;++i)
+      bit_pack(buffer, offset, deltas+i*miniblock_size, miniblock_size, bit_widths[i]);
+  }
+}
+
+static void decode_delta_binary_packed(const uint8_t* buffer, uint64_t& offset, const uint64_t size, const uint64_t num_values,
+    std::vector<uint64_t>& values)
+{
+  auto block_size = read_varint(buffer, offset, size);
+  auto num_miniblocks = read_varint(buffer, offset, size);
+  auto num_encoded_values = read_varint(buffer, offset, size);
+  uint64_t value = zigzag_decode_value(read_varint(buffer, offset, size));
+  VERIFY_OR_THROW(num_encoded_values == num_values && num_miniblocks > 0u && block_size % num_miniblocks == 0u
+      && (block_size/num_miniblocks) % 8u == 0u && block_size/num_miniblocks > 0u);
+  auto miniblock_size = block_size/num_miniblocks;
+  std::vector<uint64_t> deltas(miniblock_size);
+  auto num_total_values = values.size()+num_values;
+  if(num_values > 0u)
+    values.push_back(value);
+  while(values.size() < num_total_values)
+  {
+    uint64_t min_delta = zigzag_decode_value(read_varint(buffer, offset, size));
+    VERIFY_OR_THROW(offset + num_miniblocks <= size);
+    auto bit_widths = buffer+offset;
+    offset += num_miniblocks;
+    for(auto i=0ull;i<num_miniblocks && values.size() < num_total_values;++i)
+    {
+      VERIFY_OR_THROW(bit_widths[i] <= 64u);
+      auto num_bytes = (miniblock_size*bit_widths[i])/8u;
+      VERIFY_OR_THROW(offset + num_bytes <= size);
+      bit_unpack(buffer+offset, miniblock_size, bit_widths[i], &(deltas[0u]));
+      offset += num_bytes;
+      for(auto j=0ull;j<miniblock_size && values.size() < num_total_values;++j)
+      {
+        value += min_delta + deltas[j];
+        values.push_back(value);
+      }
+    }
+  }
+}
+
+//Thrift compact protocol writer - nested structs are begun and ended explicitly, the top level struct is implicit
+class ThriftCompactWriter
+{
+  public:
+    ThriftCompactWriter(std::vector<uint8_t>& buffer, uint64_t& offset)
+      : m_buffer(buffer), m_offset(offset)
+    {
+      m_last_field_ids.push_back(0);
+    }
+    void write_field_header(const int16_t field_id, const uint8_t type)
+    {
+      auto delta = field_id - m_last_field_ids.back();
+      if(delta > 0 && delta <= 15)
+        write_byte((delta << 4) | type);
+      else
+      {
+        write_byte(type);
+        write_varint(m_buffer, m_offset, zigzag_encode_value(field_id));
+      }
+      m_last_field_ids.back() = field_id;
+    }
+    void write_i32_field(const int16_t field_id, const int32_t value)
+    {
+      write_field_header(field_id, THRIFT_COMPACT_I32);
+      write_i32(value);
+    }
+    void write_i64_field(const int16_t field_id, const int64_t value)
+    {
+      write_field_header(field_id, THRIFT_COMPACT_I64);
+      write_varint(m_buffer, m_offset, zigzag_encode_value(value));
+    }
+    void write_binary_field(const int16_t field_id, const std::string& value)
+    {
+      write_field_header(field_id, THRIFT_COMPACT_BINARY);
+      write_binary(value);
+    }
+    void begin_struct_field(const int16_t field_id)
+    {
+      write_field_header(field_id, THRIFT_COMPACT_STRUCT);
+      begin_struct();
+    }
+    void begin_list_field(const int16_t field_id, const uint8_t element_type, const uint64_t num_elements)
+    {
+      write_field_header(field_id, THRIFT_COMPACT_LIST);
+      if(num_elements < 15u)
+        write_byte((num_elements << 4) | element_type);
+      else
+      {
+        write_byte(0xf0u | element_type);
+        write_varint(m_buffer, m_offset, num_elements);
+      }
+    }
+    //Structs that are list elements are begun without a field header
+    void begin_struct() { m_last_field_ids.push_back(0); }
+    void end_struct()
+    {
+      write_byte(0u);
+      m_last_field_ids.pop_back();
+    }
+    void write_i32(const int32_t value) { write_varint(m_buffer, m_offset, zigzag_encode_value(value)); }
+    void write_binary(const std::string& value)
+    {
+      write_varint(m_buffer, m_offset, value.length());
+      write_bytes(m_buffer, m_offset, value.c_str(), value.length());
+    }
+  private:
+    void write_byte(const uint8_t value) { write_bytes(m_buffer, m_offset, &value, 1u); }
+  private:
+    std::vector<uint8_t>& m_buffer;
+    uint64_t& m_offset;
+    std::vector<int16_t> m_last_field_ids;
+};
+
+class ThriftCompactReader
+{
+  public:
+    ThriftCompactReader(const uint8_t* buffer, const uint64_t size)
+      : m_buffer(buffer), m_size(size)
+    {
+      m_offset = 0ull;
+      m_bool_value = false;
+      m_last_field_ids.push_back(0);
+    }
+    //Returns false at the end of the current struct
+    bool read_field_header(int16_t& field_id, uint8_t& type)
+    {
+      auto byte = read_byte();
+      if(byte == 0u)
+        return false;
+      type = byte & 0xfu;
+      auto delta = byte >> 4;
+      field_id = delta ? (m_last_field_ids.back()+delta) : static_cast<int16_t>(read_int());
+      m_last_field_ids.back() = field_id;
+      //Boolean fields carry the value in the type
+      m_bool_value = (type == THRIFT_COMPACT_BOOLEAN_TRUE);
+      return true;
+    }
+    bool get_bool_field_value() const { return m_bool_value; }
+    //i16, i32 and i64 values
+    int64_t read_int() { return zigzag_decode_value(read_varint(m_buffer, m_offset, m_size)); }
+    std::string read_binary()
+    {
+      auto length = read_varint(m_buffer, m_offset, m_size);
+      VERIFY_OR_THROW(length <= m_size-m_offset);
+      std::string value(reinterpret_cast<const char*>(m_buffer+m_offset), length);
+      m_offset += length;
+      return value;
+    }
+    void read_list_header(uint8_t& element_type, uint64_t& num_elements)
+    {
+      auto byte = read_byte();
+      element_type = byte & 0xfu;
+      num_elements = byte >> 4;
+      if(num_elements == 15u)
+        num_elements = read_varint(m_buffer, m_offset, m_size);
+    }
+    void begin_struct() { m_last_field_ids.push_back(0); }
+    //Called after read_field_header() returns false
+    void end_struct() { m_last_field_ids.pop_back(); }
+    void skip(const uint8_t type, const bool is_list_element=false)
+    {
+      switch(type)
+      {
+        case THRIFT_COMPACT_BOOLEAN_TRUE:
+        case THRIFT_COMPACT_BOOLEAN_FALSE:
+          //Fields carry the value in the header, list elements are bytes
+          if(is_list_element)
+            read_byte();
+          break;
+        case THRIFT_COMPACT_BYTE:
+          read_byte();
+          break;
+        case THRIFT_COMPACT_I16:
+        case THRIFT_COMPACT_I32:
+        case THRIFT_COMPACT_I64:
+          read_int();
+          break;
+        case THRIFT_COMPACT_DOUBLE:
+          VERIFY_OR_THROW(m_offset + 8u <= m_size);
+          m_offset += 8u;
+          break;
+        case THRIFT_COMPACT_BINARY:
+          read_binary();
+          break;
+        case THRIFT_COMPACT_LIST:
+        case THRIFT_COMPACT_SET:
+          {
+            uint8_t element_type = 0u;
+            uint64_t num_elements = 0ull;
+            read_list_header(element_type, num_elements);
+            for(auto i=0ull;i<num_elements;++i)
+              skip(element_type, true);
+            break;
+          }
+        case THRIFT_COMPACT_MAP:
+          {
+            auto num_entries = read_varint(m_buffer, m_offset, m_size);
+            if(num_entries > 0u)
+            {
+              auto types = read_byte();
+              for(auto i=0ull;i<num_entries;++i)
+              {
+                skip(types >> 4, true);
+                skip(types & 0xfu, true);
+              }
+            }
+            break;
+          }
+        case THRIFT_COMPACT_STRUCT:
+          {
+            int16_t field_id = 0;
+            uint8_t field_type = 0u;
+            begin_struct();
+            while(read_field_header(field_id, field_type))
+              skip(field_type);
+            end_struct();
+            break;
+          }
+        default:
+          throw ParquetFileException(std::string("Unknown Thrift compact type ")+std::to_string(type));
+      }
+    }
+    uint64_t get_offset() const { return m_offset; }
+  private:
+    uint8_t read_byte()
+    {
+      VERIFY_OR_THROW(m_offset < m_size);
+      return m_buffer[m_offset++];
+    }
+  private:
+    const uint8_t* m_buffer;
+    uint64_t m_size;
+    uint64_t m_offset;
+    bool m_bool_value;
+    std::vector<int16_t> m_last_field_ids;
+};
+
+static void write_page_header(std::vector<uint8_t>& buffer, uint64_t& offset, const int page_type, const uint64_t page_size,
+    const uint64_t num_values, const ParquetEncodingEnum encoding)
+{
+  VERIFY_OR_THROW(page_size <= INT32_MAX && num_values <= INT32_MAX);
+  ThriftCompactWriter writer(buffer, offset);
+  writer.write_i32_field(1, page_type);
+  //Uncompressed and compressed sizes
+  writer.write_i32_field(2, page_size);
+  writer.write_i32_field(3, page_size);
+  if(page_type == PARQUET_PAGE_TYPE_DICTIONARY_PAGE)
+  {
+    writer.begin_struct_field(7);
+    writer.write_i32_field(1, num_values);
+    writer.write_i32_field(2, encoding);
+    writer.end_struct();
+  }
+  else
+  {
+    writer.begin_struct_field(5);
+    writer.write_i32_field(1, num_values);
+    writer.write_i32_field(2, encoding);
+    writer.write_i32_field(3, PARQUET_ENCODING_RLE);
+    writer.write_i32_field(4, PARQUET_ENCODING_RLE);
+    writer.end_struct();
+  }
+  writer.end_struct();
+}
+
+class ParquetPageHeader
+{
+  public:
+    ParquetPageHeader()
+    {
+      m_type = -1;
+      m_size = 0ll;
+      m_num_values = 0ll;
+      m_encoding = PARQUET_ENCODING_PLAIN;
+      m_definition_level_encoding = PARQUET_ENCODING_RLE;
+      m_repetition_level_encoding = PARQUET_ENCODING_RLE;
+    }
+    int m_type;
+    int64_t m_size;
+    int64_t m_num_values;
+    int m_encoding;
+    int m_definition_level_encoding;
+    int m_repetition_level_encoding;
+};
+
+//Returns the length of the header
+static uint64_t read_page_header(const uint8_t* buffer, const uint64_t size, ParquetPageHeader& header)
+{
+  ThriftCompactReader reader(buffer, size);
+  int16_t field_id = 0;
+  uint8_t type = 0u;
+  while(reader.read_field_header(field_id, type))
+  {
+    if(field_id == 1 && type == THRIFT_COMPACT_I32)
+      header.m_type = reader.read_int();
+    else if(field_id == 3 && type == THRIFT_COMPACT_I32)
+      header.m_size = reader.read_int();
+    else if((field_id == 5 || field_id == 7) && type == THRIFT_COMPACT_STRUCT)
+    {
+      //DataPageHeader or DictionaryPageHeader
+      auto is_data_page_header = (field_id == 5);
+      reader.begin_struct();
+      while(reader.read_field_header(field_id, type))
+      {
+        if(field_id == 1 && type == THRIFT_COMPACT_I32)
+          header.m_num_values = reader.read_int();
+        else if(field_id == 2 && type == THRIFT_COMPACT_I32)
+          header.m_encoding = reader.read_int();
+        else if(is_data_page_header && field_id == 3 && type == THRIFT_COMPACT_I32)
+          header.m_definition_level_encoding = reader.read_int();
+        else if(is_data_page_header && field_id == 4 && type == THRIFT_COMPACT_I32)
+          header.m_repetition_level_encoding = reader.read_int();
+        else
+          reader.skip(type);
+      }
+      reader.end_struct();
+    }
+    else
+      reader.skip(type);
+  }
+  VERIFY_OR_THROW(header.m_size >= 0 && header.m_num_values >= 0);
+  return reader.get_offset();
+}
+
+//4 byte length followed by the bytes
+static void decode_plain_strings(const uint8_t* buffer, uint64_t& offset, const uint64_t size, const uint64_t num_values,
+    std::vector<std::string>& values)
+{
+  for(auto i=0ull;i<num_values;++i)
+  {
+    uint64_t length = read_uint32(buffer, offset, size);
+    VERIFY_OR_THROW(offset + length <= size);
+    values.emplace_back(reinterpret_cast<const char*>(buffer+offset), length);
+    offset += length;
+  }
+}
+
+//ParquetColumn functions
+void ParquetColumn::begin_list()
+{
+  VERIFY_OR_THROW(m_repetition == PARQUET_REPETITION_LIST);
+  //Entry of an empty list - replaced by the first element
+  m_values.push_back(0ull);
+  m_definition_levels.push_back(0u);
+  m_repetition_levels.push_back(0u);
+  m_is_list_empty = true;
+  ++m_num_rows;
+}
+
+void ParquetColumn::append_entry(const uint64_t value, const unsigned definition_level)
+{
+  if(m_repetition == PARQUET_REPETITION_LIST)
+  {
+    VERIFY_OR_THROW(m_num_rows > 0ull);
+    if(m_is_list_empty)
+    {
+      m_values.back() = value;
+      m_definition_levels.back() = definition_level;
+      m_is_list_empty = false;
+      return;
+    }
+    m_repetition_levels.push_back(1u);
+  }
+  else
+    ++m_num_rows;
+  m_values.push_back(value);
+  if(m_repetition != PARQUET_REPETITION_REQUIRED)
+    m_definition_levels.push_back(definition_level);
+}
+
+void ParquetColumn::append_string(const std::string& value)
+{
+  auto iter = m_dictionary_map.find(value);
+  if(iter == m_dictionary_map.end())
+  {
+    auto idx = m_dictionary.size();
+    m_dictionary.push_back(value);
+    m_dictionary_map.emplace(value, idx);
+    append_entry(idx, get_max_definition_level());
+  }
+  else
+    append_entry((*iter).second, get_max_definition_level());
+}
+
+void ParquetColumn::append_null()
+{
+  if(m_repetition == PARQUET_REPETITION_REQUIRED)
+    throw ParquetFileException(std::string("Null value in required column ")+m_name);
+  append_entry(0ull, get_max_definition_level()-1u);
+}
+
+void ParquetColumn::encode_values(std::vector<uint8_t>& buffer, uint64_t& offset, const ParquetEncodingEnum encoding) const
+{
+  //Nulls have no values
+  std::vector<uint64_t> values;
+  values.reserve(m_values.size());
+  for(auto i=0ull;i<m_values.size();++i)
+    if(!is_null(i) && !is_empty_list(i))
+      values.push_back(m_values[i]);
+  switch(encoding)
+  {
+    case PARQUET_ENCODING_RLE_DICTIONARY:
+      {
+        //Bit width of the idxs, followed by the idxs without a length
+        uint8_t bit_width = std::max(get_bit_width(m_dictionary.size()-1u), 1u);
+        write_bytes(buffer, offset, &bit_width, 1u);
+        encode_rle_bit_packed_hybrid(buffer, offset, values, bit_width);
+        break;
+      }
+    case PARQUET_ENCODING_DELTA_BINARY_PACKED:
+      encode_delta_binary_packed(buffer, offset, values);
+      break;
+    default:
+      for(auto value : values)
+        switch(m_type)
+        {
+          case PARQUET_TYPE_INT64:
+            write_bytes(buffer, offset, &value, sizeof(uint64_t));
+            break;
+          case PARQUET_TYPE_BYTE_ARRAY:
+            write_uint32(buffer, offset, m_dictionary[value].length());
+            write_bytes(buffer, offset, m_dictionary[value].c_str(), m_dictionary[value].length());
+            break;
+          default:
+            write_uint32(buffer, offset, static_cast<uint32_t>(value));
+            break;
+        }
+      break;
+  }
+}
+
+ParquetEncodingEnum ParquetColumn::encode_pages(std::vector<uint8_t>& buffer, uint64_t& offset, uint64_t& dictionary_page_size) const
+{
+  auto num_values = 0ull;
+  for(auto i=0ull;i<m_values.size();++i)
+    num_values += (is_null(i) || is_empty_list(i)) ? 0ull : 1ull;
+  auto encoding = PARQUET_ENCODING_PLAIN;
+  if(m_type == PARQUET_TYPE_INT64)
+    encoding = PARQUET_ENCODING_DELTA_BINARY_PACKED;
+  else if(m_type == PARQUET_TYPE_BYTE_ARRAY && !m_dictionary.empty() && 2u*m_dictionary.size() <= num_values)
+    encoding = PARQUET_ENCODING_RLE_DICTIONARY;
+  //Page headers contain the page sizes - pages are encoded in a separate buffer
+  std::vector<uint8_t> page_buffer;
+  uint64_t page_size = 0ull;
+  dictionary_page_size = 0ull;
+  if(encoding == PARQUET_ENCODING_RLE_DICTIONARY)
+  {
+    for(const auto& entry : m_dictionary)
+    {
+      write_uint32(page_buffer, page_size, entry.length());
+      write_bytes(page_buffer, page_size, entry.c_str(), entry.length());
+    }
+    auto begin_offset = offset;
+    write_page_header(buffer, offset, PARQUET_PAGE_TYPE_DICTIONARY_PAGE, page_size, m_dictionary.size(), PARQUET_ENCODING_PLAIN);
+    write_bytes(buffer, offset, &(page_buffer[0u]), page_size);
+    dictionary_page_size = offset-begin_offset;
+    page_size = 0ull;
+  }
+  //Repetition levels, definition levels and values
+  if(get_max_repetition_level() > 0u)
+    encode_levels(page_buffer, page_size, m_repetition_levels, get_max_repetition_level());
+  if(get_max_definition_level() > 0u)
+    encode_levels(page_buffer, page_size, m_definition_levels, get_max_definition_level());
+  encode_values(page_buffer, page_size, encoding);
+  write_page_header(buffer, offset, PARQUET_PAGE_TYPE_DATA_PAGE, page_size, m_values.size(), encoding);
+  write_bytes(buffer, offset, page_size ? &(page_buffer[0u]) : 0, page_size);
+  return encoding;
+}
+
+void ParquetColumn::decode_pages(const uint8_t* buffer, const uint64_t size, const uint64_t num_values)
+{
+  clear();
+  std::vector<std::string> dictionary;
+  std::vector<std::string> strings;
+  std::vector<uint64_t> values;
+  std::vector<uint8_t> definition_levels;
+  std::vector<uint8_t> repetition_levels;
+  uint64_t offset = 0ull;
+  auto num_decoded_values = 0ull;
+  while(num_decoded_values < num_values)
+  {
+    ParquetPageHeader header;
+    offset += read_page_header(buffer+offset, size-offset, header);
+    VERIFY_OR_THROW(static_cast<uint64_t>(header.m_size) <= size-offset);
+    auto page = buffer+offset;
+    uint64_t page_size = header.m_size;
+    uint64_t page_offset = 0ull;
+    if(header.m_type == PARQUET_PAGE_TYPE_DICTIONARY_PAGE)
+    {
+      VERIFY_OR_THROW(m_type == PARQUET_TYPE_BYTE_ARRAY && (header.m_encoding == PARQUET_ENCODING_PLAIN
+            || header.m_encoding == PARQUET_ENCODING_PLAIN_DICTIONARY));
+      dictionary.clear();
+      decode_plain_strings(page, page_offset, page_size, header.m_num_values, dictionary);
+    }
+    else if(header.m_type == PARQUET_PAGE_TYPE_DATA_PAGE)
+    {
+      VERIFY_OR_THROW(num_decoded_values + header.m_num_values <= num_values);
+      repetition_levels.clear();
+      definition_levels.clear();
+      if(get_max_repetition_level() > 0u)
+      {
+        VERIFY_OR_THROW(header.m_repetition_level_encoding == PARQUET_ENCODING_RLE);
+        decode_levels(page, page_offset, page_size, get_max_repetition_level(), header.m_num_values, repetition_levels);
+      }
+      if(get_max_definition_level() > 0u)
+      {
+        VERIFY_OR_THROW(header.m_definition_level_encoding == PARQUET_ENCODING_RLE);
+        decode_levels(page, page_offset, page_size, get_max_definition_level(), header.m_num_values, definition_levels);
+      }
+      auto num_page_values = definition_levels.empty() ? static_cast<uint64_t>(header.m_num_values)
+        : static_cast<uint64_t>(std::count(definition_levels.begin(), definition_levels.end(), get_max_definition_level()));
+      //Strings are decoded as idxs into dictionary or strings
+      values.clear();
+      strings.clear();
+      switch(header.m_encoding)
+      {
+        case PARQUET_ENCODING_RLE_DICTIONARY:
+        case PARQUET_ENCODING_PLAIN_DICTIONARY:
+          {
+            VERIFY_OR_THROW(m_type == PARQUET_TYPE_BYTE_ARRAY && page_offset < page_size);
+            auto bit_width = page[page_offset++];
+            VERIFY_OR_THROW(bit_width <= 32u);
+            decode_rle_bit_packed_hybrid(page, page_offset, page_size, bit_width, num_page_values, values);
+            for(auto idx : values)
+              VERIFY_OR_THROW(idx < dictionary.size());
+            break;
+          }
+        case PARQUET_ENCODING_DELTA_BINARY_PACKED:
+          VERIFY_OR_THROW(m_type == PARQUET_TYPE_INT32 || m_type == PARQUET_TYPE_INT64);
+          decode_delta_binary_packed(page, page_offset, page_size, num_page_values, values);
+          break;
+        case PARQUET_ENCODING_PLAIN:
+          if(m_type == PARQUET_TYPE_BYTE_ARRAY)
+          {
+            decode_plain_strings(page, page_offset, page_size, num_page_values, strings);
+            for(auto i=0ull;i<num_page_values;++i)
+              values.push_back(i);
+          }
+          else
+          {
+            auto value_width = (m_type == PARQUET_TYPE_INT64) ? 8u : 4u;
+            VERIFY_OR_THROW(num_page_values <= (page_size-page_offset)/value_width);
+            for(auto i=0ull;i<num_page_values;++i)
+            {
+              uint64_t value = 0ull;
+              memcpy(&value, page+page_offset, value_width);
+              page_offset += value_width;
+              values.push_back(value);
+            }
+          }
+          break;
+        default:
+          throw ParquetFileException(std::string("Unsupported encoding ")+std::to_string(header.m_encoding)+" in column "+m_name);
+      }
+      //Entries from the levels
+      const auto& string_values = (header.m_encoding == PARQUET_ENCODING_PLAIN) ? strings : dictionary;
+      auto value_idx = 0ull;
+      for(auto i=0ll;i<header.m_num_values;++i)
+      {
+        if(!repetition_levels.empty() && repetition_levels[i] == 0u)
+          begin_list();
+        auto definition_level = definition_levels.empty() ? 0u : definition_levels[i];
+        if(definition_level == get_max_definition_level())
+        {
+          if(m_type == PARQUET_TYPE_BYTE_ARRAY)
+            append_string(string_values[values[value_idx++]]);
+          else
+            append_entry((m_type == PARQUET_TYPE_INT64) ? values[value_idx] : static_cast<uint32_t>(values[value_idx]),
+                get_max_definition_level());
+          if(m_type != PARQUET_TYPE_BYTE_ARRAY)
+            ++value_idx;
+        }
+        else if(definition_level+1u == get_max_definition_level())
+          append_null();
+      }
+      num_decoded_values += header.m_num_values;
+    }
+    else
+      throw ParquetFileException(std::string("Unsupported page type ")+std::to_string(header.m_type)+" in column "+m_name);
+    offset += page_size;
+  }
+  VERIFY_OR_THROW(m_values.size() == num_values);
+}
+
+//ParquetFileWriter functions
+ParquetFileWriter::ParquetFileWriter(const std::string& filename)
+  : m_filename(filename)
+{
+  m_finalized = false;
+  m_fptr.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if(!m_fptr.is_open())
+    throw ParquetFileException(std::string("Could not open Parquet file ")+filename+" for writing");
+  m_fptr.write(PARQUET_MAGIC, PARQUET_MAGIC_LENGTH);
+  m_file_offset = PARQUET_MAGIC_LENGTH;
+}
+
+ParquetFileWriter::~ParquetFileWriter()
+{
+  //File without a footer if finalize() was never called
+  if(m_fptr.is_open())
+    m_fptr.close();
+}
+
+unsigned ParquetFileWriter::add_column(const std::string& name, const ParquetPhysicalTypeEnum type,
+    const ParquetRepetitionEnum repetition)
+{
+  VERIFY_OR_THROW(m_row_groups.empty() && !m_finalized);
+  m_columns.emplace_back(name, type, repetition);
+  return m_columns.size()-1u;
+}
+
+void ParquetFileWriter::set_key_value_metadata(const std::string& key, const std::string& value)
+{
+  for(auto& entry : m_key_value_metadata)
+    if(entry.first == key)
+    {
+      entry.second = value;
+      return;
+    }
+  m_key_value_metadata.emplace_back(key, value);
+}
+
+void ParquetFileWriter::write_row_group(const uint64_t num_rows)
+{
+  VERIFY_OR_THROW(!m_finalized);
+  for(const auto& column : m_columns)
+    if(column.get_num_rows() != num_rows)
+      throw ParquetFileException(std::string("Column ")+column.get_name()+" has "+std::to_string(column.get_num_rows())
+          +" rows, row group has "+std::to_string(num_rows)+" rows");
+  m_row_groups.emplace_back();
+  auto& row_group_info = m_row_groups.back();
+  row_group_info.m_num_rows = num_rows;
+  row_group_info.m_chunks.resize(m_columns.size());
+  for(auto i=0u;i<m_columns.size();++i)
+  {
+    auto& column = m_columns[i];
+    uint64_t size = 0ull;
+    uint64_t dictionary_page_size = 0ull;
+    auto& chunk_info = row_group_info.m_chunks[i];
+    chunk_info.m_encoding = column.encode_pages(m_buffer, size, dictionary_page_size);
+    chunk_info.m_dictionary_page_offset = dictionary_page_size ? m_file_offset : -1ll;
+    chunk_info.m_data_page_offset = m_file_offset + dictionary_page_size;
+    chunk_info.m_size = size;
+    chunk_info.m_num_values = column.size();
+    m_fptr.write(reinterpret_cast<const char*>(&(m_buffer[0])), size);
+    m_file_offset += size;
+    column.clear();
+  }
+  if(!m_fptr.good())
+    throw ParquetFileException(std::string("Error while writing to Parquet file ")+m_filename);
+}
+
+void ParquetFileWriter::finalize()
+{
+  if(m_finalized)
+    return;
+  uint64_t offset = 0ull;
+  ThriftCompactWriter writer(m_buffer, offset);
+  //FileMetaData
+  writer.write_i32_field(1, 1);
+  //Schema - depth first, the root is followed by the columns. List columns are 3 elements
+  auto num_schema_elements = 1ull;
+  for(const auto& column : m_columns)
+    num_schema_elements += (column.get_repetition() == PARQUET_REPETITION_LIST) ? 3ull : 1ull;
+  writer.begin_list_field(2, THRIFT_COMPACT_STRUCT, num_schema_elements);
+  writer.begin_struct();
+  writer.write_binary_field(4, "schema");
+  writer.write_i32_field(5, m_columns.size());
+  writer.end_struct();
+  for(const auto& column : m_columns)
+  {
+    auto is_list = (column.get_repetition() == PARQUET_REPETITION_LIST);
+    if(is_list)
+    {
+      writer.begin_struct();
+      writer.write_i32_field(3, PARQUET_FIELD_REPETITION_REQUIRED);
+      writer.write_binary_field(4, column.get_name());
+      writer.write_i32_field(5, 1);
+      writer.write_i32_field(6, PARQUET_CONVERTED_TYPE_LIST);
+      writer.end_struct();
+      writer.begin_struct();
+      writer.write_i32_field(3, PARQUET_FIELD_REPETITION_REPEATED);
+      writer.write_binary_field(4, "list");
+      writer.write_i32_field(5, 1);
+      writer.end_struct();
+    }
+    writer.begin_struct();
+    writer.write_i32_field(1, column.get_type());
+    writer.write_i32_field(3, (column.get_repetition() == PARQUET_REPETITION_REQUIRED) ? PARQUET_FIELD_REPETITION_REQUIRED
+        : PARQUET_FIELD_REPETITION_OPTIONAL);
+    writer.write_binary_field(4, is_list ? "element" : column.get_name());
+    if(column.get_type() == PARQUET_TYPE_BYTE_ARRAY)
+      writer.write_i32_field(6, PARQUET_CONVERTED_TYPE_UTF8);
+    writer.end_struct();
+  }
+  auto num_rows = 0ll;
+  for(const auto& row_group_info : m_row_groups)
+    num_rows += row_group_info.m_num_rows;
+  writer.write_i64_field(3, num_rows);
+  //Row groups
+  writer.begin_list_field(4, THRIFT_COMPACT_STRUCT, m_row_groups.size());
+  for(const auto& row_group_info : m_row_groups)
+  {
+    writer.begin_struct();
+    writer.begin_list_field(1, THRIFT_COMPACT_STRUCT, m_columns.size());
+    auto total_size = 0ll;
+    for(auto i=0u;i<m_columns.size();++i)
+    {
+      const auto& column = m_columns[i];
+      const auto& chunk_info = row_group_info.m_chunks[i];
+      auto is_list = (column.get_repetition() == PARQUET_REPETITION_LIST);
+      auto has_dictionary_page = (chunk_info.m_dictionary_page_offset >= 0);
+      auto has_levels = (column.get_repetition() != PARQUET_REPETITION_REQUIRED);
+      total_size += chunk_info.m_size;
+      //ColumnChunk
+      writer.begin_struct();
+      writer.write_i64_field(2, chunk_info.get_begin_offset());
+      //ColumnMetaData
+      writer.begin_struct_field(3);
+      writer.write_i32_field(1, column.get_type());
+      writer.begin_list_field(2, THRIFT_COMPACT_I32, 1u+(has_dictionary_page ? 1u : 0u)+(has_levels ? 1u : 0u));
+      writer.write_i32(chunk_info.m_encoding);
+      if(has_dictionary_page)
+        writer.write_i32(PARQUET_ENCODING_PLAIN);
+      if(has_levels)
+        writer.write_i32(PARQUET_ENCODING_RLE);
+      writer.begin_list_field(3, THRIFT_COMPACT_BINARY, is_list ? 3u : 1u);
+      writer.write_binary(column.get_name());
+      if(is_list)
+      {
+        writer.write_binary("list");
+        writer.write_binary("element");
+      }
+      writer.write_i32_field(4, PARQUET_CODEC_UNCOMPRESSED);
+      writer.write_i64_field(5, chunk_info.m_num_values);
+      writer.write_i64_field(6, chunk_info.m_size);
+      writer.write_i64_field(7, chunk_info.m_size);
+      writer.write_i64_field(9, chunk_info.m_data_page_offset);
+      if(has_dictionary_page)
+        writer.write_i64_field(11, chunk_info.m_dictionary_page_offset);
+      writer.end_struct();
+      writer.end_struct();
+    }
+    writer.write_i64_field(2, total_size);
+    writer.write_i64_field(3, row_group_info.m_num_rows);
+    writer.end_struct();
+  }
+  if(!m_key_value_metadata.empty())
+  {
+    writer.begin_list_field(5, THRIFT_COMPACT_STRUCT, m_key_value_metadata.size());
+    for(const auto& entry : m_key_value_metadata)
+    {
+      writer.begin_struct();
+      writer.write_binary_field(1, entry.first);
+      writer.write_binary_field(2, entry.second);
+      writer.end_struct();
+    }
+  }
+  writer.write_binary_field(6, "GenomicsDB");
+  writer.end_struct();
+  VERIFY_OR_THROW(offset <= UINT32_MAX);
+  write_uint32(m_buffer, offset, offset);
+  m_fptr.write(reinterpret_cast<const char*>(&(m_buffer[0])), offset);
+  m_fptr.write(PARQUET_MAGIC, PARQUET_MAGIC_LENGTH);
+  m_fptr.close();
+  if(m_fptr.fail())
+    throw ParquetFileException(std::string("Error while writing the footer of Parquet file ")+m_filename);
+  m_finalized = true;
+}
+
+//ParquetFileReader functions
+class ParquetSchemaElement
+{
+  public:
+    ParquetSchemaElement()
+    {
+      m_type = -1;
+      m_repetition_type = PARQUET_FIELD_REPETITION_REQUIRED;
+      m_num_children = 0;
+      m_converted_type = -1;
+    }
+    int m_type;
+    int m_repetition_type;
+    std::string m_name;
+    int m_num_children;
+    int m_converted_type;
+};
+
+static void read_column_chunk_info(ThriftCompactReader& reader, ParquetColumnChunkInfo& chunk_info, int& type, int& codec)
+{
+  int16_t field_id = 0;
+  uint8_t field_type = 0u;
+  reader.begin_struct();
+  while(reader.read_field_header(field_id, field_type))
+  {
+    //file_path - the chunk is in another file
+    if(field_id == 1)
+      throw ParquetFileException("Column chunks in other files are not supported");
+    if(field_id != 3 || field_type != THRIFT_COMPACT_STRUCT)
+    {
+      reader.skip(field_type);
+      continue;
+    }
+    //ColumnMetaData
+    reader.begin_struct();
+    while(reader.read_field_header(field_id, field_type))
+    {
+      //Encoding of the values - RLE is the encoding of the levels, PLAIN of the dictionary page (if any)
+      if(field_id == 2 && field_type == THRIFT_COMPACT_LIST)
+      {
+        uint8_t element_type = 0u;
+        uint64_t num_encodings = 0ull;
+        reader.read_list_header(element_type, num_encodings);
+        VERIFY_OR_THROW(element_type == THRIFT_COMPACT_I32);
+        for(auto i=0ull;i<num_encodings;++i)
+        {
+          auto encoding = reader.read_int();
+          if(encoding != PARQUET_ENCODING_PLAIN && encoding != PARQUET_ENCODING_RLE)
+            chunk_info.m_encoding = static_cast<ParquetEncodingEnum>(encoding);
+        }
+        continue;
+      }
+      if(field_type != THRIFT_COMPACT_I32 && field_type != THRIFT_COMPACT_I64)
+      {
+        reader.skip(field_type);
+        continue;
+      }
+      auto value = reader.read_int();
+      switch(field_id)
+      {
+        case 1: type = value; break;
+        case 4: codec = value; break;
+        case 5: chunk_info.m_num_values = value; break;
+        case 7: chunk_info.m_size = value; break;
+        case 9: chunk_info.m_data_page_offset = value; break;
+        case 11: chunk_info.m_dictionary_page_offset = value; break;
+        default: break;
+      }
+    }
+    reader.end_struct();
+  }
+  reader.end_struct();
+}
+
+ParquetFileReader::ParquetFileReader(const std::string& filename)
+  : m_filename(filename)
+{
+  m_num_rows = 0ll;
+  m_fptr.open(filename.c_str(), std::ios::in | std::ios::binary);
+  if(!m_fptr.is_open())
+    throw ParquetFileException(std::string("Could not open Parquet file ")+filename);
+  m_fptr.seekg(0, std::ios::end);
+  uint64_t file_size = m_fptr.tellg();
+  if(file_size < 2u*PARQUET_MAGIC_LENGTH+sizeof(uint32_t))
+    throw ParquetFileException(std::string("File ")+filename+" is too small to be a Parquet file");
+  //Magic at both ends
+  char magic[PARQUET_MAGIC_LENGTH];
+  uint32_t footer_size = 0u;
+  m_fptr.seekg(0, std::ios::beg);
+  m_fptr.read(magic, PARQUET_MAGIC_LENGTH);
+  auto valid_magic = (memcmp(magic, PARQUET_MAGIC, PARQUET_MAGIC_LENGTH) == 0);
+  m_fptr.seekg(file_size-PARQUET_MAGIC_LENGTH-sizeof(uint32_t), std::ios::beg);
+  m_fptr.read(reinterpret_cast<char*>(&footer_size), sizeof(uint32_t));
+  m_fptr.read(magic, PARQUET_MAGIC_LENGTH);
+  valid_magic = valid_magic && (memcmp(magic, PARQUET_MAGIC, PARQUET_MAGIC_LENGTH) == 0);
+  if(!valid_magic || !m_fptr.good() || footer_size > file_size-2u*PARQUET_MAGIC_LENGTH-sizeof(uint32_t))
+    throw ParquetFileException(std::string("File ")+filename+" is not a complete Parquet file");
+  //FileMetaData
+  m_buffer.resize(footer_size+1u);
+  m_fptr.seekg(file_size-PARQUET_MAGIC_LENGTH-sizeof(uint32_t)-footer_size, std::ios::beg);
+  m_fptr.read(reinterpret_cast<char*>(&(m_buffer[0])), footer_size);
+  VERIFY_OR_THROW(m_fptr.good());
+  ThriftCompactReader reader(&(m_buffer[0]), footer_size);
+  std::vector<ParquetSchemaElement> schema;
+  std::vector<std::vector<int>> chunk_types;
+  int16_t field_id = 0;
+  uint8_t type = 0u;
+  uint8_t element_type = 0u;
+  uint64_t num_elements = 0ull;
+  while(reader.read_field_header(field_id, type))
+  {
+    if(field_id == 3 && type == THRIFT_COMPACT_I64)
+    {
+      m_num_rows = reader.read_int();
+      continue;
+    }
+    if(type != THRIFT_COMPACT_LIST || (field_id != 2 && field_id != 4 && field_id != 5))
+    {
+      reader.skip(type);
+      continue;
+    }
+    reader.read_list_header(element_type, num_elements);
+    VERIFY_OR_THROW(element_type == THRIFT_COMPACT_STRUCT);
+    for(auto i=0ull;i<num_elements;++i)
+    {
+      int16_t element_field_id = 0;
+      uint8_t element_field_type = 0u;
+      switch(field_id)
+      {
+        case 2:
+          //SchemaElement
+          schema.emplace_back();
+          reader.begin_struct();
+          while(reader.read_field_header(element_field_id, element_field_type))
+          {
+            auto& element = schema.back();
+            if(element_field_id == 4 && element_field_type == THRIFT_COMPACT_BINARY)
+              element.m_name = reader.read_binary();
+            else if(element_field_type != THRIFT_COMPACT_I32)
+              reader.skip(element_field_type);
+            else if(element_field_id == 1)
+              element.m_type = reader.read_int();
+            else if(element_field_id == 3)
+              element.m_repetition_type = reader.read_int();
+            else if(element_field_id == 5)
+              element.m_num_children = reader.read_int();
+            else if(element_field_id == 6)
+              element.m_converted_type = reader.read_int();
+            else
+              reader.skip(element_field_type);
+          }
+          reader.end_struct();
+          break;
+        case 4:
+          {
+            //RowGroup
+            m_row_groups.emplace_back();
+            chunk_types.emplace_back();
+            auto& row_group_info = m_row_groups.back();
+            row_group_info.m_num_rows = 0ll;
+            reader.begin_struct();
+            while(reader.read_field_header(element_field_id, element_field_type))
+            {
+              if(element_field_id == 3 && element_field_type == THRIFT_COMPACT_I64)
+                row_group_info.m_num_rows = reader.read_int();
+              else if(element_field_id == 1 && element_field_type == THRIFT_COMPACT_LIST)
+              {
+                uint64_t num_chunks = 0ull;
+                reader.read_list_header(element_type, num_chunks);
+                VERIFY_OR_THROW(element_type == THRIFT_COMPACT_STRUCT);
+                row_group_info.m_chunks.resize(num_chunks);
+                chunk_types.back().resize(num_chunks, -1);
+                for(auto j=0ull;j<num_chunks;++j)
+                {
+                  auto codec = PARQUET_CODEC_UNCOMPRESSED;
+                  read_column_chunk_info(reader, row_group_info.m_chunks[j], chunk_types.back()[j], codec);
+                  if(codec != PARQUET_CODEC_UNCOMPRESSED)
+                    throw ParquetFileException(std::string("Compressed column chunks are not supported - file ")+filename);
+                }
+              }
+              else
+                reader.skip(element_field_type);
+            }
+            reader.end_struct();
+            break;
+          }
+        default:
+          {
+            //KeyValue
+            std::string key, value;
+            reader.begin_struct();
+            while(reader.read_field_header(element_field_id, element_field_type))
+            {
+              if(element_field_id == 1 && element_field_type == THRIFT_COMPACT_BINARY)
+                key = reader.read_binary();
+              else if(element_field_id == 2 && element_field_type == THRIFT_COMPACT_BINARY)
+                value = reader.read_binary();
+              else
+                reader.skip(element_field_type);
+            }
+            reader.end_struct();
+            m_key_value_metadata.emplace_back(key, value);
+            break;
+          }
+      }
+    }
+  }
+  //Columns from the schema - flat columns and 3-level lists
+  VERIFY_OR_THROW(!schema.empty());
+  auto schema_idx = 1ull;
+  for(auto i=0;i<schema[0u].m_num_children;++i)
+  {
+    VERIFY_OR_THROW(schema_idx < schema.size());
+    const auto& element = schema[schema_idx];
+    if(element.m_num_children == 0)
+    {
+      if(element.m_repetition_type == PARQUET_FIELD_REPETITION_REPEATED)
+        throw ParquetFileException(std::string("Unsupported repeated column ")+element.m_name);
+      m_columns.emplace_back(element.m_name, static_cast<ParquetPhysicalTypeEnum>(element.m_type),
+          (element.m_repetition_type == PARQUET_FIELD_REPETITION_REQUIRED) ? PARQUET_REPETITION_REQUIRED
+          : PARQUET_REPETITION_OPTIONAL);
+      ++schema_idx;
+    }
+    else
+    {
+      VERIFY_OR_THROW(schema_idx+2u < schema.size());
+      const auto& list_element = schema[schema_idx+1u];
+      const auto& leaf_element = schema[schema_idx+2u];
+      if(element.m_repetition_type != PARQUET_FIELD_REPETITION_REQUIRED || element.m_num_children != 1
+          || list_element.m_repetition_type != PARQUET_FIELD_REPETITION_REPEATED || list_element.m_num_children != 1
+          || leaf_element.m_repetition_type != PARQUET_FIELD_REPETITION_OPTIONAL || leaf_element.m_num_children != 0)
+        throw ParquetFileException(std::string("Unsupported nested column ")+element.m_name);
+      m_columns.emplace_back(element.m_name, static_cast<ParquetPhysicalTypeEnum>(leaf_element.m_type),
+          PARQUET_REPETITION_LIST);
+      schema_idx += 3u;
+    }
+    auto column_type = m_columns.back().get_type();
+    if(column_type != PARQUET_TYPE_INT32 && column_type != PARQUET_TYPE_INT64 && column_type != PARQUET_TYPE_FLOAT
+        && column_type != PARQUET_TYPE_BYTE_ARRAY)
+      throw ParquetFileException(std::string("Unsupported type ")+std::to_string(column_type)+" of column "
+          +m_columns.back().get_name());
+  }
+  VERIFY_OR_THROW(schema_idx == schema.size());
+  for(auto i=0ull;i<m_row_groups.size();++i)
+  {
+    VERIFY_OR_THROW(m_row_groups[i].m_chunks.size() == m_columns.size());
+    for(auto j=0u;j<m_columns.size();++j)
+    {
+      const auto& chunk_info = m_row_groups[i].m_chunks[j];
+      VERIFY_OR_THROW(chunk_types[i][j] == m_columns[j].get_type());
+      VERIFY_OR_THROW(chunk_info.get_begin_offset() >= static_cast<int64_t>(PARQUET_MAGIC_LENGTH) && chunk_info.m_size >= 0
+          && static_cast<uint64_t>(chunk_info.get_begin_offset()+chunk_info.m_size) <= file_size);
+    }
+  }
+}
+
+bool ParquetFileReader::get_column_idx(const std::string& name, unsigned& idx) const
+{
+  for(auto i=0u;i<m_columns.size();++i)
+    if(m_columns[i].get_name() == name)
+    {
+      idx = i;
+      return true;
+    }
+  return false;
+}
+
+bool ParquetFileReader::get_key_value_metadata(const std::string& key, std::string& value) const
+{
+  for(const auto& entry : m_key_value_metadata)
+    if(entry.first == key)
+    {
+      value = entry.second;
+      return true;
+    }
+  return false;
+}
+
+void ParquetFileReader::read_column_chunk(const uint64_t row_group_idx, const unsigned column_idx, ParquetColumn& column)
+{
+  VERIFY_OR_THROW(row_group_idx < m_row_groups.size() && column_idx < m_columns.size());
+  const auto& chunk_info = m_row_groups[row_group_idx].m_chunks[column_idx];
+  m_buffer.resize(chunk_info.m_size+1u);
+  m_fptr.seekg(chunk_info.get_begin_offset(), std::ios::beg);
+  m_fptr.read(reinterpret_cast<char*>(&(m_buffer[0])), chunk_info.m_size);
+  if(!m_fptr.good())
+    throw ParquetFileException(std::string("Error while reading Parquet file ")+m_filename);
+  const auto& schema = m_columns[column_idx];
+  column = ParquetColumn(schema.get_name(), schema.get_type(), schema.get_repetition());
+  column.decode_pages(&(m_buffer[0]), chunk_info.m_size, chunk_info.m_num_values);
+  if(column.get_num_rows() != static_cast<uint64_t>(m_row_groups[row_group_idx].m_num_rows))
+    throw ParquetFileException(std::string("Column chunk ")+schema.get_name()+" does not have the #rows of row group "
+        +std::to_string(row_group_idx));
+}
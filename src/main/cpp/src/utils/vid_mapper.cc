@@ -21,6 +21,7 @@
 */
 
 #include <libgen.h>
+#include <deque>
 #include "vid_mapper.h"
 #include "c_api.h"
 #include "json_config.h"
@@ -103,38 +104,83 @@ void VidMapper::clear()
   m_contig_idx_to_info.clear();
   m_contig_begin_2_idx.clear();
   m_contig_end_2_idx.clear();
+  m_contig_begin_eytzinger.clear();
+  m_contig_idx_eytzinger.clear();
   m_field_name_to_idx.clear();
   m_field_idx_to_info.clear();
   m_buffer_stream_idx_to_global_file_idx.clear();
   m_owner_idx_to_file_idx_vec.clear();
 }
 
-bool VidMapper::get_contig_location(int64_t query_position, std::string& contig_name, int64_t& contig_position) const
+//Most lookups are sequential - the contig found by the previous lookup of this thread is tried first.
+//The hint is validated against the contig bounds, so a hint left by a different VidMapper object
+//only costs the comparison
+static thread_local int g_last_contig_idx_hint = -1;
+
+//In-order traversal of the implicit tree assigns the sorted elements to their Eytzinger positions
+static size_t fill_eytzinger_layout(const std::vector<std::pair<int64_t, int>>& sorted_vec, size_t sorted_idx,
+    const size_t k, std::vector<int64_t>& eytzinger_offsets, std::vector<int>& eytzinger_idxs)
 {
-  int idx = -1;
-  std::pair<int64_t, int> query_pair;
-  query_pair.first = query_position;
-  query_pair.second = 0;
-  //find contig with offset >= query_position
-  auto iter = std::lower_bound(m_contig_begin_2_idx.begin(), m_contig_begin_2_idx.end(), query_pair, contig_offset_idx_pair_cmp);
-  if(iter == m_contig_begin_2_idx.end())        //no such contig exists, hence, get last contig in sorted order
+  if(k < eytzinger_offsets.size())
   {
-    assert(m_contig_begin_2_idx.size() > 0u);
-    idx = m_contig_begin_2_idx[m_contig_begin_2_idx.size()-1u].second;
+    sorted_idx = fill_eytzinger_layout(sorted_vec, sorted_idx, 2u*k, eytzinger_offsets, eytzinger_idxs);
+    eytzinger_offsets[k] = sorted_vec[sorted_idx].first;
+    eytzinger_idxs[k] = sorted_vec[sorted_idx].second;
+    ++sorted_idx;
+    sorted_idx = fill_eytzinger_layout(sorted_vec, sorted_idx, 2u*k+1u, eytzinger_offsets, eytzinger_idxs);
   }
-  else
+  return sorted_idx;
+}
+
+void VidMapper::build_contig_search_index()
+{
+  m_contig_begin_eytzinger.resize(m_contig_begin_2_idx.size()+1u);
+  m_contig_idx_eytzinger.resize(m_contig_begin_2_idx.size()+1u);
+  //Position 0 is unused
+  m_contig_begin_eytzinger[0u] = INT64_MIN;
+  m_contig_idx_eytzinger[0u] = -1;
+  fill_eytzinger_layout(m_contig_begin_2_idx, 0u, 1u, m_contig_begin_eytzinger, m_contig_idx_eytzinger);
+}
+
+//Branch free descent - at the leaf, the bits of k record the path (1 == right turn)
+//Returns the Eytzinger position of the last element <= query_position, 0 if none
+static inline size_t eytzinger_last_less_or_equal(const std::vector<int64_t>& eytzinger_offsets, const int64_t query_position)
+{
+  size_t k = 1u;
+  while(k < eytzinger_offsets.size())
+    k = 2u*k + (eytzinger_offsets[k] <= query_position ? 1u : 0u);
+  //Drop the left turns after the last right turn, and the last right turn
+  return k >> __builtin_ffsll(static_cast<long long>(k));
+}
+
+//Returns the Eytzinger position of the first element > query_position, 0 if none
+static inline size_t eytzinger_first_greater(const std::vector<int64_t>& eytzinger_offsets, const int64_t query_position)
+{
+  size_t k = 1u;
+  while(k < eytzinger_offsets.size())
+    k = 2u*k + (eytzinger_offsets[k] <= query_position ? 1u : 0u);
+  //Drop the right turns after the last left turn, and the last left turn
+  return k >> __builtin_ffsll(static_cast<long long>(~k));
+}
+
+bool VidMapper::get_contig_location(int64_t query_position, std::string& contig_name, int64_t& contig_position) const
+{
+  int idx = g_last_contig_idx_hint;
+  if(idx < 0 || static_cast<size_t>(idx) >= m_contig_idx_to_info.size()
+      || query_position < m_contig_idx_to_info[idx].m_tiledb_column_offset
+      || query_position >= m_contig_idx_to_info[idx].m_tiledb_column_offset+m_contig_idx_to_info[idx].m_length)
   {
-    if((*iter).first == query_position)       //query_position == contig offset at iter, found idx
-      idx = (*iter).second;
-    else                                //query_position < contig_offset at iter, get idx at previous element
+    //find contig with the largest offset <= query_position
+    if(m_contig_begin_eytzinger.size() == m_contig_begin_2_idx.size()+1u)
+      idx = m_contig_idx_eytzinger[eytzinger_last_less_or_equal(m_contig_begin_eytzinger, query_position)];
+    else //search index not built
     {
-      //if iter == begin(), query position is less than 1st contig offset, return invalid
-      if(iter == m_contig_begin_2_idx.begin()) 
-        return false;
-      auto vector_idx = iter - m_contig_begin_2_idx.begin();
-      idx = m_contig_begin_2_idx[vector_idx-1].second;
+      auto iter = std::upper_bound(m_contig_begin_2_idx.begin(), m_contig_begin_2_idx.end(),
+          std::pair<int64_t, int>(query_position, 0), contig_offset_idx_pair_cmp);
+      idx = (iter == m_contig_begin_2_idx.begin()) ? -1 : (*(iter-1)).second;
     }
   }
+  //query_position is less than 1st contig offset
   if(idx < 0)
     return false;
   assert(static_cast<size_t>(idx) < m_contig_idx_to_info.size());
@@ -145,6 +191,7 @@ bool VidMapper::get_contig_location(int64_t query_position, std::string& contig_
   {
     contig_name = m_contig_idx_to_info[idx].m_name;
     contig_position = query_position - contig_offset;
+    g_last_contig_idx_hint = idx;
     return true;
   }
   return false;
@@ -153,12 +200,16 @@ bool VidMapper::get_contig_location(int64_t query_position, std::string& contig_
 bool VidMapper::get_next_contig_location(int64_t query_position, std::string& next_contig_name, int64_t& next_contig_offset) const
 {
   int idx = -1;
-  std::pair<int64_t, int> query_pair;
-  query_pair.first = query_position;
-  query_pair.second = 0;
   //find contig with offset > query_position
-  auto iter = std::upper_bound(m_contig_begin_2_idx.begin(), m_contig_begin_2_idx.end(), query_pair, contig_offset_idx_pair_cmp);
-  if(iter == m_contig_begin_2_idx.end())        //no such contig exists, hence, set large upper bound
+  if(m_contig_begin_eytzinger.size() == m_contig_begin_2_idx.size()+1u)
+    idx = m_contig_idx_eytzinger[eytzinger_first_greater(m_contig_begin_eytzinger, query_position)];
+  else //search index not built
+  {
+    auto iter = std::upper_bound(m_contig_begin_2_idx.begin(), m_contig_begin_2_idx.end(),
+        std::pair<int64_t, int>(query_position, 0), contig_offset_idx_pair_cmp);
+    idx = (iter == m_contig_begin_2_idx.end()) ? -1 : (*iter).second;
+  }
+  if(idx < 0)        //no such contig exists, hence, set large upper bound
   {
     next_contig_name = "";
     next_contig_offset = INT64_MAX;
@@ -166,7 +217,6 @@ bool VidMapper::get_next_contig_location(int64_t query_position, std::string& ne
   }
   else
   {
-    idx = (*iter).second;
     assert(idx >=0 && static_cast<size_t>(idx) < m_contig_idx_to_info.size());
     next_contig_name = m_contig_idx_to_info[idx].m_name;
     next_contig_offset = m_contig_idx_to_info[idx].m_tiledb_column_offset;
@@ -177,10 +227,16 @@ bool VidMapper::get_next_contig_location(int64_t query_position, std::string& ne
 
 bool VidMapper::get_tiledb_position(int64_t& position, const std::string& contig_name, const int64_t contig_position) const
 {
-  auto iter = m_contig_name_to_idx.find(contig_name);
-  if(iter == m_contig_name_to_idx.end())
-    return false;
-  auto idx = (*iter).second;
+  //Same contig as the previous lookup - skip hashing the name
+  int idx = g_last_contig_idx_hint;
+  if(idx < 0 || static_cast<size_t>(idx) >= m_contig_idx_to_info.size() || m_contig_idx_to_info[idx].m_name != contig_name)
+  {
+    auto iter = m_contig_name_to_idx.find(contig_name);
+    if(iter == m_contig_name_to_idx.end())
+      return false;
+    idx = (*iter).second;
+    g_last_contig_idx_hint = idx;
+  }
   assert(static_cast<size_t>(idx) < m_contig_idx_to_info.size());
   if(contig_position >= m_contig_idx_to_info[idx].m_length)
     return false;
@@ -481,6 +537,192 @@ std::vector<ContigIntervalTuple> VidMapper::get_contig_intervals_for_column_part
   }
 }
 
+//Binary snapshot of the mapping state - native byte order
+//Layout (version 1):
+//  magic[8], uint32 version, uint32 #contigs, uint32 #fields, uint32 #owners, uint64 #files, uint64 #callsets
+//  contigs: int64 length, int64 TileDB column offset, string name
+//  sorted contig begin and end tables: #contigs x (int64 column, int64 contig idx) each
+//  fields: string name, string vcf name, uint8 FILTER/INFO/FORMAT bits, int32 bcf_ht_type, length descriptor,
+//    #elements, combine operation, quantization cap, quantization bin size
+//  files: string name, int32 type, int32 owner idx, int64 local file idx, uint8 single split file path,
+//    uint32 #split paths, strings
+//  owners: uint64 #files, int64 global file idxs
+//  callsets (initialized rows only): int64 row idx, int64 file idx, int64 idx in file, string name
+//Strings are stored as uint32 length followed by the characters (no terminator)
+#define VID_MAPPER_SNAPSHOT_MAGIC "GDBVIDS"
+#define VID_MAPPER_SNAPSHOT_MAGIC_LENGTH 8u
+#define VID_MAPPER_SNAPSHOT_VERSION 1u
+
+class VidMapperSnapshotWriter
+{
+  public:
+    VidMapperSnapshotWriter(const std::string& filename)
+      : m_filename(filename)
+    {
+      m_fptr = fopen(filename.c_str(), "wb");
+      if(m_fptr == 0)
+        throw VidMapperException(std::string("Could not open vid mapper snapshot file ")+filename+" for writing");
+    }
+    ~VidMapperSnapshotWriter()
+    {
+      if(m_fptr)
+        fclose(m_fptr);
+    }
+    void write_bytes(const void* ptr, const size_t num_bytes)
+    {
+      if(num_bytes > 0u && fwrite(ptr, 1u, num_bytes, m_fptr) != num_bytes)
+        throw VidMapperException(std::string("Error while writing vid mapper snapshot file ")+m_filename);
+    }
+    template<class T>
+    void write(const T val) { write_bytes(&val, sizeof(T)); }
+    void write_string(const std::string& str)
+    {
+      write<uint32_t>(str.length());
+      write_bytes(str.c_str(), str.length());
+    }
+    void close()
+    {
+      auto status = fclose(m_fptr);
+      m_fptr = 0;
+      if(status != 0)
+        throw VidMapperException(std::string("Error while closing vid mapper snapshot file ")+m_filename);
+    }
+  private:
+    std::string m_filename;
+    FILE* m_fptr;
+};
+
+//Reads fields sequentially from the snapshot - the file is read into memory with a single read and
+//every field read is bounds checked
+class VidMapperSnapshotReader
+{
+  public:
+    VidMapperSnapshotReader(const std::string& filename)
+      : m_filename(filename)
+    {
+      m_offset = 0u;
+      auto* fptr = fopen(filename.c_str(), "rb");
+      if(fptr == 0)
+        throw VidMapperException(std::string("Could not open vid mapper snapshot file ")+filename);
+      auto status = fseek(fptr, 0, SEEK_END);
+      auto size = (status == 0) ? ftell(fptr) : -1l;
+      if(size <= 0 || fseek(fptr, 0, SEEK_SET) != 0)
+      {
+        fclose(fptr);
+        throw VidMapperException(std::string("Could not determine size or empty vid mapper snapshot file ")+filename);
+      }
+      m_buffer.resize(size);
+      auto num_bytes_read = fread(&(m_buffer[0]), 1u, m_buffer.size(), fptr);
+      fclose(fptr);
+      if(num_bytes_read != m_buffer.size())
+        throw VidMapperException(std::string("Error while reading vid mapper snapshot file ")+filename);
+    }
+    const char* read_bytes(const size_t num_bytes)
+    {
+      if(num_bytes > m_buffer.size() - m_offset)
+        throw VidMapperException(std::string("Truncated vid mapper snapshot file ")+m_filename);
+      auto ptr = &(m_buffer[0]) + m_offset;
+      m_offset += num_bytes;
+      return ptr;
+    }
+    template<class T>
+    T read()
+    {
+      T val;
+      memcpy(&val, read_bytes(sizeof(T)), sizeof(T));
+      return val;
+    }
+    void read_string(std::string& str)
+    {
+      auto length = read<uint32_t>();
+      str.assign(read_bytes(length), length);
+    }
+    bool is_done() const { return m_offset == m_buffer.size(); }
+  private:
+    std::string m_filename;
+    std::vector<char> m_buffer;
+    size_t m_offset;
+};
+
+bool VidMapper::is_binary_snapshot(const std::string& filename)
+{
+  auto* fptr = fopen(filename.c_str(), "rb");
+  if(fptr == 0)
+    return false;
+  char magic[VID_MAPPER_SNAPSHOT_MAGIC_LENGTH];
+  auto num_bytes_read = fread(magic, 1u, VID_MAPPER_SNAPSHOT_MAGIC_LENGTH, fptr);
+  fclose(fptr);
+  return (num_bytes_read == VID_MAPPER_SNAPSHOT_MAGIC_LENGTH
+      && memcmp(magic, VID_MAPPER_SNAPSHOT_MAGIC, VID_MAPPER_SNAPSHOT_MAGIC_LENGTH) == 0);
+}
+
+void VidMapper::write_binary_snapshot(const std::string& filename) const
+{
+  VERIFY_OR_THROW(m_is_initialized);
+  auto num_callsets = 0ull;
+  for(const auto& callset_info : m_row_idx_to_info)
+    num_callsets += (callset_info.m_is_initialized ? 1u : 0u);
+  VidMapperSnapshotWriter writer(filename);
+  writer.write_bytes(VID_MAPPER_SNAPSHOT_MAGIC, VID_MAPPER_SNAPSHOT_MAGIC_LENGTH);
+  writer.write<uint32_t>(VID_MAPPER_SNAPSHOT_VERSION);
+  writer.write<uint32_t>(m_contig_idx_to_info.size());
+  writer.write<uint32_t>(m_field_idx_to_info.size());
+  writer.write<uint32_t>(m_owner_idx_to_file_idx_vec.size());
+  writer.write<uint64_t>(m_file_idx_to_info.size());
+  writer.write<uint64_t>(num_callsets);
+  for(const auto& contig_info : m_contig_idx_to_info)
+  {
+    writer.write<int64_t>(contig_info.m_length);
+    writer.write<int64_t>(contig_info.m_tiledb_column_offset);
+    writer.write_string(contig_info.m_name);
+  }
+  for(const auto* contig_table : { &m_contig_begin_2_idx, &m_contig_end_2_idx })
+    for(const auto& offset_idx_pair : *contig_table)
+    {
+      writer.write<int64_t>(offset_idx_pair.first);
+      writer.write<int64_t>(offset_idx_pair.second);
+    }
+  for(const auto& field_info : m_field_idx_to_info)
+  {
+    writer.write_string(field_info.m_name);
+    writer.write_string(field_info.m_vcf_name);
+    writer.write<uint8_t>((field_info.m_is_vcf_FILTER_field ? 1u : 0u) | (field_info.m_is_vcf_INFO_field ? 2u : 0u)
+        | (field_info.m_is_vcf_FORMAT_field ? 4u : 0u));
+    writer.write<int32_t>(field_info.m_bcf_ht_type);
+    writer.write<int32_t>(field_info.m_length_descriptor);
+    writer.write<int32_t>(field_info.m_num_elements);
+    writer.write<int32_t>(field_info.m_VCF_field_combine_operation);
+    writer.write<int32_t>(field_info.m_quantization_cap);
+    writer.write<int32_t>(field_info.m_quantization_bin_size);
+  }
+  for(const auto& file_info : m_file_idx_to_info)
+  {
+    writer.write_string(file_info.m_name);
+    writer.write<int32_t>(file_info.m_type);
+    writer.write<int32_t>(file_info.m_owner_idx);
+    writer.write<int64_t>(file_info.m_local_file_idx);
+    writer.write<uint8_t>(file_info.m_single_split_file_path ? 1u : 0u);
+    writer.write<uint32_t>(file_info.m_split_files_paths.size());
+    for(const auto& path : file_info.m_split_files_paths)
+      writer.write_string(path);
+  }
+  for(const auto& file_idx_vec : m_owner_idx_to_file_idx_vec)
+  {
+    writer.write<uint64_t>(file_idx_vec.size());
+    for(auto file_idx : file_idx_vec)
+      writer.write<int64_t>(file_idx);
+  }
+  for(const auto& callset_info : m_row_idx_to_info)
+    if(callset_info.m_is_initialized)
+    {
+      writer.write<int64_t>(callset_info.m_row_idx);
+      writer.write<int64_t>(callset_info.m_file_idx);
+      writer.write<int64_t>(callset_info.m_idx_in_file);
+      writer.write_string(callset_info.m_name);
+    }
+  writer.close();
+}
+
 //FileBasedVidMapper code
 #ifdef VERIFY_OR_THROW
 #undef VERIFY_OR_THROW
@@ -488,6 +730,387 @@ std::vector<ContigIntervalTuple> VidMapper::get_contig_intervals_for_column_part
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw FileBasedVidMapperException(#X);
 
+//Read the whole file into buffer (null terminated) with a single read - mapping files can be
+//hundreds of MBs and istreambuf_iterator copies them a character at a time
+//Returns false if the file could not be opened
+static bool read_file_into_buffer(const std::string& filename, std::vector<char>& buffer)
+{
+  auto* fptr = fopen(filename.c_str(), "rb");
+  if(fptr == 0)
+    return false;
+  auto status = fseek(fptr, 0, SEEK_END);
+  auto file_size = ftell(fptr);
+  if(status != 0 || file_size < 0)
+  {
+    fclose(fptr);
+    return false;
+  }
+  rewind(fptr);
+  buffer.resize(file_size+1u);
+  auto num_bytes_read = fread(&(buffer[0]), 1u, file_size, fptr);
+  fclose(fptr);
+  buffer.resize(num_bytes_read+1u);
+  buffer[num_bytes_read] = '\0';
+  return true;
+}
+
+//One flat dictionary from a JSON stream - only scalar values are kept, nested values are skipped
+//Entries are re-used across records so that streaming N records does not allocate N times
+class JSONStreamRecord
+{
+  public:
+    enum JSONStreamValueTypeEnum
+    {
+      JSON_STREAM_NULL_VALUE=0,
+      JSON_STREAM_BOOL_VALUE,
+      JSON_STREAM_INT64_VALUE,
+      JSON_STREAM_DOUBLE_VALUE,
+      JSON_STREAM_STRING_VALUE
+    };
+    JSONStreamRecord() { clear(); }
+    void clear() { m_num_entries = 0u; }
+    //Key is set first, value is set by the next call
+    void add_key(const char* key, const size_t length)
+    {
+      if(m_num_entries == m_entries.size())
+        m_entries.emplace_back();
+      auto& entry = m_entries[m_num_entries++];
+      entry.m_key.assign(key, length);
+      entry.m_type = JSON_STREAM_NULL_VALUE;
+    }
+    void set_bool(const bool val) { last_entry().m_type = JSON_STREAM_BOOL_VALUE; last_entry().m_int64_value = val; }
+    void set_int64(const int64_t val) { last_entry().m_type = JSON_STREAM_INT64_VALUE; last_entry().m_int64_value = val; }
+    void set_double(const double val) { last_entry().m_type = JSON_STREAM_DOUBLE_VALUE; last_entry().m_double_value = val; }
+    void set_string(const char* val, const size_t length)
+    {
+      last_entry().m_type = JSON_STREAM_STRING_VALUE;
+      last_entry().m_string_value.assign(val, length);
+    }
+    //Nested value - drop the key
+    void remove_last_key() { --m_num_entries; }
+    bool has_member(const char* key) const { return find(key) != 0; }
+    bool is_int64(const char* key) const
+    {
+      auto entry = find(key);
+      return entry && entry->m_type == JSON_STREAM_INT64_VALUE;
+    }
+    bool is_string(const char* key) const
+    {
+      auto entry = find(key);
+      return entry && entry->m_type == JSON_STREAM_STRING_VALUE;
+    }
+    int64_t get_int64(const char* key) const
+    {
+      VERIFY_OR_THROW(is_int64(key));
+      return find(key)->m_int64_value;
+    }
+    const std::string& get_string(const char* key) const
+    {
+      VERIFY_OR_THROW(is_string(key));
+      return find(key)->m_string_value;
+    }
+  private:
+    struct JSONStreamRecordEntry
+    {
+      std::string m_key;
+      JSONStreamValueTypeEnum m_type;
+      int64_t m_int64_value;
+      double m_double_value;
+      std::string m_string_value;
+    };
+    JSONStreamRecordEntry& last_entry()
+    {
+      assert(m_num_entries > 0u);
+      return m_entries[m_num_entries-1u];
+    }
+    //Records have a handful of keys - linear scan, first occurrence wins as in the DOM
+    const JSONStreamRecordEntry* find(const char* key) const
+    {
+      for(auto i=0u;i<m_num_entries;++i)
+        if(m_entries[i].m_key == key)
+          return &(m_entries[i]);
+      return 0;
+    }
+    std::vector<JSONStreamRecordEntry> m_entries;
+    size_t m_num_entries;
+};
+
+//SAX handler for the mapping files - the records of the top level member record_container_name (a dictionary of
+//name:dict or an array of dicts, e.g. "callsets") are passed to the callback one at a time and never stored.
+//All other top level members are small and are built into json_doc for the existing DOM code
+class JSONRecordStreamHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JSONRecordStreamHandler>
+{
+  public:
+    //record_name is empty if the container is an array
+    typedef std::function<void(const JSONStreamRecord& record, const std::string& record_name, const uint64_t record_idx)>
+      RecordCallbackType;
+    JSONRecordStreamHandler(const std::string& filename, const char* record_container_name,
+        rapidjson::Document& json_doc, RecordCallbackType callback)
+      : m_filename(filename), m_record_container_name(record_container_name),
+      m_json_doc(json_doc), m_callback(callback)
+    {
+      m_state = JSON_STREAM_BEFORE_ROOT;
+      m_found_record_container = false;
+      m_is_array_container = false;
+      m_num_records = 0u;
+      m_skip_depth = 0u;
+    }
+    bool found_record_container() const { return m_found_record_container; }
+    bool is_array_container() const { return m_is_array_container; }
+    uint64_t get_num_records() const { return m_num_records; }
+    //Scalars
+    bool Null() { return add_scalar(rapidjson::Value()); }
+    bool Bool(bool val)
+    {
+      if(m_state == JSON_STREAM_IN_RECORD && m_skip_depth == 0u)
+        m_record.set_bool(val);
+      rapidjson::Value json_value;
+      json_value.SetBool(val);
+      return add_scalar(json_value);
+    }
+    bool Int(int val)
+    {
+      if(m_state == JSON_STREAM_IN_RECORD && m_skip_depth == 0u)
+        m_record.set_int64(val);
+      rapidjson::Value json_value;
+      json_value.SetInt(val);
+      return add_scalar(json_value);
+    }
+    bool Uint(unsigned val)
+    {
+      if(m_state == JSON_STREAM_IN_RECORD && m_skip_depth == 0u)
+        m_record.set_int64(val);
+      rapidjson::Value json_value;
+      json_value.SetUint(val);
+      return add_scalar(json_value);
+    }
+    bool Int64(int64_t val)
+    {
+      if(m_state == JSON_STREAM_IN_RECORD && m_skip_depth == 0u)
+        m_record.set_int64(val);
+      rapidjson::Value json_value;
+      json_value.SetInt64(val);
+      return add_scalar(json_value);
+    }
+    bool Uint64(uint64_t val)
+    {
+      if(m_state == JSON_STREAM_IN_RECORD && m_skip_depth == 0u)
+      {
+        if(val > static_cast<uint64_t>(INT64_MAX))
+          m_record.set_double(val);
+        else
+          m_record.set_int64(val);
+      }
+      rapidjson::Value json_value;
+      json_value.SetUint64(val);
+      return add_scalar(json_value);
+    }
+    bool Double(double val)
+    {
+      if(m_state == JSON_STREAM_IN_RECORD && m_skip_depth == 0u)
+        m_record.set_double(val);
+      rapidjson::Value json_value;
+      json_value.SetDouble(val);
+      return add_scalar(json_value);
+    }
+    bool String(const char* str, rapidjson::SizeType length, bool copy)
+    {
+      if(m_state == JSON_STREAM_IN_RECORD && m_skip_depth == 0u)
+        m_record.set_string(str, length);
+      rapidjson::Value json_value;
+      if(m_state == JSON_STREAM_IN_DOM_MEMBER)
+        json_value.SetString(str, length, m_json_doc.GetAllocator());
+      return add_scalar(json_value);
+    }
+    bool Key(const char* str, rapidjson::SizeType length, bool copy)
+    {
+      switch(m_state)
+      {
+        case JSON_STREAM_IN_ROOT:
+          if(strcmp(str, m_record_container_name) == 0 && !m_found_record_container)
+          {
+            m_found_record_container = true;
+            m_state = JSON_STREAM_BEFORE_RECORD_CONTAINER;
+          }
+          else
+          {
+            m_top_level_key.SetString(str, length, m_json_doc.GetAllocator());
+            m_state = JSON_STREAM_IN_DOM_MEMBER;
+          }
+          break;
+        case JSON_STREAM_IN_RECORD_CONTAINER: //dictionary of name:dict
+          m_record_name.assign(str, length);
+          break;
+        case JSON_STREAM_IN_RECORD:
+          if(m_skip_depth == 0u)
+            m_record.add_key(str, length);
+          break;
+        case JSON_STREAM_IN_DOM_MEMBER:
+          assert(m_dom_key_stack.size() > 0u);
+          m_dom_key_stack.back().SetString(str, length, m_json_doc.GetAllocator());
+          break;
+        default:
+          throw FileBasedVidMapperException(std::string("Unexpected key ")+str+" in JSON "+m_filename);
+      }
+      return true;
+    }
+    bool StartObject() { return start_container(true); }
+    bool EndObject(rapidjson::SizeType num_members) { return end_container(); }
+    bool StartArray() { return start_container(false); }
+    bool EndArray(rapidjson::SizeType num_elements) { return end_container(); }
+  private:
+    enum JSONStreamStateEnum
+    {
+      JSON_STREAM_BEFORE_ROOT=0,
+      JSON_STREAM_IN_ROOT,
+      JSON_STREAM_BEFORE_RECORD_CONTAINER,
+      JSON_STREAM_IN_RECORD_CONTAINER,
+      JSON_STREAM_IN_RECORD,
+      JSON_STREAM_IN_DOM_MEMBER,
+      JSON_STREAM_AFTER_ROOT
+    };
+    bool add_scalar(rapidjson::Value& json_value)
+    {
+      switch(m_state)
+      {
+        case JSON_STREAM_IN_RECORD:
+          return true;
+        case JSON_STREAM_IN_DOM_MEMBER:
+          add_dom_value(json_value);
+          return true;
+        case JSON_STREAM_BEFORE_RECORD_CONTAINER:
+          throw FileBasedVidMapperException(std::string("\"")+m_record_container_name
+              +"\" must be a dictionary or an array in JSON "+m_filename);
+        case JSON_STREAM_IN_RECORD_CONTAINER:
+          throw FileBasedVidMapperException(std::string("Entries of \"")+m_record_container_name
+              +"\" must be dictionaries in JSON "+m_filename);
+        default:
+          throw FileBasedVidMapperException(std::string("Top level of JSON ")+m_filename+" must be a dictionary");
+      }
+    }
+    bool add_scalar(rapidjson::Value&& json_value) { return add_scalar(json_value); }
+    bool start_container(const bool is_object)
+    {
+      switch(m_state)
+      {
+        case JSON_STREAM_BEFORE_ROOT:
+          if(!is_object)
+            throw FileBasedVidMapperException(std::string("Top level of JSON ")+m_filename+" must be a dictionary");
+          m_json_doc.SetObject();
+          m_state = JSON_STREAM_IN_ROOT;
+          break;
+        case JSON_STREAM_BEFORE_RECORD_CONTAINER:
+          m_is_array_container = !is_object;
+          m_state = JSON_STREAM_IN_RECORD_CONTAINER;
+          break;
+        case JSON_STREAM_IN_RECORD_CONTAINER:
+          if(!is_object)
+            throw FileBasedVidMapperException(std::string("Entries of \"")+m_record_container_name
+                +"\" must be dictionaries in JSON "+m_filename);
+          if(m_is_array_container)
+            m_record_name.clear();
+          m_record.clear();
+          m_state = JSON_STREAM_IN_RECORD;
+          break;
+        case JSON_STREAM_IN_RECORD:
+          //Nested values inside records are not used
+          if(m_skip_depth == 0u)
+            m_record.remove_last_key();
+          ++m_skip_depth;
+          break;
+        case JSON_STREAM_IN_DOM_MEMBER:
+          m_dom_value_stack.emplace_back(is_object ? rapidjson::kObjectType : rapidjson::kArrayType);
+          m_dom_key_stack.emplace_back();
+          break;
+        default:
+          throw FileBasedVidMapperException(std::string("Top level of JSON ")+m_filename+" must be a dictionary");
+      }
+      return true;
+    }
+    bool end_container()
+    {
+      switch(m_state)
+      {
+        case JSON_STREAM_IN_ROOT:
+          m_state = JSON_STREAM_AFTER_ROOT;
+          break;
+        case JSON_STREAM_IN_RECORD_CONTAINER:
+          m_state = JSON_STREAM_IN_ROOT;
+          break;
+        case JSON_STREAM_IN_RECORD:
+          if(m_skip_depth > 0u)
+            --m_skip_depth;
+          else
+          {
+            m_callback(m_record, m_record_name, m_num_records);
+            ++m_num_records;
+            m_state = JSON_STREAM_IN_RECORD_CONTAINER;
+          }
+          break;
+        case JSON_STREAM_IN_DOM_MEMBER:
+          {
+            assert(m_dom_value_stack.size() > 0u);
+            rapidjson::Value json_value;
+            json_value.Swap(m_dom_value_stack.back());
+            m_dom_value_stack.pop_back();
+            m_dom_key_stack.pop_back();
+            add_dom_value(json_value);
+            break;
+          }
+        default:
+          assert(0);
+      }
+      return true;
+    }
+    //Adds to the innermost open container - or to json_doc for top level members
+    void add_dom_value(rapidjson::Value& json_value)
+    {
+      auto& allocator = m_json_doc.GetAllocator();
+      if(m_dom_value_stack.empty())
+      {
+        m_json_doc.AddMember(m_top_level_key, json_value, allocator);
+        m_state = JSON_STREAM_IN_ROOT;
+      }
+      else
+      {
+        auto& parent = m_dom_value_stack.back();
+        if(parent.IsObject())
+          parent.AddMember(m_dom_key_stack.back(), json_value, allocator);
+        else
+          parent.PushBack(json_value, allocator);
+      }
+    }
+  private:
+    std::string m_filename;
+    const char* m_record_container_name;
+    rapidjson::Document& m_json_doc;
+    RecordCallbackType m_callback;
+    JSONStreamStateEnum m_state;
+    bool m_found_record_container;
+    bool m_is_array_container;
+    uint64_t m_num_records;
+    //Depth of nested values being skipped inside the current record
+    unsigned m_skip_depth;
+    JSONStreamRecord m_record;
+    std::string m_record_name;
+    //Open containers of the top level member being built into json_doc - deque, values never move
+    rapidjson::Value m_top_level_key;
+    std::deque<rapidjson::Value> m_dom_value_stack;
+    std::deque<rapidjson::Value> m_dom_key_stack;
+};
+
+//Stream parse of buffer (modified in place) - see JSONRecordStreamHandler
+static void stream_parse_json_buffer(std::vector<char>& buffer, JSONRecordStreamHandler& handler,
+    const std::string& filename)
+{
+  rapidjson::Reader reader;
+  rapidjson::InsituStringStream stream(&(buffer[0]));
+  reader.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+  if(reader.HasParseError())
+    throw FileBasedVidMapperException(std::string("Syntax error in JSON ")+filename+" at offset "
+        +std::to_string(reader.GetErrorOffset()));
+}
+
 void FileBasedVidMapper::common_constructor_initialization(const std::string& filename,
     const std::vector<BufferStreamInfo>& buffer_stream_info_vec,
     const std::string& callset_mapping_file,
@@ -497,14 +1120,91 @@ void FileBasedVidMapper::common_constructor_initialization(const std::string& fi
   m_lb_callset_row_idx = 0;
   m_ub_callset_row_idx = INT64_MAX-1;
   VERIFY_OR_THROW(filename.length() && "Vid mapping file unspecified");
+  //Binary snapshot in place of the vid JSON - contains the callset mapping as well
+  if(VidMapper::is_binary_snapshot(filename))
+  {
+    m_lb_callset_row_idx = lb_callset_row_idx;
+    m_ub_callset_row_idx = ub_callset_row_idx;
+    load_binary_snapshot(filename);
+    //Explicitly specified callsets file overrides the mapping stored in the snapshot
+    if(!callset_mapping_file.empty())
+    {
+      m_callset_name_to_row_idx.clear();
+      m_row_idx_to_info.clear();
+      m_filename_to_idx.clear();
+      m_file_idx_to_info.clear();
+      m_owner_idx_to_file_idx_vec.clear();
+      m_is_callset_mapping_initialized = false;
+      parse_callsets_json(callset_mapping_file, buffer_stream_info_vec, true);
+    }
+    else
+      if(m_is_callset_mapping_initialized)
+        initialize_buffer_streams(buffer_stream_info_vec);
+      else
+        if(buffer_stream_callset_mapping_json_string.empty() && is_callset_mapping_required)
+          throw FileBasedVidMapperException(std::string("Vid mapper snapshot ")+filename+" has no callsets and no callset mapping was specified");
+    parse_callsets_json(buffer_stream_callset_mapping_json_string, buffer_stream_info_vec, false);
+    m_is_initialized = true;
+    return;
+  }
   rapidjson::Document json_doc;
-  std::ifstream ifs(filename.c_str());
-  if(!ifs.is_open())
+  std::vector<char> json_buffer;
+  if(!read_file_into_buffer(filename, json_buffer))
     throw FileBasedVidMapperException((std::string("Could not open vid mapping file \"")+filename+"\"").c_str());
-  std::string str((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-  json_doc.Parse(str.c_str());
-  if(json_doc.HasParseError())
-    throw FileBasedVidMapperException(std::string("Syntax error in JSON file ")+filename);
+  //Contig info parsing - contigs are streamed into the contig vectors without building a DOM
+  //contigs is a dictionary of name:info key-value pairs or array of dict { "name": <>, ... }
+  //Rest of the vid file (fields etc) is small and is built into json_doc
+  auto duplicate_contigs_exist = false;
+  JSONRecordStreamHandler contigs_handler(filename, "contigs", json_doc,
+      [&](const JSONStreamRecord& contig_info_dict, const std::string& record_name, const uint64_t json_contig_idx) {
+        std::string contig_name;
+        if(record_name.empty())
+        {
+          auto num_found = 0u;
+          for(const auto name_field : { "name", "contig_name", "chromosome_name" })
+          {
+            if(contig_info_dict.has_member(name_field))
+            {
+              contig_name = contig_info_dict.get_string(name_field);
+              ++num_found;
+            }
+          }
+          if(num_found == 0u)
+            throw VidMapperException(std::string("Contig info dict with index ")+std::to_string(json_contig_idx)
+                +" does not have any one of the keys \"name\", \"contig_name\" or \"chromosome_name\"");
+          if(num_found > 1u)
+            throw VidMapperException(std::string("Contig info dict with index ")+std::to_string(json_contig_idx)
+                +" has two or more of the keys \"name\", \"contig_name\" or \"chromosome_name\" - at most one is allowed");
+        }
+        else
+          contig_name = record_name;
+        if(m_contig_name_to_idx.find(contig_name) != m_contig_name_to_idx.end())
+        {
+          std::cerr << (std::string("Duplicate contig/chromosome name ")+contig_name+" found in vid file "+filename) << "\n";
+          duplicate_contigs_exist = true;
+        }
+        else
+        {
+          VERIFY_OR_THROW(contig_info_dict.is_int64("tiledb_column_offset"));
+          auto tiledb_column_offset = contig_info_dict.get_int64("tiledb_column_offset");
+          VERIFY_OR_THROW(tiledb_column_offset >= 0ll);
+          VERIFY_OR_THROW(contig_info_dict.is_int64("length"));
+          auto length = contig_info_dict.get_int64("length");
+          VERIFY_OR_THROW(length >= 0ll);
+          VERIFY_OR_THROW(json_contig_idx < static_cast<uint64_t>(INT_MAX));
+          m_contig_name_to_idx[contig_name] = json_contig_idx;
+          //Number of contigs is not known up front - grow with the index within the JSON container
+          m_contig_idx_to_info.resize(json_contig_idx+1u);
+          m_contig_begin_2_idx.resize(json_contig_idx+1u);
+          m_contig_end_2_idx.resize(json_contig_idx+1u);
+          m_contig_idx_to_info[json_contig_idx].set_info(json_contig_idx, contig_name, length, tiledb_column_offset);
+          m_contig_begin_2_idx[json_contig_idx].first = tiledb_column_offset;
+          m_contig_begin_2_idx[json_contig_idx].second = json_contig_idx;
+          m_contig_end_2_idx[json_contig_idx].first = tiledb_column_offset + length - 1; //inclusive
+          m_contig_end_2_idx[json_contig_idx].second = json_contig_idx;
+        }
+      });
+  stream_parse_json_buffer(json_buffer, contigs_handler, filename);
   m_lb_callset_row_idx = lb_callset_row_idx;
   m_ub_callset_row_idx = ub_callset_row_idx;
   //Callset info parsing
@@ -525,76 +1225,8 @@ void FileBasedVidMapper::common_constructor_initialization(const std::string& fi
   }
   parse_callsets_json(real_callset_mapping_file, buffer_stream_info_vec, true);
   parse_callsets_json(buffer_stream_callset_mapping_json_string, buffer_stream_info_vec, false);
-  //Contig info parsing
-  VERIFY_OR_THROW(json_doc.HasMember("contigs"));
+  VERIFY_OR_THROW(contigs_handler.found_record_container());
   {
-    const rapidjson::Value& contigs_container = json_doc["contigs"];
-    //contigs is a dictionary of name:info key-value pairs or array of dict { "name": <>, ... }
-    VERIFY_OR_THROW(contigs_container.IsObject() || contigs_container.IsArray());
-    auto is_array = contigs_container.IsArray();
-    auto num_contigs = is_array ? contigs_container.Size() : contigs_container.MemberCount();
-    m_contig_idx_to_info.resize(num_contigs);
-    m_contig_begin_2_idx.resize(num_contigs);
-    m_contig_end_2_idx.resize(num_contigs);
-    std::string contig_name;
-    std::string filename;
-    auto duplicate_contigs_exist = false;
-    //index within the JSON array
-    rapidjson::SizeType json_contig_idx = 0u;
-    auto dict_iter = is_array ? rapidjson::Value::ConstMemberIterator()
-      : contigs_container.MemberBegin();
-    auto dict_end_position = is_array ? dict_iter : contigs_container.MemberEnd();
-    auto next_contig_exists = is_array ? (json_contig_idx < num_contigs) : (dict_iter != dict_end_position);
-    while(next_contig_exists)
-    {
-      const auto& contig_info_dict = is_array ? contigs_container[json_contig_idx] : (*dict_iter).value;
-      VERIFY_OR_THROW(contig_info_dict.IsObject());
-      if(is_array)
-      {
-        auto num_found = 0u;
-        for(const auto name_field : { "name", "contig_name", "chromosome_name" })
-        {
-          if(contig_info_dict.HasMember(name_field))
-          {
-            contig_name = contig_info_dict[name_field].GetString();
-            ++num_found;
-          }
-        }
-        if(num_found == 0u)
-          throw VidMapperException(std::string("Contig info dict with index ")+std::to_string(json_contig_idx)
-              +" does not have any one of the keys \"name\", \"contig_name\" or \"chromosome_name\"");
-        if(num_found > 1u)
-          throw VidMapperException(std::string("Contig info dict with index ")+std::to_string(json_contig_idx)
-              +" has two or more of the keys \"name\", \"contig_name\" or \"chromosome_name\" - at most one is allowed");
-      }
-      else
-        contig_name = (*dict_iter).name.GetString();
-      if(m_contig_name_to_idx.find(contig_name) != m_contig_name_to_idx.end())
-      {
-        std::cerr << (std::string("Duplicate contig/chromosome name ")+contig_name+" found in vid file "+filename) << "\n";
-        duplicate_contigs_exist = true;
-      }
-      else
-      {
-        VERIFY_OR_THROW(contig_info_dict.HasMember("tiledb_column_offset") && contig_info_dict["tiledb_column_offset"].IsInt64());
-        auto tiledb_column_offset = contig_info_dict["tiledb_column_offset"].GetInt64();
-        VERIFY_OR_THROW(tiledb_column_offset >= 0ll);
-        VERIFY_OR_THROW(contig_info_dict.HasMember("length") && contig_info_dict["length"].IsInt64());
-        auto length = contig_info_dict["length"].GetInt64();
-        VERIFY_OR_THROW(length >= 0ll);
-        VERIFY_OR_THROW(static_cast<size_t>(json_contig_idx) < static_cast<size_t>(num_contigs));
-        m_contig_name_to_idx[contig_name] = json_contig_idx;
-        m_contig_idx_to_info[json_contig_idx].set_info(json_contig_idx, contig_name, length, tiledb_column_offset);
-        m_contig_begin_2_idx[json_contig_idx].first = tiledb_column_offset;
-        m_contig_begin_2_idx[json_contig_idx].second = json_contig_idx;
-        m_contig_end_2_idx[json_contig_idx].first = tiledb_column_offset + length - 1; //inclusive
-        m_contig_end_2_idx[json_contig_idx].second = json_contig_idx;
-      }
-      ++json_contig_idx;
-      if(!is_array)
-        ++dict_iter;
-      next_contig_exists = is_array ? (json_contig_idx < num_contigs) : (dict_iter != dict_end_position);
-    }
     if(duplicate_contigs_exist)
       throw FileBasedVidMapperException(std::string("Duplicate contigs exist in vid file ")+filename);
     std::sort(m_contig_begin_2_idx.begin(), m_contig_begin_2_idx.end(), contig_offset_idx_pair_cmp);
@@ -624,6 +1256,7 @@ void FileBasedVidMapper::common_constructor_initialization(const std::string& fi
     }
     if(overlapping_contigs_exist)
       throw FileBasedVidMapperException(std::string("Overlapping contigs exist in vid file ")+filename);
+    build_contig_search_index();
   }
   //Field info parsing
   VERIFY_OR_THROW(json_doc.HasMember("fields"));
@@ -748,6 +1381,23 @@ void FileBasedVidMapper::common_constructor_initialization(const std::string& fi
           if(is_known_field)
             m_field_idx_to_info[field_idx].m_VCF_field_combine_operation = KnownFieldInfo::get_VCF_field_combine_operation_for_known_field_enum(known_field_enum);
         }
+        //Lossy quantization at import - only for integer fields
+        if(field_info_dict.HasMember("quantization_cap") || field_info_dict.HasMember("quantization_bin_size"))
+        {
+          if(m_field_idx_to_info[field_idx].m_bcf_ht_type != BCF_HT_INT)
+            throw VidMapperException(std::string("Quantization can only be specified for integer fields; field ")+field_name
+                +" is not an integer field");
+          if(field_info_dict.HasMember("quantization_cap"))
+          {
+            VERIFY_OR_THROW(field_info_dict["quantization_cap"].IsInt() && field_info_dict["quantization_cap"].GetInt() >= 0);
+            m_field_idx_to_info[field_idx].m_quantization_cap = field_info_dict["quantization_cap"].GetInt();
+          }
+          if(field_info_dict.HasMember("quantization_bin_size"))
+          {
+            VERIFY_OR_THROW(field_info_dict["quantization_bin_size"].IsInt() && field_info_dict["quantization_bin_size"].GetInt() > 0);
+            m_field_idx_to_info[field_idx].m_quantization_bin_size = field_info_dict["quantization_bin_size"].GetInt();
+          }
+        }
         //Both INFO and FORMAT, throw another entry <field>_FORMAT
         if(m_field_idx_to_info[field_idx].m_is_vcf_INFO_field && m_field_idx_to_info[field_idx].m_is_vcf_FORMAT_field)
         {
@@ -799,132 +1449,74 @@ void FileBasedVidMapper::parse_callsets_json(const std::string& json, const std:
   if(json.empty())
     return;
   std::string filename = is_file ? json : "buffer_stream_callset_mapping_json_string";
-  rapidjson::Document json_doc;
+  std::vector<char> json_buffer;
   if(is_file)
   {
-    std::ifstream ifs(filename.c_str());
-    if(!ifs.is_open())
+    if(!read_file_into_buffer(filename, json_buffer))
       throw FileBasedVidMapperException((std::string("Could not open callsets file \"")+filename+"\"").c_str());
-    std::string str((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-    json_doc.Parse(str.c_str());
-    if(json_doc.HasParseError())
-      throw FileBasedVidMapperException(std::string("Syntax error in JSON file ")+filename);
   }
   else
   {
-    json_doc.Parse(json.c_str());
-    if(json_doc.HasParseError())
-      throw FileBasedVidMapperException(std::string("Syntax error in JSON ")+filename);
+    json_buffer.resize(json.length()+1u);
+    memcpy(&(json_buffer[0]), json.c_str(), json.length()+1u);
   }
-  //Callset info parsing
-  VERIFY_OR_THROW(json_doc.HasMember("callsets"));
-  {
-    const rapidjson::Value& callsets_container = json_doc["callsets"];
-    //callsets is a dictionary of name:info key-value pairs or array of info dictionaries
-    VERIFY_OR_THROW(callsets_container.IsObject() || callsets_container.IsArray());
-    auto is_array = callsets_container.IsArray();
-    auto num_callsets_in_container = is_array ? callsets_container.Size() : callsets_container.MemberCount();
-    auto num_callsets = (m_ub_callset_row_idx == INT64_MAX) ? num_callsets_in_container :
-      std::min<int64_t>(num_callsets_in_container, m_ub_callset_row_idx+1);
-    m_row_idx_to_info.resize(num_callsets);
-    m_max_callset_row_idx = -1;
-    std::string callset_name;
-    auto dict_iter = is_array ? rapidjson::Value::ConstMemberIterator()
-      : callsets_container.MemberBegin();
-    auto dict_end_position = is_array ? dict_iter : callsets_container.MemberEnd();
-    rapidjson::SizeType json_callset_idx = 0ull;
-    auto next_callset_exists = is_array ? (json_callset_idx < callsets_container.Size()) : (dict_iter != dict_end_position);
-    while(next_callset_exists)
-    {
-      const auto& callset_info_dict = is_array ? callsets_container[json_callset_idx]
-        : (*dict_iter).value;
-      VERIFY_OR_THROW(callset_info_dict.IsObject());    //must be dict
-      if(is_array)
-      {
-        auto num_found = 0u;
-        for(const auto name_field : { "name", "callset_name", "sample_name" })
+  //Callset info parsing - callsets are streamed into add_callset() one at a time without building a DOM
+  //callsets is a dictionary of name:info key-value pairs or array of info dictionaries
+  //Rest of the JSON (file_division etc) is small and is built into json_doc
+  rapidjson::Document json_doc;
+  m_max_callset_row_idx = -1;
+  JSONRecordStreamHandler callsets_handler(filename, "callsets", json_doc,
+      [&](const JSONStreamRecord& callset_info_dict, const std::string& record_name, const uint64_t json_callset_idx) {
+        std::string callset_name;
+        if(record_name.empty())
         {
-          if(callset_info_dict.HasMember(name_field))
+          auto num_found = 0u;
+          for(const auto name_field : { "name", "callset_name", "sample_name" })
           {
-            callset_name = callset_info_dict[name_field].GetString();
-            ++num_found;
+            if(callset_info_dict.has_member(name_field))
+            {
+              callset_name = callset_info_dict.get_string(name_field);
+              ++num_found;
+            }
           }
+          if(num_found == 0u)
+            throw VidMapperException(std::string("Callset info dict with index ")+std::to_string(json_callset_idx)
+                +" does not have any one of the keys \"name\", \"callset_name\" or \"sample_name\"");
+          if(num_found > 1u)
+            throw VidMapperException(std::string("Callset info dict with index ")+std::to_string(json_callset_idx)
+                +" has two or more of the keys \"name\", \"callset_name\" or \"sample_name\" - at most one is allowed");
         }
-        if(num_found == 0u)
-          throw VidMapperException(std::string("Callset info dict with index ")+std::to_string(json_callset_idx)
-              +" does not have any one of the keys \"name\", \"callset_name\" or \"sample_name\"");
-        if(num_found > 1u)
-          throw VidMapperException(std::string("Callset info dict with index ")+std::to_string(json_callset_idx)
-              +" has two or more of the keys \"name\", \"callset_name\" or \"sample_name\" - at most one is allowed");
-      }
-      else
-        callset_name = (*dict_iter).name.GetString();
-      VERIFY_OR_THROW(callset_info_dict.HasMember("row_idx"));
-      int64_t row_idx = callset_info_dict["row_idx"].GetInt64();
-      //already exists in map
-      if(m_callset_name_to_row_idx.find(callset_name) != m_callset_name_to_row_idx.end())
-        //different row idx
-        if(m_callset_name_to_row_idx[callset_name] != row_idx)
-          throw FileBasedVidMapperException(std::string("Duplicate with conflicting row index for sample/callset name ")+callset_name
-              +" found in callsets mapping "+std::to_string(m_callset_name_to_row_idx[callset_name])+", "+std::to_string(row_idx));
-      if(row_idx <= m_ub_callset_row_idx)
-      {
-        m_max_callset_row_idx = std::max(m_max_callset_row_idx, row_idx);
-        //Resize vector
-        if(static_cast<size_t>(row_idx) >= m_row_idx_to_info.size())
-          m_row_idx_to_info.resize(row_idx+1);
-        auto file_idx = -1ll;
+        else
+          callset_name = record_name;
+        VERIFY_OR_THROW(callset_info_dict.has_member("row_idx"));
+        int64_t row_idx = callset_info_dict.get_int64("row_idx");
+        const char* callset_filename = 0;
         //idx in file
         auto idx_in_file = 0ll;
-        if(row_idx >= m_lb_callset_row_idx && (callset_info_dict.HasMember("filename") || callset_info_dict.HasMember("stream_name")))
+        if(row_idx >= m_lb_callset_row_idx && row_idx <= m_ub_callset_row_idx
+            && (callset_info_dict.has_member("filename") || callset_info_dict.has_member("stream_name")))
         {
-          VERIFY_OR_THROW((!callset_info_dict.HasMember("filename") || !callset_info_dict.HasMember("stream_name"))
+          VERIFY_OR_THROW((!callset_info_dict.has_member("filename") || !callset_info_dict.has_member("stream_name"))
               && (std::string("Cannot have both \"filename\" and \"stream_name\" as the data source for sample/CallSet ")+callset_name).c_str());
-          std::string filename = callset_info_dict.HasMember("filename")
-            ? std::move(callset_info_dict["filename"].GetString())
-            : std::move(callset_info_dict["stream_name"].GetString());
-          file_idx = get_or_append_global_file_idx(filename);
-          if(callset_info_dict.HasMember("idx_in_file"))
-            idx_in_file = callset_info_dict["idx_in_file"].GetInt64();
-          //Check for conflicting file/stream info if initialized previously
-          const auto& curr_row_info = m_row_idx_to_info[row_idx];
-          if(curr_row_info.m_is_initialized)
-          {
-            if(curr_row_info.m_file_idx >= 0 && file_idx >= 0
-                && curr_row_info.m_file_idx != file_idx)
-              throw FileBasedVidMapperException(std::string("Conflicting file/stream names specified for sample/callset ")+callset_name
-                  +" "+m_file_idx_to_info[curr_row_info.m_file_idx].m_name+", "+filename);
-            if(curr_row_info.m_idx_in_file != idx_in_file)
-              throw FileBasedVidMapperException(std::string("Conflicting values of \"idx_in_file\" specified for sample/callset ")+callset_name
-                  +" "+std::to_string(curr_row_info.m_idx_in_file)+", "+std::to_string(idx_in_file));
-          }
-          else
-          {
-            assert(file_idx < static_cast<int64_t>(m_file_idx_to_info.size()));
-            m_file_idx_to_info[file_idx].add_local_tiledb_row_idx_pair(idx_in_file, row_idx);
-          }
+          callset_filename = callset_info_dict.has_member("filename")
+            ? callset_info_dict.get_string("filename").c_str()
+            : callset_info_dict.get_string("stream_name").c_str();
+          if(callset_info_dict.has_member("idx_in_file"))
+            idx_in_file = callset_info_dict.get_int64("idx_in_file");
         }
-        m_callset_name_to_row_idx[callset_name] = row_idx;
-        VERIFY_OR_THROW(static_cast<size_t>(row_idx) < m_row_idx_to_info.size());
-        if(m_row_idx_to_info[row_idx].m_is_initialized && m_row_idx_to_info[row_idx].m_name != callset_name)
-          throw FileBasedVidMapperException(std::string("Sample/callset ")+callset_name+" has the same row idx as "
-              +m_row_idx_to_info[row_idx].m_name);
-        m_row_idx_to_info[row_idx].set_info(row_idx, callset_name, file_idx, idx_in_file);
-      }
-      ++json_callset_idx;
-      if(!is_array)
-        ++dict_iter;
-      next_callset_exists = is_array ? (json_callset_idx < callsets_container.Size()) : (dict_iter != dict_end_position);
-    }
-    auto missing_row_idxs_exist = false;
-    for(auto row_idx=0ll;static_cast<size_t>(row_idx)<m_row_idx_to_info.size() && row_idx<=m_ub_callset_row_idx;++row_idx)
-      if(row_idx >= m_lb_callset_row_idx && row_idx <= m_ub_callset_row_idx && !(m_row_idx_to_info[row_idx].m_is_initialized))
-      {
-        std::cerr << "Sample/callset information missing for row " << row_idx << "\n";
-        missing_row_idxs_exist = true;
-      }
-    if(missing_row_idxs_exist)
-      throw FileBasedVidMapperException(std::string("Row indexes with missing sample/callset information found in callsets mapping: ")+filename);
+        add_callset(callset_name, row_idx, callset_filename, idx_in_file);
+      });
+  stream_parse_json_buffer(json_buffer, callsets_handler, filename);
+  VERIFY_OR_THROW(callsets_handler.found_record_container());
+  {
+    //Every row up to the number of callsets must be initialized - add_callset() only grows the vector
+    //up to the largest row idx seen
+    auto num_callsets_in_container = callsets_handler.get_num_records();
+    auto num_callsets = (m_ub_callset_row_idx == INT64_MAX) ? num_callsets_in_container :
+      std::min<uint64_t>(num_callsets_in_container, m_ub_callset_row_idx+1);
+    if(num_callsets > m_row_idx_to_info.size())
+      m_row_idx_to_info.resize(num_callsets);
+    check_for_missing_callsets(filename);
   }
   //File partitioning info
   if(json_doc.HasMember("file_division"))
@@ -1011,6 +1603,222 @@ void FileBasedVidMapper::parse_callsets_json(const std::string& json, const std:
       }
     }
   }
+  initialize_buffer_streams(buffer_stream_info_vec);
+}
+
+void FileBasedVidMapper::load_binary_snapshot(const std::string& filename)
+{
+  VidMapperSnapshotReader reader(filename);
+  reader.read_bytes(VID_MAPPER_SNAPSHOT_MAGIC_LENGTH);
+  auto version = reader.read<uint32_t>();
+  if(version != VID_MAPPER_SNAPSHOT_VERSION)
+    throw FileBasedVidMapperException(std::string("Unsupported version ")+std::to_string(version)
+        +" of vid mapper snapshot file "+filename);
+  auto num_contigs = reader.read<uint32_t>();
+  auto num_fields = reader.read<uint32_t>();
+  auto num_owners = reader.read<uint32_t>();
+  auto num_files = reader.read<uint64_t>();
+  auto num_callsets = reader.read<uint64_t>();
+  std::string name;
+  //Contigs - duplicates and overlaps were checked when the snapshot was created, the offset
+  //tables are stored sorted
+  m_contig_idx_to_info.resize(num_contigs);
+  m_contig_name_to_idx.reserve(num_contigs);
+  for(auto i=0u;i<num_contigs;++i)
+  {
+    auto length = reader.read<int64_t>();
+    auto tiledb_column_offset = reader.read<int64_t>();
+    reader.read_string(name);
+    m_contig_idx_to_info[i].set_info(i, name, length, tiledb_column_offset);
+    m_contig_name_to_idx.emplace(name, i);
+  }
+  for(auto* contig_table : { &m_contig_begin_2_idx, &m_contig_end_2_idx })
+  {
+    contig_table->resize(num_contigs);
+    for(auto& offset_idx_pair : *contig_table)
+    {
+      offset_idx_pair.first = reader.read<int64_t>();
+      offset_idx_pair.second = reader.read<int64_t>();
+      VERIFY_OR_THROW(offset_idx_pair.second >= 0 && static_cast<uint32_t>(offset_idx_pair.second) < num_contigs);
+    }
+  }
+  build_contig_search_index();
+  //Fields - includes the <field>_FORMAT entries and END
+  m_field_idx_to_info.resize(num_fields);
+  m_field_name_to_idx.reserve(num_fields);
+  for(auto i=0u;i<num_fields;++i)
+  {
+    auto& field_info = m_field_idx_to_info[i];
+    reader.read_string(name);
+    field_info.set_info(name, i);
+    reader.read_string(field_info.m_vcf_name);
+    auto vcf_field_class_bits = reader.read<uint8_t>();
+    field_info.m_is_vcf_FILTER_field = (vcf_field_class_bits & 1u);
+    field_info.m_is_vcf_INFO_field = (vcf_field_class_bits & 2u);
+    field_info.m_is_vcf_FORMAT_field = (vcf_field_class_bits & 4u);
+    field_info.m_bcf_ht_type = reader.read<int32_t>();
+    switch(field_info.m_bcf_ht_type)
+    {
+      case BCF_HT_INT:
+        field_info.m_type_index = std::type_index(typeid(int));
+        break;
+      case BCF_HT_REAL:
+        field_info.m_type_index = std::type_index(typeid(float));
+        break;
+      default:
+        field_info.m_type_index = std::type_index(typeid(char));
+        break;
+    }
+    field_info.m_length_descriptor = reader.read<int32_t>();
+    field_info.m_num_elements = reader.read<int32_t>();
+    field_info.m_VCF_field_combine_operation = reader.read<int32_t>();
+    field_info.m_quantization_cap = reader.read<int32_t>();
+    field_info.m_quantization_bin_size = reader.read<int32_t>();
+    m_field_name_to_idx.emplace(name, i);
+  }
+  //Files - owner and local idx are recomputed once the files outside the row bounds are dropped
+  std::vector<FileInfo> snapshot_file_info_vec(num_files);
+  for(auto& file_info : snapshot_file_info_vec)
+  {
+    reader.read_string(file_info.m_name);
+    file_info.m_type = static_cast<VidFileTypeEnum>(reader.read<int32_t>());
+    reader.read<int32_t>();     //owner idx
+    reader.read<int64_t>();     //local file idx
+    file_info.m_single_split_file_path = reader.read<uint8_t>();
+    file_info.m_split_files_paths.resize(reader.read<uint32_t>());
+    for(auto& split_file_path : file_info.m_split_files_paths)
+      reader.read_string(split_file_path);
+  }
+  std::vector<std::vector<int64_t>> snapshot_owner_idx_to_file_idx_vec(num_owners);
+  for(auto& file_idx_vec : snapshot_owner_idx_to_file_idx_vec)
+  {
+    file_idx_vec.resize(reader.read<uint64_t>());
+    for(auto& file_idx : file_idx_vec)
+    {
+      file_idx = reader.read<int64_t>();
+      VERIFY_OR_THROW(file_idx >= 0 && static_cast<uint64_t>(file_idx) < num_files);
+    }
+  }
+  std::vector<CallSetInfo> snapshot_callset_info_vec(num_callsets);
+  for(auto& callset_info : snapshot_callset_info_vec)
+  {
+    auto row_idx = reader.read<int64_t>();
+    auto file_idx = reader.read<int64_t>();
+    auto idx_in_file = reader.read<int64_t>();
+    reader.read_string(name);
+    VERIFY_OR_THROW(row_idx >= 0 && file_idx < static_cast<int64_t>(num_files));
+    callset_info.set_info(row_idx, name, file_idx, idx_in_file);
+  }
+  if(!reader.is_done())
+    throw FileBasedVidMapperException(std::string("Trailing bytes in vid mapper snapshot file ")+filename);
+  //Same row filtering as parse_callsets_json - keep only files of callsets within the row bounds of this process
+  //and files with split paths, in the order of the snapshot
+  std::vector<bool> is_file_retained(num_files, false);
+  for(const auto& callset_info : snapshot_callset_info_vec)
+    if(callset_info.m_file_idx >= 0 && callset_info.m_row_idx >= m_lb_callset_row_idx
+        && callset_info.m_row_idx <= m_ub_callset_row_idx)
+      is_file_retained[callset_info.m_file_idx] = true;
+  std::vector<int64_t> snapshot_file_idx_to_file_idx(num_files, -1ll);
+  m_filename_to_idx.reserve(num_files);
+  for(auto i=0ull;i<num_files;++i)
+  {
+    const auto& snapshot_file_info = snapshot_file_info_vec[i];
+    if(!is_file_retained[i] && snapshot_file_info.m_split_files_paths.empty())
+      continue;
+    auto file_idx = get_or_append_global_file_idx(snapshot_file_info.m_name);
+    auto& file_info = m_file_idx_to_info[file_idx];
+    file_info.m_type = snapshot_file_info.m_type;
+    file_info.m_single_split_file_path = snapshot_file_info.m_single_split_file_path;
+    file_info.m_split_files_paths = snapshot_file_info.m_split_files_paths;
+    snapshot_file_idx_to_file_idx[i] = file_idx;
+  }
+  m_owner_idx_to_file_idx_vec.resize(num_owners);
+  for(auto owner_idx=0u;owner_idx<num_owners;++owner_idx)
+  {
+    for(auto snapshot_file_idx : snapshot_owner_idx_to_file_idx_vec[owner_idx])
+    {
+      auto file_idx = snapshot_file_idx_to_file_idx[snapshot_file_idx];
+      if(file_idx >= 0)
+      {
+        m_file_idx_to_info[file_idx].m_owner_idx = owner_idx;
+        m_owner_idx_to_file_idx_vec[owner_idx].push_back(file_idx);
+      }
+    }
+    sort_and_assign_local_file_idxs_for_partition(owner_idx);
+  }
+  //Callsets - go through add_callset() so that the row bounds of this process are applied
+  m_callset_name_to_row_idx.reserve(num_callsets);
+  m_max_callset_row_idx = -1;
+  for(const auto& callset_info : snapshot_callset_info_vec)
+    add_callset(callset_info.m_name, callset_info.m_row_idx,
+        (callset_info.m_file_idx >= 0) ? snapshot_file_info_vec[callset_info.m_file_idx].m_name.c_str() : 0,
+        callset_info.m_idx_in_file);
+  check_for_missing_callsets(filename);
+  m_is_callset_mapping_initialized = (num_callsets > 0u);
+}
+
+void FileBasedVidMapper::add_callset(const std::string& callset_name, const int64_t row_idx,
+    const char* filename, const int64_t idx_in_file)
+{
+  //already exists in map
+  auto existing_iter = m_callset_name_to_row_idx.find(callset_name);
+  if(existing_iter != m_callset_name_to_row_idx.end())
+    //different row idx
+    if((*existing_iter).second != row_idx)
+      throw FileBasedVidMapperException(std::string("Duplicate with conflicting row index for sample/callset name ")+callset_name
+          +" found in callsets mapping "+std::to_string((*existing_iter).second)+", "+std::to_string(row_idx));
+  if(row_idx > m_ub_callset_row_idx)
+    return;
+  m_max_callset_row_idx = std::max(m_max_callset_row_idx, row_idx);
+  //Resize vector
+  if(static_cast<size_t>(row_idx) >= m_row_idx_to_info.size())
+    m_row_idx_to_info.resize(row_idx+1);
+  auto file_idx = -1ll;
+  if(row_idx >= m_lb_callset_row_idx && filename)
+  {
+    file_idx = get_or_append_global_file_idx(filename);
+    //Check for conflicting file/stream info if initialized previously
+    const auto& curr_row_info = m_row_idx_to_info[row_idx];
+    if(curr_row_info.m_is_initialized)
+    {
+      if(curr_row_info.m_file_idx >= 0 && file_idx >= 0
+          && curr_row_info.m_file_idx != file_idx)
+        throw FileBasedVidMapperException(std::string("Conflicting file/stream names specified for sample/callset ")+callset_name
+            +" "+m_file_idx_to_info[curr_row_info.m_file_idx].m_name+", "+filename);
+      if(curr_row_info.m_idx_in_file != idx_in_file)
+        throw FileBasedVidMapperException(std::string("Conflicting values of \"idx_in_file\" specified for sample/callset ")+callset_name
+            +" "+std::to_string(curr_row_info.m_idx_in_file)+", "+std::to_string(idx_in_file));
+    }
+    else
+    {
+      assert(file_idx < static_cast<int64_t>(m_file_idx_to_info.size()));
+      m_file_idx_to_info[file_idx].add_local_tiledb_row_idx_pair(idx_in_file, row_idx);
+    }
+  }
+  if(existing_iter == m_callset_name_to_row_idx.end())
+    m_callset_name_to_row_idx.emplace(callset_name, row_idx);
+  VERIFY_OR_THROW(static_cast<size_t>(row_idx) < m_row_idx_to_info.size());
+  if(m_row_idx_to_info[row_idx].m_is_initialized && m_row_idx_to_info[row_idx].m_name != callset_name)
+    throw FileBasedVidMapperException(std::string("Sample/callset ")+callset_name+" has the same row idx as "
+        +m_row_idx_to_info[row_idx].m_name);
+  m_row_idx_to_info[row_idx].set_info(row_idx, callset_name, file_idx, (file_idx >= 0) ? idx_in_file : 0ll);
+}
+
+void FileBasedVidMapper::check_for_missing_callsets(const std::string& filename) const
+{
+  auto missing_row_idxs_exist = false;
+  for(auto row_idx=0ll;static_cast<size_t>(row_idx)<m_row_idx_to_info.size() && row_idx<=m_ub_callset_row_idx;++row_idx)
+    if(row_idx >= m_lb_callset_row_idx && row_idx <= m_ub_callset_row_idx && !(m_row_idx_to_info[row_idx].m_is_initialized))
+    {
+      std::cerr << "Sample/callset information missing for row " << row_idx << "\n";
+      missing_row_idxs_exist = true;
+    }
+  if(missing_row_idxs_exist)
+    throw FileBasedVidMapperException(std::string("Row indexes with missing sample/callset information found in callsets mapping: ")+filename);
+}
+
+void FileBasedVidMapper::initialize_buffer_streams(const std::vector<BufferStreamInfo>& buffer_stream_info_vec)
+{
   //For buffer streams
   m_buffer_stream_idx_to_global_file_idx.resize(buffer_stream_info_vec.size(), -1);
   auto max_buffer_stream_idx_with_global_file_idx = -1ll;
@@ -293,6 +293,7 @@ int ProtoBufBasedVidMapper::parse_contigs_from_vidmap(
       std::string("Overlapping contigs found"));
   }
 
+  build_contig_search_index();
   return GENOMICSDB_VID_MAPPER_SUCCESS;
 } // end of parse_contigs_from_vidmap
 
@@ -102,6 +102,8 @@ int SQLBasedVidMapper::load_contig_info() {
   }
 
   dbi_result_free(result);
+  //Rows are ordered by tiledb_column_offset
+  build_contig_search_index();
   return(GENOMICSDB_VID_MAPPER_SUCCESS);
 }
 
@@ -24,6 +24,8 @@
 
 #include "vcf2binary.h"
 #include "htslib/bgzf.h"
+#include "htslib/tbx.h"
+#include <cmath>
 #include "vcf_adapter.h"
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw VCF2BinaryException(#X);
@@ -81,12 +83,55 @@ void VCFBufferReader::read_and_advance()
   }
 }
 
+//Names of FORMAT fields in ReferenceBlockFieldsEnum order
+static const char* g_reference_block_field_names[] = { "GQ", "MIN_DP", "DP", "PL" };
+
+//VCFReaderHandlePool functions
+void VCFReaderHandlePool::release(VCFReader* reader, const uint64_t cost)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  assert(m_reader_to_entry.find(reader) == m_reader_to_entry.end());
+  m_reader_to_entry[reader] = m_priority_to_reader.emplace(m_inflation_value+cost, reader);
+  while(m_priority_to_reader.size() > m_capacity)
+  {
+    auto iter = m_priority_to_reader.begin();
+    auto evicted_reader = (*iter).second;
+    //Entries inserted later start from a higher base - ages out expensive, but stale readers
+    m_inflation_value = (*iter).first;
+    m_reader_to_entry.erase(evicted_reader);
+    m_priority_to_reader.erase(iter);
+    evicted_reader->close_handles();
+  }
+}
+
+bool VCFReaderHandlePool::acquire(VCFReader* reader)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto iter = m_reader_to_entry.find(reader);
+  if(iter == m_reader_to_entry.end())
+    return false;
+  m_priority_to_reader.erase((*iter).second);
+  m_reader_to_entry.erase(iter);
+  return true;
+}
+
+void VCFReaderHandlePool::forget(VCFReader* reader)
+{
+  acquire(reader);
+}
+
 //VCFReader functions
-VCFReader::VCFReader()
+VCFReader::VCFReader(htsThreadPool* thread_pool, VCFReaderHandlePool* handle_pool)
   : GenomicsDBImportReaderBase(true), FileReaderBase(), VCFReaderBase(true)
 {
   m_indexed_reader = 0;
   m_fptr = 0;
+  m_thread_pool = thread_pool;
+  m_handle_pool = handle_pool;
+  m_current_record_virtual_offset = -1;
+  m_resume_virtual_offset = -1;
+  m_resume_contig_idx = -1;
+  m_resume_position = -1;
   m_vcf_file_buffer.l = 0;
   m_vcf_file_buffer.m = 4096;    //4KB
   m_vcf_file_buffer.s = (char*)malloc(m_vcf_file_buffer.m*sizeof(char));
@@ -94,6 +139,8 @@ VCFReader::VCFReader()
 
 VCFReader::~VCFReader()
 {
+  if(m_handle_pool)
+    m_handle_pool->forget(this);
   if(m_indexed_reader)
     bcf_sr_destroy(m_indexed_reader);
   m_indexed_reader = 0;
@@ -142,13 +189,60 @@ void VCFReader::initialize(const char* filename,
 
 void VCFReader::add_reader()
 {
+  //Handles released earlier and not evicted yet - nothing to open
+  if(m_handle_pool && m_handle_pool->acquire(this))
+    return;
   assert(m_indexed_reader->nreaders == 0);      //no existing files are open
   assert(m_fptr == 0);  //normal file handle should be NULL
+  //Position saved when the file was closed - plain file handle is sufficient, index not needed
+  if(m_resume_virtual_offset >= 0)
+  {
+    m_fptr = hts_open(m_name.c_str(), "r");
+    if(m_fptr)
+    {
+      attach_thread_pool(m_fptr);
+      return;
+    }
+    invalidate_resume_position();
+  }
   if(bcf_sr_add_reader(m_indexed_reader, m_name.c_str()) != 1)
     throw VCF2BinaryException(std::string("Could not open file ")+m_name+" : " + bcf_sr_strerror(m_indexed_reader->errnum) + " (VCF/BCF files must be block compressed and indexed)");
+  attach_thread_pool(m_indexed_reader->readers[0].file);
+}
+
+void VCFReader::attach_thread_pool(htsFile* fptr)
+{
+  //No-op for files that are not BGZF compressed
+  if(m_thread_pool && fptr && hts_set_thread_pool(fptr, m_thread_pool) < 0)
+    throw VCF2BinaryException(std::string("Could not attach htslib thread pool to file ")+m_name);
 }
 
 void VCFReader::remove_reader()
+{
+  save_resume_position();
+  //Cost of re-opening is dominated by header parsing (and index loading if index is retained)
+  if(m_handle_pool)
+    m_handle_pool->release(this, static_cast<uint64_t>(bcf_hdr_nsamples(m_hdr))+m_hdr->n[BCF_DT_CTG]+m_hdr->n[BCF_DT_ID]
+        + (m_indexed_reader->nreaders ? m_hdr->n[BCF_DT_CTG] : 0));
+  else
+    close_handles();
+}
+
+void VCFReader::save_resume_position()
+{
+  //Save position of the current record so that re-opening does not need the index
+  //Only possible when the file handle is moved to m_fptr after discarding index
+  if(m_fptr && m_is_record_valid && m_current_record_virtual_offset >= 0)
+  {
+    m_resume_virtual_offset = m_current_record_virtual_offset;
+    m_resume_contig_idx = m_line->rid;
+    m_resume_position = m_line->pos;
+  }
+  else
+    invalidate_resume_position();
+}
+
+void VCFReader::close_handles()
 {
   if(m_fptr)    //file handle moved to m_fptr after discarding index
   {
@@ -157,11 +251,40 @@ void VCFReader::remove_reader()
     m_fptr = 0;
   }
   else
-    bcf_sr_remove_reader(m_indexed_reader, 0);
+    if(m_indexed_reader->nreaders)
+      bcf_sr_remove_reader(m_indexed_reader, 0);
+}
+
+bool VCFReader::resume_from_virtual_offset(const char* contig, const int pos)
+{
+  assert(m_resume_virtual_offset >= 0);
+  auto resume_virtual_offset = m_resume_virtual_offset;
+  invalidate_resume_position();
+  //Caller wants a different position
+  if(bcf_hdr_name2id(m_hdr, contig) != m_resume_contig_idx || static_cast<int64_t>(pos) != m_resume_position)
+    return false;
+  if(m_fptr == 0)
+  {
+    if(m_indexed_reader->nreaders > 0)
+      return false;
+    m_fptr = hts_open(m_name.c_str(), "r");
+    if(m_fptr == 0)
+      return false;
+    attach_thread_pool(m_fptr);
+  }
+  auto bgzf_fptr = hts_get_bgzfp(m_fptr);
+  if(bgzf_fptr == 0 || bgzf_seek(bgzf_fptr, resume_virtual_offset, SEEK_SET) < 0)
+    return false;
+  read_and_advance();
+  //Must land on the same record that was current when the file was closed
+  return (m_is_record_valid && m_line->rid == m_resume_contig_idx && static_cast<int64_t>(m_line->pos) == m_resume_position);
 }
 
 void VCFReader::seek_read_advance(const char* contig, const int pos, bool discard_index)
 {
+  //Resume from saved virtual offset, index is used only as a fallback
+  if(discard_index && m_resume_virtual_offset >= 0 && resume_from_virtual_offset(contig, pos))
+    return;
   //Close file handle if open
   if(m_fptr)
   {
@@ -169,8 +292,11 @@ void VCFReader::seek_read_advance(const char* contig, const int pos, bool discar
     m_fptr = 0;
   }
   if(m_indexed_reader->nreaders == 0)        //index not loaded
+  {
     if(bcf_sr_add_reader(m_indexed_reader, m_name.c_str()) != 1)
       throw VCF2BinaryException(std::string("Could not open file ")+m_name+" or its index doesn't exist - VCF/BCF files must be block compressed and indexed");
+    attach_thread_pool(m_indexed_reader->readers[0].file);
+  }
   assert(m_indexed_reader->nreaders == 1);
   bcf_sr_seek(m_indexed_reader, contig, pos);
   //Only read 1 record at a time
@@ -189,6 +315,9 @@ void VCFReader::read_and_advance()
 {
   if(m_fptr)    //normal file handle - no index
   {
+    //Virtual offset at which the next record begins - saved for resuming after the file is closed
+    auto bgzf_fptr = hts_get_bgzfp(m_fptr);
+    m_current_record_virtual_offset = bgzf_fptr ? bgzf_tell(bgzf_fptr) : -1;
     //Handle VCFs and BCFs differently since the indexed reader handles file pointers differently
     if(m_fptr->format.format == htsExactFormat::vcf)
     {
@@ -209,6 +338,8 @@ void VCFReader::read_and_advance()
   }
   else  //indexed reader
   {
+    //Offset of records buffered by the synced reader is not known
+    m_current_record_virtual_offset = -1;
     bcf_sr_next_line(m_indexed_reader);
     auto line = bcf_sr_get_line(m_indexed_reader, 0);
     if(line)
@@ -231,6 +362,14 @@ VCFColumnPartition::VCFColumnPartition(VCFColumnPartition&& other)
   m_vcf_get_buffer_size = other.m_vcf_get_buffer_size;
   m_vcf_get_buffer = other.m_vcf_get_buffer;
   m_split_output_fptr = other.m_split_output_fptr;
+  m_reference_block_cell_end_buffer_offset = other.m_reference_block_cell_end_buffer_offset;
+  m_reference_block_end_column = other.m_reference_block_end_column;
+  m_reference_block_local_contig_idx = other.m_reference_block_local_contig_idx;
+  m_reference_block_gq_band = other.m_reference_block_gq_band;
+  m_reference_block_END_buffer_offset = other.m_reference_block_END_buffer_offset;
+  m_reference_block_field_buffer_offsets = std::move(other.m_reference_block_field_buffer_offsets);
+  m_reference_block_field_num_values = std::move(other.m_reference_block_field_num_values);
+  m_reference_block_field_values = std::move(other.m_reference_block_field_values);
   other.m_vcf_get_buffer = 0;
   other.m_vcf_get_buffer_size = 0;
   other.m_split_output_fptr = 0;
@@ -253,7 +392,8 @@ VCF2Binary::VCF2Binary(const std::string& vcf_filename, const std::vector<std::v
     unsigned file_idx, VidMapper& vid_mapper, const std::vector<ColumnRange>& partition_bounds,
     size_t max_size_per_callset,
     bool treat_deletions_as_intervals,
-    bool parallel_partitions, bool noupdates, bool close_file, bool discard_index)
+    bool parallel_partitions, bool noupdates, bool close_file, bool discard_index,
+    htsThreadPool* htslib_thread_pool, VCFReaderHandlePool* handle_pool)
   : File2TileDBBinaryBase(vcf_filename, file_idx, vid_mapper,
         max_size_per_callset,
         treat_deletions_as_intervals,
@@ -263,6 +403,8 @@ VCF2Binary::VCF2Binary(const std::string& vcf_filename, const std::vector<std::v
   m_vcf_fields = &vcf_fields;
   m_discard_index = discard_index;
   m_import_ID_field = false;
+  m_htslib_thread_pool = htslib_thread_pool;
+  m_handle_pool = handle_pool;
   m_close_file = close_file || discard_index;   //close file if index has to be discarded
   m_vcf_buffer_reader_buffer_size = 0;
   m_vcf_buffer_reader_is_bcf = false;
@@ -291,6 +433,8 @@ VCF2Binary::VCF2Binary(const std::string& stream_name, const std::vector<std::ve
   //The next parameter is irrelevant for buffered readers
   m_discard_index = false;
   m_import_ID_field = false;
+  m_htslib_thread_pool = 0;
+  m_handle_pool = 0;
   //VCFBufferReader relevant params
   m_vcf_buffer_reader_buffer_size = vcf_buffer_reader_buffer_size;
   m_vcf_buffer_reader_is_bcf = vcf_buffer_reader_is_bcf;
@@ -306,6 +450,9 @@ VCF2Binary::VCF2Binary(VCF2Binary&& other)
   m_vcf_fields = other.m_vcf_fields;
   m_discard_index = other.m_discard_index;
   m_import_ID_field = other.m_import_ID_field;
+  m_reference_block_gq_bands = std::move(other.m_reference_block_gq_bands);
+  m_htslib_thread_pool = other.m_htslib_thread_pool;
+  m_handle_pool = other.m_handle_pool;
   m_local_contig_idx_to_global_contig_idx = std::move(other.m_local_contig_idx_to_global_contig_idx);
   m_local_field_idx_to_global_field_idx = std::move(other.m_local_field_idx_to_global_field_idx);
   m_vcf_buffer_reader_buffer_size = other.m_vcf_buffer_reader_buffer_size;
@@ -330,7 +477,7 @@ GenomicsDBImportReaderBase* VCF2Binary::create_new_reader_object(const std::stri
 {
   //either reading from file or buffer parameters initialized
   assert(m_get_data_from_file || (m_vcf_buffer_reader_init_buffer && m_vcf_buffer_reader_init_num_valid_bytes && m_vcf_buffer_reader_buffer_size));
-  return (m_get_data_from_file ? dynamic_cast<GenomicsDBImportReaderBase*>(new VCFReader())
+  return (m_get_data_from_file ? dynamic_cast<GenomicsDBImportReaderBase*>(new VCFReader(m_htslib_thread_pool, m_handle_pool))
       : dynamic_cast<GenomicsDBImportReaderBase*>(new VCFBufferReader(m_vcf_buffer_reader_buffer_size, m_vcf_buffer_reader_is_bcf,
        m_vcf_buffer_reader_init_buffer,  m_vcf_buffer_reader_init_num_valid_bytes))
       );
@@ -450,10 +597,42 @@ inline void VCF2Binary::update_local_contig_idx(VCFColumnPartition& vcf_partitio
   }
 }
 
+int64_t VCF2Binary::get_end_column_idx(VCFColumnPartition& vcf_partition, bcf_hdr_t* hdr, bcf1_t* line, const int64_t column_idx)
+{
+  int max_num_values = vcf_partition.m_vcf_get_buffer_size/sizeof(int);
+  //FIXME: avoid strings
+  auto num_values = bcf_get_info_int32(hdr, line, "END", &(vcf_partition.m_vcf_get_buffer), &max_num_values);
+  assert(num_values == 1 || num_values == -3);
+  auto end_column_idx = column_idx;
+  if(num_values < 0)    //missing end value
+  {
+    //handle spanning deletions
+    if(m_treat_deletions_as_intervals)
+    {
+      auto alleles = line->d.allele;
+      auto ref_length = strlen(alleles[0]);
+      for(auto j=1;j<line->n_allele;++j)
+      {    
+        if(bcf_get_variant_type(line, j) == VCF_INDEL && ref_length > strlen(alleles[j]))
+        {    
+          end_column_idx = column_idx + ref_length - 1;
+          break;
+        }    
+      }    
+    }
+  }
+  else  //valid END found
+    end_column_idx = vcf_partition.m_contig_tiledb_column_offset + *(reinterpret_cast<int*>(vcf_partition.m_vcf_get_buffer)) - 1; //convert 1-based END to 0-based
+  return end_column_idx;
+}
+
 bool VCF2Binary::seek_and_fetch_position(File2TileDBBinaryColumnPartitionBase& partition_info, bool& is_read_buffer_exhausted,
     bool force_seek, bool advance_reader)
 {
   auto& vcf_partition = static_cast<VCFColumnPartition&>(partition_info);
+  //New batch - cells of the previous batch cannot be extended
+  if(!advance_reader)
+    vcf_partition.m_reference_block_cell_end_buffer_offset = -1;
   if(!m_get_data_from_file) //handle VCFBufferReader
   {
     //Cast to VCFBufferReader
@@ -561,7 +740,7 @@ bool VCF2Binary::seek_and_fetch_position(File2TileDBBinaryColumnPartitionBase& p
 template<class FieldType>
 bool VCF2Binary::convert_field_to_tiledb(std::vector<uint8_t>& buffer, VCFColumnPartition& vcf_partition, 
     int64_t& buffer_offset, const int64_t buffer_offset_limit, int local_callset_idx,
-    const std::string& field_name, unsigned field_type_idx)
+    const std::string& field_name, unsigned field_type_idx, const FieldInfo* quantization_info)
 {
   //Cast to VCFReader
   auto vcf_reader_ptr = dynamic_cast<VCFReaderBase*>(vcf_partition.get_base_reader_ptr());
@@ -663,6 +842,9 @@ bool VCF2Binary::convert_field_to_tiledb(std::vector<uint8_t>& buffer, VCFColumn
       }
       if(is_GT_field)
         val = bcf_gt_allele(static_cast<int>(val));
+      else
+        if(quantization_info)
+          val = quantization_info->quantize(val);
       buffer_full = buffer_full || tiledb_buffer_print<FieldType>(buffer, buffer_offset, buffer_offset_limit, val, print_sep);
       if(buffer_full) return true;
       print_sep  = !is_vcf_str_type;
@@ -671,6 +853,97 @@ bool VCF2Binary::convert_field_to_tiledb(std::vector<uint8_t>& buffer, VCFColumn
   return buffer_full;
 }
 
+int VCF2Binary::get_reference_block_gq_band(VCFColumnPartition& vcf_partition, bcf_hdr_t* hdr, bcf1_t* line,
+    const int local_callset_idx)
+{
+  //<NON_REF> must be the only ALT allele
+  if(line->n_allele != 2 || bcf_get_variant_type(line, 1) != VCF_NON_REF)
+    return -1;
+  auto num_samples = bcf_hdr_nsamples(hdr);
+  //GT must be hom-ref (or missing)
+  int max_num_values = vcf_partition.m_vcf_get_buffer_size/sizeof(int);
+  auto num_values = bcf_get_genotypes(hdr, line, reinterpret_cast<void**>(&(vcf_partition.m_vcf_get_buffer)), &max_num_values);
+  if(static_cast<uint64_t>(max_num_values)*sizeof(int) > vcf_partition.m_vcf_get_buffer_size)
+    vcf_partition.m_vcf_get_buffer_size = static_cast<uint64_t>(max_num_values)*sizeof(int);
+  if(num_values > 0)
+  {
+    auto ploidy = num_values/num_samples;
+    auto* ptr = reinterpret_cast<const int*>(vcf_partition.m_vcf_get_buffer) + local_callset_idx*ploidy;
+    for(auto k=0;k<ploidy && ptr[k] != bcf_int32_vector_end;++k)
+      if(!bcf_gt_is_missing(ptr[k]) && bcf_gt_allele(ptr[k]) != 0)
+        return -1;
+  }
+  //GQ
+  max_num_values = vcf_partition.m_vcf_get_buffer_size/sizeof(int);
+  num_values = bcf_get_format_int32(hdr, line, g_reference_block_field_names[REFERENCE_BLOCK_GQ_IDX],
+      reinterpret_cast<void**>(&(vcf_partition.m_vcf_get_buffer)), &max_num_values);
+  if(static_cast<uint64_t>(max_num_values)*sizeof(int) > vcf_partition.m_vcf_get_buffer_size)
+    vcf_partition.m_vcf_get_buffer_size = static_cast<uint64_t>(max_num_values)*sizeof(int);
+  if(num_values <= 0)
+    return -1;
+  auto GQ = reinterpret_cast<const int*>(vcf_partition.m_vcf_get_buffer)[local_callset_idx*(num_values/num_samples)];
+  if(GQ == bcf_int32_missing || GQ == bcf_int32_vector_end)
+    return -1;
+  return std::upper_bound(m_reference_block_gq_bands.begin(), m_reference_block_gq_bands.end(), GQ)
+    - m_reference_block_gq_bands.begin();
+}
+
+bool VCF2Binary::merge_into_last_reference_block(std::vector<uint8_t>& buffer, VCFColumnPartition& vcf_partition,
+    bcf_hdr_t* hdr, bcf1_t* line, const int local_callset_idx,
+    const int64_t column_idx, const int64_t end_column_idx, const int gq_band, const int64_t buffer_offset)
+{
+  //Last cell in the buffer for this callset must be a reference block in the same band that ends just before this record
+  //on the same contig - the first base of a contig is adjacent (in columns) to the last base of the previous contig
+  if(vcf_partition.m_reference_block_cell_end_buffer_offset != buffer_offset
+      || vcf_partition.m_reference_block_gq_band != gq_band
+      || vcf_partition.m_reference_block_local_contig_idx != line->rid
+      || vcf_partition.m_reference_block_end_column+1 != column_idx)
+    return false;
+  auto num_samples = bcf_hdr_nsamples(hdr);
+  //Obtain all values first - the cell must not be modified unless every field can be combined
+  for(auto i=0u;i<REFERENCE_BLOCK_NUM_FIELDS;++i)
+  {
+    auto& values = vcf_partition.m_reference_block_field_values[i];
+    values.clear();
+    if(vcf_partition.m_reference_block_field_buffer_offsets[i] < 0)
+      continue;
+    int max_num_values = vcf_partition.m_vcf_get_buffer_size/sizeof(int);
+    auto num_values = bcf_get_format_int32(hdr, line, g_reference_block_field_names[i],
+        reinterpret_cast<void**>(&(vcf_partition.m_vcf_get_buffer)), &max_num_values);
+    if(static_cast<uint64_t>(max_num_values)*sizeof(int) > vcf_partition.m_vcf_get_buffer_size)
+      vcf_partition.m_vcf_get_buffer_size = static_cast<uint64_t>(max_num_values)*sizeof(int);
+    if(num_values > 0)
+    {
+      num_values /= num_samples;
+      auto* ptr = reinterpret_cast<const int*>(vcf_partition.m_vcf_get_buffer) + local_callset_idx*num_values;
+      //Values in the cell may be quantized
+      auto local_field_idx = bcf_hdr_id2int(hdr, BCF_DT_ID, g_reference_block_field_names[i]);
+      auto global_field_idx = m_local_field_idx_to_global_field_idx[local_field_idx];
+      const auto* quantization_info = (global_field_idx >= 0 && m_vid_mapper->get_field_info(global_field_idx).is_quantized())
+        ? &(m_vid_mapper->get_field_info(global_field_idx)) : 0;
+      for(auto k=0;k<num_values && ptr[k] != bcf_int32_vector_end;++k)
+        values.push_back(quantization_info ? quantization_info->quantize(ptr[k]) : ptr[k]);
+    }
+    //Field missing in this record - values in the cell are retained
+    if(values.size() && values.size() != static_cast<size_t>(vcf_partition.m_reference_block_field_num_values[i]))
+      return false;
+  }
+  for(auto i=0u;i<REFERENCE_BLOCK_NUM_FIELDS;++i)
+  {
+    const auto& values = vcf_partition.m_reference_block_field_values[i];
+    if(values.empty())
+      continue;
+    auto* cell_values = reinterpret_cast<int*>(&(buffer[vcf_partition.m_reference_block_field_buffer_offsets[i]]));
+    for(auto k=0ull;k<values.size();++k)
+      cell_values[k] = std::min(cell_values[k], values[k]);
+  }
+  //END of the cell
+  int64_t buffer_END_offset = vcf_partition.m_reference_block_END_buffer_offset;
+  tiledb_buffer_print<int64_t>(buffer, buffer_END_offset, buffer_offset, end_column_idx);
+  vcf_partition.m_reference_block_end_column = end_column_idx;
+  return true;
+}
+
 bool VCF2Binary::convert_VCF_to_binary_for_callset(std::vector<uint8_t>& buffer, VCFColumnPartition& vcf_partition,
     size_t size_per_callset, uint64_t enabled_callsets_idx)
 {
@@ -698,42 +971,35 @@ bool VCF2Binary::convert_VCF_to_binary_for_callset(std::vector<uint8_t>& buffer,
   //Row
   int64_t row_idx = m_local_callset_idx_to_tiledb_row_idx[local_callset_idx];
   if(row_idx < 0) return false;
+  int64_t column_idx = vcf_partition.m_contig_tiledb_column_offset + line->pos;
+  auto end_column_idx = get_end_column_idx(vcf_partition, hdr, line, column_idx);
+  //Reference block compaction - merging writes no new bytes, so a partially written record can never
+  //leave a merged cell behind only for files with a single callset
+  auto gq_band = -1;
+#ifdef PRODUCE_BINARY_CELLS
+  if(m_reference_block_gq_bands.size() && m_enabled_local_callset_idx_vec.size() == 1u)
+  {
+    gq_band = get_reference_block_gq_band(vcf_partition, hdr, line, local_callset_idx);
+    if(gq_band >= 0 && merge_into_last_reference_block(buffer, vcf_partition, hdr, line, local_callset_idx,
+          column_idx, end_column_idx, gq_band, buffer_offset))
+      return false;
+  }
+  auto& reference_block_field_buffer_offsets = vcf_partition.m_reference_block_field_buffer_offsets;
+  for(auto& x : reference_block_field_buffer_offsets)
+    x = -1;
+#endif
   buffer_full = buffer_full || tiledb_buffer_print<int64_t>(buffer, buffer_offset, buffer_offset_limit, row_idx, false);
   if(buffer_full) return true;
   //Column
-  int64_t column_idx = vcf_partition.m_contig_tiledb_column_offset + line->pos;
   buffer_full = buffer_full || tiledb_buffer_print<int64_t>(buffer, buffer_offset, buffer_offset_limit, column_idx);
   if(buffer_full) return true;
 #ifdef PRODUCE_BINARY_CELLS
   //For binary cells, must print size of cell here. Keep track of offset and update later
   auto cell_size_offset = buffer_offset;
   buffer_offset += sizeof(size_t);
+  vcf_partition.m_reference_block_END_buffer_offset = buffer_offset;
 #endif
   //END position
-  int max_num_values = vcf_partition.m_vcf_get_buffer_size/sizeof(int);
-  //FIXME: avoid strings
-  auto num_values = bcf_get_info_int32(hdr, line, "END", &(vcf_partition.m_vcf_get_buffer), &max_num_values);
-  assert(num_values == 1 || num_values == -3);
-  auto end_column_idx = column_idx;
-  if(num_values < 0)    //missing end value
-  {
-    //handle spanning deletions
-    if(m_treat_deletions_as_intervals)
-    {
-      auto alleles = line->d.allele;
-      auto ref_length = strlen(alleles[0]);
-      for(auto j=1;j<line->n_allele;++j)
-      {    
-        if(bcf_get_variant_type(line, j) == VCF_INDEL && ref_length > strlen(alleles[j]))
-        {    
-          end_column_idx = column_idx + ref_length - 1;
-          break;
-        }    
-      }    
-    }
-  }
-  else  //valid END found
-    end_column_idx = vcf_partition.m_contig_tiledb_column_offset + *(reinterpret_cast<int*>(vcf_partition.m_vcf_get_buffer)) - 1; //convert 1-based END to 0-based
   buffer_full = buffer_full || tiledb_buffer_print<int64_t>(buffer, buffer_offset, buffer_offset_limit, end_column_idx);
   if(buffer_full) return true;
   //REF
@@ -817,10 +1083,38 @@ bool VCF2Binary::convert_VCF_to_binary_for_callset(std::vector<uint8_t>& buffer,
       switch(field_ht_type)
       {
         case BCF_HT_INT:
+        {
+          auto field_begin_buffer_offset = buffer_offset;
+          //Lossy quantization specified in the vid mapping
+          const FieldInfo* quantization_info = 0;
+          assert(static_cast<size_t>(field_idx) < m_local_field_idx_to_global_field_idx.size());
+          auto global_field_idx = m_local_field_idx_to_global_field_idx[field_idx];
+          if(global_field_idx >= 0 && m_vid_mapper->get_field_info(global_field_idx).is_quantized())
+            quantization_info = &(m_vid_mapper->get_field_info(global_field_idx));
           buffer_full = buffer_full || convert_field_to_tiledb<int>(buffer, vcf_partition, buffer_offset, buffer_offset_limit, local_callset_idx,
-              field_name, field_type_idx);
+              field_name, field_type_idx, quantization_info);
           if(buffer_full) return true;
+#ifdef PRODUCE_BINARY_CELLS
+          //Track location of fields combined when the cell is extended
+          if(gq_band >= 0 && field_type_idx == BCF_HL_FMT)
+          {
+            for(auto k=0u;k<REFERENCE_BLOCK_NUM_FIELDS;++k)
+              if(field_name == g_reference_block_field_names[k])
+              {
+                auto num_values = static_cast<int>((buffer_offset-field_begin_buffer_offset)/sizeof(int));
+                //Variable length fields begin with #values
+                if(bcf_hdr_id2length(hdr, BCF_HL_FMT, field_idx) != BCF_VL_FIXED)
+                {
+                  num_values = *(reinterpret_cast<const int*>(&(buffer[field_begin_buffer_offset])));
+                  field_begin_buffer_offset += sizeof(int);
+                }
+                reference_block_field_buffer_offsets[k] = field_begin_buffer_offset;
+                vcf_partition.m_reference_block_field_num_values[k] = num_values;
+              }
+          }
+#endif
           break;
+        }
         case BCF_HT_REAL:
           buffer_full = buffer_full || convert_field_to_tiledb<float>(buffer, vcf_partition, buffer_offset, buffer_offset_limit, local_callset_idx,
               field_name, field_type_idx);
@@ -843,6 +1137,11 @@ bool VCF2Binary::convert_VCF_to_binary_for_callset(std::vector<uint8_t>& buffer,
   //Update total size
   buffer_full = buffer_full ||  tiledb_buffer_print<size_t>(buffer, cell_size_offset, buffer_offset_limit, buffer_offset-line_begin_buffer_offset);
   if(buffer_full) return true;
+  //Reference block cell may be extended by the next record
+  vcf_partition.m_reference_block_cell_end_buffer_offset = (gq_band >= 0) ? buffer_offset : -1;
+  vcf_partition.m_reference_block_end_column = end_column_idx;
+  vcf_partition.m_reference_block_local_contig_idx = line->rid;
+  vcf_partition.m_reference_block_gq_band = gq_band;
 #endif
 #ifdef PRODUCE_CSV_CELLS
   //Add newline
@@ -923,4 +1222,220 @@ void VCF2Binary::close_partition_output_file(File2TileDBBinaryColumnPartitionBas
     std::cerr << "WARNING: indexing of partition file "<< vcf_partition.m_split_filename <<" failed\n";
 }
 
+void VCF2Binary::get_column_interval_of_record(File2TileDBBinaryColumnPartitionBase& partition_info,
+    int64_t& begin, int64_t& end)
+{
+  auto& vcf_partition = static_cast<VCFColumnPartition&>(partition_info);
+  auto vcf_reader_ptr = dynamic_cast<VCFReaderBase*>(vcf_partition.m_base_reader_ptr);
+  assert(vcf_reader_ptr);
+  auto* line = vcf_reader_ptr->get_line();
+  assert(line);
+  //Alleles are needed to determine the end of deletions
+  bcf_unpack(line, BCF_UN_STR);
+  begin = vcf_partition.m_contig_tiledb_column_offset + static_cast<int64_t>(line->pos);
+  end = get_end_column_idx(vcf_partition, vcf_reader_ptr->get_header(), line, begin);
+}
+
+void VCF2Binary::write_record_to_partition(File2TileDBBinaryColumnPartitionBase& cursor_info,
+    File2TileDBBinaryColumnPartitionBase& partition_info)
+{
+  auto& vcf_partition = static_cast<VCFColumnPartition&>(partition_info);
+  assert(vcf_partition.m_split_output_fptr);
+  auto vcf_reader_ptr = dynamic_cast<VCFReaderBase*>(cursor_info.get_base_reader_ptr());
+  assert(vcf_reader_ptr && vcf_reader_ptr->get_line());
+  auto status = bcf_write(vcf_partition.m_split_output_fptr, vcf_reader_ptr->get_header(), vcf_reader_ptr->get_line());
+  if(status != 0)
+    throw VCF2BinaryException(std::string("Error writing record to output split file ")+vcf_partition.m_split_filename);
+}
+
+//Part of a histogram bin that lies within a single contig
+struct IndexHistogramSegment
+{
+  int m_tid;
+  //0-based positions in the contig
+  int64_t m_begin;
+  int64_t m_end;
+  int64_t m_begin_column;
+  uint64_t m_num_compressed_bytes;
+  //-1 if unknown
+  double m_num_records;
+};
+
+//Compressed offset of the first record that overlaps [begin, end) - default_offset if there is none
+static uint64_t get_compressed_offset_from_index(const hts_idx_t* idx, const int tid, const int64_t begin, const int64_t end,
+    const uint64_t default_offset)
+{
+  auto offset = default_offset;
+  auto* itr = hts_itr_query(idx, tid, begin, end, 0);
+  if(itr)
+  {
+    for(auto i=0;i<itr->n_off;++i)
+      offset = std::min<uint64_t>(offset, itr->off[i].u >> 16);
+    hts_itr_destroy(itr);
+  }
+  return offset;
+}
+
+void VCF2Binary::create_histogram_from_index(uint64_t max_histogram_range, unsigned num_bins, unsigned num_bins_to_sample)
+{
+  //Streams have no index
+  if(!m_get_data_from_file)
+  {
+    create_histogram(max_histogram_range, num_bins);
+    return;
+  }
+  auto* fptr = hts_open(m_filename.c_str(), "r");
+  if(fptr == 0)
+    throw VCF2BinaryException(std::string("Could not open file ")+m_filename);
+  auto* hdr = bcf_hdr_read(fptr);
+  if(hdr == 0)
+    throw VCF2BinaryException(std::string("Could not read VCF/BCF header from file ")+m_filename);
+  auto is_bcf = (hts_get_format(fptr)->format == bcf);
+  tbx_t* tbx = 0;
+  hts_idx_t* idx = 0;
+  if(is_bcf)
+    idx = bcf_index_load(m_filename.c_str());
+  else
+  {
+    tbx = tbx_index_load(m_filename.c_str());
+    idx = tbx ? tbx->idx : 0;
+  }
+  if(idx == 0)
+  {
+    std::cerr << "WARNING: no index found for file "<<m_filename<<" - histogram is computed by reading all records\n";
+    bcf_hdr_destroy(hdr);
+    hts_close(fptr);
+    create_histogram(max_histogram_range, num_bins);
+    return;
+  }
+  if(m_histogram)
+    delete m_histogram;
+  m_histogram = new UniformHistogram(0, max_histogram_range, num_bins);
+  std::vector<IndexHistogramSegment> segments;
+  auto record_counts_in_index = true;
+  for(auto local_contig_idx=0;local_contig_idx<hdr->n[BCF_DT_CTG];++local_contig_idx)
+  {
+    auto global_contig_idx = m_local_contig_idx_to_global_contig_idx[local_contig_idx];
+    if(global_contig_idx < 0)
+      continue;
+    const auto& contig_info = m_vid_mapper->get_contig_info(global_contig_idx);
+    if(contig_info.m_tiledb_column_offset > static_cast<int64_t>(max_histogram_range))
+      continue;
+    auto tid = is_bcf ? local_contig_idx : tbx_name2id(tbx, bcf_hdr_id2name(hdr, local_contig_idx));
+    if(tid < 0) //no records
+      continue;
+    //Compressed byte range of the contig
+    auto* itr = hts_itr_query(idx, tid, 0, contig_info.m_length, 0);
+    if(itr == 0)
+      continue;
+    uint64_t contig_begin_offset = UINT64_MAX;
+    uint64_t contig_end_offset = 0ull;
+    for(auto i=0;i<itr->n_off;++i)
+    {
+      contig_begin_offset = std::min<uint64_t>(contig_begin_offset, itr->off[i].u >> 16);
+      contig_end_offset = std::max<uint64_t>(contig_end_offset, itr->off[i].v >> 16);
+    }
+    hts_itr_destroy(itr);
+    if(contig_end_offset == 0ull)
+      continue;
+    //Split the contig at histogram bin boundaries
+    auto first_segment_idx = segments.size();
+    auto contig_end_column = std::min<int64_t>(contig_info.m_tiledb_column_offset+contig_info.m_length-1, max_histogram_range);
+    for(auto begin_column=contig_info.m_tiledb_column_offset;begin_column<=contig_end_column;)
+    {
+      auto end_column = std::min<int64_t>(m_histogram->get_hi(m_histogram->get_bin_idx_for_value(begin_column)), contig_end_column);
+      IndexHistogramSegment segment;
+      segment.m_tid = tid;
+      segment.m_begin = begin_column - contig_info.m_tiledb_column_offset;
+      segment.m_end = end_column - contig_info.m_tiledb_column_offset;
+      segment.m_begin_column = begin_column;
+      segment.m_num_compressed_bytes = 0ull;
+      segment.m_num_records = -1;
+      segments.push_back(segment);
+      begin_column = end_column+1;
+    }
+    //Bytes of a segment - from its first record to the first record of the next non-empty segment
+    //Each query covers only the segment, walking backwards lets empty segments take the offset that follows them
+    auto end_offset = contig_end_offset;
+    for(auto i=segments.size();i>first_segment_idx;--i)
+    {
+      auto& segment = segments[i-1u];
+      auto begin_offset = std::min(end_offset,
+          get_compressed_offset_from_index(idx, tid, segment.m_begin, segment.m_end+1, end_offset));
+      segment.m_num_compressed_bytes = end_offset - begin_offset;
+      end_offset = begin_offset;
+    }
+    //#records in the contig is stored in the index by bcftools/tabix
+    uint64_t num_mapped = 0ull;
+    uint64_t num_unmapped = 0ull;
+    if(hts_idx_get_stat(idx, tid, &num_mapped, &num_unmapped) >= 0)
+    {
+      auto num_contig_bytes = contig_end_offset - std::min(contig_begin_offset, contig_end_offset);
+      for(auto i=first_segment_idx;i<segments.size();++i)
+        segments[i].m_num_records = num_contig_bytes
+          ? static_cast<double>(num_mapped)*segments[i].m_num_compressed_bytes/num_contig_bytes
+          : (i == first_segment_idx ? num_mapped : 0);
+    }
+    else
+      record_counts_in_index = false;
+  }
+  //Records/byte is obtained from the sampled bins if the index has no record counts
+  if(!record_counts_in_index)
+    num_bins_to_sample = std::max(num_bins_to_sample, 1u);
+  std::vector<size_t> sorted_segment_idxs(segments.size());
+  for(auto i=0ull;i<segments.size();++i)
+    sorted_segment_idxs[i] = i;
+  auto num_sampled_segments = std::min<size_t>(num_bins_to_sample, segments.size());
+  std::partial_sort(sorted_segment_idxs.begin(), sorted_segment_idxs.begin()+num_sampled_segments, sorted_segment_idxs.end(),
+      [&segments](const size_t a, const size_t b) { return segments[a].m_num_compressed_bytes > segments[b].m_num_compressed_bytes; });
+  uint64_t num_sampled_records = 0ull;
+  uint64_t num_sampled_bytes = 0ull;
+  auto* line = bcf_init();
+  kstring_t str = { 0, 0, 0 };
+  for(auto i=0ull;i<num_sampled_segments;++i)
+  {
+    auto& segment = segments[sorted_segment_idxs[i]];
+    //Records that begin in the segment
+    auto num_records = 0ull;
+    auto* itr = is_bcf ? bcf_itr_queryi(idx, segment.m_tid, segment.m_begin, segment.m_end+1)
+      : tbx_itr_queryi(tbx, segment.m_tid, segment.m_begin, segment.m_end+1);
+    if(itr)
+    {
+      if(is_bcf)
+      {
+        while(bcf_itr_next(fptr, itr, line) >= 0)
+          num_records += (line->pos >= segment.m_begin) ? 1u : 0u;
+      }
+      else
+      {
+        while(tbx_itr_next(fptr, tbx, itr, &str) >= 0)
+        {
+          auto* pos_ptr = strchr(str.s, '\t');
+          num_records += (pos_ptr && strtoll(pos_ptr+1, 0, 10)-1 >= segment.m_begin) ? 1u : 0u;
+        }
+      }
+      hts_itr_destroy(itr);
+    }
+    segment.m_num_records = num_records;
+    num_sampled_records += num_records;
+    num_sampled_bytes += segment.m_num_compressed_bytes;
+  }
+  bcf_destroy(line);
+  free(str.s);
+  auto records_per_byte = num_sampled_bytes ? static_cast<double>(num_sampled_records)/num_sampled_bytes : 0.0;
+  //Each record contains a cell for every callset
+  auto num_callsets = m_enabled_local_callset_idx_vec.size();
+  for(const auto& segment : segments)
+  {
+    auto num_records = (segment.m_num_records >= 0) ? segment.m_num_records : records_per_byte*segment.m_num_compressed_bytes;
+    m_histogram->add_count(segment.m_begin_column, static_cast<uint64_t>(std::llround(num_records))*num_callsets);
+  }
+  if(tbx)
+    tbx_destroy(tbx);
+  else
+    hts_idx_destroy(idx);
+  bcf_hdr_destroy(hdr);
+  hts_close(fptr);
+}
+
 #endif //ifdef HTSDIR
@@ -25,6 +25,8 @@
 #include "vcf_adapter.h"
 #include "vid_mapper.h"
 #include "htslib/tbx.h"
+#include "htslib/bgzf.h"
+#include "htslib/hfile.h"
 
 //ReferenceGenomeInfo functions
 void ReferenceGenomeInfo::initialize(const std::string& reference_genome)
@@ -302,17 +304,38 @@ bcf_hdr_t* VCFAdapter::initialize_default_header()
 void VCFAdapter::print_header()
 {
   bcf_hdr_write(m_output_fptr, m_template_vcf_hdr);
+  //Start records in a new BGZF block - outputs of different ranks/partitions can then be concatenated
+  //without recompression (see VCFPartsConcatenator)
+  auto bgzf_fptr = hts_get_bgzfp(m_output_fptr);
+  if(bgzf_fptr && bgzf_flush(bgzf_fptr) != 0)
+    throw VCFAdapterException(std::string("Failed to write VCF/BCF header to ")+m_output_filename);
 }
 
-void VCFAdapter::handoff_output_bcf_line(bcf1_t*& line, const size_t bcf_record_size)
+void VCFAdapter::write_line(bcf1_t* line)
 {
-  auto write_status = bcf_write(m_output_fptr, m_template_vcf_hdr, line);
+  auto write_status = 0;
+  if(m_is_bcf)
+    write_status = bcf_write(m_output_fptr, m_template_vcf_hdr, line);
+  else
+  {
+    //Same bytes as vcf_write - indexes are built after the file is closed, so there is no index to update here
+    auto num_bytes = VCFTextFormatter::format(m_template_vcf_hdr, line, m_text_buffer, 0u);
+    auto num_bytes_written = (m_output_fptr->format.compression != no_compression)
+      ? bgzf_write(m_output_fptr->fp.bgzf, &(m_text_buffer[0]), num_bytes)
+      : hwrite(m_output_fptr->fp.hfile, &(m_text_buffer[0]), num_bytes);
+    write_status = (num_bytes_written == static_cast<ssize_t>(num_bytes)) ? 0 : -1;
+  }
   if(write_status != 0)
     throw VCFAdapterException(std::string("Failed to write VCF/BCF record at position ")
         +bcf_hdr_id2name(m_template_vcf_hdr, line->rid)+", "
         +std::to_string(line->pos+1));
 }
 
+void VCFAdapter::handoff_output_bcf_line(bcf1_t*& line, const size_t bcf_record_size)
+{
+  write_line(line);
+}
+
 BufferedVCFAdapter::BufferedVCFAdapter(unsigned num_circular_buffers, unsigned max_num_entries, const size_t combined_vcf_records_buffer_size_limit)
   : VCFAdapter(true, combined_vcf_records_buffer_size_limit), CircularBufferController(num_circular_buffers)
 {
@@ -380,11 +403,7 @@ void BufferedVCFAdapter::do_output()
   for(auto i=0u;i<m_num_valid_entries[read_idx];++i)
   {
     assert(m_line_buffers[read_idx][i]);
-    auto write_status = bcf_write(m_output_fptr, m_template_vcf_hdr, m_line_buffers[read_idx][i]);
-    if(write_status != 0)
-      throw VCFAdapterException(std::string("Failed to write VCF/BCF record at position ")
-          +bcf_hdr_id2name(m_template_vcf_hdr, m_line_buffers[read_idx][i]->rid)+", "
-          +std::to_string(m_line_buffers[read_idx][i]->pos+1));
+    write_line(m_line_buffers[read_idx][i]);
   }
   m_num_valid_entries[read_idx] = 0u;
   m_combined_vcf_records_buffer_sizes[read_idx] = 0ull;
@@ -412,6 +431,16 @@ void VCFSerializedBufferAdapter::handoff_output_bcf_line(bcf1_t*& line, const si
   m_vcf_serialization_timer.start();
 #endif
   assert(m_rw_buffer);
+  //VCF text - formatted directly into the buffer, which grows as needed
+  if(!m_is_bcf)
+  {
+    m_rw_buffer->m_num_valid_bytes = VCFTextFormatter::format(m_template_vcf_hdr, line, m_rw_buffer->m_buffer,
+        m_rw_buffer->m_num_valid_bytes);
+#ifdef DO_PROFILING
+    m_vcf_serialization_timer.stop();
+#endif
+    return;
+  }
   auto offset = bcf_serialize(line, &(m_rw_buffer->m_buffer[0]), m_rw_buffer->m_num_valid_bytes, m_rw_buffer->m_buffer.size(),
        m_is_bcf ? 1u : 0u, m_template_vcf_hdr, &m_hts_string);
   //Buffer capacity was too small, resize
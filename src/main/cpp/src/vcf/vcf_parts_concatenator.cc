@@ -0,0 +1,600 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifdef HTSDIR
+
+#include "vcf_parts_concatenator.h"
+#include "htslib/bgzf.h"
+#include "htslib/kstring.h"
+#include "htslib/vcf.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw VCFPartsConcatenatorException(#X);
+
+//Empty BGZF block that terminates every BGZF file
+#define BGZF_EOF_MARKER_LENGTH 28u
+static const char g_bgzf_eof_marker[] = "\037\213\010\4\0\0\0\0\0\377\6\0\102\103\2\0\033\0\3\0\0\0\0\0\0\0\0\0";
+
+#define CONCATENATOR_COPY_BUFFER_SIZE (4u*1024u*1024u)
+
+//Tabix indexes always use these values, CSI stores them in the index
+#define TBI_MIN_SHIFT 14
+#define TBI_DEPTH 5
+//Tabix configuration - format, col_seq, col_beg, col_end, meta, skip
+#define TABIX_CONF_NUM_FIELDS 6u
+
+//Virtual file offsets (compressed block offset << 16 | offset within block) are rebased by the
+//position of the part's data in the concatenated file
+static inline uint64_t shift_virtual_offset(const uint64_t voffset, const int64_t shift)
+{
+  return ((static_cast<uint64_t>(static_cast<int64_t>(voffset >> 16) + shift)) << 16) | (voffset & 0xffffull);
+}
+
+void VCFPartsConcatenator::initialize_part_info(const unsigned part_idx, PartInfo& part_info) const
+{
+  auto& filename = m_part_filenames[part_idx];
+  struct stat stat_buffer;
+  if(stat(filename.c_str(), &stat_buffer) != 0)
+    throw VCFPartsConcatenatorException(std::string("Cannot access part ")+filename);
+  uint64_t file_size = stat_buffer.st_size;
+  part_info.m_data_end = file_size;
+  //Strip EOF marker block
+  if(file_size >= BGZF_EOF_MARKER_LENGTH)
+  {
+    auto fptr = fopen(filename.c_str(), "rb");
+    VERIFY_OR_THROW(fptr);
+    char buffer[BGZF_EOF_MARKER_LENGTH];
+    auto status = (fseeko(fptr, file_size-BGZF_EOF_MARKER_LENGTH, SEEK_SET) == 0)
+      && (fread(buffer, 1u, BGZF_EOF_MARKER_LENGTH, fptr) == BGZF_EOF_MARKER_LENGTH);
+    fclose(fptr);
+    VERIFY_OR_THROW(status);
+    if(memcmp(buffer, g_bgzf_eof_marker, BGZF_EOF_MARKER_LENGTH) == 0)
+      part_info.m_data_end = file_size - BGZF_EOF_MARKER_LENGTH;
+  }
+  //First part keeps its header
+  if(part_idx == 0u)
+  {
+    part_info.m_data_begin = 0ull;
+    return;
+  }
+  //Locate the first BGZF block after the header
+  auto fp = bgzf_open(filename.c_str(), "r");
+  if(fp == 0 || !(fp->is_compressed))
+  {
+    if(fp)
+      bgzf_close(fp);
+    throw VCFPartsConcatenatorException(std::string("Part ")+filename+" is not BGZF compressed");
+  }
+  auto valid_header = true;
+  char magic[5];
+  if(bgzf_read(fp, magic, 5) == 5 && memcmp(magic, "BCF\2", 4) == 0)
+  {
+    uint32_t l_text = 0u;
+    valid_header = (bgzf_read(fp, &l_text, sizeof(l_text)) == sizeof(l_text));
+    std::vector<char> header_text(l_text+1u);
+    valid_header = valid_header && (bgzf_read(fp, &(header_text[0]), l_text) == static_cast<ssize_t>(l_text));
+  }
+  else
+  {
+    //VCF - header lines begin with '#', the last one with #CHROM
+    valid_header = (bgzf_seek(fp, 0ll, SEEK_SET) == 0);
+    kstring_t line = { 0, 0, 0 };
+    auto found_chrom_line = false;
+    while(valid_header && !found_chrom_line && bgzf_getline(fp, '\n', &line) >= 0)
+    {
+      valid_header = (line.l > 0u && line.s[0] == '#');
+      found_chrom_line = (strncmp(line.s, "#CHROM", 6u) == 0);
+    }
+    valid_header = valid_header && found_chrom_line;
+    free(line.s);
+  }
+  if(!valid_header)
+  {
+    bgzf_close(fp);
+    throw VCFPartsConcatenatorException(std::string("Could not read VCF/BCF header of part ")+filename);
+  }
+  char next_byte;
+  auto num_bytes_read = bgzf_read(fp, &next_byte, 1u);
+  auto voffset = bgzf_tell(fp);
+  bgzf_close(fp);
+  if(num_bytes_read == 1)
+  {
+    //Records must start at the beginning of a block
+    if((voffset & 0xffffll) != 1)
+      throw VCFPartsConcatenatorException(std::string("Header and records share a BGZF block in part ")+filename
+          +" - part cannot be concatenated without recompression");
+    part_info.m_data_begin = voffset >> 16;
+  }
+  else //header only
+    part_info.m_data_begin = part_info.m_data_end;
+}
+
+static bcf_hdr_t* read_part_header(const std::string& filename)
+{
+  auto fptr = hts_open(filename.c_str(), "r");
+  if(fptr == 0)
+    throw VCFPartsConcatenatorException(std::string("Cannot open part ")+filename);
+  auto hdr = bcf_hdr_read(fptr);
+  hts_close(fptr);
+  if(hdr == 0)
+    throw VCFPartsConcatenatorException(std::string("Could not read VCF/BCF header of part ")+filename);
+  return hdr;
+}
+
+//Records of every part are kept as is, so the contig, INFO and FORMAT dictionaries of all parts must be
+//identical to those of the first part (whose header is written out). BCF records refer to dictionary
+//entries by index, hence the order must match too
+void VCFPartsConcatenator::check_part_header(const unsigned part_idx, const bcf_hdr_t* first_hdr, const bcf_hdr_t* hdr) const
+{
+  auto& filename = m_part_filenames[part_idx];
+  auto contigs_match = (hdr->n[BCF_DT_CTG] == first_hdr->n[BCF_DT_CTG]);
+  for(auto i=0;contigs_match && i<hdr->n[BCF_DT_CTG];++i)
+    contigs_match = (strcmp(hdr->id[BCF_DT_CTG][i].key, first_hdr->id[BCF_DT_CTG][i].key) == 0)
+      && (hdr->id[BCF_DT_CTG][i].val->info[0] == first_hdr->id[BCF_DT_CTG][i].val->info[0]);
+  if(!contigs_match)
+    throw VCFPartsConcatenatorException(std::string("Contigs in the header of part ")+filename
+        +" do not match those of part "+m_part_filenames[0u]);
+  auto fields_match = (hdr->n[BCF_DT_ID] == first_hdr->n[BCF_DT_ID]);
+  for(auto i=0;fields_match && i<hdr->n[BCF_DT_ID];++i)
+  {
+    fields_match = (strcmp(hdr->id[BCF_DT_ID][i].key, first_hdr->id[BCF_DT_ID][i].key) == 0);
+    for(auto field_type_idx : { BCF_HL_INFO, BCF_HL_FMT })
+    {
+      if(!fields_match)
+        break;
+      auto exists = bcf_hdr_idinfo_exists(hdr, field_type_idx, i);
+      fields_match = (exists == bcf_hdr_idinfo_exists(first_hdr, field_type_idx, i))
+        && (!exists ||
+            (bcf_hdr_id2type(hdr, field_type_idx, i) == bcf_hdr_id2type(first_hdr, field_type_idx, i)
+             && bcf_hdr_id2length(hdr, field_type_idx, i) == bcf_hdr_id2length(first_hdr, field_type_idx, i)
+             && bcf_hdr_id2number(hdr, field_type_idx, i) == bcf_hdr_id2number(first_hdr, field_type_idx, i)));
+    }
+  }
+  if(!fields_match)
+    throw VCFPartsConcatenatorException(std::string("INFO/FORMAT fields in the header of part ")+filename
+        +" do not match those of part "+m_part_filenames[0u]);
+}
+
+void VCFPartsConcatenator::concatenate(const std::string& output_filename, const bool merge_part_indexes)
+{
+  VERIFY_OR_THROW(m_part_filenames.size() > 0u);
+  m_part_info.resize(m_part_filenames.size());
+  for(auto i=0u;i<m_part_filenames.size();++i)
+    initialize_part_info(i, m_part_info[i]);
+  auto first_hdr = read_part_header(m_part_filenames[0u]);
+  for(auto i=1u;i<m_part_filenames.size();++i)
+  {
+    bcf_hdr_t* hdr = 0;
+    try
+    {
+      hdr = read_part_header(m_part_filenames[i]);
+      check_part_header(i, first_hdr, hdr);
+    }
+    catch(...)
+    {
+      if(hdr)
+        bcf_hdr_destroy(hdr);
+      bcf_hdr_destroy(first_hdr);
+      throw;
+    }
+    bcf_hdr_destroy(hdr);
+  }
+  bcf_hdr_destroy(first_hdr);
+  auto output_fptr = fopen(output_filename.c_str(), "wb");
+  if(output_fptr == 0)
+    throw VCFPartsConcatenatorException(std::string("Cannot write to output file ")+output_filename);
+  std::vector<char> buffer(CONCATENATOR_COPY_BUFFER_SIZE);
+  uint64_t output_offset = 0ull;
+  for(auto i=0u;i<m_part_filenames.size();++i)
+  {
+    auto& part_info = m_part_info[i];
+    part_info.m_shift = static_cast<int64_t>(output_offset) - static_cast<int64_t>(part_info.m_data_begin);
+    auto fptr = fopen(m_part_filenames[i].c_str(), "rb");
+    auto status = (fptr != 0) && (fseeko(fptr, part_info.m_data_begin, SEEK_SET) == 0);
+    for(auto num_remaining_bytes = part_info.m_data_end - part_info.m_data_begin;status && num_remaining_bytes > 0ull;)
+    {
+      auto num_bytes = std::min<uint64_t>(num_remaining_bytes, buffer.size());
+      status = (fread(&(buffer[0]), 1u, num_bytes, fptr) == num_bytes)
+        && (fwrite(&(buffer[0]), 1u, num_bytes, output_fptr) == num_bytes);
+      num_remaining_bytes -= num_bytes;
+    }
+    if(fptr)
+      fclose(fptr);
+    if(!status)
+    {
+      fclose(output_fptr);
+      throw VCFPartsConcatenatorException(std::string("Failed to copy part ")+m_part_filenames[i]+" to "+output_filename);
+    }
+    output_offset += (part_info.m_data_end - part_info.m_data_begin);
+  }
+  auto status = (fwrite(g_bgzf_eof_marker, 1u, BGZF_EOF_MARKER_LENGTH, output_fptr) == BGZF_EOF_MARKER_LENGTH);
+  status = (fclose(output_fptr) == 0) && status;
+  if(!status)
+    throw VCFPartsConcatenatorException(std::string("Failed to write output file ")+output_filename);
+  if(merge_part_indexes)
+  {
+    for(auto suffix : { ".tbi", ".csi" })
+    {
+      auto all_parts_indexed = true;
+      struct stat stat_buffer;
+      for(auto i=0u;all_parts_indexed && i<m_part_filenames.size();++i)
+        all_parts_indexed = (stat((m_part_filenames[i]+suffix).c_str(), &stat_buffer) == 0);
+      if(all_parts_indexed)
+      {
+        merge_indexes(output_filename, suffix);
+        return;
+      }
+    }
+    std::cerr << "WARNING: not all parts have a .tbi or .csi index, no index created for "<<output_filename<<"\n";
+  }
+}
+
+//Tabix and CSI indexes are BGZF compressed - see the SAM/BAM specification for the layout
+//Integers are stored little endian - like the rest of the binary formats in GenomicsDB, this assumes a little endian host
+class BGZFIndexReader
+{
+  public:
+    BGZFIndexReader(const std::string& filename)
+      : m_filename(filename)
+    {
+      m_fp = bgzf_open(filename.c_str(), "r");
+      if(m_fp == 0)
+        throw VCFPartsConcatenatorException(std::string("Cannot open index file ")+filename);
+    }
+    ~BGZFIndexReader()
+    {
+      if(m_fp)
+        bgzf_close(m_fp);
+      m_fp = 0;
+    }
+    void read_bytes(void* dst, const size_t num_bytes)
+    {
+      if(bgzf_read(m_fp, dst, num_bytes) != static_cast<ssize_t>(num_bytes))
+        throw VCFPartsConcatenatorException(std::string("Truncated index file ")+m_filename);
+    }
+    template<class T>
+    T read()
+    {
+      T val;
+      read_bytes(&val, sizeof(T));
+      return val;
+    }
+    //Optional trailing fields
+    bool try_read(uint64_t& val) { return (bgzf_read(m_fp, &val, sizeof(val)) == sizeof(val)); }
+  private:
+    std::string m_filename;
+    BGZF* m_fp;
+};
+
+class BGZFIndexWriter
+{
+  public:
+    BGZFIndexWriter(const std::string& filename)
+      : m_filename(filename)
+    {
+      m_fp = bgzf_open(filename.c_str(), "w");
+      if(m_fp == 0)
+        throw VCFPartsConcatenatorException(std::string("Cannot write to index file ")+filename);
+    }
+    ~BGZFIndexWriter()
+    {
+      if(m_fp)
+        bgzf_close(m_fp);
+      m_fp = 0;
+    }
+    void write_bytes(const void* src, const size_t num_bytes)
+    {
+      if(bgzf_write(m_fp, src, num_bytes) != static_cast<ssize_t>(num_bytes))
+        throw VCFPartsConcatenatorException(std::string("Failed to write index file ")+m_filename);
+    }
+    template<class T>
+    void write(const T val) { write_bytes(&val, sizeof(T)); }
+    void close()
+    {
+      auto status = bgzf_close(m_fp);
+      m_fp = 0;
+      if(status != 0)
+        throw VCFPartsConcatenatorException(std::string("Failed to write index file ")+m_filename);
+    }
+  private:
+    std::string m_filename;
+    BGZF* m_fp;
+};
+
+class MergedIndexChunk
+{
+  public:
+    MergedIndexChunk(const uint64_t begin, const uint64_t end, const unsigned part_idx)
+      : m_begin(begin), m_end(end), m_part_idx(part_idx)
+    { }
+    uint64_t m_begin;
+    uint64_t m_end;
+    unsigned m_part_idx;
+};
+
+class MergedIndexBin
+{
+  public:
+    MergedIndexBin()
+      : m_loffset(UINT64_MAX), m_first_part_idx(UINT_MAX)
+    { }
+    uint64_t m_loffset;         //CSI only
+    unsigned m_first_part_idx;
+    std::vector<MergedIndexChunk> m_chunks;
+};
+
+class MergedIndexReference
+{
+  public:
+    MergedIndexReference()
+      : m_has_meta_bin(false), m_meta_begin(UINT64_MAX), m_meta_end(0ull), m_num_mapped(0ull), m_num_unmapped(0ull)
+    { }
+    std::map<uint32_t, MergedIndexBin> m_bins;
+    //Pseudo-bin with the offset range and record counts of the reference
+    bool m_has_meta_bin;
+    uint64_t m_meta_begin;
+    uint64_t m_meta_end;
+    uint64_t m_num_mapped;
+    uint64_t m_num_unmapped;
+    //Tabix only - UINT64_MAX for windows with no entries
+    std::vector<uint64_t> m_linear_index;
+};
+
+void VCFPartsConcatenator::merge_indexes(const std::string& output_filename, const std::string& index_suffix) const
+{
+  auto is_tbi = (index_suffix == ".tbi");
+  auto magic = is_tbi ? "TBI\1" : "CSI\1";
+  int32_t min_shift = TBI_MIN_SHIFT;
+  int32_t depth = TBI_DEPTH;
+  //Tabix indexes and CSI indexes built by tabix identify references by name, BCF CSI indexes by the
+  //contig idx in the (common) header
+  auto has_names = is_tbi;
+  std::vector<int32_t> tabix_conf(TABIX_CONF_NUM_FIELDS, 0);
+  std::vector<std::string> merged_names;
+  std::unordered_map<std::string, int> name_to_merged_idx;
+  std::vector<MergedIndexReference> references;
+  auto has_num_no_coordinate = false;
+  uint64_t num_no_coordinate = 0ull;
+  for(auto part_idx=0u;part_idx<m_part_filenames.size();++part_idx)
+  {
+    auto& part_info = m_part_info[part_idx];
+    BGZFIndexReader reader(m_part_filenames[part_idx]+index_suffix);
+    char part_magic[4];
+    reader.read_bytes(part_magic, 4u);
+    if(memcmp(part_magic, magic, 4u) != 0)
+      throw VCFPartsConcatenatorException(std::string("Invalid index file ")+m_part_filenames[part_idx]+index_suffix);
+    std::vector<int> local_to_merged_idx;
+    auto read_tabix_conf_and_names = [&]() -> uint32_t {
+      for(auto i=0u;i<TABIX_CONF_NUM_FIELDS;++i)
+        tabix_conf[i] = reader.read<int32_t>();
+      auto l_nm = reader.read<int32_t>();
+      std::vector<char> names(l_nm+1, '\0');
+      reader.read_bytes(&(names[0]), l_nm);
+      for(auto offset=0;offset<l_nm;)
+      {
+        std::string name = &(names[offset]);
+        offset += name.length()+1u;
+        auto iter = name_to_merged_idx.find(name);
+        if(iter == name_to_merged_idx.end())
+        {
+          iter = name_to_merged_idx.insert(std::make_pair(name, static_cast<int>(merged_names.size()))).first;
+          merged_names.push_back(name);
+        }
+        local_to_merged_idx.push_back((*iter).second);
+      }
+      return TABIX_CONF_NUM_FIELDS*sizeof(int32_t) + sizeof(int32_t) + l_nm;
+    };
+    int32_t n_ref = 0;
+    if(is_tbi)
+    {
+      n_ref = reader.read<int32_t>();
+      read_tabix_conf_and_names();
+    }
+    else
+    {
+      auto part_min_shift = reader.read<int32_t>();
+      auto part_depth = reader.read<int32_t>();
+      auto l_aux = reader.read<int32_t>();
+      if(part_idx == 0u)
+      {
+        min_shift = part_min_shift;
+        depth = part_depth;
+        has_names = (l_aux > 0);
+      }
+      else
+        if(part_min_shift != min_shift || part_depth != depth || has_names != (l_aux > 0))
+          throw VCFPartsConcatenatorException(std::string("Index of part ")+m_part_filenames[part_idx]
+              +" was created with different parameters");
+      if(l_aux > 0)
+        VERIFY_OR_THROW(read_tabix_conf_and_names() == static_cast<uint32_t>(l_aux));
+      n_ref = reader.read<int32_t>();
+    }
+    if(has_names)
+      VERIFY_OR_THROW(local_to_merged_idx.size() == static_cast<size_t>(n_ref));
+    const uint32_t meta_bin = ((1u << (3*depth+3)) - 1u)/7u + 1u;
+    //Offsets below the part's first record - entries for regions before the part begins
+    auto is_valid_offset = [&](const uint64_t voffset) -> bool {
+      return (voffset != UINT64_MAX && (voffset >> 16) >= part_info.m_data_begin);
+    };
+    for(auto i=0;i<n_ref;++i)
+    {
+      auto merged_idx = has_names ? local_to_merged_idx[i] : i;
+      if(static_cast<size_t>(merged_idx) >= references.size())
+        references.resize(merged_idx+1);
+      auto& reference = references[merged_idx];
+      auto n_bin = reader.read<int32_t>();
+      for(auto j=0;j<n_bin;++j)
+      {
+        auto bin = reader.read<uint32_t>();
+        auto loffset = is_tbi ? 0ull : reader.read<uint64_t>();
+        auto n_chunk = reader.read<int32_t>();
+        if(bin == meta_bin)
+        {
+          VERIFY_OR_THROW(n_chunk == 2);
+          reference.m_has_meta_bin = true;
+          reference.m_meta_begin = std::min(reference.m_meta_begin, shift_virtual_offset(reader.read<uint64_t>(), part_info.m_shift));
+          reference.m_meta_end = std::max(reference.m_meta_end, shift_virtual_offset(reader.read<uint64_t>(), part_info.m_shift));
+          reference.m_num_mapped += reader.read<uint64_t>();
+          reference.m_num_unmapped += reader.read<uint64_t>();
+          continue;
+        }
+        auto& merged_bin = reference.m_bins[bin];
+        if(merged_bin.m_first_part_idx == UINT_MAX)
+          merged_bin.m_first_part_idx = part_idx;
+        if(!is_tbi)
+          merged_bin.m_loffset = std::min(merged_bin.m_loffset, is_valid_offset(loffset)
+              ? shift_virtual_offset(loffset, part_info.m_shift)
+              : (static_cast<uint64_t>(part_info.m_data_begin + part_info.m_shift) << 16));
+        for(auto k=0;k<n_chunk;++k)
+        {
+          auto begin = shift_virtual_offset(reader.read<uint64_t>(), part_info.m_shift);
+          auto end = shift_virtual_offset(reader.read<uint64_t>(), part_info.m_shift);
+          auto& chunks = merged_bin.m_chunks;
+          //Chunk continues across the part boundary
+          if(!chunks.empty() && chunks.back().m_end == begin)
+            chunks.back().m_end = end;
+          else
+            chunks.emplace_back(begin, end, part_idx);
+        }
+      }
+      if(is_tbi)
+      {
+        auto n_intv = reader.read<int32_t>();
+        auto& linear_index = reference.m_linear_index;
+        if(linear_index.size() < static_cast<size_t>(n_intv))
+          linear_index.resize(n_intv, UINT64_MAX);
+        for(auto k=0;k<n_intv;++k)
+        {
+          auto voffset = reader.read<uint64_t>();
+          if(is_valid_offset(voffset))
+            linear_index[k] = std::min(linear_index[k], shift_virtual_offset(voffset, part_info.m_shift));
+        }
+      }
+    }
+    uint64_t val = 0ull;
+    if(reader.try_read(val))
+    {
+      has_num_no_coordinate = true;
+      num_no_coordinate += val;
+    }
+  }
+  if(has_names && merged_names.size() > references.size())
+    references.resize(merged_names.size());
+  for(auto& reference : references)
+  {
+    //Records from an earlier part may overlap a bin first seen in a later part - they are stored in an ancestor
+    //bin and the lower bound offset of the bin must not skip them
+    if(!is_tbi)
+      for(auto& bin_iter : reference.m_bins)
+      {
+        auto& merged_bin = bin_iter.second;
+        for(auto ancestor=bin_iter.first;ancestor>0u;)
+        {
+          ancestor = (ancestor-1u) >> 3;
+          auto iter = reference.m_bins.find(ancestor);
+          if(iter != reference.m_bins.end())
+            for(const auto& chunk : (*iter).second.m_chunks)
+              if(chunk.m_part_idx < merged_bin.m_first_part_idx)
+                merged_bin.m_loffset = std::min(merged_bin.m_loffset, chunk.m_begin);
+        }
+      }
+    //Windows with no entries get the offset of the previous window, as htslib does
+    uint64_t prev_voffset = 0ull;
+    for(auto& voffset : reference.m_linear_index)
+    {
+      if(voffset == UINT64_MAX)
+        voffset = prev_voffset;
+      prev_voffset = voffset;
+    }
+  }
+  //Write merged index
+  BGZFIndexWriter writer(output_filename+index_suffix);
+  writer.write_bytes(magic, 4u);
+  std::string names_buffer;
+  for(const auto& name : merged_names)
+  {
+    names_buffer += name;
+    names_buffer.push_back('\0');
+  }
+  auto write_tabix_conf_and_names = [&]() {
+    for(auto val : tabix_conf)
+      writer.write<int32_t>(val);
+    writer.write<int32_t>(names_buffer.length());
+    writer.write_bytes(names_buffer.c_str(), names_buffer.length());
+  };
+  if(is_tbi)
+  {
+    writer.write<int32_t>(references.size());
+    write_tabix_conf_and_names();
+  }
+  else
+  {
+    writer.write<int32_t>(min_shift);
+    writer.write<int32_t>(depth);
+    if(has_names)
+    {
+      writer.write<int32_t>(TABIX_CONF_NUM_FIELDS*sizeof(int32_t) + sizeof(int32_t) + names_buffer.length());
+      write_tabix_conf_and_names();
+    }
+    else
+      writer.write<int32_t>(0);
+    writer.write<int32_t>(references.size());
+  }
+  const uint32_t meta_bin = ((1u << (3*depth+3)) - 1u)/7u + 1u;
+  for(const auto& reference : references)
+  {
+    writer.write<int32_t>(reference.m_bins.size() + (reference.m_has_meta_bin ? 1u : 0u));
+    for(const auto& bin_iter : reference.m_bins)
+    {
+      writer.write<uint32_t>(bin_iter.first);
+      if(!is_tbi)
+        writer.write<uint64_t>(bin_iter.second.m_loffset);
+      writer.write<int32_t>(bin_iter.second.m_chunks.size());
+      for(const auto& chunk : bin_iter.second.m_chunks)
+      {
+        writer.write<uint64_t>(chunk.m_begin);
+        writer.write<uint64_t>(chunk.m_end);
+      }
+    }
+    if(reference.m_has_meta_bin)
+    {
+      writer.write<uint32_t>(meta_bin);
+      if(!is_tbi)
+        writer.write<uint64_t>(0ull);
+      writer.write<int32_t>(2);
+      writer.write<uint64_t>(reference.m_meta_begin);
+      writer.write<uint64_t>(reference.m_meta_end);
+      writer.write<uint64_t>(reference.m_num_mapped);
+      writer.write<uint64_t>(reference.m_num_unmapped);
+    }
+    if(is_tbi)
+    {
+      writer.write<int32_t>(reference.m_linear_index.size());
+      for(auto voffset : reference.m_linear_index)
+        writer.write<uint64_t>(voffset);
+    }
+  }
+  if(has_num_no_coordinate)
+    writer.write<uint64_t>(num_no_coordinate);
+  writer.close();
+}
+
+#endif //ifdef HTSDIR
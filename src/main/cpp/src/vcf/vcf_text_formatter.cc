@@ -0,0 +1,512 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "vcf_text_formatter.h"
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+static const char g_digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+//Exact doubles
+static const double g_powers_of_10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+#define MAX_EXACT_POWER_OF_10 22
+
+//Precision of %g
+#define FLOAT_NUM_SIGNIFICANT_DIGITS 6
+
+unsigned VCFTextFormatter::format_int32(char* dst, const int32_t value)
+{
+  auto* begin = dst;
+  uint32_t u = static_cast<uint32_t>(value);
+  if(value < 0)
+  {
+    *dst++ = '-';
+    u = 0u-u;
+  }
+  //Digits are generated from the right, two at a time
+  char tmp[12];
+  auto* ptr = tmp+sizeof(tmp);
+  while(u >= 100u)
+  {
+    auto idx = (u % 100u)*2u;
+    u /= 100u;
+    *--ptr = g_digit_pairs[idx+1u];
+    *--ptr = g_digit_pairs[idx];
+  }
+  if(u >= 10u)
+  {
+    *--ptr = g_digit_pairs[2u*u+1u];
+    *--ptr = g_digit_pairs[2u*u];
+  }
+  else
+    *--ptr = '0'+u;
+  auto num_digits = tmp+sizeof(tmp)-ptr;
+  memcpy(dst, ptr, num_digits);
+  return (dst-begin)+num_digits;
+}
+
+//Scales value by 10^exponent - false if the power of 10 is not an exact double
+static inline bool scale_by_power_of_10(const double value, const int exponent, double& result)
+{
+  if(exponent >= 0)
+  {
+    if(exponent > MAX_EXACT_POWER_OF_10)
+      return false;
+    result = value*g_powers_of_10[exponent];
+  }
+  else
+  {
+    if(-exponent > MAX_EXACT_POWER_OF_10)
+      return false;
+    result = value/g_powers_of_10[-exponent];
+  }
+  return true;
+}
+
+//Sign of (value*10^exponent - boundary) where result is value*10^exponent rounded to a double and
+//boundary is within 1 of result. The rounding error of a product (value*p - result) and the remainder
+//of a quotient (value - result*p) are exact doubles (fma), so the sign is exact
+static inline int compare_scaled_with_boundary(const double value, const int exponent, const double result,
+    const double boundary)
+{
+  //Exact - result and boundary are within 1 of each other and boundary is a multiple of 0.5
+  auto delta = result - boundary;
+  double diff = 0;
+  if(exponent >= 0)
+  {
+    auto power = g_powers_of_10[exponent];
+    //value*power - boundary == delta + error exactly
+    diff = delta + std::fma(value, power, -result);
+  }
+  else
+  {
+    auto power = g_powers_of_10[-exponent];
+    //value/power - boundary == (delta*power + remainder)/power
+    diff = std::fma(delta, power, std::fma(-result, power, value));
+  }
+  return (diff > 0) ? 1 : ((diff < 0) ? -1 : 0);
+}
+
+unsigned VCFTextFormatter::format_float(char* dst, const float value)
+{
+  auto d = static_cast<double>(value);
+  if(!std::isfinite(d))
+    return snprintf(dst, VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH, "%g", d);
+  auto* begin = dst;
+  if(std::signbit(d))
+  {
+    *dst++ = '-';
+    d = -d;
+  }
+  if(d == 0.0)
+  {
+    *dst++ = '0';
+    return dst-begin;
+  }
+  //Decimal exponent X such that 10^X <= d < 10^(X+1) - d*10^(5-X) is then in [10^5, 10^6)
+  int e2 = 0;
+  frexp(d, &e2);
+  auto X = static_cast<int>(floor((e2-1)*0.30102999566398120));
+  double scaled = 0;
+  for(auto i=0u;i<3u;++i)
+  {
+    if(!scale_by_power_of_10(d, FLOAT_NUM_SIGNIFICANT_DIGITS-1-X, scaled))
+      return snprintf(begin, VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH, "%g", static_cast<double>(value));
+    if(scaled < 1e5)
+      --X;
+    else if(scaled >= 1e6)
+      ++X;
+    else
+      break;
+  }
+  if(scaled < 1e5 || scaled >= 1e6)
+    return snprintf(begin, VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH, "%g", static_cast<double>(value));
+  //scaled has a single rounding - its error is below half an ulp of 2^20 (2^-33). Only if the fraction is
+  //that close to 0.5 is the rounding direction decided exactly - exact ties are rounded to even, as printf does
+  auto n = static_cast<uint32_t>(scaled);
+  auto fraction = scaled - n;
+  if(fabs(fraction-0.5) > 1.0/4294967296.0)
+  {
+    if(fraction > 0.5)
+      ++n;
+  }
+  else
+  {
+    auto cmp = compare_scaled_with_boundary(d, FLOAT_NUM_SIGNIFICANT_DIGITS-1-X, scaled, n+0.5);
+    if(cmp > 0 || (cmp == 0 && (n & 1u)))
+      ++n;
+  }
+  if(n == 1000000u)
+  {
+    n = 100000u;
+    ++X;
+  }
+  char digits[FLOAT_NUM_SIGNIFICANT_DIGITS];
+  for(auto i=FLOAT_NUM_SIGNIFICANT_DIGITS-1;i>=0;--i)
+  {
+    digits[i] = '0'+(n%10u);
+    n /= 10u;
+  }
+  //%g drops trailing zeros of the fraction
+  auto num_digits = FLOAT_NUM_SIGNIFICANT_DIGITS;
+  while(num_digits > 1 && digits[num_digits-1] == '0')
+    --num_digits;
+  if(X < -4 || X >= FLOAT_NUM_SIGNIFICANT_DIGITS)
+  {
+    //d.ddddde+XX
+    *dst++ = digits[0];
+    if(num_digits > 1)
+    {
+      *dst++ = '.';
+      memcpy(dst, digits+1, num_digits-1);
+      dst += (num_digits-1);
+    }
+    *dst++ = 'e';
+    *dst++ = (X < 0) ? '-' : '+';
+    auto abs_X = (X < 0) ? -X : X;
+    if(abs_X >= 100)
+    {
+      *dst++ = '0'+(abs_X/100);
+      abs_X %= 100;
+    }
+    *dst++ = g_digit_pairs[2*abs_X];
+    *dst++ = g_digit_pairs[2*abs_X+1];
+  }
+  else if(X >= 0)
+  {
+    memcpy(dst, digits, X+1);
+    dst += (X+1);
+    if(num_digits > X+1)
+    {
+      *dst++ = '.';
+      memcpy(dst, digits+X+1, num_digits-X-1);
+      dst += (num_digits-X-1);
+    }
+  }
+  else
+  {
+    *dst++ = '0';
+    *dst++ = '.';
+    for(auto i=0;i<-X-1;++i)
+      *dst++ = '0';
+    memcpy(dst, digits, num_digits);
+    dst += num_digits;
+  }
+  return dst-begin;
+}
+
+#ifdef HTSDIR
+
+//Writes into a std::vector<uint8_t> at an offset - callers reserve an upper bound before writing a value
+class VCFTextBuffer
+{
+  public:
+    VCFTextBuffer(std::vector<uint8_t>& buffer, const size_t offset)
+      : m_buffer(buffer), m_offset(offset)
+    { }
+    inline char* reserve(const size_t num_bytes)
+    {
+      if(m_offset+num_bytes > m_buffer.size())
+        m_buffer.resize(std::max<size_t>(2u*m_buffer.size(), m_offset+num_bytes));
+      return reinterpret_cast<char*>(&(m_buffer[m_offset]));
+    }
+    inline void advance(const char* ptr) { m_offset = ptr-reinterpret_cast<const char*>(&(m_buffer[0])); }
+    inline void put_char(const char c)
+    {
+      *reserve(1u) = c;
+      ++m_offset;
+    }
+    inline void put_string(const char* str)
+    {
+      auto length = strlen(str);
+      memcpy(reserve(length), str, length);
+      m_offset += length;
+    }
+    inline void put_int32(const int32_t value)
+    {
+      m_offset += VCFTextFormatter::format_int32(reserve(VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH), value);
+    }
+    inline void put_float(const float value)
+    {
+      m_offset += VCFTextFormatter::format_float(reserve(VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH), value);
+    }
+    size_t get_offset() const { return m_offset; }
+  private:
+    std::vector<uint8_t>& m_buffer;
+    size_t m_offset;
+};
+
+//Same as htslib's bcf_fmt_array
+template<class T>
+static inline void format_int_array(VCFTextBuffer& out, const uint8_t* data, const int n, const T missing, const T vector_end)
+{
+  auto* p = reinterpret_cast<const T*>(data);
+  auto* dst = out.reserve(static_cast<size_t>(n)*(VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH+1u));
+  for(auto j=0;j<n;++j)
+  {
+    if(p[j] == vector_end)
+      break;
+    if(j)
+      *dst++ = ',';
+    if(p[j] == missing)
+      *dst++ = '.';
+    else
+      dst += VCFTextFormatter::format_int32(dst, p[j]);
+  }
+  out.advance(dst);
+}
+
+static void format_array(VCFTextBuffer& out, const int n, const int type, const uint8_t* data)
+{
+  if(n == 0)
+  {
+    out.put_char('.');
+    return;
+  }
+  switch(type)
+  {
+    case BCF_BT_CHAR:
+      {
+        auto* p = reinterpret_cast<const char*>(data);
+        auto* dst = out.reserve(n);
+        for(auto j=0;j<n && *p;++j,++p)
+          *dst++ = (*p == bcf_str_missing) ? '.' : *p;
+        out.advance(dst);
+        break;
+      }
+    case BCF_BT_INT8:
+      format_int_array<int8_t>(out, data, n, bcf_int8_missing, bcf_int8_vector_end);
+      break;
+    case BCF_BT_INT16:
+      format_int_array<int16_t>(out, data, n, bcf_int16_missing, bcf_int16_vector_end);
+      break;
+    case BCF_BT_INT32:
+      format_int_array<int32_t>(out, data, n, bcf_int32_missing, bcf_int32_vector_end);
+      break;
+    case BCF_BT_FLOAT:
+      {
+        auto* p = reinterpret_cast<const float*>(data);
+        auto* dst = out.reserve(static_cast<size_t>(n)*(VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH+1u));
+        for(auto j=0;j<n;++j)
+        {
+          if(bcf_float_is_vector_end(p[j]))
+            break;
+          if(j)
+            *dst++ = ',';
+          if(bcf_float_is_missing(p[j]))
+            *dst++ = '.';
+          else
+            dst += VCFTextFormatter::format_float(dst, p[j]);
+        }
+        out.advance(dst);
+        break;
+      }
+    default:
+      throw VCFTextFormatterException(std::string("Unhandled BCF type ")+std::to_string(type)+" in INFO/FORMAT array");
+  }
+}
+
+//Same as htslib's bcf_format_gt
+template<class T>
+static inline void format_GT(VCFTextBuffer& out, const bcf_fmt_t* fmt, const int sample_idx, const T vector_end)
+{
+  auto* ptr = reinterpret_cast<const T*>(fmt->p + sample_idx*fmt->size);
+  auto* dst = out.reserve(static_cast<size_t>(fmt->n)*(VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH+1u)+1u);
+  auto i = 0;
+  for(;i<fmt->n && ptr[i] != vector_end;++i)
+  {
+    if(i)
+      *dst++ = "/|"[ptr[i]&1];
+    if(!(ptr[i]>>1))
+      *dst++ = '.';
+    else
+      dst += VCFTextFormatter::format_int32(dst, (ptr[i]>>1)-1);
+  }
+  if(i == 0)
+    *dst++ = '.';
+  out.advance(dst);
+}
+
+size_t VCFTextFormatter::format(const bcf_hdr_t* hdr, bcf1_t* line, std::vector<uint8_t>& buffer, size_t offset)
+{
+  bcf_unpack(line, BCF_UN_ALL);
+  VCFTextBuffer out(buffer, offset);
+  //CHROM, POS, ID
+  out.put_string(bcf_hdr_id2name(hdr, line->rid));
+  out.put_char('\t');
+  out.put_int32(line->pos+1);
+  out.put_char('\t');
+  out.put_string(line->d.id ? line->d.id : ".");
+  //REF, ALT
+  out.put_char('\t');
+  if(line->n_allele > 0)
+    out.put_string(line->d.allele[0]);
+  else
+    out.put_char('.');
+  out.put_char('\t');
+  if(line->n_allele > 1)
+    for(auto i=1;i<line->n_allele;++i)
+    {
+      if(i > 1)
+        out.put_char(',');
+      out.put_string(line->d.allele[i]);
+    }
+  else
+    out.put_char('.');
+  //QUAL
+  out.put_char('\t');
+  if(bcf_float_is_missing(line->qual))
+    out.put_char('.');
+  else
+    out.put_float(line->qual);
+  //FILTER
+  out.put_char('\t');
+  if(line->d.n_flt)
+    for(auto i=0;i<line->d.n_flt;++i)
+    {
+      if(i)
+        out.put_char(';');
+      out.put_string(bcf_hdr_int2id(hdr, BCF_DT_ID, line->d.flt[i]));
+    }
+  else
+    out.put_char('.');
+  //INFO
+  out.put_char('\t');
+  auto first = true;
+  for(auto i=0u;i<line->n_info;++i)
+  {
+    const auto* z = &(line->d.info[i]);
+    if(!z->vptr)
+      continue;
+    if(!first)
+      out.put_char(';');
+    first = false;
+    out.put_string(bcf_hdr_int2id(hdr, BCF_DT_ID, z->key));
+    if(z->len <= 0)
+      continue;
+    out.put_char('=');
+    if(z->len == 1)
+    {
+      switch(z->type)
+      {
+        case BCF_BT_INT8:
+          if(z->v1.i == bcf_int8_missing) out.put_char('.'); else out.put_int32(z->v1.i);
+          break;
+        case BCF_BT_INT16:
+          if(z->v1.i == bcf_int16_missing) out.put_char('.'); else out.put_int32(z->v1.i);
+          break;
+        case BCF_BT_INT32:
+          if(z->v1.i == bcf_int32_missing) out.put_char('.'); else out.put_int32(z->v1.i);
+          break;
+        case BCF_BT_FLOAT:
+          if(bcf_float_is_missing(z->v1.f)) out.put_char('.'); else out.put_float(z->v1.f);
+          break;
+        case BCF_BT_CHAR:
+          out.put_char(z->v1.i);
+          break;
+        default:
+          throw VCFTextFormatterException(std::string("Unhandled BCF type ")+std::to_string(z->type)+" in INFO field "
+              +bcf_hdr_int2id(hdr, BCF_DT_ID, z->key));
+      }
+    }
+    else
+      format_array(out, z->len, z->type, z->vptr);
+  }
+  if(first)
+    out.put_char('.');
+  //FORMAT and samples
+  if(line->n_sample)
+  {
+    if(line->n_fmt)
+    {
+      auto GT_idx = -1;
+      const auto* fmt = line->d.fmt;
+      first = true;
+      for(auto i=0;i<static_cast<int>(line->n_fmt);++i)
+      {
+        if(!fmt[i].p)
+          continue;
+        out.put_char(first ? '\t' : ':');
+        first = false;
+        auto* key = bcf_hdr_int2id(hdr, BCF_DT_ID, fmt[i].id);
+        out.put_string(key);
+        if(strcmp(key, "GT") == 0)
+          GT_idx = i;
+      }
+      if(first)
+        out.put_string("\t.");
+      for(auto j=0;j<static_cast<int>(line->n_sample);++j)
+      {
+        out.put_char('\t');
+        first = true;
+        for(auto i=0;i<static_cast<int>(line->n_fmt);++i)
+        {
+          const auto* f = &(fmt[i]);
+          if(!f->p)
+            continue;
+          if(!first)
+            out.put_char(':');
+          first = false;
+          if(GT_idx == i)
+            switch(f->type)
+            {
+              case BCF_BT_INT8:
+                format_GT<int8_t>(out, f, j, bcf_int8_vector_end);
+                break;
+              case BCF_BT_INT16:
+                format_GT<int16_t>(out, f, j, bcf_int16_vector_end);
+                break;
+              case BCF_BT_INT32:
+                format_GT<int32_t>(out, f, j, bcf_int32_vector_end);
+                break;
+              default:
+                throw VCFTextFormatterException(std::string("Unexpected BCF type ")+std::to_string(f->type)+" for GT");
+            }
+          else
+            format_array(out, f->n, f->type, f->p + j*f->size);
+        }
+        if(first)
+          out.put_char('.');
+      }
+    }
+    else
+      for(auto j=0;j<=static_cast<int>(line->n_sample);++j)
+        out.put_string("\t.");
+  }
+  out.put_char('\n');
+  return out.get_offset();
+}
+
+#endif //ifdef HTSDIR
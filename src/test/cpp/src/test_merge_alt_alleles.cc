@@ -0,0 +1,87 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "variant_operations.h"
+#include "gtest/gtest.h"
+
+static void merge(const std::vector<std::string>& reference_alleles, const std::vector<std::vector<std::string>>& alt_alleles,
+    const std::string& merged_reference_allele, CombineAllelesLUT& alleles_LUT,
+    std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists)
+{
+  std::vector<const std::string*> reference_allele_ptrs;
+  std::vector<const std::vector<std::string>*> alt_allele_ptrs;
+  for(auto i=0u;i<reference_alleles.size();++i)
+  {
+    reference_allele_ptrs.push_back(&(reference_alleles[i]));
+    alt_allele_ptrs.push_back(&(alt_alleles[i]));
+  }
+  VariantOperations::merge_alt_alleles(reference_allele_ptrs, alt_allele_ptrs, merged_reference_allele, alleles_LUT,
+      merged_alt_alleles, NON_REF_exists);
+}
+
+TEST(MergeAltAllelesTest, SuffixAndNonRef) {
+  CombineAllelesLUT alleles_LUT(2u);
+  std::vector<std::string> merged_alt_alleles;
+  auto NON_REF_exists = false;
+  //NON_REF as stored in the array and as spelled out by an earlier merge
+  merge({ "T", "TG" }, { { "G", TILEDB_NON_REF_VARIANT_REPRESENTATION }, { "T", g_vcf_NON_REF } }, "TG", alleles_LUT,
+      merged_alt_alleles, NON_REF_exists);
+  EXPECT_TRUE(NON_REF_exists);
+  EXPECT_EQ(std::vector<std::string>({ "GG", "T", g_vcf_NON_REF }), merged_alt_alleles);
+  EXPECT_EQ(0, alleles_LUT.get_merged_idx_for_input(0, 0));
+  EXPECT_EQ(1, alleles_LUT.get_merged_idx_for_input(0, 1));
+  EXPECT_EQ(3, alleles_LUT.get_merged_idx_for_input(0, 2));
+  EXPECT_EQ(2, alleles_LUT.get_merged_idx_for_input(1, 1));
+  EXPECT_EQ(3, alleles_LUT.get_merged_idx_for_input(1, 2));
+}
+
+//Many distinct alleles force the hash table to grow - merged list must keep first-seen order and indexes
+TEST(MergeAltAllelesTest, ManyAllelesAcrossSites) {
+  CombineAllelesLUT alleles_LUT(4u);
+  std::vector<std::string> merged_alt_alleles;
+  auto NON_REF_exists = false;
+  for(auto num_alleles : { 3u, 100u, 5u, 1000u, 2u })
+  {
+    std::vector<std::string> reference_alleles(4u, "A");
+    std::vector<std::vector<std::string>> alt_alleles(4u);
+    for(auto i=0u;i<num_alleles;++i)
+      alt_alleles[i%4u].push_back(std::string(1u+i/4u, "CGT"[i%3u]));
+    //Repeat alleles of input 0 in input 3
+    alt_alleles[3u].insert(alt_alleles[3u].end(), alt_alleles[0u].begin(), alt_alleles[0u].end());
+    merge(reference_alleles, alt_alleles, "A", alleles_LUT, merged_alt_alleles, NON_REF_exists);
+    EXPECT_FALSE(NON_REF_exists);
+    //Expected list - linear scan
+    std::vector<std::string> expected_alt_alleles;
+    for(const auto& input_alleles : alt_alleles)
+      for(const auto& allele : input_alleles)
+        if(std::find(expected_alt_alleles.begin(), expected_alt_alleles.end(), allele) == expected_alt_alleles.end())
+          expected_alt_alleles.push_back(allele);
+    ASSERT_EQ(expected_alt_alleles, merged_alt_alleles);
+    for(auto input_idx=0u;input_idx<alt_alleles.size();++input_idx)
+      for(auto j=0u;j<alt_alleles[input_idx].size();++j)
+        EXPECT_EQ(std::find(expected_alt_alleles.begin(), expected_alt_alleles.end(), alt_alleles[input_idx][j])
+            - expected_alt_alleles.begin() + 1, alleles_LUT.get_merged_idx_for_input(input_idx, j+1u));
+  }
+}
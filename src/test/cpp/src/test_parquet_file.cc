@@ -0,0 +1,195 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include "parquet_file.h"
+#include "gtest/gtest.h"
+
+class ParquetFileTest : public ::testing::Test {
+  protected:
+    virtual void SetUp()
+    {
+      m_filename = std::string("/tmp/genomicsdb_parquet_file_test_")+std::to_string(getpid())+".parquet";
+      //One column of every type and repetition
+      m_columns.emplace_back("contig", PARQUET_TYPE_BYTE_ARRAY, PARQUET_REPETITION_REQUIRED);
+      m_columns.emplace_back("pos", PARQUET_TYPE_INT64, PARQUET_REPETITION_REQUIRED);
+      m_columns.emplace_back("id", PARQUET_TYPE_BYTE_ARRAY, PARQUET_REPETITION_OPTIONAL);
+      m_columns.emplace_back("INFO.DP", PARQUET_TYPE_INT32, PARQUET_REPETITION_OPTIONAL);
+      m_columns.emplace_back("INFO.QUAL", PARQUET_TYPE_FLOAT, PARQUET_REPETITION_OPTIONAL);
+      m_columns.emplace_back("end", PARQUET_TYPE_INT64, PARQUET_REPETITION_OPTIONAL);
+      m_columns.emplace_back("FORMAT.GT", PARQUET_TYPE_BYTE_ARRAY, PARQUET_REPETITION_LIST);
+      m_columns.emplace_back("FORMAT.GQ", PARQUET_TYPE_INT32, PARQUET_REPETITION_LIST);
+    }
+    virtual void TearDown()
+    {
+      remove(m_filename.c_str());
+    }
+    //Runs longer and shorter than 8 values, nulls, empty lists and deltas of all sizes
+    void fill_row_group(const uint64_t row_group_idx, const uint64_t num_rows)
+    {
+      for(auto i=0ull;i<num_rows;++i)
+      {
+        auto row = row_group_idx*num_rows+i;
+        m_columns[0u].append_string((i < num_rows/3u) ? "1" : "chrUn_gl000220");
+        m_columns[1u].append_int64(static_cast<int64_t>(row*row*37ull)-static_cast<int64_t>(row%3u)*5000000000ll);
+        if(row%3u == 0u)
+          m_columns[2u].append_null();
+        else
+          m_columns[2u].append_string("rs"+std::to_string(row));
+        if(row%4u == 1u || (row/16u)%2u == 0u)
+          m_columns[3u].append_null();
+        else
+          m_columns[3u].append_int32(static_cast<int32_t>(row%7u)-3);
+        if(row%5u == 2u)
+          m_columns[4u].append_null();
+        else
+          m_columns[4u].append_float(0.5f*row);
+        if(row%6u == 0u)
+          m_columns[5u].append_null();
+        else
+          m_columns[5u].append_int64((row%2u) ? (INT64_MAX-row) : (INT64_MIN+row));
+        m_columns[6u].begin_list();
+        m_columns[7u].begin_list();
+        for(auto j=0ull;j<row%4u;++j)
+        {
+          if((row+j)%3u == 0u)
+            m_columns[6u].append_null();
+          else
+            m_columns[6u].append_string(((row+j)%2u) ? "0/1" : "1/1");
+          if((row+j)%5u == 0u)
+            m_columns[7u].append_null();
+          else
+            m_columns[7u].append_int32(row*j);
+        }
+      }
+    }
+    void expect_identical(const ParquetColumn& expected, const ParquetColumn& column)
+    {
+      EXPECT_EQ(expected.get_name(), column.get_name());
+      EXPECT_EQ(expected.get_type(), column.get_type());
+      EXPECT_EQ(expected.get_repetition(), column.get_repetition());
+      EXPECT_EQ(expected.get_num_rows(), column.get_num_rows());
+      ASSERT_EQ(expected.size(), column.size());
+      for(auto i=0ull;i<expected.size();++i)
+      {
+        ASSERT_EQ(expected.is_null(i), column.is_null(i)) << expected.get_name() << " entry " << i;
+        ASSERT_EQ(expected.is_list_begin(i), column.is_list_begin(i)) << expected.get_name() << " entry " << i;
+        ASSERT_EQ(expected.is_empty_list(i), column.is_empty_list(i)) << expected.get_name() << " entry " << i;
+        if(expected.is_null(i))
+          continue;
+        switch(expected.get_type())
+        {
+          case PARQUET_TYPE_INT32:
+            ASSERT_EQ(expected.get_int32(i), column.get_int32(i)) << expected.get_name() << " entry " << i;
+            break;
+          case PARQUET_TYPE_INT64:
+            ASSERT_EQ(expected.get_int64(i), column.get_int64(i)) << expected.get_name() << " entry " << i;
+            break;
+          case PARQUET_TYPE_FLOAT:
+            ASSERT_EQ(expected.get_float(i), column.get_float(i)) << expected.get_name() << " entry " << i;
+            break;
+          default:
+            ASSERT_EQ(expected.get_string(i), column.get_string(i)) << expected.get_name() << " entry " << i;
+            break;
+        }
+      }
+    }
+    std::string m_filename;
+    std::vector<ParquetColumn> m_columns;
+};
+
+TEST_F(ParquetFileTest, RoundTrip) {
+  //Row group sizes around the 8 value groups and 128 value delta blocks
+  for(auto num_rows : { 1ull, 7ull, 8ull, 9ull, 129ull, 1000ull })
+  {
+    auto num_row_groups = 3ull;
+    {
+      ParquetFileWriter writer(m_filename);
+      for(const auto& column : m_columns)
+        writer.add_column(column.get_name(), column.get_type(), column.get_repetition());
+      writer.set_key_value_metadata("samples", "HG00141\tHG01958\tHG01530");
+      for(auto i=0ull;i<num_row_groups;++i)
+      {
+        for(auto& column : m_columns)
+          column.clear();
+        fill_row_group(i, num_rows);
+        for(auto j=0u;j<m_columns.size();++j)
+          writer.get_column(j) = m_columns[j];
+        writer.write_row_group(num_rows);
+      }
+      writer.finalize();
+    }
+    ParquetFileReader reader(m_filename);
+    std::string samples;
+    ASSERT_TRUE(reader.get_key_value_metadata("samples", samples));
+    EXPECT_EQ("HG00141\tHG01958\tHG01530", samples);
+    EXPECT_FALSE(reader.get_key_value_metadata("contigs", samples));
+    EXPECT_EQ(static_cast<int64_t>(num_row_groups*num_rows), reader.get_num_rows());
+    ASSERT_EQ(num_row_groups, reader.get_num_row_groups());
+    ASSERT_EQ(m_columns.size(), reader.get_num_columns());
+    unsigned column_idx = 0u;
+    ASSERT_TRUE(reader.get_column_idx("FORMAT.GT", column_idx));
+    EXPECT_EQ(6u, column_idx);
+    ParquetColumn column;
+    for(auto i=0ull;i<num_row_groups;++i)
+    {
+      for(auto& expected : m_columns)
+        expected.clear();
+      fill_row_group(i, num_rows);
+      const auto& row_group_info = reader.get_row_group_info(i);
+      EXPECT_EQ(static_cast<int64_t>(num_rows), row_group_info.m_num_rows);
+      for(auto j=0u;j<m_columns.size();++j)
+      {
+        reader.read_column_chunk(i, j, column);
+        expect_identical(m_columns[j], column);
+      }
+      EXPECT_EQ(PARQUET_ENCODING_DELTA_BINARY_PACKED, row_group_info.m_chunks[1u].m_encoding);
+      EXPECT_EQ(PARQUET_ENCODING_PLAIN, row_group_info.m_chunks[3u].m_encoding);
+      if(num_rows >= 8u)
+      {
+        EXPECT_EQ(PARQUET_ENCODING_RLE_DICTIONARY, row_group_info.m_chunks[0u].m_encoding);
+        EXPECT_EQ(PARQUET_ENCODING_PLAIN, row_group_info.m_chunks[2u].m_encoding);
+      }
+    }
+  }
+}
+
+TEST_F(ParquetFileTest, Errors) {
+  {
+    ParquetFileWriter writer(m_filename);
+    writer.add_column(m_columns[0u].get_name(), m_columns[0u].get_type(), m_columns[0u].get_repetition());
+    writer.add_column(m_columns[2u].get_name(), m_columns[2u].get_type(), m_columns[2u].get_repetition());
+    writer.get_column(0u).append_string("1");
+    EXPECT_THROW(writer.get_column(0u).append_null(), ParquetFileException);
+    //Columns with different #rows
+    EXPECT_THROW(writer.write_row_group(1u), ParquetFileException);
+    writer.get_column(1u).append_null();
+    //Schema is fixed once a row group is written
+    writer.write_row_group(1u);
+    EXPECT_THROW(writer.add_column("pos", PARQUET_TYPE_INT64, PARQUET_REPETITION_REQUIRED), ParquetFileException);
+    //No footer
+  }
+  EXPECT_THROW(ParquetFileReader reader(m_filename), ParquetFileException);
+  EXPECT_THROW(ParquetFileReader reader(m_filename+".nonexistent"), ParquetFileException);
+}
@@ -0,0 +1,252 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <limits.h>
+#include <string.h>
+#include <random>
+#include <string>
+#include "vcf_text_formatter.h"
+#include "gtest/gtest.h"
+
+static std::string format_int32_with_printf(const int32_t value)
+{
+  char buffer[VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH];
+  snprintf(buffer, sizeof(buffer), "%d", value);
+  return buffer;
+}
+
+static std::string format_float_with_printf(const float value)
+{
+  char buffer[VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH];
+  snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+  return buffer;
+}
+
+static std::string format_int32(const int32_t value)
+{
+  char buffer[VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH];
+  auto length = VCFTextFormatter::format_int32(buffer, value);
+  return std::string(buffer, length);
+}
+
+static std::string format_float(const float value)
+{
+  char buffer[VCF_TEXT_FORMATTER_MAX_NUMBER_LENGTH];
+  auto length = VCFTextFormatter::format_float(buffer, value);
+  return std::string(buffer, length);
+}
+
+TEST(VCFTextFormatterTest, Int32MatchesPrintf) {
+  for(auto value : { 0, 1, -1, 9, 10, -10, 99, 100, 101, 999999, 1000000, -128, -32768, INT_MAX, INT_MIN, INT_MIN+1 })
+    EXPECT_EQ(format_int32_with_printf(value), format_int32(value));
+  std::mt19937 generator(0);
+  for(auto i=0;i<1000000;++i)
+  {
+    auto value = static_cast<int32_t>(generator());
+    //Small values are the common case in VCFs
+    ASSERT_EQ(format_int32_with_printf(value), format_int32(value));
+    ASSERT_EQ(format_int32_with_printf(value%1000), format_int32(value%1000));
+  }
+}
+
+TEST(VCFTextFormatterTest, FloatMatchesPrintf) {
+  //Rounding boundaries, ties, switches between fixed and exponent notation, signed zero
+  for(auto value : { 0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 0.1f, 1e-4f, 9.99999e-5f, 1e-5f, 123456.0f, 999999.0f, 999999.5f,
+      1000000.0f, 1234565.0f, 1234575.0f, 10.03125f, 10.03135f, 0.0001234565f, 3.4028235e38f, 1.1754944e-38f, 1.4e-45f,
+      60.0f, 29.97f, -2.326f, 0.693f, 1e10f, 1.5e-7f })
+    EXPECT_EQ(format_float_with_printf(value), format_float(value));
+  //Sweep of the bit patterns - covers every exponent
+  for(auto u=0ull;u<(1ull<<32);u+=9973ull)
+  {
+    auto bits = static_cast<uint32_t>(u);
+    float value = 0;
+    memcpy(&value, &bits, sizeof(float));
+    ASSERT_EQ(format_float_with_printf(value), format_float(value)) << "bits " << bits;
+  }
+  //Typical annotation values - few decimals
+  for(auto i=-100000;i<=100000;++i)
+  {
+    ASSERT_EQ(format_float_with_printf(i/100.0f), format_float(i/100.0f));
+    ASSERT_EQ(format_float_with_printf(i/1000.0f), format_float(i/1000.0f));
+    ASSERT_EQ(format_float_with_printf(i/8.0f), format_float(i/8.0f));
+  }
+}
+
+//Every float at the start of a few binades - exact and near ties of the 7th significant digit (eg 1.015625,
+//1048575) through both the scaling by multiplication (< 1e5) and by division (>= 1e6)
+TEST(VCFTextFormatterTest, FloatTiesMatchPrintf) {
+  for(auto binade_begin : { 1.0f, 1048576.0f, 1.0f/16384.0f })
+  {
+    uint32_t begin_bits = 0u;
+    memcpy(&begin_bits, &binade_begin, sizeof(float));
+    for(auto bits=begin_bits;bits<begin_bits+(1u<<20u);++bits)
+    {
+      float value = 0;
+      memcpy(&value, &bits, sizeof(float));
+      ASSERT_EQ(format_float_with_printf(value), format_float(value)) << "bits " << bits;
+    }
+  }
+}
+
+#ifdef HTSDIR
+
+class VCFTextFormatterRecordTest : public ::testing::Test {
+  protected:
+    virtual void SetUp()
+    {
+      m_hdr = bcf_hdr_init("w");
+      for(auto header_line : { "##contig=<ID=1,length=249250621>",
+          "##contig=<ID=chrUn_gl000220,length=161802>",
+          "##FILTER=<ID=q10,Description=\"Quality below 10\">",
+          "##FILTER=<ID=LowQual,Description=\"Low quality\">",
+          "##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Depth\">",
+          "##INFO=<ID=MQ,Number=1,Type=Float,Description=\"Mapping quality\">",
+          "##INFO=<ID=AC,Number=A,Type=Integer,Description=\"Allele count\">",
+          "##INFO=<ID=AF,Number=A,Type=Float,Description=\"Allele frequency\">",
+          "##INFO=<ID=DB,Number=0,Type=Flag,Description=\"dbSNP\">",
+          "##INFO=<ID=STR,Number=1,Type=String,Description=\"String\">",
+          "##INFO=<ID=C,Number=1,Type=String,Description=\"Char\">",
+          "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">",
+          "##FORMAT=<ID=AD,Number=R,Type=Integer,Description=\"Allelic depths\">",
+          "##FORMAT=<ID=PL,Number=G,Type=Integer,Description=\"Phred likelihoods\">",
+          "##FORMAT=<ID=AB,Number=1,Type=Float,Description=\"Allele balance\">",
+          "##FORMAT=<ID=FT,Number=1,Type=String,Description=\"Sample filter\">" })
+        bcf_hdr_append(m_hdr, header_line);
+      for(auto sample : { "S0", "S1", "S2" })
+        bcf_hdr_add_sample(m_hdr, sample);
+      bcf_hdr_add_sample(m_hdr, 0);
+      bcf_hdr_sync(m_hdr);
+      m_line = bcf_init();
+      m_hts_string.l = 0u;
+      m_hts_string.m = 0u;
+      m_hts_string.s = 0;
+    }
+    virtual void TearDown()
+    {
+      bcf_destroy(m_line);
+      bcf_hdr_destroy(m_hdr);
+      free(m_hts_string.s);
+    }
+    void set_site(const char* contig, const int pos, const char* id, const char* alleles)
+    {
+      bcf_clear(m_line);
+      m_line->rid = bcf_hdr_name2id(m_hdr, contig);
+      m_line->pos = pos;
+      bcf_update_id(m_hdr, m_line, id);
+      bcf_update_alleles_str(m_hdr, m_line, alleles);
+    }
+    //Formats m_line with htslib and VCFTextFormatter - the latter appending to a buffer that already has data
+    void expect_identical_output()
+    {
+      m_hts_string.l = 0u;
+      vcf_format(m_hdr, m_line, &m_hts_string);
+      std::string expected(m_hts_string.s, m_hts_string.l);
+      std::vector<uint8_t> buffer(3u, 'x');
+      auto offset = VCFTextFormatter::format(m_hdr, m_line, buffer, 3u);
+      EXPECT_EQ(expected, std::string(reinterpret_cast<const char*>(&(buffer[3])), offset-3u));
+      EXPECT_EQ(std::string("xxx"), std::string(reinterpret_cast<const char*>(&(buffer[0])), 3u));
+      //Re-use - second line appended after the first
+      auto second_offset = VCFTextFormatter::format(m_hdr, m_line, buffer, offset);
+      EXPECT_EQ(expected, std::string(reinterpret_cast<const char*>(&(buffer[offset])), second_offset-offset));
+    }
+    bcf_hdr_t* m_hdr;
+    bcf1_t* m_line;
+    kstring_t m_hts_string;
+};
+
+TEST_F(VCFTextFormatterRecordTest, SitesOnly) {
+  set_site("1", 14699, ".", "C,G");
+  bcf_float_set_missing(m_line->qual);
+  expect_identical_output();
+  set_site("chrUn_gl000220", 0, "rs123", "ACGT,A,<NON_REF>");
+  m_line->qual = 1234.56f;
+  int32_t filter_ids[] = { bcf_hdr_id2int(m_hdr, BCF_DT_ID, "q10"), bcf_hdr_id2int(m_hdr, BCF_DT_ID, "LowQual") };
+  bcf_update_filter(m_hdr, m_line, filter_ids, 2);
+  int32_t DP = 1000000;
+  bcf_update_info_int32(m_hdr, m_line, "DP", &DP, 1);
+  float MQ = 59.9999f;
+  bcf_update_info_float(m_hdr, m_line, "MQ", &MQ, 1);
+  int32_t AC[] = { 3, bcf_int32_missing };
+  bcf_update_info_int32(m_hdr, m_line, "AC", AC, 2);
+  float AF[2];
+  AF[0] = 1.5e-7f;
+  bcf_float_set_missing(AF[1]);
+  bcf_update_info_float(m_hdr, m_line, "AF", AF, 2);
+  bcf_update_info_flag(m_hdr, m_line, "DB", 0, 1);
+  bcf_update_info_string(m_hdr, m_line, "STR", "some_value");
+  bcf_update_info_string(m_hdr, m_line, "C", "Z");
+  expect_identical_output();
+}
+
+TEST_F(VCFTextFormatterRecordTest, MissingSingleValues) {
+  set_site("1", 100, ".", "A,T");
+  m_line->qual = 0.0f;
+  int32_t DP = bcf_int32_missing;
+  bcf_update_info_int32(m_hdr, m_line, "DP", &DP, 1);
+  float MQ;
+  bcf_float_set_missing(MQ);
+  bcf_update_info_float(m_hdr, m_line, "MQ", &MQ, 1);
+  expect_identical_output();
+}
+
+TEST_F(VCFTextFormatterRecordTest, Samples) {
+  //int8, int16 and int32 encodings of the FORMAT integers
+  for(auto scale : { 1, 1000, 100000 })
+  {
+    set_site("1", 999, ".", "A,C,<NON_REF>");
+    m_line->qual = 29.97f;
+    //Diploid, missing allele + phased, haploid (vector end)
+    int32_t GT[] = { bcf_gt_unphased(0), bcf_gt_unphased(1), bcf_gt_missing, bcf_gt_phased(2),
+      bcf_gt_unphased(1), bcf_int32_vector_end };
+    bcf_update_genotypes(m_hdr, m_line, GT, 6);
+    int32_t AD[] = { 10*scale, 2*scale, 0, bcf_int32_missing, bcf_int32_missing, bcf_int32_missing,
+      scale, bcf_int32_vector_end, bcf_int32_vector_end };
+    bcf_update_format_int32(m_hdr, m_line, "AD", AD, 9);
+    int32_t PL[18];
+    for(auto i=0;i<18;++i)
+      PL[i] = i*scale;
+    PL[7] = bcf_int32_missing;
+    PL[12] = bcf_int32_vector_end;
+    PL[13] = bcf_int32_vector_end;
+    PL[14] = bcf_int32_vector_end;
+    PL[15] = bcf_int32_vector_end;
+    PL[16] = bcf_int32_vector_end;
+    PL[17] = bcf_int32_vector_end;
+    bcf_update_format_int32(m_hdr, m_line, "PL", PL, 18);
+    float AB[3];
+    AB[0] = 0.333333f;
+    bcf_float_set_missing(AB[1]);
+    AB[2] = -2.5e-6f*scale;
+    bcf_update_format_float(m_hdr, m_line, "AB", AB, 3);
+    const char* FT[] = { "PASS", ".", "LowGQ" };
+    bcf_update_format_string(m_hdr, m_line, "FT", FT, 3);
+    expect_identical_output();
+  }
+}
+
+TEST_F(VCFTextFormatterRecordTest, SamplesWithoutFormatFields) {
+  set_site("1", 5, ".", "G,<NON_REF>");
+  m_line->qual = 10.0f;
+  expect_identical_output();
+}
+
+#endif //ifdef HTSDIR
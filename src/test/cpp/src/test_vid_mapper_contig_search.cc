@@ -0,0 +1,201 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "vid_mapper.h"
+#include "gtest/gtest.h"
+
+//Contig tables filled directly - lookups are checked against a linear scan over all contigs
+class ContigSearchTester : public VidMapper
+{
+  public:
+    //contigs - (offset, length) pairs in vid file order
+    ContigSearchTester(const std::vector<std::pair<int64_t, int64_t>>& contigs, const bool build_search_index)
+      : VidMapper()
+    {
+      for(auto i=0u;i<contigs.size();++i)
+      {
+        auto contig_name = std::string("contig_")+std::to_string(i);
+        auto offset = contigs[i].first;
+        auto length = contigs[i].second;
+        m_contig_name_to_idx[contig_name] = i;
+        m_contig_idx_to_info.emplace_back();
+        m_contig_idx_to_info.back().set_info(i, contig_name, length, offset);
+        m_contig_begin_2_idx.emplace_back(offset, i);
+        m_contig_end_2_idx.emplace_back(offset+length-1, i);
+      }
+      std::sort(m_contig_begin_2_idx.begin(), m_contig_begin_2_idx.end(), contig_offset_idx_pair_cmp);
+      std::sort(m_contig_end_2_idx.begin(), m_contig_end_2_idx.end(), contig_offset_idx_pair_cmp);
+      if(build_search_index)
+        build_contig_search_index();
+    }
+    //Positions at and around every contig begin and end, in the gaps, before the first and after the last contig
+    std::vector<int64_t> get_probe_positions() const
+    {
+      std::vector<int64_t> positions = { INT64_MIN, -1ll, 0ll, INT64_MAX-1 };
+      for(const auto& info : m_contig_idx_to_info)
+        for(auto delta : { -2ll, -1ll, 0ll, 1ll })
+        {
+          positions.push_back(info.m_tiledb_column_offset+delta);
+          positions.push_back(info.m_tiledb_column_offset+info.m_length+delta);
+        }
+      return positions;
+    }
+    void check_contig_location(const int64_t position) const
+    {
+      std::string expected_name;
+      auto expected_position = -1ll;
+      for(const auto& info : m_contig_idx_to_info)
+        if(position >= info.m_tiledb_column_offset && position < info.m_tiledb_column_offset+info.m_length)
+        {
+          expected_name = info.m_name;
+          expected_position = position-info.m_tiledb_column_offset;
+        }
+      std::string contig_name;
+      int64_t contig_position = -1ll;
+      auto found = get_contig_location(position, contig_name, contig_position);
+      ASSERT_EQ(!expected_name.empty(), found) << "position " << position;
+      if(found)
+      {
+        EXPECT_EQ(expected_name, contig_name) << "position " << position;
+        EXPECT_EQ(expected_position, contig_position) << "position " << position;
+      }
+    }
+    void check_next_contig_location(const int64_t position) const
+    {
+      std::string expected_name;
+      auto expected_offset = INT64_MAX;
+      for(const auto& info : m_contig_idx_to_info)
+        if(info.m_tiledb_column_offset > position && info.m_tiledb_column_offset < expected_offset)
+        {
+          expected_name = info.m_name;
+          expected_offset = info.m_tiledb_column_offset;
+        }
+      std::string next_contig_name;
+      int64_t next_contig_offset = -1ll;
+      auto found = get_next_contig_location(position, next_contig_name, next_contig_offset);
+      EXPECT_EQ(!expected_name.empty(), found) << "position " << position;
+      EXPECT_EQ(expected_name, next_contig_name) << "position " << position;
+      EXPECT_EQ(expected_offset, next_contig_offset) << "position " << position;
+    }
+    void check_contig_info() const
+    {
+      for(auto i=0u;i<m_contig_idx_to_info.size();++i)
+      {
+        ContigInfo info;
+        ASSERT_TRUE(get_contig_info(m_contig_idx_to_info[i].m_name, info));
+        EXPECT_EQ(static_cast<int>(i), info.m_contig_idx);
+        EXPECT_EQ(m_contig_idx_to_info[i].m_tiledb_column_offset, info.m_tiledb_column_offset);
+        EXPECT_EQ(m_contig_idx_to_info[i].m_length, info.m_length);
+        EXPECT_EQ(m_contig_idx_to_info[i].m_name, get_contig_info(i).m_name);
+      }
+      ContigInfo info;
+      EXPECT_FALSE(get_contig_info("no_such_contig", info));
+    }
+};
+
+//Contigs with random lengths and gaps (possibly none), listed in shuffled order in the vid file
+static std::vector<std::pair<int64_t, int64_t>> generate_contigs(const unsigned num_contigs, const int64_t first_offset,
+    std::mt19937& generator)
+{
+  std::uniform_int_distribution<int64_t> length_distribution(1ll, 20ll);
+  std::uniform_int_distribution<int64_t> gap_distribution(0ll, 3ll);
+  std::vector<std::pair<int64_t, int64_t>> contigs;
+  auto offset = first_offset;
+  for(auto i=0u;i<num_contigs;++i)
+  {
+    offset += gap_distribution(generator);
+    auto length = length_distribution(generator);
+    contigs.emplace_back(offset, length);
+    offset += length;
+  }
+  std::shuffle(contigs.begin(), contigs.end(), generator);
+  return contigs;
+}
+
+//Every tree shape up to 5 levels, with and without the Eytzinger index (std::upper_bound fallback)
+TEST(VidMapperContigSearchTest, LinearScan) {
+  std::mt19937 generator(17);
+  for(auto build_search_index : { true, false })
+    for(auto num_contigs=0u;num_contigs<=40u;++num_contigs)
+    {
+      ContigSearchTester vid_mapper(generate_contigs(num_contigs, num_contigs%3u, generator), build_search_index);
+      for(auto position : vid_mapper.get_probe_positions())
+      {
+        vid_mapper.check_contig_location(position);
+        vid_mapper.check_next_contig_location(position);
+      }
+      vid_mapper.check_contig_info();
+    }
+}
+
+//The per-thread hint from the previous lookup must not leak into lookups that move backwards or jump
+TEST(VidMapperContigSearchTest, NonMonotonicQueries) {
+  std::mt19937 generator(29);
+  for(auto build_search_index : { true, false })
+  {
+    ContigSearchTester vid_mapper(generate_contigs(25u, 5ll, generator), build_search_index);
+    auto positions = vid_mapper.get_probe_positions();
+    std::sort(positions.begin(), positions.end());
+    //Descending
+    for(auto iter=positions.rbegin();iter!=positions.rend();++iter)
+      vid_mapper.check_contig_location(*iter);
+    //Alternate between both ends
+    for(auto i=0u;i<positions.size();++i)
+    {
+      vid_mapper.check_contig_location(positions[i]);
+      vid_mapper.check_contig_location(positions[positions.size()-1u-i]);
+    }
+    //Random order
+    std::shuffle(positions.begin(), positions.end(), generator);
+    for(auto position : positions)
+      vid_mapper.check_contig_location(position);
+    //Hint left by get_tiledb_position() on a different contig
+    for(auto position : positions)
+    {
+      int64_t tiledb_position = -1ll;
+      ASSERT_TRUE(vid_mapper.get_tiledb_position(tiledb_position, "contig_0", 0ll));
+      vid_mapper.check_contig_location(position);
+    }
+  }
+}
+
+//The hint is shared by all VidMapper objects of a thread
+TEST(VidMapperContigSearchTest, HintAcrossVidMappers) {
+  std::mt19937 generator(43);
+  ContigSearchTester large_vid_mapper(generate_contigs(30u, 0ll, generator), true);
+  ContigSearchTester small_vid_mapper(generate_contigs(3u, 7ll, generator), true);
+  ContigSearchTester empty_vid_mapper(generate_contigs(0u, 0ll, generator), true);
+  auto large_positions = large_vid_mapper.get_probe_positions();
+  auto small_positions = small_vid_mapper.get_probe_positions();
+  for(auto i=0u;i<large_positions.size();++i)
+  {
+    large_vid_mapper.check_contig_location(large_positions[i]);
+    small_vid_mapper.check_contig_location(small_positions[i%small_positions.size()]);
+    large_vid_mapper.check_contig_location(small_positions[i%small_positions.size()]);
+    small_vid_mapper.check_contig_location(large_positions[i]);
+    empty_vid_mapper.check_contig_location(large_positions[i]);
+  }
+}
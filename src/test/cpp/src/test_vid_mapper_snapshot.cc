@@ -0,0 +1,125 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include "vid_mapper.h"
+#include "gtest/gtest.h"
+
+//Paths are relative to the tests directory - the working directory of the test
+#define VID_MAPPING_FILE "inputs/vid.json"
+#define CALLSET_MAPPING_FILE "inputs/callsets/t0_1_2_file_division.json"
+
+//Exposes the mapping state for comparison
+class VidMapperSnapshotTester : public FileBasedVidMapper
+{
+  public:
+    VidMapperSnapshotTester(const std::string& filename, const std::string& callset_mapping_file,
+        const int64_t lb_callset_row_idx, const int64_t ub_callset_row_idx)
+      : FileBasedVidMapper(filename, callset_mapping_file, lb_callset_row_idx, ub_callset_row_idx)
+    { }
+    void expect_identical(const VidMapperSnapshotTester& other) const
+    {
+      EXPECT_EQ(m_is_callset_mapping_initialized, other.m_is_callset_mapping_initialized);
+      EXPECT_EQ(m_max_callset_row_idx, other.m_max_callset_row_idx);
+      ASSERT_EQ(m_contig_idx_to_info.size(), other.m_contig_idx_to_info.size());
+      for(auto i=0u;i<m_contig_idx_to_info.size();++i)
+      {
+        EXPECT_EQ(m_contig_idx_to_info[i].m_name, other.m_contig_idx_to_info[i].m_name);
+        EXPECT_EQ(m_contig_idx_to_info[i].m_length, other.m_contig_idx_to_info[i].m_length);
+        EXPECT_EQ(m_contig_idx_to_info[i].m_tiledb_column_offset, other.m_contig_idx_to_info[i].m_tiledb_column_offset);
+      }
+      EXPECT_EQ(m_contig_begin_2_idx, other.m_contig_begin_2_idx);
+      EXPECT_EQ(m_contig_end_2_idx, other.m_contig_end_2_idx);
+      ASSERT_EQ(m_field_idx_to_info.size(), other.m_field_idx_to_info.size());
+      for(auto i=0u;i<m_field_idx_to_info.size();++i)
+      {
+        EXPECT_EQ(m_field_idx_to_info[i].m_name, other.m_field_idx_to_info[i].m_name);
+        EXPECT_EQ(m_field_idx_to_info[i].m_vcf_name, other.m_field_idx_to_info[i].m_vcf_name);
+        EXPECT_EQ(m_field_idx_to_info[i].m_bcf_ht_type, other.m_field_idx_to_info[i].m_bcf_ht_type);
+        EXPECT_EQ(m_field_idx_to_info[i].m_length_descriptor, other.m_field_idx_to_info[i].m_length_descriptor);
+        EXPECT_EQ(m_field_idx_to_info[i].m_num_elements, other.m_field_idx_to_info[i].m_num_elements);
+      }
+      EXPECT_EQ(m_field_name_to_idx, other.m_field_name_to_idx);
+      ASSERT_EQ(m_file_idx_to_info.size(), other.m_file_idx_to_info.size());
+      for(auto i=0u;i<m_file_idx_to_info.size();++i)
+      {
+        const auto& file_info = m_file_idx_to_info[i];
+        const auto& other_file_info = other.m_file_idx_to_info[i];
+        EXPECT_EQ(file_info.m_name, other_file_info.m_name);
+        EXPECT_EQ(file_info.m_file_idx, other_file_info.m_file_idx);
+        EXPECT_EQ(file_info.m_owner_idx, other_file_info.m_owner_idx);
+        EXPECT_EQ(file_info.m_local_file_idx, other_file_info.m_local_file_idx);
+        EXPECT_EQ(file_info.m_local_tiledb_row_idx_pairs, other_file_info.m_local_tiledb_row_idx_pairs);
+        EXPECT_EQ(file_info.m_type, other_file_info.m_type);
+      }
+      EXPECT_EQ(m_filename_to_idx, other.m_filename_to_idx);
+      EXPECT_EQ(m_owner_idx_to_file_idx_vec, other.m_owner_idx_to_file_idx_vec);
+      ASSERT_EQ(m_row_idx_to_info.size(), other.m_row_idx_to_info.size());
+      for(auto i=0u;i<m_row_idx_to_info.size();++i)
+      {
+        const auto& callset_info = m_row_idx_to_info[i];
+        const auto& other_callset_info = other.m_row_idx_to_info[i];
+        EXPECT_EQ(callset_info.m_is_initialized, other_callset_info.m_is_initialized);
+        EXPECT_EQ(callset_info.m_row_idx, other_callset_info.m_row_idx);
+        EXPECT_EQ(callset_info.m_name, other_callset_info.m_name);
+        EXPECT_EQ(callset_info.m_file_idx, other_callset_info.m_file_idx);
+        EXPECT_EQ(callset_info.m_idx_in_file, other_callset_info.m_idx_in_file);
+      }
+      EXPECT_EQ(m_callset_name_to_row_idx, other.m_callset_name_to_row_idx);
+    }
+};
+
+class VidMapperSnapshotTest : public ::testing::Test {
+  protected:
+    virtual void SetUp()
+    {
+      m_snapshot_filename = std::string("/tmp/genomicsdb_vid_mapper_snapshot_test_")+std::to_string(getpid());
+      FileBasedVidMapper json_mapper(VID_MAPPING_FILE, CALLSET_MAPPING_FILE);
+      json_mapper.write_binary_snapshot(m_snapshot_filename);
+    }
+    virtual void TearDown()
+    {
+      remove(m_snapshot_filename.c_str());
+    }
+    //Mappers loaded from JSON and from the snapshot with the same row bounds must be identical
+    void check_row_bounds(const int64_t lb_callset_row_idx, const int64_t ub_callset_row_idx)
+    {
+      VidMapperSnapshotTester json_mapper(VID_MAPPING_FILE, CALLSET_MAPPING_FILE, lb_callset_row_idx, ub_callset_row_idx);
+      VidMapperSnapshotTester snapshot_mapper(m_snapshot_filename, "", lb_callset_row_idx, ub_callset_row_idx);
+      json_mapper.expect_identical(snapshot_mapper);
+    }
+    std::string m_snapshot_filename;
+};
+
+TEST_F(VidMapperSnapshotTest, AllRows) {
+  ASSERT_TRUE(VidMapper::is_binary_snapshot(m_snapshot_filename));
+  check_row_bounds(0, INT64_MAX-1);
+}
+
+TEST_F(VidMapperSnapshotTest, RowBounds) {
+  //Files of callsets outside the bounds are dropped and the remaining files are re-numbered
+  check_row_bounds(1, 2);
+  check_row_bounds(0, 1);
+  check_row_bounds(2, 2);
+}
@@ -27,7 +27,10 @@ import hashlib
 import os
 import sys
 import shutil
+import struct
+import zlib
 from collections import OrderedDict
+from distutils.spawn import find_executable
 
 query_json_template_string="""
 {   
@@ -90,6 +93,8 @@ def create_loader_json(ws_dir, test_name, test_params_dict):
     test_dict["callset_mapping_file"] = test_params_dict['callset_mapping_file'];
     if('vid_mapping_file' in test_params_dict):
         test_dict['vid_mapping_file'] = test_params_dict['vid_mapping_file'];
+    if('loader_params' in test_params_dict):
+        test_dict.update(test_params_dict['loader_params']);
     return test_dict;
 
 def get_file_content_and_md5sum(filename):
@@ -106,11 +111,509 @@ def print_diff(golden_output, test_output):
     print(test_output);
     print("=======END=======");
 
+def read_bgzf(filename):
+    #Uncompressed data and the uncompressed offset of every BGZF block, keyed by the compressed offset
+    with open(filename, 'rb') as fptr:
+        raw = fptr.read();
+        fptr.close();
+    data = b'';
+    block_offsets = {};
+    offset = 0;
+    while(offset < len(raw)):
+        xlen = struct.unpack('<H', raw[offset+10:offset+12])[0];
+        bsize = struct.unpack('<H', raw[offset+16:offset+18])[0]; #BC subfield is the only extra field
+        block_offsets[offset] = len(data);
+        data += zlib.decompress(raw[offset+12+xlen:offset+bsize+1-8], -15);
+        offset += bsize+1;
+    return (data, block_offsets);
+
+def read_tbi(filename):
+    data, block_offsets = read_bgzf(filename);
+    if(data[0:4] != b'TBI\1'):
+        return None;
+    n_ref = struct.unpack('<i', data[4:8])[0];
+    l_nm = struct.unpack('<i', data[32:36])[0];
+    names = data[36:36+l_nm].split(b'\0')[0:n_ref];
+    offset = 36+l_nm;
+    references = {};
+    for name in names:
+        bins = {};
+        n_bin = struct.unpack('<i', data[offset:offset+4])[0];
+        offset += 4;
+        for i in range(n_bin):
+            bin_idx, n_chunk = struct.unpack('<Ii', data[offset:offset+8]);
+            offset += 8;
+            bins[bin_idx] = [ struct.unpack('<QQ', data[offset+16*j:offset+16*j+16]) for j in range(n_chunk) ];
+            offset += 16*n_chunk;
+        n_intv = struct.unpack('<i', data[offset:offset+4])[0];
+        linear_index = list(struct.unpack('<%dQ'%(n_intv), data[offset+4:offset+4+8*n_intv]));
+        offset += 4+8*n_intv;
+        references[name.decode()] = (bins, linear_index);
+    return references;
+
+def tabix_query(vcf_filename, index, contig, begin, end):
+    #Records overlapping the 0-based half open interval [begin, end) found through the index, the way htslib does
+    data, block_offsets = read_bgzf(vcf_filename);
+    if(contig not in index):
+        return [];
+    bins, linear_index = index[contig];
+    min_offset = 0;
+    if(len(linear_index) > 0):
+        min_offset = linear_index[min(begin >> 14, len(linear_index)-1)];
+    query_bins = [ 0 ];
+    for shift, bin_offset in [ (26, 1), (23, 9), (20, 73), (17, 585), (14, 4681) ]:
+        query_bins.extend(range(bin_offset+(begin >> shift), bin_offset+((end-1) >> shift)+1));
+    to_uncompressed_offset = lambda voffset : block_offsets[voffset >> 16] + (voffset & 0xffff);
+    records = {};
+    for bin_idx in query_bins:
+        for chunk_begin, chunk_end in bins.get(bin_idx, []):
+            if(chunk_end <= min_offset):
+                continue;
+            offset = to_uncompressed_offset(chunk_begin);
+            while(offset < to_uncompressed_offset(chunk_end)):
+                line_end = data.index(b'\n', offset);
+                line = data[offset:line_end].decode();
+                fields = line.split('\t');
+                record_begin = int(fields[1])-1;
+                record_end = record_begin+len(fields[3]);
+                for info in fields[7].split(';'):
+                    if(info.startswith('END=')):
+                        record_end = int(info[4:]);
+                if(fields[0] == contig and record_begin < end and record_end > begin):
+                    records[offset] = line;
+                offset = line_end+1;
+    return [ records[offset] for offset in sorted(records.keys()) ];
+
 def cleanup_and_exit(tmpdir, exit_code):
     if(exit_code == 0):
         shutil.rmtree(tmpdir, ignore_errors=True)
     sys.exit(exit_code);
 
+#Combined gVCFs of consecutive column ranges concatenated by concatenate_vcf_parts must be identical to the
+#combined gVCF of the whole range and the merged tabix index must return the same records for every region
+def test_concatenate_vcf_parts(exe_path, ws_dir, tmpdir, segment_size):
+    test_name = 'concatenate_vcf_parts';
+    single_filename = tmpdir+os.path.sep+test_name+'_single.vcf.gz';
+    part_filenames = [ tmpdir+os.path.sep+test_name+'_part_%d.vcf.gz'%(i) for i in range(2) ];
+    concatenated_filename = tmpdir+os.path.sep+test_name+'.vcf.gz';
+    query_dict = create_query_json(ws_dir, 't0_1_2', { "query_column_ranges" : [0, 1000000000],
+        "vid_mapping_file": "inputs/vid.json", "callset_mapping_file": "inputs/callsets/t0_1_2.json",
+        "query_attributes": vcf_query_attributes_order });
+    query_dict['vcf_header_filename'] = 'inputs/template_vcf_header.vcf';
+    query_dict['vcf_output_format'] = 'z';
+    query_dict['index_output_VCF'] = True;
+    single_query_dict = dict(query_dict);
+    single_query_dict['vcf_output_filename'] = single_filename;
+    #No interval in t0, t1 or t2 spans position 17000 - the parts hold exactly the records of the single file
+    parts_query_dict = dict(query_dict);
+    parts_query_dict['query_column_ranges'] = [ [ [0, 16999] ], [ [17000, 1000000000] ] ];
+    parts_query_dict['vcf_output_filename'] = part_filenames;
+    for query_name, test_query_dict, ranks in [ ('single', single_query_dict, [0]), ('parts', parts_query_dict, [0, 1]) ]:
+        query_json_filename = tmpdir+os.path.sep+test_name+'_'+query_name+'.json';
+        with open(query_json_filename, 'wb') as fptr:
+            json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+            fptr.close();
+        for rank in ranks:
+            retcode = subprocess.call((exe_path+os.path.sep+'gt_mpi_gather -s %d -r %d -j '+query_json_filename
+                +' --produce-Broad-GVCF')%(segment_size, rank), shell=True);
+            if(retcode != 0):
+                sys.stderr.write('Query test: '+test_name+'-'+query_name+' failed for rank %d\n'%(rank));
+                cleanup_and_exit(tmpdir, -1);
+    retcode = subprocess.call(exe_path+os.path.sep+'concatenate_vcf_parts -o '+concatenated_filename+' '
+            +' '.join(part_filenames), shell=True);
+    if(retcode != 0):
+        sys.stderr.write('Test '+test_name+' failed\n');
+        cleanup_and_exit(tmpdir, -1);
+    single_data = read_bgzf(single_filename)[0];
+    concatenated_data = read_bgzf(concatenated_filename)[0];
+    if(single_data != concatenated_data):
+        sys.stderr.write('Mismatch in test: '+test_name+'\n');
+        print_diff(single_data, concatenated_data);
+        cleanup_and_exit(tmpdir, -1);
+    single_index = read_tbi(single_filename+'.tbi');
+    concatenated_index = read_tbi(concatenated_filename+'.tbi');
+    num_records = len([ line for line in single_data.decode().split('\n') if line and line[0] != '#' ]);
+    for contig, begin, end in [ ('1', 0, 1 << 29), ('1', 12000, 13000), ('1', 12290, 17390), ('1', 16000, 17000),
+            ('1', 17000, 18000), ('2', 0, 1 << 29) ]:
+        single_records = tabix_query(single_filename, single_index, contig, begin, end);
+        concatenated_records = tabix_query(concatenated_filename, concatenated_index, contig, begin, end);
+        if(single_records != concatenated_records or (end-begin == (1 << 29) and contig == '1'
+            and len(single_records) != num_records)):
+            sys.stderr.write('Mismatch in test: '+test_name+' for index query %s:%d-%d\n'%(contig, begin+1, end));
+            print_diff('\n'.join(single_records), '\n'.join(concatenated_records));
+            cleanup_and_exit(tmpdir, -1);
+
+def get_mpirun_env():
+    mpi_env = dict(os.environ);
+    mpi_env.update({ 'OMPI_ALLOW_RUN_AS_ROOT': '1', 'OMPI_ALLOW_RUN_AS_ROOT_CONFIRM': '1',
+        'OMPI_MCA_rmaps_base_oversubscribe': '1' });
+    return mpi_env;
+
+#Variants queried on rank 1 reach the root only through the compact serialization - the root prints them
+#and must reproduce the golden outputs. Needs an MPI launcher, skipped if mpirun is not available
+def test_compact_serialization_round_trip(exe_path, ws_dir, tmpdir, segment_size):
+    test_name = 'compact_serialization_round_trip';
+    if(find_executable('mpirun') is None):
+        sys.stderr.write('mpirun not found, skipping test '+test_name+'\n');
+        return;
+    mpi_env = get_mpirun_env();
+    for array_name, query_param_dict, golden_output in [
+            ('t0_1_2', { "query_column_ranges" : [0, 1000000000], "vid_mapping_file": "inputs/vid.json",
+                "callset_mapping_file": "inputs/callsets/t0_1_2.json" }, 'golden_outputs/t0_1_2_variants_at_0'),
+            ('t0_1_2', { "query_column_ranges" : [12150, 1000000000], "vid_mapping_file": "inputs/vid.json",
+                "callset_mapping_file": "inputs/callsets/t0_1_2.json" }, 'golden_outputs/t0_1_2_variants_at_12150'),
+            ('test_flag_field', { "query_column_ranges" : [0, 1000000000], "vid_mapping_file": "inputs/vid_DS_ID.json",
+                "callset_mapping_file": "inputs/callsets/t0_1_2.json", "query_attributes": query_attributes_with_DS_ID },
+                'golden_outputs/t0_1_2_DS_ID_variants_at_0') ]:
+        test_query_dict = create_query_json(ws_dir, array_name, query_param_dict);
+        query_json_filename = tmpdir+os.path.sep+test_name+'.json';
+        with open(query_json_filename, 'wb') as fptr:
+            json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+            fptr.close();
+        golden_stdout, golden_md5sum = get_file_content_and_md5sum(golden_output);
+        for cmd_line_param in [ '', '--streaming-chunk-size 256 --streaming-page-size 2' ]:
+            pid = subprocess.Popen(('mpirun -np 2 '+exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename
+                +' --skip-query-on-root '+cmd_line_param)%(segment_size), shell=True, stdout=subprocess.PIPE, env=mpi_env);
+            stdout_string = pid.communicate()[0]
+            if(pid.returncode != 0):
+                sys.stderr.write('Query test: '+test_name+' failed for '+golden_output+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            if(golden_md5sum != str(hashlib.md5(stdout_string).hexdigest())):
+                sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_output+' '+cmd_line_param+'\n');
+                print_diff(golden_stdout, stdout_string);
+                cleanup_and_exit(tmpdir, -1);
+
+#Combined gVCF of the rows of all ranks merged at the root (--combine-row-partitions) must be identical to the
+#combined gVCF produced by a single process querying all the rows. Needs an MPI launcher
+def test_combine_row_partitions(exe_path, ws_dir, tmpdir, segment_size):
+    test_name = 'combine_row_partitions';
+    if(find_executable('mpirun') is None):
+        sys.stderr.write('mpirun not found, skipping test '+test_name+'\n');
+        return;
+    mpi_env = get_mpirun_env();
+    query_dict = create_query_json(ws_dir, 't0_1_2', { "query_column_ranges" : [0, 1000000000],
+        "vid_mapping_file": "inputs/vid.json", "callset_mapping_file": "inputs/callsets/t0_1_2.json",
+        "query_attributes": vcf_query_attributes_order });
+    query_dict['vcf_header_filename'] = 'inputs/template_vcf_header.vcf';
+    query_json_filename = tmpdir+os.path.sep+test_name+'.json';
+    with open(query_json_filename, 'wb') as fptr:
+        json.dump(query_dict, fptr, indent=4, separators=(',', ': '));
+        fptr.close();
+    pid = subprocess.Popen((exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename+' --produce-Broad-GVCF')
+            %(segment_size), shell=True, stdout=subprocess.PIPE);
+    expected_stdout = pid.communicate()[0];
+    if(pid.returncode != 0 or len(expected_stdout) == 0):
+        sys.stderr.write('Query test: '+test_name+' failed for the unpartitioned combine\n');
+        cleanup_and_exit(tmpdir, -1);
+    for num_processes, query_row_ranges, cmd_line_param in [
+            (2, [ [ [0, 0] ], [ [1, 2] ] ], ''),
+            (3, [ [ [0, 0] ], [ [1, 1] ], [ [2, 2] ] ], ''),
+            (3, [ [ [0, 0] ], [ [0, 1] ], [ [2, 2] ] ], '--skip-query-on-root') ]:
+        query_dict['query_row_ranges'] = query_row_ranges;
+        query_dict['query_column_ranges'] = [ query_dict['query_column_ranges'][0] ] * num_processes;
+        with open(query_json_filename, 'wb') as fptr:
+            json.dump(query_dict, fptr, indent=4, separators=(',', ': '));
+            fptr.close();
+        pid = subprocess.Popen(('mpirun -np %d '+exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename
+            +' --produce-Broad-GVCF --combine-row-partitions '+cmd_line_param)%(num_processes, segment_size), shell=True,
+            stdout=subprocess.PIPE, env=mpi_env);
+        stdout_string = pid.communicate()[0];
+        if(pid.returncode != 0):
+            sys.stderr.write('Query test: '+test_name+' failed for row ranges '+str(query_row_ranges)+'\n');
+            cleanup_and_exit(tmpdir, -1);
+        if(expected_stdout != stdout_string):
+            sys.stderr.write('Mismatch in query test: '+test_name+' for row ranges '+str(query_row_ranges)+'\n');
+            print_diff(expected_stdout, stdout_string);
+            cleanup_and_exit(tmpdir, -1);
+
+#Histogram estimated from the tabix indexes must be identical to the histogram of the full scan when every bin
+#is counted exactly, and must preserve the total count when it is estimated from the index record counts
+def test_histogram_from_index(exe_path, ws_dir, tmpdir):
+    test_name = 'histogram_from_index';
+    histogram_dict = create_loader_json(ws_dir, test_name, { 'callset_mapping_file': 'inputs/callsets/t0_1_2.json',
+        'loader_params': { 'produce_combined_vcf': False, 'produce_tiledb_array': False } });
+    #Both contigs of vid.json within the range, 10000 columns per bin
+    histogram_dict['max_histogram_range'] = 500000000;
+    histogram_dict['num_bins'] = 50000;
+    histogram_outputs = {};
+    for mode, mode_params in [ ('full_scan', { 'histogram_from_index': False }),
+            ('index_all_bins_sampled', { 'histogram_from_index': True, 'histogram_num_bins_to_sample': 100000 }),
+            ('index_estimate', { 'histogram_from_index': True, 'histogram_num_bins_to_sample': 0 }) ]:
+        histogram_dict.update(mode_params);
+        histogram_json_filename = tmpdir+os.path.sep+test_name+'_'+mode+'.json';
+        with open(histogram_json_filename, 'wb') as fptr:
+            json.dump(histogram_dict, fptr, indent=4, separators=(',', ': '));
+            fptr.close();
+        pid = subprocess.Popen(exe_path+os.path.sep+'vcf_histogram '+histogram_json_filename, shell=True,
+                stdout=subprocess.PIPE);
+        histogram_outputs[mode] = pid.communicate()[0];
+        if(pid.returncode != 0):
+            sys.stderr.write('Test '+test_name+' failed for mode '+mode+'\n');
+            cleanup_and_exit(tmpdir, -1);
+    if(histogram_outputs['full_scan'] != histogram_outputs['index_all_bins_sampled']):
+        sys.stderr.write('Mismatch in test: '+test_name+' between full scan and index with all bins sampled\n');
+        print_diff(histogram_outputs['full_scan'], histogram_outputs['index_all_bins_sampled']);
+        cleanup_and_exit(tmpdir, -1);
+    #Bins are lines lo,hi,count
+    totals = [ sum([ int(line.split(',')[2]) for line in histogram_outputs[mode].split('\n') if line.count(',') == 2 ])
+            for mode in [ 'full_scan', 'index_estimate' ] ];
+    #Per bin counts are rounded, allow a small deviation in the total
+    if(totals[0] == 0 or abs(totals[0]-totals[1]) > 0.05*totals[0]):
+        sys.stderr.write('Mismatch in test: '+test_name+' totals of full scan %d and index estimate %d\n'%(totals[0], totals[1]));
+        cleanup_and_exit(tmpdir, -1);
+
+#Comparison split into shards must report exactly what the single pass comparison reports - REF blocks split
+#differently in the two files cross shard boundaries and lines present in one file only end shards early
+def test_vcfdiff_shards(exe_path, tmpdir):
+    test_name = 'vcfdiff_shards';
+    for gold_filename, test_filename, regions in [
+            ('inputs/vcfs/ref_blocks_contig_boundary_merged.vcf.gz', 'inputs/vcfs/ref_blocks_contig_boundary.vcf.gz',
+                '1:249248001-249250621,2:1-2000'),
+            ('inputs/vcfs/t0.vcf.gz', 'inputs/vcfs/t0_overlapping.vcf.gz', '1:12000-18000'),
+            ('inputs/vcfs/t0.vcf.gz', 'inputs/vcfs/info_op0.vcf.gz', '1:12000-18000'),
+            ('inputs/vcfs/t0.vcf.gz', 'inputs/vcfs/t0_prequantized.vcf.gz', '1:12000-18000') ]:
+        outputs = [];
+        for cmd_line_param in [ '', '-j 2', '-j 1 -s 100', '-j 4 -s 100', '-j 3 -s 1000' ]:
+            pid = subprocess.Popen(exe_path+os.path.sep+'vcfdiff -r '+regions+' '+cmd_line_param+' '+gold_filename+' '
+                    +test_filename, shell=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE);
+            stdout_string, stderr_string = pid.communicate();
+            if(pid.returncode != 0):
+                sys.stderr.write('Test '+test_name+' failed for '+gold_filename+' '+test_filename+' '+cmd_line_param+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            outputs.append((cmd_line_param, stdout_string, stderr_string));
+        for cmd_line_param, stdout_string, stderr_string in outputs[1:]:
+            if(stdout_string != outputs[0][1] or stderr_string != outputs[0][2]):
+                sys.stderr.write('Mismatch in test: '+test_name+' for '+gold_filename+' '+test_filename+' between the single pass and '
+                        +cmd_line_param+'\n');
+                print_diff(outputs[0][1]+outputs[0][2], stdout_string+stderr_string);
+                cleanup_and_exit(tmpdir, -1);
+
+#Genotype matrix of t0_1_2 must match the golden PLINK and dosage files byte for byte - the site with ALT alleles
+#A,T,<NON_REF> exports A and T only. PLINK variants have a single A1 allele so alt-count with plink must fail
+def test_genotype_matrix_export(exe_path, ws_dir, tmpdir, segment_size):
+    test_name = 'genotype_matrix_export';
+    query_dict = create_query_json(ws_dir, 't0_1_2', { "query_column_ranges" : [0, 1000000000],
+        "vid_mapping_file": "inputs/vid.json", "callset_mapping_file": "inputs/callsets/t0_1_2.json" });
+    query_json_filename = tmpdir+os.path.sep+test_name+'.json';
+    with open(query_json_filename, 'wb') as fptr:
+        json.dump(query_dict, fptr, indent=4, separators=(',', ': '));
+        fptr.close();
+    for cmd_line_param, golden_prefix, extensions in [
+            ('--genotype-matrix-format plink', 'golden_outputs/t0_1_2_genotype_matrix', [ '.fam', '.bim', '.bed' ]),
+            ('--genotype-matrix-format dosage --num-threads 2', 'golden_outputs/t0_1_2_genotype_matrix',
+                [ '.fam', '.bim', '.dosage' ]),
+            ('--genotype-matrix-format dosage --multiallelic alt-count', 'golden_outputs/t0_1_2_genotype_matrix_alt_count',
+                [ '.bim', '.dosage' ]) ]:
+        output_prefix = tmpdir+os.path.sep+test_name;
+        retcode = subprocess.call((exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename
+            +' --export-genotype-matrix '+output_prefix+' '+cmd_line_param)%(segment_size), shell=True);
+        if(retcode != 0):
+            sys.stderr.write('Query test: '+test_name+' failed for '+cmd_line_param+'\n');
+            cleanup_and_exit(tmpdir, -1);
+        for extension in extensions:
+            golden_content, golden_md5sum = get_file_content_and_md5sum(golden_prefix+extension);
+            test_content, test_md5sum = get_file_content_and_md5sum(output_prefix+extension);
+            if(golden_md5sum != test_md5sum):
+                sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_prefix+extension+' '+cmd_line_param+'\n');
+                print_diff(golden_content, test_content);
+                cleanup_and_exit(tmpdir, -1);
+    retcode = subprocess.call((exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename
+        +' --export-genotype-matrix '+tmpdir+os.path.sep+test_name+'_invalid --genotype-matrix-format plink'
+        +' --multiallelic alt-count')%(segment_size), shell=True, stderr=subprocess.PIPE);
+    if(retcode == 0):
+        sys.stderr.write('Query test: '+test_name+' must reject --multiallelic alt-count with the plink format\n');
+        cleanup_and_exit(tmpdir, -1);
+
+#VCF text written by VCFTextFormatter must match the golden combined gVCFs for every output path - plain text
+#file, BGZF compressed file and the serialized buffer (-p) printed to stdout
+def test_vcf_text_output(exe_path, ws_dir, tmpdir, segment_size):
+    test_name = 'vcf_text_output';
+    for array_name, query_column_range, golden_output in [
+            ('t0_1_2', [0, 1000000000], 'golden_outputs/t0_1_2_vcf_at_0'),
+            ('t0_1_2', [12150, 1000000000], 'golden_outputs/t0_1_2_vcf_at_12150'),
+            ('t6_7_8', [0, 1000000000], 'golden_outputs/t6_7_8_vcf_at_0'),
+            ('t6_7_8', [8029500, 1000000000], 'golden_outputs/t6_7_8_vcf_at_8029500') ]:
+        golden_content, golden_md5sum = get_file_content_and_md5sum(golden_output);
+        query_dict = create_query_json(ws_dir, array_name, { "query_column_ranges" : query_column_range,
+            "vid_mapping_file": "inputs/vid.json", "callset_mapping_file": "inputs/callsets/"+array_name+".json",
+            "query_attributes": vcf_query_attributes_order });
+        for output_format, cmd_line_param in [ ('', ''), ('z', ''), ('', '-p 128') ]:
+            test_query_dict = dict(query_dict);
+            output_filename = None;
+            if(cmd_line_param == ''):
+                output_filename = tmpdir+os.path.sep+test_name+('.vcf.gz' if output_format == 'z' else '.vcf');
+                test_query_dict['vcf_output_filename'] = output_filename;
+                test_query_dict['vcf_output_format'] = output_format;
+            query_json_filename = tmpdir+os.path.sep+test_name+'.json';
+            with open(query_json_filename, 'wb') as fptr:
+                json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+                fptr.close();
+            pid = subprocess.Popen((exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename
+                +' --produce-Broad-GVCF '+cmd_line_param)%(segment_size), shell=True, stdout=subprocess.PIPE);
+            test_content = pid.communicate()[0];
+            if(pid.returncode != 0):
+                sys.stderr.write('Query test: '+test_name+' failed for '+golden_output+' format "'+output_format+'" '
+                        +cmd_line_param+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            if(output_filename):
+                if(output_format == 'z'):
+                    test_content = read_bgzf(output_filename)[0];
+                else:
+                    test_content = get_file_content_and_md5sum(output_filename)[0];
+            if(golden_md5sum != str(hashlib.md5(test_content).hexdigest())):
+                sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_output+' format "'+output_format+'" '
+                        +cmd_line_param+'\n');
+                print_diff(golden_content, test_content);
+                cleanup_and_exit(tmpdir, -1);
+
+#Parquet files written by --export-columnar are read back with pyarrow. The sites must match the golden combined
+#gVCFs (same scan) and every call of the long layout must match its element in the nested layout
+def test_columnar_export(exe_path, ws_dir, tmpdir, segment_size):
+    test_name = 'columnar_export';
+    try:
+        import pyarrow.parquet;
+    except ImportError:
+        sys.stderr.write('pyarrow not found, skipping test '+test_name+'\n');
+        return;
+    for array_name, query_column_range, golden_output in [
+            ('t0_1_2', [0, 1000000000], 'golden_outputs/t0_1_2_vcf_at_0'),
+            ('t0_1_2', [12150, 1000000000], 'golden_outputs/t0_1_2_vcf_at_12150'),
+            ('t6_7_8', [0, 1000000000], 'golden_outputs/t6_7_8_vcf_at_0'),
+            ('t6_7_8', [8029500, 1000000000], 'golden_outputs/t6_7_8_vcf_at_8029500') ]:
+        #contig, pos, end, ref, alt of every golden record
+        golden_samples = [];
+        golden_sites = [];
+        for line in get_file_content_and_md5sum(golden_output)[0].decode('utf-8').splitlines():
+            if(line.startswith('#CHROM')):
+                golden_samples = line.split('\t')[9:];
+            elif(not line.startswith('#')):
+                fields = line.split('\t');
+                end = int(fields[1]);
+                for INFO_entry in fields[7].split(';'):
+                    if(INFO_entry.startswith('END=')):
+                        end = int(INFO_entry[4:]);
+                golden_sites.append((fields[0], int(fields[1]), end, fields[3], fields[4]));
+        query_dict = create_query_json(ws_dir, array_name, { "query_column_ranges" : query_column_range,
+            "vid_mapping_file": "inputs/vid.json", "callset_mapping_file": "inputs/callsets/"+array_name+".json",
+            "query_attributes": vcf_query_attributes_order });
+        query_json_filename = tmpdir+os.path.sep+test_name+'.json';
+        with open(query_json_filename, 'wb') as fptr:
+            json.dump(query_dict, fptr, indent=4, separators=(',', ': '));
+            fptr.close();
+        tables = {};
+        for layout in [ 'nested', 'long' ]:
+            output_filename = tmpdir+os.path.sep+test_name+'_'+layout+'.parquet';
+            #Small row groups - sites span several row groups
+            retcode = subprocess.call((exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename
+                +' --export-columnar '+output_filename+' --columnar-layout '+layout+' --columnar-row-group-size 4')
+                %(segment_size), shell=True);
+            if(retcode != 0):
+                sys.stderr.write('Query test: '+test_name+' failed for '+golden_output+' layout '+layout+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            parquet_file = pyarrow.parquet.ParquetFile(output_filename);
+            samples = parquet_file.metadata.metadata[b'samples'].decode('utf-8').split('\t');
+            if(samples != golden_samples):
+                sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_output+' layout '+layout
+                        +' samples '+str(samples)+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            tables[layout] = parquet_file.read().to_pydict();
+        nested = tables['nested'];
+        long_table = tables['long'];
+        #REF is replaced by the reference base in the gVCF when it is N
+        sites = [ (nested['contig'][i], nested['pos'][i], nested['end'][i],
+            golden_sites[i][3] if(nested['ref'][i] == 'N' and i < len(golden_sites)) else nested['ref'][i],
+            nested['alt'][i] if(nested['alt'][i] is not None) else '.') for i in range(len(nested['pos'])) ];
+        if(sites != golden_sites):
+            sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_output+' sites\n');
+            print_diff('\n'.join([ str(site) for site in golden_sites ]), '\n'.join([ str(site) for site in sites ]));
+            cleanup_and_exit(tmpdir, -1);
+        site_columns = [ name for name in nested if not name.startswith('FORMAT.') ];
+        call_columns = [ name for name in nested if name.startswith('FORMAT.') ];
+        if(sorted(long_table.keys()) != sorted(site_columns+call_columns+[ 'site_idx', 'sample' ])):
+            sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_output+' long layout columns '
+                    +str(sorted(long_table.keys()))+'\n');
+            cleanup_and_exit(tmpdir, -1);
+        for i in range(len(long_table['site_idx'])):
+            site_idx = long_table['site_idx'][i];
+            sample_idx = golden_samples.index(long_table['sample'][i]);
+            for name in site_columns:
+                if(long_table[name][i] != nested[name][site_idx]):
+                    sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_output+' long layout row '
+                            +str(i)+' column '+name+'\n');
+                    cleanup_and_exit(tmpdir, -1);
+            for name in call_columns:
+                if(len(nested[name][site_idx]) != len(golden_samples)
+                        or long_table[name][i] != nested[name][site_idx][sample_idx]):
+                    sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_output+' long layout row '
+                            +str(i)+' column '+name+'\n');
+                    cleanup_and_exit(tmpdir, -1);
+        #Samples without a call at a site have no row in the long layout
+        num_nested_GTs = sum([ len([ GT for GT in site_GTs if GT is not None ]) for site_GTs in nested['FORMAT.GT'] ]);
+        num_long_GTs = len([ GT for GT in long_table['FORMAT.GT'] if GT is not None ]);
+        if(num_nested_GTs != num_long_GTs):
+            sys.stderr.write('Mismatch in query test: '+test_name+' for '+golden_output+' number of GTs nested '
+                    +str(num_nested_GTs)+' long '+str(num_long_GTs)+'\n');
+            cleanup_and_exit(tmpdir, -1);
+
+#gt_local_gather forks one worker per partition and must print exactly what gt_mpi_gather prints for the
+#same query JSON. Worker results of range queries reach the parent through the compact serialization
+def test_local_gather(exe_path, ws_dir, tmpdir, segment_size):
+    test_name = 'local_gather';
+    query_types_list = [
+            ('calls', '--print-calls', '--print-calls'),
+            ('variants', '', ''),
+            ('paged_variants', '', '-p 2'),
+            ('vcf', '--produce-Broad-GVCF', '--produce-Broad-GVCF'),
+            ('batched_vcf', '--produce-Broad-GVCF -p 128', '--produce-Broad-GVCF -p 128'),
+            ];
+    runs = [];
+    for array_name in [ 't0_1_2', 't6_7_8' ]:
+        for query_column_ranges in [ [ [0, 1000000000] ], [ [12150, 1000000000] ] ]:
+            runs.append((array_name, query_column_ranges, 1));
+    #Two partitions - needs an MPI launcher for the reference output
+    if(find_executable('mpirun') is not None):
+        runs.append(('t0_1_2', [ [ [0, 12149] ], [ [12150, 1000000000] ] ], 2));
+    else:
+        sys.stderr.write('mpirun not found, skipping multi-partition case of test '+test_name+'\n');
+    mpi_env = get_mpirun_env();
+    for array_name, query_column_ranges, num_partitions in runs:
+        for query_type, mpi_gather_param, local_gather_param in query_types_list:
+            #Ranks of gt_mpi_gather print calls and GVCFs in no fixed order - only range query results are gathered
+            if(num_partitions > 1 and query_type.find('variants') == -1):
+                continue;
+            #No loader JSON - partition i of the query JSON is queried by rank/worker i
+            test_query_dict = create_query_json(ws_dir, array_name, { "query_column_ranges": [0, 0],
+                "vid_mapping_file": "inputs/vid.json", "callset_mapping_file": "inputs/callsets/"+array_name+".json" });
+            if(num_partitions == 1):
+                test_query_dict["query_column_ranges"] = [ query_column_ranges ];
+            else:
+                test_query_dict["query_column_ranges"] = query_column_ranges;
+                test_query_dict["query_row_ranges"] = test_query_dict["query_row_ranges"]*num_partitions;
+            if(query_type.find('vcf') != -1):
+                test_query_dict['query_attributes'] = vcf_query_attributes_order;
+            query_json_filename = tmpdir+os.path.sep+test_name+'.json';
+            with open(query_json_filename, 'wb') as fptr:
+                json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+                fptr.close();
+            mpi_launcher = 'mpirun -np %d '%(num_partitions) if(num_partitions > 1) else '';
+            pid = subprocess.Popen((mpi_launcher+exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename
+                +' '+mpi_gather_param)%(segment_size), shell=True, stdout=subprocess.PIPE, env=mpi_env);
+            expected_stdout = pid.communicate()[0];
+            if(pid.returncode != 0):
+                sys.stderr.write('Query test: '+test_name+'-'+array_name+'-'+query_type+' failed for gt_mpi_gather\n');
+                cleanup_and_exit(tmpdir, -1);
+            pid = subprocess.Popen((exe_path+os.path.sep+'gt_local_gather -n %d -s %d -j '+query_json_filename
+                +' '+local_gather_param)%(num_partitions, segment_size), shell=True, stdout=subprocess.PIPE);
+            stdout_string = pid.communicate()[0];
+            if(pid.returncode != 0):
+                sys.stderr.write('Query test: '+test_name+'-'+array_name+'-'+query_type+' failed\n');
+                cleanup_and_exit(tmpdir, -1);
+            if(expected_stdout != stdout_string):
+                sys.stderr.write('Mismatch in query test: '+test_name+'-'+array_name+'-'+query_type
+                        +' and gt_mpi_gather for column ranges '+str(query_column_ranges)+'\n');
+                print_diff(expected_stdout, stdout_string);
+                cleanup_and_exit(tmpdir, -1);
+
 def main():
     #lcov gcda directory prefix
     gcda_prefix_dir = '../';
@@ -353,7 +856,91 @@ def main():
                 'callset_mapping_file': 'inputs/callsets/t0_1_2_as_array.json',
                 "vid_mapping_file": "inputs/vid_as_array.json",
             },
+            #END copies of intervals carry only co-ordinates - queries starting inside an interval fetch the
+            #begin cell
+            { "name" : "t0_1_2_lightweight_end_copies", 'golden_output' : 'golden_outputs/t0_1_2_loading',
+                'callset_mapping_file': 'inputs/callsets/t0_1_2.json',
+                'loader_params': { "lightweight_end_copies": True },
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_0",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_0",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_0",
+                        } },
+                    { "query_column_ranges" : [12150, 1000000000], "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_12150",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_12150",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_12150",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_12150",
+                        } }
+                    ]
+            },
+            #REF and ALT stored as codes into per-array dictionaries - queries see the strings
+            { "name" : "t0_1_2_dictionary_encoded", 'golden_output' : 'golden_outputs/t0_1_2_loading',
+                'callset_mapping_file': 'inputs/callsets/t0_1_2.json',
+                'loader_params': { "dictionary_encoded_fields": [ "REF", "ALT" ] },
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_0",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_0",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_0",
+                        } },
+                    { "query_column_ranges" : [12150, 1000000000], "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_12150",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_12150",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_12150",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_12150",
+                        } }
+                    ]
+            },
+            { "name" : "t0_overlapping_lightweight_end_copies", 'golden_output': 'golden_outputs/t0_overlapping',
+                'callset_mapping_file': 'inputs/callsets/t0_overlapping.json',
+                'loader_params': { "lightweight_end_copies": True },
+                "query_params": [
+                    { "query_column_ranges" : [12202, 1000000000], "golden_output": {
+                        "vcf"        : "golden_outputs/t0_overlapping_at_12202",
+                        }
+                    }
+                ]
+            },
+            #Reference blocks merged by hand - expected result of merging GQ bands at import
+            #Blocks end at the last base of contig 1 and begin at the first base of contig 2
+            { "name" : "ref_blocks_contig_boundary_merged",
+                'callset_mapping_file': 'inputs/callsets/ref_blocks_contig_boundary_merged.json',
+                'loader_params': { "produce_combined_vcf": False, "size_per_column_partition": 16384 },
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "query_types": [ "calls", "variants" ] }
+                    ]
+            },
+            { "name" : "ref_blocks_contig_boundary",
+                'callset_mapping_file': 'inputs/callsets/ref_blocks_contig_boundary.json',
+                'loader_params': { "produce_combined_vcf": False, "size_per_column_partition": 16384,
+                    "reference_block_gq_bands": [ 20, 60 ] },
+                'same_query_output_as': 'ref_blocks_contig_boundary_merged',
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "query_types": [ "calls", "variants" ] }
+                    ]
+            },
+            #GQ and PL quantized in the input files - expected result of quantization at import
+            { "name" : "t0_1_2_prequantized",
+                'callset_mapping_file': 'inputs/callsets/t0_1_2_prequantized.json',
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "query_types": [ "calls", "variants", "vcf" ] }
+                    ]
+            },
+            { "name" : "t0_1_2_quantized",
+                'callset_mapping_file': 'inputs/callsets/t0_1_2.json',
+                'vid_mapping_file': 'inputs/vid_quantized.json',
+                'same_query_output_as': 't0_1_2_prequantized',
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "query_types": [ "calls", "variants", "vcf" ] }
+                    ]
+            },
     ];
+    #Query outputs of every test - a test may require its outputs to be identical to those of an earlier test
+    query_outputs = {};
     for test_params_dict in loader_tests:
         test_name = test_params_dict['name']
         test_loader_dict = create_loader_json(ws_dir, test_name, test_params_dict);
@@ -401,17 +988,21 @@ def main():
                 print_diff(golden_stdout, stdout_string);
                 cleanup_and_exit(tmpdir, -1);
         if('query_params' in test_params_dict):
-            for query_param_dict in test_params_dict['query_params']:
+            for query_idx,query_param_dict in enumerate(test_params_dict['query_params']):
                 test_query_dict = create_query_json(ws_dir, test_name, query_param_dict)
                 query_types_list = [
                         ('calls','--print-calls'),
                         ('variants',''),
+                        #Small pages and chunks - each page resumes the scan where the previous page stopped
+                        ('streamed_variants','--streaming-chunk-size 256 --streaming-page-size 2'),
                         ('vcf','--produce-Broad-GVCF'),
                         ('batched_vcf','--produce-Broad-GVCF -p 128'),
                         ('java_vcf', ''),
                         ('consolidate_and_vcf', '--produce-Broad-GVCF'), #keep as the last query test
                         ]
                 for query_type,cmd_line_param in query_types_list:
+                    if('query_types' in query_param_dict and query_type not in query_param_dict['query_types']):
+                        continue;
                     if(query_type == 'vcf' or query_type == 'batched_vcf' or query_type.find('java_vcf') != -1):
                         test_query_dict['query_attributes'] = vcf_query_attributes_order;
                     query_json_filename = tmpdir+os.path.sep+test_name+'_'+query_type+'.json'
@@ -449,6 +1040,31 @@ def main():
                             sys.stderr.write('Mismatch in query test: '+test_name+'-'+query_type+'\n');
                             print_diff(golden_stdout, stdout_string);
                             cleanup_and_exit(tmpdir, -1);
+                    query_outputs[(test_name, query_idx, query_type)] = stdout_string;
+                    #Streaming the range query output must not change it
+                    if(query_type == 'streamed_variants' and (test_name, query_idx, 'variants') in query_outputs):
+                        expected_stdout = query_outputs[(test_name, query_idx, 'variants')];
+                        if(expected_stdout != stdout_string):
+                            sys.stderr.write('Mismatch in query test: '+test_name+'-'+query_type+' and '
+                                    +test_name+'-variants\n');
+                            print_diff(expected_stdout, stdout_string);
+                            cleanup_and_exit(tmpdir, -1);
+                    if('same_query_output_as' in test_params_dict):
+                        expected_stdout = query_outputs[(test_params_dict['same_query_output_as'], query_idx, query_type)];
+                        if(expected_stdout != stdout_string):
+                            sys.stderr.write('Mismatch in query test: '+test_name+'-'+query_type+' and '
+                                    +test_params_dict['same_query_output_as']+'-'+query_type+'\n');
+                            print_diff(expected_stdout, stdout_string);
+                            cleanup_and_exit(tmpdir, -1);
+    test_concatenate_vcf_parts(exe_path, ws_dir, tmpdir, segment_size);
+    test_compact_serialization_round_trip(exe_path, ws_dir, tmpdir, segment_size);
+    test_combine_row_partitions(exe_path, ws_dir, tmpdir, segment_size);
+    test_histogram_from_index(exe_path, ws_dir, tmpdir);
+    test_vcfdiff_shards(exe_path, tmpdir);
+    test_genotype_matrix_export(exe_path, ws_dir, tmpdir, segment_size);
+    test_vcf_text_output(exe_path, ws_dir, tmpdir, segment_size);
+    test_local_gather(exe_path, ws_dir, tmpdir, segment_size);
+    test_columnar_export(exe_path, ws_dir, tmpdir, segment_size);
     coverage_file='coverage.info'
     subprocess.call('lcov --directory '+gcda_prefix_dir+' --capture --output-file '+coverage_file, shell=True);
     #Remove protocol buffer generated files from the coverage information
@@ -0,0 +1,88 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GT_QUERY_OPERATIONS_H
+#define GT_QUERY_OPERATIONS_H
+
+#include "headers.h"
+#include "query_variants.h"
+#include "variant_operations.h"
+#include "timer.h"
+#include "vid_mapper.h"
+
+#ifdef HTSDIR
+#include "vcf_adapter.h"
+#include "json_config.h"
+#endif
+
+/*
+ * Query operations shared by the gt_mpi_gather and gt_local_gather drivers - each runs the operation for the
+ * partition of a single rank
+ */
+
+/*
+ * Queries a column interval page by page so that the full result set is never held in memory
+ * Each page resumes the forward scan at the last column of the previous page
+ */
+template<class PageHandlerTy>
+void run_paged_column_interval_query(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    const unsigned column_interval_idx, const unsigned page_size, PageHandlerTy handle_page,
+    GTProfileStats* stats_ptr=0, Timer* query_timer=0)
+{
+  GA4GHPagingInfo paging_info;
+  paging_info.set_page_size(page_size);
+  std::vector<Variant> page;
+  do
+  {
+    page.clear();
+    if(query_timer)
+      query_timer->start();
+    qp.gt_get_column_interval(qp.get_array_descriptor(), query_config, column_interval_idx, page, &paging_info, stats_ptr);
+    if(query_timer)
+      query_timer->stop();
+    handle_page(page);
+  }
+  while(!(paging_info.is_query_completed()));
+}
+
+template<class PageHandlerTy>
+void run_paged_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, const unsigned page_size,
+    PageHandlerTy handle_page, GTProfileStats* stats_ptr=0, Timer* query_timer=0)
+{
+  for(auto i=0u;i<query_config.get_num_column_intervals();++i)
+    run_paged_column_interval_query(qp, query_config, i, page_size, handle_page, stats_ptr, query_timer);
+}
+
+#ifdef HTSDIR
+void scan_and_produce_Broad_GVCF(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    VCFAdapter& vcf_adapter, const VidMapper& id_mapper, const JSONVCFAdapterQueryConfig& json_scan_config, const int rank);
+#endif
+
+//Prints all cells in the queried intervals as JSON
+void print_calls(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, const VidMapper& id_mapper);
+//Prints all cells in the queried intervals as CSV lines
+void print_calls_csv(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config);
+
+void produce_column_histogram(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, uint64_t bin_size,
+    const std::vector<uint64_t>& num_equi_load_bins);
+
+#endif
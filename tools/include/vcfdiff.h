@@ -29,6 +29,7 @@
 #include "lut.h"
 #include "vcf.h"
 #include "htslib/synced_bcf_reader.h"
+#include "htslib/tbx.h"
 #include "known_field_info.h"
 
 //Exceptions thrown
@@ -43,6 +44,98 @@ class VCFDiffException : public std::exception{
     std::string msg_;
 };
 
+//Difference counts for one region (shard) of the comparison - merged into a total at the end
+class VCFDiffStats
+{
+  public:
+    VCFDiffStats(const std::string& name="")
+      : m_name(name)
+    {
+      m_num_lines_compared = 0ull;
+      m_num_lines_different = 0ull;
+      m_num_position_mismatches = 0ull;
+      m_num_gold_extra_line_errors = 0ull;
+      m_num_test_extra_line_errors = 0ull;
+    }
+    void add_line_difference();
+    void add_position_mismatch();
+    void add_extra_line_error(const bool is_gold);
+    void add_field_difference(const std::string& field_name) { ++(m_field_to_num_diffs[field_name]); }
+    uint64_t get_num_differences() const
+    {
+      return m_num_lines_different + m_num_position_mismatches + m_num_gold_extra_line_errors + m_num_test_extra_line_errors;
+    }
+    void merge(const VCFDiffStats& other);
+    void print(std::ostream& fptr, const bool print_fields=true) const;
+  public:
+    std::string m_name;
+    uint64_t m_num_lines_compared;
+    uint64_t m_num_lines_different;
+    uint64_t m_num_position_mismatches;
+    uint64_t m_num_gold_extra_line_errors;
+    uint64_t m_num_test_extra_line_errors;
+    //Key is QUAL/ID/ALT/FILTER or INFO/<name>, FORMAT/<name>
+    std::map<std::string, uint64_t> m_field_to_num_diffs;
+};
+
+//Region processed by one thread - contig:[begin, end], 1-based like the regions string
+class VCFDiffShard
+{
+  public:
+    VCFDiffShard(const std::string& contig, const int64_t begin, const int64_t end, const bool skip_lines_before_begin)
+      : m_contig(contig), m_begin(begin), m_end(end), m_skip_lines_before_begin(skip_lines_before_begin)
+    { }
+    std::string get_name() const { return m_contig+":"+std::to_string(m_begin)+"-"+std::to_string(m_end); }
+    //Quoted region string for the synced reader
+    std::string get_synced_reader_region() const
+    {
+      return '"' + m_contig + "\":" + std::to_string(m_begin) + "-" + std::to_string(m_end);
+    }
+  public:
+    std::string m_contig;
+    int64_t m_begin;
+    int64_t m_end;
+    //Lines overlapping the begin of the shard belong to the previous shard of the same contig
+    bool m_skip_lines_before_begin;
+};
+
+//Traversal state at the end of a shard - a shard compared on its own assumes the state at the
+//start of a region, which must match the state the previous shard of the region ended with
+class VCFDiffTraversalState
+{
+  public:
+    VCFDiffTraversalState()
+    {
+      m_both_must_have_valid_lines = false;
+      m_lines_left = false;
+      m_used_initial_state = false;
+    }
+  public:
+    //In - value at the start of the traversal, out - value at its end
+    bool m_both_must_have_valid_lines;
+    //Lines of one of the files were left when the other file ran out of lines
+    bool m_lines_left;
+    //No pair of lines was compared and the result depends on m_both_must_have_valid_lines at the start
+    bool m_used_initial_state;
+};
+
+//Index queries used to place shard boundaries
+class VCFDiffIndexReader
+{
+  public:
+    VCFDiffIndexReader(const std::string& filename);
+    ~VCFDiffIndexReader();
+    //1-based end of the longest line that covers position and ends after it - position if there is no such line
+    int64_t get_end_of_lines_crossing(const std::string& contig, const int64_t position);
+  private:
+    std::string m_filename;
+    htsFile* m_fptr;
+    bcf_hdr_t* m_hdr;
+    tbx_t* m_tbx;
+    hts_idx_t* m_idx;
+    bcf1_t* m_line;
+    kstring_t m_tmp_hts_string;
+};
 
 class VCFDiffFile
 {
@@ -55,6 +148,8 @@ class VCFDiffFile
     void set_regions_and_open_file();
     void seek_and_read(const int rid, const int pos);
     void read_and_advance();
+    void read_next_line();
+    void set_identity_samples_lut_flag(const VCFDiffFile& gold);
     void reset_field_to_line_idx_mapping()
     {
       //-1
@@ -62,8 +157,9 @@ class VCFDiffFile
       memset(&(m_fields_in_test_line[0]), -1, m_fields_in_test_line.size()*sizeof(int));
     }
     void print_line(std::ostream& fptr=std::cerr);
-    void compare_line(const bcf_hdr_t* gold_hdr, bcf1_t* gold_line);
-    bool compare_unequal_fields(const bcf_hdr_t* gold_hdr, const bcf1_t* gold_line, const int bcf_field_type, std::string& error_message);
+    void compare_line(const bcf_hdr_t* gold_hdr, bcf1_t* gold_line, VCFDiffStats& stats, std::ostream& fptr=std::cerr);
+    bool compare_unequal_fields(const bcf_hdr_t* gold_hdr, const bcf1_t* gold_line, const int bcf_field_type, std::string& error_message,
+        VCFDiffStats& stats);
     template<class T1, class T2>
     bool compare_unequal_vector(const bcf_hdr_t* gold_hdr, const bcf1_t* gold_line, const int bcf_field_type,
         int gold_line_field_pos_idx, int test_line_field_pos_idx);
@@ -72,6 +168,10 @@ class VCFDiffFile
   public:
     std::string m_filename;
     std::string m_regions;
+    //Lines starting before this (0-based) position are skipped, -1 disables
+    int64_t m_min_line_position;
+    //Lines starting after this (0-based) position end the traversal, -1 disables
+    int64_t m_max_line_position;
   private:
     bcf_srs_t* m_reader;
   public:
@@ -89,6 +189,13 @@ class VCFDiffFile
     std::vector<int> m_fields_in_test_line;
     SchemaIdxToKnownVariantFieldsEnumLUT m_field_idx_to_known_field_enum;
     bool m_diff_alleles_flag;
+    //Test alleles are in the same order as gold alleles
+    bool m_identity_alleles_lut;
+    //Test sample j is gold sample j for all samples
+    bool m_identity_samples_lut;
+    //Float comparison threshold for each field in the test header and QUAL
+    std::vector<double> m_field_idx_to_threshold;
+    double m_QUAL_threshold;
     std::vector<int> m_gold_genotype_idx_to_test_idx;
     CombineAllelesLUT m_alleles_lut;
     //Temp buffer
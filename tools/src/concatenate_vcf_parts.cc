@@ -0,0 +1,83 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include "vcf_parts_concatenator.h"
+
+enum ArgsEnum
+{
+  ARGS_IDX_NO_INDEX=1000
+};
+
+//Combines the per-rank/per-partition BGZF compressed VCF/BCF outputs of gt_mpi_gather (in column order)
+//into a single file without recompression and merges their indexes
+int main(int argc, char** argv)
+{
+  static struct option long_options[] =
+  {
+    {"output",1,0,'o'},
+    {"no-index",0,0,ARGS_IDX_NO_INDEX},
+    {0,0,0,0},
+  };
+  std::string output_filename = "";
+  auto merge_part_indexes = true;
+  int c;
+  while((c=getopt_long(argc, argv, "o:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'o':
+        output_filename = std::move(std::string(optarg));
+        break;
+      case ARGS_IDX_NO_INDEX:
+        merge_part_indexes = false;
+        break;
+      default:
+        std::cerr << "Unknown command line argument\n";
+        exit(-1);
+    }
+  }
+  if(output_filename.empty() || optind >= argc)
+  {
+    std::cerr << "Usage: " << argv[0] << " -o <output_file> [--no-index] <part_file_0> [<part_file_1> ...]\n"
+      << "Parts must be listed in column order\n";
+    return -1;
+  }
+#ifdef HTSDIR
+  try
+  {
+    VCFPartsConcatenator concatenator(std::vector<std::string>(argv+optind, argv+argc));
+    concatenator.concatenate(output_filename, merge_part_indexes);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    return -1;
+  }
+#else
+  std::cerr << "concatenate_vcf_parts needs htslib - recompile with HTSDIR set\n";
+  return -1;
+#endif
+  return 0;
+}
@@ -0,0 +1,46 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <iostream>
+#include "vid_mapper.h"
+
+//The snapshot can be used as the "vid_mapping_file" in loader/query JSONs - the "callset_mapping_file"
+//can then be dropped
+int main(int argc, char** argv)
+{
+  if(argc < 4)
+  {
+    std::cerr << "Needs 3 arguments <vid_mapping_file> <callset_mapping_file> <output_snapshot_file>\n";
+    exit(-1);
+  }
+  try
+  {
+    FileBasedVidMapper vid_mapper(argv[1], argv[2]);
+    vid_mapper.write_binary_snapshot(argv[3]);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,626 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <string>
+#include <getopt.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "libtiledb_variant.h"
+#include "json_config.h"
+#include "timer.h"
+#include "vid_mapper_pb.h"
+#include "gt_query_operations.h"
+
+/*
+ * Single node equivalent of gt_mpi_gather that needs no MPI runtime - forks one worker process per
+ * partition (rank) in the JSON configuration. Workers send their results to the parent over pipes and the
+ * parent prints them in rank (partition) order, so the output matches that of gt_mpi_gather
+ */
+
+enum ArgsEnum
+{
+  ARGS_IDX_PRODUCE_BROAD_GVCF=1000,
+  ARGS_IDX_PRODUCE_HISTOGRAM,
+  ARGS_IDX_PRINT_CALLS,
+  ARGS_IDX_PRINT_CSV,
+  ARGS_IDX_VERSION
+};
+
+enum CommandsEnum
+{
+  COMMAND_RANGE_QUERY=0,
+  COMMAND_PRODUCE_BROAD_GVCF,
+  COMMAND_PRODUCE_HISTOGRAM,
+  COMMAND_PRINT_CALLS,
+  COMMAND_PRINT_CSV
+};
+
+//Range query results are sent to the parent as frames - type[1 byte] length[uint64] payload
+enum LocalGatherFrameTypeEnum
+{
+  //Variants serialized with Variant::compact_binary_serialize()
+  LOCAL_GATHER_FRAME_VARIANTS=0u,
+  //For every queried column interval - #variants returned so far, column begin, column end [uint64]
+  LOCAL_GATHER_FRAME_INTERVAL_INFO
+};
+#define LOCAL_GATHER_FRAME_HEADER_SIZE (sizeof(uint8_t)+sizeof(uint64_t))
+#define LOCAL_GATHER_CHUNK_SIZE (1024u*1024u)
+#define LOCAL_GATHER_PIPE_READ_SIZE (1024u*1024u)
+//#variants returned by each paged query call unless -p is specified
+#define LOCAL_GATHER_QUERY_PAGE_SIZE 1024u
+
+class LocalGatherException : public std::exception {
+  public:
+    LocalGatherException(const std::string m="") : msg_("LocalGatherException : "+m) { ; }
+    ~LocalGatherException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+class LocalGatherArgs
+{
+  public:
+    LocalGatherArgs()
+      : m_command_idx(COMMAND_RANGE_QUERY), m_page_size(0u), m_segment_size(10u*1024u*1024u)
+    { }
+    unsigned m_command_idx;
+    uint64_t m_page_size;
+    size_t m_segment_size;
+    std::string m_output_format;
+    std::string m_json_config_file;
+    std::string m_loader_json_config_file;
+};
+
+/*
+ * Configuration and query processor for one rank
+ * open_array - if false, the array is not opened and the query processor can only deserialize Variants
+ */
+class LocalGatherRankContext
+{
+  public:
+    LocalGatherRankContext(const LocalGatherArgs& args, const int rank, const bool open_array=true);
+    ~LocalGatherRankContext()
+    {
+      if(m_qp)
+      {
+        if(m_storage_manager)
+          m_storage_manager->close_array(m_qp->get_array_descriptor());
+        delete m_qp;
+      }
+      m_qp = 0;
+      if(m_storage_manager)
+        delete m_storage_manager;
+      m_storage_manager = 0;
+    }
+    bool is_partitioned_by_column() const { return !m_loader_config || m_loader_config->is_partitioned_by_column(); }
+  public:
+    VariantQueryConfig m_query_config;
+    FileBasedVidMapper m_id_mapper;
+    std::string m_loader_json_config_file;
+    std::shared_ptr<const JSONLoaderConfig> m_loader_config;
+#ifdef HTSDIR
+    VCFAdapter m_vcf_adapter_base;
+    VCFSerializedBufferAdapter m_serialized_vcf_adapter;
+    VCFAdapter* m_vcf_adapter;
+    JSONVCFAdapterQueryConfig m_scan_config;
+#endif
+    VariantStorageManager* m_storage_manager;
+    VariantQueryProcessor* m_qp;
+};
+
+LocalGatherRankContext::LocalGatherRankContext(const LocalGatherArgs& args, const int rank, const bool open_array)
+  : m_loader_json_config_file(args.m_loader_json_config_file)
+#ifdef HTSDIR
+    , m_serialized_vcf_adapter(args.m_page_size, true)
+#endif
+{
+  m_storage_manager = 0;
+  m_qp = 0;
+#ifdef HTSDIR
+  m_vcf_adapter = &m_vcf_adapter_base;
+#endif
+  if(!(m_loader_json_config_file.empty()))
+  {
+    auto loader_config = std::make_shared<JSONLoaderConfig>();
+    loader_config->read_from_file(m_loader_json_config_file, &m_id_mapper, rank);
+    m_loader_config = loader_config;
+  }
+  JSONBasicQueryConfig* json_config_ptr = 0;
+  JSONBasicQueryConfig range_query_config;
+  auto output_format = args.m_output_format;
+  switch(args.m_command_idx)
+  {
+    case COMMAND_PRODUCE_BROAD_GVCF:
+#ifdef HTSDIR
+      m_vcf_adapter = (args.m_page_size > 0u) ? dynamic_cast<VCFAdapter*>(&m_serialized_vcf_adapter) : &m_vcf_adapter_base;
+      m_scan_config.read_from_file(args.m_json_config_file, m_query_config, *m_vcf_adapter, &m_id_mapper, output_format, rank,
+          0u, m_loader_config);
+      json_config_ptr = static_cast<JSONBasicQueryConfig*>(&m_scan_config);
+#else
+      throw LocalGatherException("Cannot produce Broad's combined GVCF without htslib. Re-compile with HTSDIR variable set");
+#endif
+      break;
+    default:
+      range_query_config.read_from_file(args.m_json_config_file, m_query_config, &m_id_mapper, rank, m_loader_config);
+      json_config_ptr = &range_query_config;
+      break;
+  }
+  auto workspace = json_config_ptr->get_workspace(rank);
+  auto array_name = json_config_ptr->get_array_name(rank);
+  if(workspace == "" || array_name == "")
+    throw LocalGatherException(std::string("Missing workspace or array name for rank ")+std::to_string(rank));
+  if(open_array)
+  {
+    m_storage_manager = new VariantStorageManager(workspace, args.m_segment_size);
+    m_qp = new VariantQueryProcessor(m_storage_manager, array_name, m_id_mapper);
+  }
+  else
+  {
+    //Schema built from the vid mapping, as the loader did when it created the array
+    VariantArraySchema* array_schema = 0;
+    m_id_mapper.build_tiledb_array_schema(array_schema, array_name, false,
+        RowRange(0, std::max<int64_t>(m_id_mapper.get_num_callsets(), 1)-1), false);
+    m_qp = new VariantQueryProcessor(*array_schema, m_id_mapper);
+    delete array_schema;
+  }
+  auto require_alleles = ((args.m_command_idx == COMMAND_RANGE_QUERY)
+      || (args.m_command_idx == COMMAND_PRODUCE_BROAD_GVCF));
+  m_qp->do_query_bookkeeping(m_qp->get_array_schema(), m_query_config, m_id_mapper, require_alleles);
+}
+
+void write_to_fd(const int fd, const void* data, const size_t num_bytes)
+{
+  auto ptr = reinterpret_cast<const char*>(data);
+  for(auto num_written=0ull;num_written<num_bytes;)
+  {
+    auto status = write(fd, ptr+num_written, num_bytes-num_written);
+    if(status < 0)
+    {
+      if(errno == EINTR)
+        continue;
+      throw LocalGatherException(std::string("Failed to write to pipe - ")+strerror(errno));
+    }
+    num_written += status;
+  }
+}
+
+void write_frame(const int fd, const uint8_t frame_type, const void* payload, const uint64_t length)
+{
+  uint8_t header[LOCAL_GATHER_FRAME_HEADER_SIZE];
+  header[0] = frame_type;
+  memcpy(header+sizeof(uint8_t), &length, sizeof(uint64_t));
+  write_to_fd(fd, header, LOCAL_GATHER_FRAME_HEADER_SIZE);
+  write_to_fd(fd, payload, length);
+}
+
+void send_range_query_results(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, const unsigned page_size,
+    const int fd)
+{
+  std::vector<uint8_t> buffer(LOCAL_GATHER_CHUNK_SIZE);
+  uint64_t length = 0ull;
+  uint64_t num_variants = 0ull;
+  std::vector<uint64_t> interval_info;
+  GTProfileStats* stats_ptr = 0;
+#ifdef DO_PROFILING
+  GTProfileStats stats;
+  stats_ptr = &stats;
+#endif
+  for(auto i=0u;i<query_config.get_num_column_intervals();++i)
+  {
+    run_paged_column_interval_query(qp, query_config, i, page_size, [&](const std::vector<Variant>& page) {
+        for(const auto& variant : page)
+        {
+          variant.compact_binary_serialize(buffer, length, query_config);
+          if(length >= LOCAL_GATHER_CHUNK_SIZE)
+          {
+            write_frame(fd, LOCAL_GATHER_FRAME_VARIANTS, &(buffer[0]), length);
+            length = 0ull;
+          }
+        }
+        num_variants += page.size();
+      }, stats_ptr);
+    interval_info.push_back(num_variants);
+    interval_info.push_back(query_config.get_column_begin(i));
+    interval_info.push_back(query_config.get_column_end(i));
+  }
+  if(length > 0ull)
+    write_frame(fd, LOCAL_GATHER_FRAME_VARIANTS, &(buffer[0]), length);
+  write_frame(fd, LOCAL_GATHER_FRAME_INTERVAL_INFO, interval_info.size() ? &(interval_info[0]) : 0,
+      interval_info.size()*sizeof(uint64_t));
+}
+
+//Runs in the forked worker - stdout is already redirected to the pipe for all commands except range queries
+int run_worker(const LocalGatherArgs& args, const int rank, const int fd)
+{
+  try
+  {
+    LocalGatherRankContext context(args, rank);
+    auto& qp = *(context.m_qp);
+    switch(args.m_command_idx)
+    {
+      case COMMAND_RANGE_QUERY:
+        send_range_query_results(qp, context.m_query_config,
+            args.m_page_size > 0u ? args.m_page_size : LOCAL_GATHER_QUERY_PAGE_SIZE, fd);
+        break;
+      case COMMAND_PRODUCE_BROAD_GVCF:
+#if defined(HTSDIR)
+        scan_and_produce_Broad_GVCF(qp, context.m_query_config, *(context.m_vcf_adapter),
+            static_cast<const VidMapper&>(context.m_id_mapper), context.m_scan_config, rank);
+#endif
+        break;
+      case COMMAND_PRODUCE_HISTOGRAM:
+        produce_column_histogram(qp, context.m_query_config, 100, std::vector<uint64_t>({ 128, 64, 32, 16, 8, 4, 2 }));
+        break;
+      case COMMAND_PRINT_CALLS:
+        print_calls(qp, context.m_query_config, static_cast<const VidMapper&>(context.m_id_mapper));
+        break;
+      case COMMAND_PRINT_CSV:
+        print_calls_csv(qp, context.m_query_config);
+        break;
+    }
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "Worker " << rank << ": " << e.what() << "\n";
+    return -1;
+  }
+  std::cout.flush();
+  fflush(stdout);
+  return 0;
+}
+
+//Output of one worker as read by the parent
+class LocalGatherWorkerOutput
+{
+  public:
+    LocalGatherWorkerOutput()
+      : m_pid(-1), m_fd(-1), m_read_offset(0ull), m_eof(false)
+    { }
+    pid_t m_pid;
+    int m_fd;
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_read_offset;
+    bool m_eof;
+};
+
+//Blocking read from the pipe of the worker whose output is printed next - pipes of the other workers are
+//not drained, so a worker that runs ahead blocks once its pipe buffer is full
+void read_worker_pipe(LocalGatherWorkerOutput& worker)
+{
+  if(worker.m_eof)
+    return;
+  auto curr_size = worker.m_buffer.size();
+  worker.m_buffer.resize(curr_size+LOCAL_GATHER_PIPE_READ_SIZE);
+  ssize_t status = 0;
+  do
+  {
+    status = read(worker.m_fd, &(worker.m_buffer[curr_size]), LOCAL_GATHER_PIPE_READ_SIZE);
+  }
+  while(status < 0 && errno == EINTR);
+  if(status < 0)
+    throw LocalGatherException(std::string("Failed to read from pipe - ")+strerror(errno));
+  worker.m_buffer.resize(curr_size+status);
+  if(status == 0)
+  {
+    worker.m_eof = true;
+    close(worker.m_fd);
+    worker.m_fd = -1;
+  }
+}
+
+//Consumes complete frames/bytes of the worker whose output is printed next
+class LocalGatherOutputHandler
+{
+  public:
+    virtual ~LocalGatherOutputHandler() = default;
+    virtual void handle(LocalGatherWorkerOutput& worker) = 0;
+    virtual void finalize() { }
+};
+
+//Worker output is already in its final form
+class LocalGatherRawOutputHandler : public LocalGatherOutputHandler
+{
+  public:
+    void handle(LocalGatherWorkerOutput& worker)
+    {
+      auto num_bytes = worker.m_buffer.size() - worker.m_read_offset;
+      if(num_bytes)
+      {
+        std::cout.write(reinterpret_cast<const char*>(&(worker.m_buffer[worker.m_read_offset])), num_bytes);
+        std::cout.flush();
+      }
+      worker.m_buffer.clear();
+      worker.m_read_offset = 0ull;
+    }
+};
+
+class LocalGatherRangeQueryOutputHandler : public LocalGatherOutputHandler
+{
+  public:
+    LocalGatherRangeQueryOutputHandler(const LocalGatherRankContext& context, const std::string& output_format)
+      : m_context(context), m_output_format(output_format),
+      m_printer(context.m_query_config, &(context.m_id_mapper))
+    {
+      //Cotton-JSON and Positions-JSON group variants by queried interval and need the full result set
+      m_stream_output = (output_format != "Cotton-JSON" && output_format != "Positions-JSON");
+      m_ss << std::fixed << std::setprecision(6);
+      if(m_stream_output)
+        m_printer.print_header(m_ss);
+    }
+    void handle(LocalGatherWorkerOutput& worker);
+    void finalize();
+  private:
+    void flush_output()
+    {
+      std::cout << m_ss.str();
+      std::cout.flush();
+      m_ss.str("");
+    }
+  private:
+    const LocalGatherRankContext& m_context;
+    std::string m_output_format;
+    bool m_stream_output;
+    VariantsJSONStreamPrinter m_printer;
+    std::ostringstream m_ss;
+    //Re-used for all streamed variants
+    Variant m_variant;
+    //Used only if output cannot be streamed
+    std::vector<Variant> m_variants;
+    std::vector<uint64_t> m_query_column_lengths;
+    std::vector<uint64_t> m_num_column_intervals;
+    std::vector<uint64_t> m_queried_column_positions;
+};
+
+void LocalGatherRangeQueryOutputHandler::handle(LocalGatherWorkerOutput& worker)
+{
+  auto& qp = *(m_context.m_qp);
+  auto& buffer = worker.m_buffer;
+  auto& offset = worker.m_read_offset;
+  while(offset + LOCAL_GATHER_FRAME_HEADER_SIZE <= buffer.size())
+  {
+    auto frame_type = buffer[offset];
+    uint64_t length = 0ull;
+    memcpy(&length, &(buffer[offset+sizeof(uint8_t)]), sizeof(uint64_t));
+    if(offset + LOCAL_GATHER_FRAME_HEADER_SIZE + length > buffer.size())
+      break;
+    offset += LOCAL_GATHER_FRAME_HEADER_SIZE;
+    auto frame_end = offset + length;
+    switch(frame_type)
+    {
+      case LOCAL_GATHER_FRAME_VARIANTS:
+        while(offset < frame_end)
+        {
+          if(m_stream_output)
+          {
+            qp.compact_binary_deserialize(m_variant, m_context.m_query_config, buffer, offset);
+            m_printer.print(m_ss, m_variant);
+          }
+          else
+          {
+            m_variants.emplace_back();
+            qp.compact_binary_deserialize(m_variants.back(), m_context.m_query_config, buffer, offset);
+          }
+        }
+        if(m_stream_output)
+          flush_output();
+        break;
+      case LOCAL_GATHER_FRAME_INTERVAL_INFO:
+        m_num_column_intervals.push_back(length/(3u*sizeof(uint64_t)));
+        for(;offset<frame_end;offset+=3u*sizeof(uint64_t))
+        {
+          auto ptr = reinterpret_cast<const uint64_t*>(&(buffer[offset]));
+          m_query_column_lengths.push_back(ptr[0]);
+          m_queried_column_positions.push_back(ptr[1]);
+          m_queried_column_positions.push_back(ptr[2]);
+        }
+        break;
+      default:
+        throw LocalGatherException(std::string("Unknown frame type ")+std::to_string(frame_type));
+    }
+    if(offset != frame_end)
+      throw LocalGatherException("Corrupted frame received from worker");
+  }
+  //Drop consumed data - an incomplete frame at the end is moved to the front of the buffer
+  if(offset == buffer.size())
+    buffer.clear();
+  else
+    buffer.erase(buffer.begin(), buffer.begin()+offset);
+  offset = 0ull;
+}
+
+void LocalGatherRangeQueryOutputHandler::finalize()
+{
+  if(m_stream_output)
+  {
+    m_printer.print_trailer(m_ss);
+    flush_output();
+  }
+  else
+    print_variants(m_variants, m_output_format, m_context.m_query_config, std::cout, m_context.is_partitioned_by_column(),
+        &(m_context.m_id_mapper), m_query_column_lengths, m_num_column_intervals, m_queried_column_positions);
+}
+
+int main(int argc, char *argv[]) {
+  // Define long options
+  static struct option long_options[] = 
+  {
+    {"page-size",1,0,'p'},
+    {"num-workers",1,0,'n'},
+    {"output-format",1,0,'O'},
+    {"json-config",1,0,'j'},
+    {"loader-json-config",1,0,'l'},
+    {"segment-size",1,0,'s'},
+    {"produce-Broad-GVCF",0,0,ARGS_IDX_PRODUCE_BROAD_GVCF},
+    {"produce-histogram",0,0,ARGS_IDX_PRODUCE_HISTOGRAM},
+    {"print-calls",0,0,ARGS_IDX_PRINT_CALLS},
+    {"print-csv",0,0,ARGS_IDX_PRINT_CSV},
+    {"version",0,0,ARGS_IDX_VERSION},
+    {0,0,0,0},
+  };
+  int c;
+  LocalGatherArgs args;
+  auto num_workers = 1;
+  while((c=getopt_long(argc, argv, "j:l:p:O:s:n:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'p':
+        args.m_page_size = strtoull(optarg, 0, 10);
+        break;
+      case 'n':
+        num_workers = strtol(optarg, 0, 10);
+        break;
+      case 'O':
+        args.m_output_format = std::move(std::string(optarg));
+        break;
+      case 's':
+        args.m_segment_size = strtoull(optarg, 0, 10);
+        break;
+      case ARGS_IDX_PRODUCE_BROAD_GVCF:
+        args.m_command_idx = COMMAND_PRODUCE_BROAD_GVCF;
+        break;
+      case ARGS_IDX_PRODUCE_HISTOGRAM:
+        args.m_command_idx = COMMAND_PRODUCE_HISTOGRAM;
+        break;
+      case 'j':
+        args.m_json_config_file = std::move(std::string(optarg));
+        break;
+      case ARGS_IDX_PRINT_CALLS:
+        args.m_command_idx = COMMAND_PRINT_CALLS;
+        break;
+      case ARGS_IDX_PRINT_CSV:
+        args.m_command_idx = COMMAND_PRINT_CSV;
+        break;
+      case 'l':
+        args.m_loader_json_config_file = std::move(std::string(optarg));
+        break;
+      case ARGS_IDX_VERSION:
+        std::cout << GENOMICSDB_VERSION <<"\n";
+        return 0;
+      default:
+        std::cerr << "Unknown command line argument\n";
+        exit(-1);
+    }
+  }
+  if(args.m_json_config_file.empty() || num_workers <= 0)
+  {
+    std::cerr << "Usage: " << argv[0] << " -j <json_config_file> -n <num_workers> [ -l <loader_json_file> -O <output_format> -p <page_size> ]"
+      << " [ --produce-Broad-GVCF | --produce-histogram | --print-calls | --print-csv ]\n"
+      << "Worker i queries the partition of rank i in the JSON configuration\n"
+      << "-p - #variants per page of range queries (default " << LOCAL_GATHER_QUERY_PAGE_SIZE
+      << "), #variants per batch of the combined GVCF\n";
+    return -1;
+  }
+  //Avoid duplicate output from buffers inherited by the workers
+  std::cout.flush();
+  fflush(stdout);
+  std::vector<LocalGatherWorkerOutput> workers(num_workers);
+  for(auto rank=0;rank<num_workers;++rank)
+  {
+    int pipe_fds[2];
+    if(pipe(pipe_fds) != 0)
+    {
+      std::cerr << "Failed to create pipe - " << strerror(errno) << "\n";
+      exit(-1);
+    }
+    auto pid = fork();
+    if(pid < 0)
+    {
+      std::cerr << "Failed to fork worker - " << strerror(errno) << "\n";
+      exit(-1);
+    }
+    if(pid == 0)
+    {
+      //Worker
+      close(pipe_fds[0]);
+      for(auto i=0;i<rank;++i)
+        close(workers[i].m_fd);
+      if(args.m_command_idx != COMMAND_RANGE_QUERY)
+      {
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        close(pipe_fds[1]);
+        pipe_fds[1] = STDOUT_FILENO;
+      }
+      auto status = run_worker(args, rank, pipe_fds[1]);
+      close(pipe_fds[1]);
+      _exit(status == 0 ? 0 : 1);
+    }
+    close(pipe_fds[1]);
+    workers[rank].m_pid = pid;
+    workers[rank].m_fd = pipe_fds[0];
+  }
+  auto exit_status = 0;
+  try
+  {
+    //The parent needs the query configuration and a query processor to deserialize and print range query results
+    //- it never reads the array
+    std::unique_ptr<LocalGatherRankContext> context;
+    std::unique_ptr<LocalGatherOutputHandler> handler;
+    if(args.m_command_idx == COMMAND_RANGE_QUERY)
+    {
+      context.reset(new LocalGatherRankContext(args, 0, false));
+      handler.reset(new LocalGatherRangeQueryOutputHandler(*context, args.m_output_format));
+    }
+    else
+      handler.reset(new LocalGatherRawOutputHandler());
+    for(auto curr_rank=0;curr_rank<num_workers;++curr_rank)
+    {
+      auto& worker = workers[curr_rank];
+      while(!worker.m_eof)
+      {
+        read_worker_pipe(worker);
+        handler->handle(worker);
+      }
+      if(worker.m_buffer.size() > worker.m_read_offset)
+        throw LocalGatherException(std::string("Incomplete output received from worker ")+std::to_string(curr_rank));
+    }
+    handler->finalize();
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    exit_status = -1;
+  }
+  for(auto rank=0;rank<num_workers;++rank)
+  {
+    auto& worker = workers[rank];
+    if(worker.m_fd >= 0)
+      close(worker.m_fd);
+    int status = 0;
+    if(waitpid(worker.m_pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      std::cerr << "Worker " << rank << " failed\n";
+      exit_status = -1;
+    }
+  }
+  GenomicsDBProtoBufInitAndCleanup::shutdown_protobuf_library();
+  return exit_status;
+}
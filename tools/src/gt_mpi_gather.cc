@@ -21,6 +21,7 @@
 */
 
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <getopt.h>
 #include <mpi.h>
@@ -28,7 +29,10 @@
 #include "json_config.h"
 #include "timer.h"
 #include "broad_combined_gvcf.h"
+#include "columnar_export.h"
+#include "genotype_matrix_export.h"
 #include "vid_mapper_pb.h"
+#include "gt_query_operations.h"
 
 #ifdef USE_BIGMPI
 #include "bigmpi.h"
@@ -45,7 +49,17 @@ enum ArgsEnum
   ARGS_IDX_PRODUCE_HISTOGRAM,
   ARGS_IDX_PRINT_CALLS,
   ARGS_IDX_PRINT_CSV,
-  ARGS_IDX_VERSION
+  ARGS_IDX_VERSION,
+  ARGS_IDX_STREAMING_CHUNK_SIZE,
+  ARGS_IDX_STREAMING_PAGE_SIZE,
+  ARGS_IDX_COMBINE_ROW_PARTITIONS,
+  ARGS_IDX_EXPORT_COLUMNAR,
+  ARGS_IDX_COLUMNAR_LAYOUT,
+  ARGS_IDX_COLUMNAR_ROW_GROUP_SIZE,
+  ARGS_IDX_EXPORT_GENOTYPE_MATRIX,
+  ARGS_IDX_GENOTYPE_MATRIX_FORMAT,
+  ARGS_IDX_MULTIALLELIC,
+  ARGS_IDX_NUM_THREADS
 };
 
 enum CommandsEnum
@@ -54,7 +68,9 @@ enum CommandsEnum
   COMMAND_PRODUCE_BROAD_GVCF,
   COMMAND_PRODUCE_HISTOGRAM,
   COMMAND_PRINT_CALLS,
-  COMMAND_PRINT_CSV
+  COMMAND_PRINT_CSV,
+  COMMAND_EXPORT_COLUMNAR,
+  COMMAND_EXPORT_GENOTYPE_MATRIX
 };
 
 #define MegaByte (1024*1024)
@@ -135,7 +151,7 @@ void run_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig&
   serialized_buffer.resize(1000000u);       //1MB, arbitrary value - will be resized if necessary by serialization functions
   uint64_t serialized_length = 0ull;
   for(const auto& variant : variants)
-    variant.binary_serialize(serialized_buffer, serialized_length);
+    variant.compact_binary_serialize(serialized_buffer, serialized_length, query_config);
 #if VERBOSE>0
   std::cerr << "[Rank "<< my_world_mpi_rank << " ]: Completed serialization, serialized data size "
     << std::fixed << std::setprecision(3) << ((double)serialized_length)/MegaByte  << " MBs\n";
@@ -269,7 +285,7 @@ void run_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig&
     {
       variants.emplace_back();
       auto& variant = variants.back();
-      qp.binary_deserialize(variant, query_config, receive_buffer, offset);
+      qp.compact_binary_deserialize(variant, query_config, receive_buffer, offset);
     }
 #if VERBOSE>0
     std::cerr << "Completed binary deserialization at root\n";
@@ -306,86 +322,443 @@ void run_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig&
   }
 }
 
+//Streaming gather - ranks send bounded size chunks of serialized variants as they are produced
+//and the root prints them in rank (partition) order as they arrive
+#define GATHER_STREAM_CHUNK_TAG 100
+//#chunk buffers per sending rank - a buffer is reused only after the root has started receiving
+//the chunk previously sent from it, so this bounds the #chunks in flight per rank
+#define GATHER_STREAM_NUM_CHUNK_BUFFERS 4u
+//Default #variants returned by each paged query call
+#define GATHER_STREAM_QUERY_PAGE_SIZE 1024u
+
+//Cotton-JSON and Positions-JSON group variants by queried interval and need the full gathered set
+bool can_stream_range_query_output(const std::string& output_format)
+{
+  return output_format != "Cotton-JSON" && output_format != "Positions-JSON";
+}
+
+#ifdef DO_PROFILING
+//Cumulative times of each phase of the streaming gather
+void print_streaming_timers(const std::vector<Timer>& timers, const int my_world_mpi_rank)
+{
+  for(auto i=0u;i<TIMER_NUM_TIMERS;++i)
+    timers[i].print(g_timer_names[i]+" for rank "+std::to_string(my_world_mpi_rank), std::cerr);
+}
+#endif
+
+void send_range_query_stream(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    const uint64_t chunk_size, const unsigned page_size, const int my_world_mpi_rank)
+{
+  GTProfileStats* stats_ptr = 0;
+  Timer* query_timer = 0;
+#ifdef DO_PROFILING
+  std::vector<Timer> timers(TIMER_NUM_TIMERS);
+  GTProfileStats stats;
+  stats_ptr = &stats;
+  query_timer = &(timers[TIMER_TILEDB_QUERY_RANGE_IDX]);
+#endif
+  std::vector<std::vector<uint8_t>> chunks(GATHER_STREAM_NUM_CHUNK_BUFFERS);
+  std::vector<MPI_Request> requests(GATHER_STREAM_NUM_CHUNK_BUFFERS, MPI_REQUEST_NULL);
+  auto curr_chunk_idx = 0u;
+  uint64_t curr_chunk_length = 0ull;
+  chunks[curr_chunk_idx].resize(chunk_size); //will be resized if necessary by serialization functions
+  auto send_chunk = [&]() {
+    //MPI uses int for counts
+    if(curr_chunk_length >= static_cast<uint64_t>(INT_MAX))
+    {
+      std::cerr << "Serialized chunk size beyond 32-bit int limit - exiting.\n";
+      exit(-1);
+    }
+#ifdef DO_PROFILING
+    timers[TIMER_MPI_GATHER_IDX].start();
+#endif
+    //Synchronous send - completes only once the root has started receiving the chunk
+    ASSERT(MPI_Issend(&(chunks[curr_chunk_idx][0]), curr_chunk_length, MPI_UNSIGNED_CHAR, 0, GATHER_STREAM_CHUNK_TAG,
+          MPI_COMM_WORLD, &(requests[curr_chunk_idx])) == MPI_SUCCESS);
+    curr_chunk_idx = (curr_chunk_idx+1u)%GATHER_STREAM_NUM_CHUNK_BUFFERS;
+    //Wait till the chunk buffer to be filled next is free again
+    ASSERT(MPI_Wait(&(requests[curr_chunk_idx]), MPI_STATUS_IGNORE) == MPI_SUCCESS);
+#ifdef DO_PROFILING
+    timers[TIMER_MPI_GATHER_IDX].stop();
+#endif
+    if(chunks[curr_chunk_idx].size() < chunk_size)
+      chunks[curr_chunk_idx].resize(chunk_size);
+    curr_chunk_length = 0ull;
+  };
+  run_paged_range_query(qp, query_config, page_size, [&](const std::vector<Variant>& page) {
+      for(const auto& variant : page)
+      {
+#ifdef DO_PROFILING
+        timers[TIMER_BINARY_SERIALIZATION_IDX].start();
+#endif
+        variant.compact_binary_serialize(chunks[curr_chunk_idx], curr_chunk_length, query_config);
+#ifdef DO_PROFILING
+        timers[TIMER_BINARY_SERIALIZATION_IDX].stop();
+#endif
+        if(curr_chunk_length >= chunk_size)
+          send_chunk();
+      }
+    }, stats_ptr, query_timer);
+  if(curr_chunk_length > 0ull)
+    send_chunk();
+  //Empty chunk marks end of stream
+  send_chunk();
+  ASSERT(MPI_Waitall(requests.size(), &(requests[0]), MPI_STATUSES_IGNORE) == MPI_SUCCESS);
+#ifdef DO_PROFILING
+  print_streaming_timers(timers, my_world_mpi_rank);
+#endif
+}
+
+//Output is identical to run_range_query() with the default output format, but memory at the root
+//is bounded by the chunk size and printing starts as soon as the first chunk is available
+void run_streaming_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, const VidMapper& id_mapper,
+    int num_mpi_processes, int my_world_mpi_rank, bool skip_query_on_root, const uint64_t chunk_size, const unsigned page_size)
+{
+  if(my_world_mpi_rank != 0)
+  {
+    send_range_query_stream(qp, query_config, chunk_size, page_size, my_world_mpi_rank);
+    return;
+  }
+  GTProfileStats* stats_ptr = 0;
+  Timer* query_timer = 0;
+#ifdef DO_PROFILING
+  std::vector<Timer> timers(TIMER_NUM_TIMERS);
+  GTProfileStats stats;
+  stats_ptr = &stats;
+  query_timer = &(timers[TIMER_TILEDB_QUERY_RANGE_IDX]);
+#endif
+  VariantsJSONStreamPrinter printer(query_config, &id_mapper);
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(6);
+  auto flush_output = [&]() {
+    std::cout << ss.str();
+    std::cout.flush();
+    ss.str("");
+  };
+  printer.print_header(ss);
+  if(!skip_query_on_root)
+    run_paged_range_query(qp, query_config, page_size, [&](const std::vector<Variant>& page) {
+#ifdef DO_PROFILING
+        timers[TIMER_JSON_PRINTING_IDX].start();
+#endif
+        for(const auto& variant : page)
+          printer.print(ss, variant);
+        if(static_cast<uint64_t>(ss.tellp()) >= chunk_size)
+          flush_output();
+#ifdef DO_PROFILING
+        timers[TIMER_JSON_PRINTING_IDX].stop();
+#endif
+      }, stats_ptr, query_timer);
+  flush_output();
+  std::vector<uint8_t> receive_buffer(chunk_size+1u);
+  //Re-used for all received variants - compact deserialization re-uses field objects
+  Variant variant;
+  for(auto src_rank=1;src_rank<num_mpi_processes;++src_rank)
+  {
+    while(true)
+    {
+#ifdef DO_PROFILING
+      timers[TIMER_MPI_GATHER_IDX].start();
+#endif
+      MPI_Status status;
+      ASSERT(MPI_Probe(src_rank, GATHER_STREAM_CHUNK_TAG, MPI_COMM_WORLD, &status) == MPI_SUCCESS);
+      int count = 0;
+      ASSERT(MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &count) == MPI_SUCCESS);
+      if(static_cast<size_t>(count) >= receive_buffer.size())
+        receive_buffer.resize(count+1u);
+      ASSERT(MPI_Recv(&(receive_buffer[0]), count, MPI_UNSIGNED_CHAR, src_rank, GATHER_STREAM_CHUNK_TAG,
+            MPI_COMM_WORLD, MPI_STATUS_IGNORE) == MPI_SUCCESS);
+#ifdef DO_PROFILING
+      timers[TIMER_MPI_GATHER_IDX].stop();
+#endif
+      if(count == 0)
+        break;
+      uint64_t offset = 0ull;
+      while(offset < static_cast<uint64_t>(count))
+      {
+#ifdef DO_PROFILING
+        timers[TIMER_ROOT_BINARY_DESERIALIZATION_IDX].start();
+#endif
+        qp.compact_binary_deserialize(variant, query_config, receive_buffer, offset);
+#ifdef DO_PROFILING
+        timers[TIMER_ROOT_BINARY_DESERIALIZATION_IDX].stop();
+        timers[TIMER_JSON_PRINTING_IDX].start();
+#endif
+        printer.print(ss, variant);
+#ifdef DO_PROFILING
+        timers[TIMER_JSON_PRINTING_IDX].stop();
+#endif
+      }
+      flush_output();
+    }
+  }
+#if VERBOSE>0
+  std::cerr << "Completed streaming gather at root, printed "<<printer.get_num_printed_variants()<<" variants\n";
+#endif
+  printer.print_trailer(ss);
+  flush_output();
+#ifdef DO_PROFILING
+  print_streaming_timers(timers, my_world_mpi_rank);
+#endif
+}
+
 #if defined(HTSDIR)
-void scan_and_produce_Broad_GVCF(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
-    VCFAdapter& vcf_adapter, const VidMapper& id_mapper, const JSONVCFAdapterQueryConfig& json_scan_config,
-    int num_mpi_processes, int my_world_mpi_rank, bool skip_query_on_root)
+//Combined GVCF for arrays partitioned by rows - every rank produces partially combined records for its rows
+//(PartialCombineOperator) and streams them to the root, which merges the records of all ranks into the output
+void send_partial_combined_GVCF_stream(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    const JSONVCFAdapterQueryConfig& json_scan_config, const uint64_t chunk_size)
 {
-  //Read output in batches if required
-  //Must initialize buffer before constructing gvcf_op
-  RWBuffer rw_buffer;
-  auto serialized_vcf_adapter_ptr = dynamic_cast<VCFSerializedBufferAdapter*>(&vcf_adapter);
-  if(serialized_vcf_adapter_ptr)
-    serialized_vcf_adapter_ptr->set_buffer(rw_buffer);
-  BroadCombinedGVCFOperator gvcf_op(vcf_adapter, id_mapper, query_config, json_scan_config.get_max_diploid_alt_alleles_that_can_be_genotyped());
-  Timer timer;
-  timer.start();
+  std::vector<uint8_t> buffer(chunk_size);
+  PartialCombineOperator partial_op(query_config, buffer, chunk_size, json_scan_config.get_max_diploid_alt_alleles_that_can_be_genotyped());
+  std::vector<std::vector<uint8_t>> chunks(GATHER_STREAM_NUM_CHUNK_BUFFERS);
+  std::vector<MPI_Request> requests(GATHER_STREAM_NUM_CHUNK_BUFFERS, MPI_REQUEST_NULL);
+  auto curr_chunk_idx = 0u;
+  auto send_chunk = [&]() {
+    auto curr_chunk_length = partial_op.get_num_valid_bytes();
+    //MPI uses int for counts
+    if(curr_chunk_length >= static_cast<uint64_t>(INT_MAX))
+    {
+      std::cerr << "Serialized chunk size beyond 32-bit int limit - exiting.\n";
+      exit(-1);
+    }
+    //Wait till the chunk buffer is free again, then hand the filled buffer over to it
+    ASSERT(MPI_Wait(&(requests[curr_chunk_idx]), MPI_STATUS_IGNORE) == MPI_SUCCESS);
+    chunks[curr_chunk_idx].swap(buffer);
+    if(buffer.size() < chunk_size)
+      buffer.resize(chunk_size);
+    partial_op.reset_buffer();
+    ASSERT(MPI_Issend(&(chunks[curr_chunk_idx][0]), curr_chunk_length, MPI_UNSIGNED_CHAR, 0, GATHER_STREAM_CHUNK_TAG,
+          MPI_COMM_WORLD, &(requests[curr_chunk_idx])) == MPI_SUCCESS);
+    curr_chunk_idx = (curr_chunk_idx+1u)%GATHER_STREAM_NUM_CHUNK_BUFFERS;
+  };
   //At least 1 iteration
   for(auto i=0u;i<std::max(1u, query_config.get_num_column_intervals());++i)
   {
     VariantQueryProcessorScanState scan_state;
     while(!scan_state.end())
     {
-      qp.scan_and_operate(qp.get_array_descriptor(), query_config, gvcf_op, i, true, &scan_state);
-      if(serialized_vcf_adapter_ptr)
-      {
-        serialized_vcf_adapter_ptr->do_output();
-        rw_buffer.m_num_valid_bytes = 0u;
-      }
+      qp.scan_and_operate(qp.get_array_descriptor(), query_config, partial_op, i, true, &scan_state);
+      if(partial_op.overflow())
+        send_chunk();
     }
   }
-  timer.stop();
-  timer.print(std::string("Total scan_and_produce_Broad_GVCF time")+" for rank "+std::to_string(my_world_mpi_rank), std::cerr);
+  if(partial_op.get_num_valid_bytes() > 0ull)
+    send_chunk();
+  //Empty chunk marks end of stream
+  send_chunk();
+  ASSERT(MPI_Waitall(requests.size(), &(requests[0]), MPI_STATUSES_IGNORE) == MPI_SUCCESS);
 }
-#endif
 
-void print_calls(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, int command_idx, const VidMapper& id_mapper)
+//Partially combined records of the rows queried at the root
+class LocalPartialCombinedGVCFSource : public PartialCombinedGVCFSource
 {
-  switch(command_idx)
-  {
-    case COMMAND_PRINT_CALLS:
+  public:
+    LocalPartialCombinedGVCFSource(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+        const JSONVCFAdapterQueryConfig& json_scan_config, const uint64_t chunk_size)
+      : m_buffer(chunk_size),
+      m_partial_op(query_config, m_buffer, chunk_size, json_scan_config.get_max_diploid_alt_alleles_that_can_be_genotyped())
+    {
+      m_qp = &qp;
+      m_query_config = &query_config;
+      m_offset = 0ull;
+      m_column_interval_idx = 0u;
+    }
+    bool next(Variant& partial)
+    {
+      while(m_offset >= m_partial_op.get_num_valid_bytes())
       {
-        std::string indent_prefix = "    ";
-        std::cout << "{\n";
-        //variant_calls is an array of dictionaries
-        std::cout << indent_prefix << "\"variant_calls\": [\n";
-        VariantCallPrintOperator printer(std::cout, indent_prefix+indent_prefix+indent_prefix+indent_prefix, &id_mapper);
-        for(auto i=0ull;i<query_config.get_num_column_intervals();++i)
+        if(m_column_interval_idx >= std::max(1u, m_query_config->get_num_column_intervals()))
+          return false;
+        m_partial_op.reset_buffer();
+        m_offset = 0ull;
+        if(m_scan_state.get() == 0)
+          m_scan_state.reset(new VariantQueryProcessorScanState());
+        m_qp->scan_and_operate(m_qp->get_array_descriptor(), *m_query_config, m_partial_op, m_column_interval_idx, true,
+            m_scan_state.get());
+        if(m_scan_state->end())
         {
-          //Each dictionary contains 2 keys - query_interval and variant_calls
-          std::cout << indent_prefix << indent_prefix << "{\n";
-          std::cout << indent_prefix << indent_prefix << indent_prefix << "\"query_interval\": [ "
-            <<query_config.get_column_begin(i) <<", "<<query_config.get_column_end(i)<<" ],\n";
-          //variant_calls is an array of dictionaries
-          std::cout << indent_prefix << indent_prefix << indent_prefix << "\"variant_calls\": [\n";
-          qp.iterate_over_cells(qp.get_array_descriptor(), query_config, printer, i);
-          std::cout << "\n" << indent_prefix << indent_prefix << indent_prefix << "]\n";
-          std::cout << indent_prefix << indent_prefix << "}\n";
+          m_scan_state.reset();
+          ++m_column_interval_idx;
         }
-        std::cout << indent_prefix << "]\n";
-        std::cout << "}\n";
-        break;
       }
-    case COMMAND_PRINT_CSV:
+      m_qp->compact_binary_deserialize(partial, *m_query_config, m_buffer, m_offset);
+      return true;
+    }
+  private:
+    const VariantQueryProcessor* m_qp;
+    const VariantQueryConfig* m_query_config;
+    std::vector<uint8_t> m_buffer;
+    PartialCombineOperator m_partial_op;
+    uint64_t m_offset;
+    unsigned m_column_interval_idx;
+    std::unique_ptr<VariantQueryProcessorScanState> m_scan_state;
+};
+
+//Partially combined records streamed by send_partial_combined_GVCF_stream() from another rank
+class MPIPartialCombinedGVCFSource : public PartialCombinedGVCFSource
+{
+  public:
+    MPIPartialCombinedGVCFSource(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, const int src_rank)
+    {
+      m_qp = &qp;
+      m_query_config = &query_config;
+      m_src_rank = src_rank;
+      m_num_valid_bytes = 0ull;
+      m_offset = 0ull;
+      m_done = false;
+    }
+    bool next(Variant& partial)
+    {
+      while(m_offset >= m_num_valid_bytes)
       {
-        VariantCallPrintCSVOperator printer(std::cout);
-        for(auto i=0ull;i<query_config.get_num_column_intervals();++i)
-          qp.iterate_over_cells(qp.get_array_descriptor(), query_config, printer, i);
-        break;
+        if(m_done)
+          return false;
+        MPI_Status status;
+        ASSERT(MPI_Probe(m_src_rank, GATHER_STREAM_CHUNK_TAG, MPI_COMM_WORLD, &status) == MPI_SUCCESS);
+        int count = 0;
+        ASSERT(MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &count) == MPI_SUCCESS);
+        if(static_cast<size_t>(count) >= m_buffer.size())
+          m_buffer.resize(count+1u);
+        ASSERT(MPI_Recv(&(m_buffer[0]), count, MPI_UNSIGNED_CHAR, m_src_rank, GATHER_STREAM_CHUNK_TAG,
+              MPI_COMM_WORLD, MPI_STATUS_IGNORE) == MPI_SUCCESS);
+        m_num_valid_bytes = count;
+        m_offset = 0ull;
+        m_done = (count == 0);
       }
-    default:
-      std::cerr << "Unknown print_calls command "<<command_idx<<"\n";
-      exit(-1);
+      m_qp->compact_binary_deserialize(partial, *m_query_config, m_buffer, m_offset);
+      return true;
+    }
+  private:
+    const VariantQueryProcessor* m_qp;
+    const VariantQueryConfig* m_query_config;
+    int m_src_rank;
+    std::vector<uint8_t> m_buffer;
+    uint64_t m_num_valid_bytes;
+    uint64_t m_offset;
+    bool m_done;
+};
+
+void produce_Broad_GVCF_for_row_partitions(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    VCFAdapter& vcf_adapter, const VidMapper& id_mapper, const JSONVCFAdapterQueryConfig& json_scan_config,
+    int num_mpi_processes, int my_world_mpi_rank, bool skip_query_on_root, const uint64_t chunk_size)
+{
+  Timer timer;
+  timer.start();
+  //Rows queried by every rank - the root combines the calls of all of them
+  std::vector<int64_t> queried_rows;
+  if(my_world_mpi_rank != 0 || !skip_query_on_root)
+    for(auto i=0ull;i<query_config.get_num_rows_to_query();++i)
+      queried_rows.push_back(query_config.get_array_row_idx_for_query_row_idx(i));
+  int num_queried_rows = queried_rows.size();
+  std::vector<int> gathered_num_queried_rows(num_mpi_processes);
+  ASSERT(MPI_Gather(&num_queried_rows, 1, MPI_INT, &(gathered_num_queried_rows[0]), 1, MPI_INT, 0, MPI_COMM_WORLD) == MPI_SUCCESS);
+  std::vector<int> displs(num_mpi_processes, 0);
+  for(auto i=1;i<num_mpi_processes;++i)
+    displs[i] = displs[i-1] + gathered_num_queried_rows[i-1];
+  std::vector<int64_t> all_queried_rows(my_world_mpi_rank == 0
+      ? displs[num_mpi_processes-1]+gathered_num_queried_rows[num_mpi_processes-1] : 0);
+  //Avoid taking the address of elements of empty vectors
+  queried_rows.push_back(0);
+  all_queried_rows.push_back(0);
+  ASSERT(MPI_Gatherv(&(queried_rows[0]), num_queried_rows, MPI_INT64_T, &(all_queried_rows[0]), &(gathered_num_queried_rows[0]),
+        &(displs[0]), MPI_INT64_T, 0, MPI_COMM_WORLD) == MPI_SUCCESS);
+  all_queried_rows.pop_back();
+  if(my_world_mpi_rank != 0)
+  {
+    send_partial_combined_GVCF_stream(qp, query_config, json_scan_config, chunk_size);
+    timer.stop();
+    timer.print(std::string("Total partial combine time")+" for rank "+std::to_string(my_world_mpi_rank), std::cerr);
+    return;
+  }
+  if(all_queried_rows.empty())
+  {
+    std::cerr << "No rows queried in any partition - no combined GVCF produced\n";
+    return;
   }
+  std::sort(all_queried_rows.begin(), all_queried_rows.end());
+  all_queried_rows.erase(std::unique(all_queried_rows.begin(), all_queried_rows.end()), all_queried_rows.end());
+  //Query config of the reducer spans the rows of all partitions
+  VariantQueryConfig reducer_query_config(query_config);
+  reducer_query_config.set_rows_to_query(all_queried_rows);
+  reducer_query_config.set_num_rows_in_array(all_queried_rows.back()-all_queried_rows.front()+1, all_queried_rows.front());
+  reducer_query_config.setup_array_row_idx_to_query_row_idx_map();
+  //Must initialize buffer before constructing the reducer
+  RWBuffer rw_buffer;
+  auto serialized_vcf_adapter_ptr = dynamic_cast<VCFSerializedBufferAdapter*>(&vcf_adapter);
+  if(serialized_vcf_adapter_ptr)
+    serialized_vcf_adapter_ptr->set_buffer(rw_buffer);
+  BroadCombinedGVCFPartialsReducer reducer(vcf_adapter, id_mapper, reducer_query_config,
+      json_scan_config.get_max_diploid_alt_alleles_that_can_be_genotyped());
+  std::vector<PartialCombinedGVCFSource*> sources;
+  if(!skip_query_on_root)
+    sources.push_back(new LocalPartialCombinedGVCFSource(qp, query_config, json_scan_config, chunk_size));
+  for(auto src_rank=1;src_rank<num_mpi_processes;++src_rank)
+    sources.push_back(new MPIPartialCombinedGVCFSource(qp, query_config, src_rank));
+  auto done = false;
+  while(!done)
+  {
+    done = reducer.reduce(sources);
+    if(serialized_vcf_adapter_ptr)
+    {
+      serialized_vcf_adapter_ptr->do_output();
+      rw_buffer.m_num_valid_bytes = 0u;
+    }
+  }
+  for(auto source_ptr : sources)
+    delete source_ptr;
+  timer.stop();
+  timer.print(std::string("Total produce_Broad_GVCF_for_row_partitions time")+" for rank "+std::to_string(my_world_mpi_rank), std::cerr);
+}
+#endif
+
+//Columnar export - every rank writes the sites of its partition into its own Parquet file
+void export_columnar(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    const VidMapper& id_mapper, const std::string& filename, const ColumnarExportLayoutEnum layout,
+    const uint64_t row_group_num_sites, int num_mpi_processes, int my_world_mpi_rank)
+{
+  auto rank_filename = (num_mpi_processes > 1) ? (filename+"."+std::to_string(my_world_mpi_rank)) : filename;
+  ColumnarExportOperator export_op(rank_filename, id_mapper, query_config, layout, row_group_num_sites);
+  Timer timer;
+  timer.start();
+  //At least 1 iteration
+  for(auto i=0u;i<std::max(1u, query_config.get_num_column_intervals());++i)
+  {
+    VariantQueryProcessorScanState scan_state;
+    while(!scan_state.end())
+      qp.scan_and_operate(qp.get_array_descriptor(), query_config, export_op, i, true, &scan_state);
+  }
+  export_op.finalize();
+  timer.stop();
+  timer.print(std::string("Total export_columnar time")+" for rank "+std::to_string(my_world_mpi_rank), std::cerr);
+#if VERBOSE>0
+  std::cerr << "Exported "<<export_op.get_num_sites()<<" sites to "<<rank_filename<<"\n";
+#endif
 }
 
-void produce_column_histogram(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, uint64_t bin_size,
-    const std::vector<uint64_t>& num_equi_load_bins)
+//Genotype matrix export - every rank writes the sites of its partition into its own set of files
+void export_genotype_matrix(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    const VidMapper& id_mapper, const std::string& prefix, const GenotypeMatrixFormatEnum format,
+    const GenotypeMatrixMultiAllelicEnum multiallelic_mode, const unsigned num_threads,
+    int num_mpi_processes, int my_world_mpi_rank)
 {
-  ColumnHistogramOperator histogram_op(0, 4000000000ull, bin_size);
-  qp.iterate_over_cells(qp.get_array_descriptor(), query_config, histogram_op, 0u);
-  for(auto val : num_equi_load_bins)
-    histogram_op.equi_partition_and_print_bins(val);
+  auto rank_prefix = (num_mpi_processes > 1) ? (prefix+"."+std::to_string(my_world_mpi_rank)) : prefix;
+  GenotypeMatrixExportOperator export_op(rank_prefix, id_mapper, query_config, format, multiallelic_mode, 4096ull, num_threads);
+  Timer timer;
+  timer.start();
+  //At least 1 iteration
+  for(auto i=0u;i<std::max(1u, query_config.get_num_column_intervals());++i)
+  {
+    VariantQueryProcessorScanState scan_state;
+    while(!scan_state.end())
+      qp.scan_and_operate(qp.get_array_descriptor(), query_config, export_op, i, true, &scan_state);
+  }
+  export_op.finalize();
+  timer.stop();
+  timer.print(std::string("Total export_genotype_matrix time")+" for rank "+std::to_string(my_world_mpi_rank), std::cerr);
+#if VERBOSE>0
+  std::cerr << "Exported "<<export_op.get_num_variants()<<" variants x "<<export_op.get_num_samples()
+    <<" samples to "<<rank_prefix<<"\n";
+#endif
 }
 
 int main(int argc, char *argv[]) {
@@ -428,6 +801,16 @@ int main(int argc, char *argv[]) {
     {"print-csv",0,0,ARGS_IDX_PRINT_CSV},
     {"array",1,0,'A'},
     {"version",0,0,ARGS_IDX_VERSION},
+    {"streaming-chunk-size",1,0,ARGS_IDX_STREAMING_CHUNK_SIZE},
+    {"streaming-page-size",1,0,ARGS_IDX_STREAMING_PAGE_SIZE},
+    {"combine-row-partitions",0,0,ARGS_IDX_COMBINE_ROW_PARTITIONS},
+    {"export-columnar",1,0,ARGS_IDX_EXPORT_COLUMNAR},
+    {"columnar-layout",1,0,ARGS_IDX_COLUMNAR_LAYOUT},
+    {"columnar-row-group-size",1,0,ARGS_IDX_COLUMNAR_ROW_GROUP_SIZE},
+    {"export-genotype-matrix",1,0,ARGS_IDX_EXPORT_GENOTYPE_MATRIX},
+    {"genotype-matrix-format",1,0,ARGS_IDX_GENOTYPE_MATRIX_FORMAT},
+    {"multiallelic",1,0,ARGS_IDX_MULTIALLELIC},
+    {"num-threads",1,0,ARGS_IDX_NUM_THREADS},
     {0,0,0,0},
   };
   int c;
@@ -441,6 +824,16 @@ int main(int argc, char *argv[]) {
   auto print_version_only = false;
   unsigned command_idx = COMMAND_RANGE_QUERY;
   size_t segment_size = 10u*1024u*1024u; //in bytes = 10MB
+  uint64_t streaming_chunk_size = 0ull; //0 - gather all variants at root before printing
+  unsigned streaming_page_size = GATHER_STREAM_QUERY_PAGE_SIZE;
+  auto combine_row_partitions = false;
+  std::string columnar_filename = "";
+  auto columnar_layout = COLUMNAR_EXPORT_LAYOUT_NESTED;
+  uint64_t columnar_row_group_num_sites = 65536ull;
+  std::string genotype_matrix_prefix = "";
+  auto genotype_matrix_format = GENOTYPE_MATRIX_FORMAT_PLINK_BED;
+  auto multiallelic_mode = GENOTYPE_MATRIX_MULTIALLELIC_SPLIT;
+  unsigned num_threads = 1u;
   while((c=getopt_long(argc, argv, "j:l:w:A:p:O:s:r:", long_options, NULL)) >= 0)
   {
     switch(c)
@@ -485,6 +878,67 @@ int main(int argc, char *argv[]) {
       case 'l':
         loader_json_config_file = std::move(std::string(optarg));
         break;
+      case ARGS_IDX_STREAMING_CHUNK_SIZE:
+        streaming_chunk_size = strtoull(optarg, 0, 10);
+        break;
+      case ARGS_IDX_STREAMING_PAGE_SIZE:
+        streaming_page_size = strtoul(optarg, 0, 10);
+        if(streaming_page_size == 0u)
+        {
+          std::cerr << "Streaming page size must be positive\n";
+          exit(-1);
+        }
+        break;
+      case ARGS_IDX_COMBINE_ROW_PARTITIONS:
+        combine_row_partitions = true;
+        break;
+      case ARGS_IDX_EXPORT_COLUMNAR:
+        columnar_filename = std::move(std::string(optarg));
+        command_idx = COMMAND_EXPORT_COLUMNAR;
+        break;
+      case ARGS_IDX_COLUMNAR_LAYOUT:
+        if(std::string(optarg) == "nested")
+          columnar_layout = COLUMNAR_EXPORT_LAYOUT_NESTED;
+        else if(std::string(optarg) == "long")
+          columnar_layout = COLUMNAR_EXPORT_LAYOUT_LONG;
+        else
+        {
+          std::cerr << "Unknown columnar layout "<<optarg<<" - must be one of nested, long\n";
+          exit(-1);
+        }
+        break;
+      case ARGS_IDX_COLUMNAR_ROW_GROUP_SIZE:
+        columnar_row_group_num_sites = strtoull(optarg, 0, 10);
+        break;
+      case ARGS_IDX_EXPORT_GENOTYPE_MATRIX:
+        genotype_matrix_prefix = std::move(std::string(optarg));
+        command_idx = COMMAND_EXPORT_GENOTYPE_MATRIX;
+        break;
+      case ARGS_IDX_GENOTYPE_MATRIX_FORMAT:
+        if(std::string(optarg) == "plink")
+          genotype_matrix_format = GENOTYPE_MATRIX_FORMAT_PLINK_BED;
+        else if(std::string(optarg) == "dosage")
+          genotype_matrix_format = GENOTYPE_MATRIX_FORMAT_DOSAGE;
+        else
+        {
+          std::cerr << "Unknown genotype matrix format "<<optarg<<" - must be one of plink, dosage\n";
+          exit(-1);
+        }
+        break;
+      case ARGS_IDX_MULTIALLELIC:
+        if(std::string(optarg) == "split")
+          multiallelic_mode = GENOTYPE_MATRIX_MULTIALLELIC_SPLIT;
+        else if(std::string(optarg) == "alt-count")
+          multiallelic_mode = GENOTYPE_MATRIX_MULTIALLELIC_ALT_COUNT;
+        else
+        {
+          std::cerr << "Unknown multiallelic mode "<<optarg<<" - must be one of split, alt-count\n";
+          exit(-1);
+        }
+        break;
+      case ARGS_IDX_NUM_THREADS:
+        num_threads = strtoull(optarg, 0, 10);
+        break;
       case ARGS_IDX_VERSION:
         std::cout << GENOMICSDB_VERSION <<"\n";
         print_version_only = true;
@@ -494,6 +948,12 @@ int main(int argc, char *argv[]) {
         exit(-1);
     }
   }
+  if(command_idx == COMMAND_EXPORT_GENOTYPE_MATRIX && genotype_matrix_format == GENOTYPE_MATRIX_FORMAT_PLINK_BED
+      && multiallelic_mode == GENOTYPE_MATRIX_MULTIALLELIC_ALT_COUNT)
+  {
+    std::cerr << "Multiallelic mode alt-count is not supported with the plink format - PLINK variants have a single A1 allele, use split or the dosage format\n";
+    exit(-1);
+  }
   if(!print_version_only)
   {
     //Use VariantQueryConfig to setup query info
@@ -501,12 +961,12 @@ int main(int argc, char *argv[]) {
     //Vid mapping
     FileBasedVidMapper id_mapper;
     //Loader configuration
-    JSONLoaderConfig loader_config;
-    JSONLoaderConfig* loader_config_ptr = 0;
+    std::shared_ptr<const JSONLoaderConfig> loader_config;
     if(!(loader_json_config_file.empty()))
     {
-      loader_config.read_from_file(loader_json_config_file, &id_mapper, my_world_mpi_rank);
-      loader_config_ptr = &loader_config;
+      auto parsed_loader_config = std::make_shared<JSONLoaderConfig>();
+      parsed_loader_config->read_from_file(loader_json_config_file, &id_mapper, my_world_mpi_rank);
+      loader_config = parsed_loader_config;
     }
 #ifdef HTSDIR
     VCFAdapter vcf_adapter_base;
@@ -523,7 +983,8 @@ int main(int argc, char *argv[]) {
       {
         case COMMAND_PRODUCE_BROAD_GVCF:
 #if defined(HTSDIR)
-          scan_config.read_from_file(json_config_file, query_config, vcf_adapter, &id_mapper, output_format, my_world_mpi_rank);
+          scan_config.read_from_file(json_config_file, query_config, vcf_adapter, &id_mapper, output_format, my_world_mpi_rank,
+              0u, loader_config);
           json_config_ptr = static_cast<JSONBasicQueryConfig*>(&scan_config);
 #else
           std::cerr << "Cannot produce Broad's combined GVCF without htslib. Re-compile with HTSDIR variable set\n";
@@ -531,7 +992,7 @@ int main(int argc, char *argv[]) {
 #endif
           break;
         default:
-          range_query_config.read_from_file(json_config_file, query_config, &id_mapper, my_world_mpi_rank, loader_config_ptr);
+          range_query_config.read_from_file(json_config_file, query_config, &id_mapper, my_world_mpi_rank, loader_config);
           json_config_ptr = &range_query_config;
           break;
       }
@@ -556,6 +1017,14 @@ int main(int argc, char *argv[]) {
           std::cerr << "To produce Broad's combined GVCF, you need to pass parameters through a JSON file, exiting\n";
           exit(-1);
           break;
+        case COMMAND_EXPORT_COLUMNAR:
+          std::cerr << "To export to a columnar file, you need to pass parameters through a JSON file, exiting\n";
+          exit(-1);
+          break;
+        case COMMAND_EXPORT_GENOTYPE_MATRIX:
+          std::cerr << "To export a genotype matrix, you need to pass parameters through a JSON file, exiting\n";
+          exit(-1);
+          break;
         case COMMAND_PRODUCE_HISTOGRAM:
           break;  //no attributes
         case COMMAND_PRINT_CALLS:
@@ -583,27 +1052,47 @@ int main(int argc, char *argv[]) {
     /*Create query processor*/
     VariantQueryProcessor qp(&sm, array_name, id_mapper);
     auto require_alleles = ((command_idx == COMMAND_RANGE_QUERY)
-        || (command_idx == COMMAND_PRODUCE_BROAD_GVCF));
+        || (command_idx == COMMAND_PRODUCE_BROAD_GVCF) || (command_idx == COMMAND_EXPORT_COLUMNAR)
+        || (command_idx == COMMAND_EXPORT_GENOTYPE_MATRIX));
     qp.do_query_bookkeeping(qp.get_array_schema(), query_config, id_mapper, require_alleles);
     switch(command_idx)
     {
       case COMMAND_RANGE_QUERY:
-        run_range_query(qp, query_config, static_cast<const VidMapper&>(id_mapper), output_format,
-            (loader_json_config_file.empty() || loader_config.is_partitioned_by_column()),
-            num_mpi_processes, my_world_mpi_rank, skip_query_on_root);
+        if(streaming_chunk_size > 0u && can_stream_range_query_output(output_format))
+          run_streaming_range_query(qp, query_config, static_cast<const VidMapper&>(id_mapper),
+              num_mpi_processes, my_world_mpi_rank, skip_query_on_root, streaming_chunk_size, streaming_page_size);
+        else
+          run_range_query(qp, query_config, static_cast<const VidMapper&>(id_mapper), output_format,
+              (!loader_config || loader_config->is_partitioned_by_column()),
+              num_mpi_processes, my_world_mpi_rank, skip_query_on_root);
         break;
       case COMMAND_PRODUCE_BROAD_GVCF:
 #if defined(HTSDIR)
-        scan_and_produce_Broad_GVCF(qp, query_config, vcf_adapter, static_cast<const VidMapper&>(id_mapper), scan_config,
-            num_mpi_processes, my_world_mpi_rank, skip_query_on_root);
+        //Each rank holds a subset of the samples - produce a single combined GVCF at the root
+        if(combine_row_partitions)
+          produce_Broad_GVCF_for_row_partitions(qp, query_config, vcf_adapter, static_cast<const VidMapper&>(id_mapper), scan_config,
+              num_mpi_processes, my_world_mpi_rank, skip_query_on_root, std::max<uint64_t>(streaming_chunk_size, MegaByte));
+        else
+          scan_and_produce_Broad_GVCF(qp, query_config, vcf_adapter, static_cast<const VidMapper&>(id_mapper), scan_config,
+              my_world_mpi_rank);
 #endif
         break;
       case COMMAND_PRODUCE_HISTOGRAM:
         produce_column_histogram(qp, query_config, 100, std::vector<uint64_t>({ 128, 64, 32, 16, 8, 4, 2 }));
         break;
       case COMMAND_PRINT_CALLS:
+        print_calls(qp, query_config, static_cast<const VidMapper&>(id_mapper));
+        break;
       case COMMAND_PRINT_CSV:
-        print_calls(qp, query_config, command_idx, static_cast<const VidMapper&>(id_mapper));
+        print_calls_csv(qp, query_config);
+        break;
+      case COMMAND_EXPORT_COLUMNAR:
+        export_columnar(qp, query_config, static_cast<const VidMapper&>(id_mapper), columnar_filename, columnar_layout,
+            columnar_row_group_num_sites, num_mpi_processes, my_world_mpi_rank);
+        break;
+      case COMMAND_EXPORT_GENOTYPE_MATRIX:
+        export_genotype_matrix(qp, query_config, static_cast<const VidMapper&>(id_mapper), genotype_matrix_prefix,
+            genotype_matrix_format, multiallelic_mode, num_threads, num_mpi_processes, my_world_mpi_rank);
         break;
     }
 #ifdef USE_GPERFTOOLS
@@ -0,0 +1,95 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016-2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "gt_query_operations.h"
+#include "broad_combined_gvcf.h"
+
+#ifdef HTSDIR
+void scan_and_produce_Broad_GVCF(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    VCFAdapter& vcf_adapter, const VidMapper& id_mapper, const JSONVCFAdapterQueryConfig& json_scan_config, const int rank)
+{
+  //Read output in batches if required
+  //Must initialize buffer before constructing gvcf_op
+  RWBuffer rw_buffer;
+  auto serialized_vcf_adapter_ptr = dynamic_cast<VCFSerializedBufferAdapter*>(&vcf_adapter);
+  if(serialized_vcf_adapter_ptr)
+    serialized_vcf_adapter_ptr->set_buffer(rw_buffer);
+  BroadCombinedGVCFOperator gvcf_op(vcf_adapter, id_mapper, query_config, json_scan_config.get_max_diploid_alt_alleles_that_can_be_genotyped());
+  Timer timer;
+  timer.start();
+  //At least 1 iteration
+  for(auto i=0u;i<std::max(1u, query_config.get_num_column_intervals());++i)
+  {
+    VariantQueryProcessorScanState scan_state;
+    while(!scan_state.end())
+    {
+      qp.scan_and_operate(qp.get_array_descriptor(), query_config, gvcf_op, i, true, &scan_state);
+      if(serialized_vcf_adapter_ptr)
+      {
+        serialized_vcf_adapter_ptr->do_output();
+        rw_buffer.m_num_valid_bytes = 0u;
+      }
+    }
+  }
+  timer.stop();
+  timer.print(std::string("Total scan_and_produce_Broad_GVCF time")+" for rank "+std::to_string(rank), std::cerr);
+}
+#endif
+
+void print_calls(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, const VidMapper& id_mapper)
+{
+  std::string indent_prefix = "    ";
+  std::cout << "{\n";
+  //variant_calls is an array of dictionaries
+  std::cout << indent_prefix << "\"variant_calls\": [\n";
+  VariantCallPrintOperator printer(std::cout, indent_prefix+indent_prefix+indent_prefix+indent_prefix, &id_mapper);
+  for(auto i=0ull;i<query_config.get_num_column_intervals();++i)
+  {
+    //Each dictionary contains 2 keys - query_interval and variant_calls
+    std::cout << indent_prefix << indent_prefix << "{\n";
+    std::cout << indent_prefix << indent_prefix << indent_prefix << "\"query_interval\": [ "
+      <<query_config.get_column_begin(i) <<", "<<query_config.get_column_end(i)<<" ],\n";
+    //variant_calls is an array of dictionaries
+    std::cout << indent_prefix << indent_prefix << indent_prefix << "\"variant_calls\": [\n";
+    qp.iterate_over_cells(qp.get_array_descriptor(), query_config, printer, i);
+    std::cout << "\n" << indent_prefix << indent_prefix << indent_prefix << "]\n";
+    std::cout << indent_prefix << indent_prefix << "}\n";
+  }
+  std::cout << indent_prefix << "]\n";
+  std::cout << "}\n";
+}
+
+void print_calls_csv(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config)
+{
+  VariantCallPrintCSVOperator printer(std::cout);
+  for(auto i=0ull;i<query_config.get_num_column_intervals();++i)
+    qp.iterate_over_cells(qp.get_array_descriptor(), query_config, printer, i);
+}
+
+void produce_column_histogram(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, uint64_t bin_size,
+    const std::vector<uint64_t>& num_equi_load_bins)
+{
+  ColumnHistogramOperator histogram_op(0, 4000000000ull, bin_size);
+  qp.iterate_over_cells(qp.get_array_descriptor(), query_config, histogram_op, 0u);
+  for(auto val : num_equi_load_bins)
+    histogram_op.equi_partition_and_print_bins(val);
+}
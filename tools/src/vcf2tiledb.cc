@@ -36,6 +36,7 @@ enum VCF2TileDBArgsEnum
   VCF2TILEDB_ARG_SPLIT_FILES_RESULTS_DIRECTORY_IDX,
   VCF2TILEDB_ARG_SPLIT_FILES_SPLIT_OUTPUT_FILENAME_IDX,
   VCF2TILEDB_ARG_SPLIT_FILES_SPLIT_CALLSET_MAPPING_IDX,
+  VCF2TILEDB_ARG_SPLIT_FILES_SINGLE_PASS_IDX,
   VCF2TILEDB_ARG_VERSION
 };
 
@@ -60,6 +61,7 @@ int main(int argc, char** argv)
     {"split-files-results-directory",1,0,VCF2TILEDB_ARG_SPLIT_FILES_RESULTS_DIRECTORY_IDX},
     {"split-output-filename",1,0,VCF2TILEDB_ARG_SPLIT_FILES_SPLIT_OUTPUT_FILENAME_IDX},
     {"split-callset-mapping-file",0,0,VCF2TILEDB_ARG_SPLIT_FILES_SPLIT_CALLSET_MAPPING_IDX},
+    {"split-single-pass",0,0,VCF2TILEDB_ARG_SPLIT_FILES_SINGLE_PASS_IDX},
     {"version",0,0,VCF2TILEDB_ARG_VERSION},
     {0,0,0,0},
   };
@@ -69,6 +71,7 @@ int main(int argc, char** argv)
   std::string results_directory;
   std::string split_output_filename;
   auto split_callset_mapping_file = false;
+  auto split_single_pass = false;
   auto print_version_only = false;
   while((c=getopt_long(argc, argv, "T:r:", long_options, NULL)) >= 0)
   {
@@ -95,6 +98,9 @@ int main(int argc, char** argv)
       case VCF2TILEDB_ARG_SPLIT_FILES_SPLIT_CALLSET_MAPPING_IDX:
         split_callset_mapping_file = true;
         break;
+      case VCF2TILEDB_ARG_SPLIT_FILES_SINGLE_PASS_IDX:
+        split_single_pass = true;
+        break;
       case VCF2TILEDB_ARG_VERSION:
         std::cout << GENOMICSDB_VERSION <<"\n";
         print_version_only = true;
@@ -118,10 +124,11 @@ int main(int argc, char** argv)
     //Split files as per the partitions defined - don't load data
     if(split_files)
     {
-      JSONLoaderConfig loader_config;
+      //Parsed once and shared by all the converters below
+      auto loader_config = std::make_shared<JSONLoaderConfig>();
       FileBasedVidMapper id_mapper;
-      loader_config.read_from_file(loader_json_config_file, &id_mapper, my_world_mpi_rank);
-      if(loader_config.is_partitioned_by_row())
+      loader_config->read_from_file(loader_json_config_file, &id_mapper, my_world_mpi_rank);
+      if(loader_config->is_partitioned_by_row())
       {
         std::cerr << "Splitting is available for column partitioning, row partitioning should be trivial if samples are scattered across files. See wiki page https://github.com/Intel-HLS/GenomicsDB/wiki/Dealing-with-multiple-GenomicsDB-partitions for more information\n";
         return 0;
@@ -134,19 +141,30 @@ int main(int argc, char** argv)
         id_mapper.set_single_split_file_path(0u, split_output_filename);
       std::vector<std::vector<uint8_t>> empty_buffers;
       std::vector<LoaderConverterMessageExchange> empty_exchange;
-      const auto& column_partitions = loader_config.get_sorted_column_partitions();
+      const auto& column_partitions = loader_config->get_sorted_column_partitions();
       auto loop_bound = (produce_all_partitions ? column_partitions.size() : 1u);
-      for(auto i=0ull;i<loop_bound;++i)
+      //Each file is read once and records are dispatched to all partitions
+      if(produce_all_partitions && split_single_pass)
       {
-        int rank = produce_all_partitions ? i : my_world_mpi_rank;
-        VCF2TileDBConverter converter(loader_json_config_file, rank,
-            static_cast<VidMapper*>(&id_mapper), &empty_buffers, &empty_exchange);
-        converter.print_all_partitions(results_directory, "", rank);
+        VCF2TileDBConverter converter(loader_config, 0,
+            static_cast<VidMapper*>(&id_mapper), &empty_buffers, &empty_exchange, true);
+        converter.print_all_partitions_single_pass(results_directory, "");
         if(split_callset_mapping_file)
-          id_mapper.write_partition_callsets_json_file(loader_config.get_callset_mapping_filename(), results_directory, rank);
+          for(auto i=0ull;i<loop_bound;++i)
+            id_mapper.write_partition_callsets_json_file(loader_config->get_callset_mapping_filename(), results_directory, i);
       }
+      else
+        for(auto i=0ull;i<loop_bound;++i)
+        {
+          int rank = produce_all_partitions ? i : my_world_mpi_rank;
+          VCF2TileDBConverter converter(loader_config, rank,
+              static_cast<VidMapper*>(&id_mapper), &empty_buffers, &empty_exchange);
+          converter.print_all_partitions(results_directory, "", rank);
+          if(split_callset_mapping_file)
+            id_mapper.write_partition_callsets_json_file(loader_config->get_callset_mapping_filename(), results_directory, rank);
+        }
       if(split_callset_mapping_file)
-        id_mapper.write_partition_loader_json_file(loader_json_config_file, loader_config.get_callset_mapping_filename(),
+        id_mapper.write_partition_loader_json_file(loader_json_config_file, loader_config->get_callset_mapping_filename(),
             results_directory, (produce_all_partitions ? column_partitions.size() : 1u), my_world_mpi_rank);
     }
     else
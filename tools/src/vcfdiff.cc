@@ -22,12 +22,25 @@
 
 #include <getopt.h>
 #include <mpi.h>
+#include <atomic>
+#include <memory>
+#include <type_traits>
 #include "vcfdiff.h"
 #include "vid_mapper.h"
 #include "json_config.h"
 
 double g_threshold = 1e-5; //fp comparison threshold
 int64_t g_num_callsets = INT64_MAX;
+//Per field fp comparison thresholds, override g_threshold
+std::unordered_map<std::string, double> g_field_to_threshold;
+//Stop comparing once these many differences are found across all threads, 0 - no limit
+uint64_t g_max_num_differences = 0ull;
+std::atomic<uint64_t> g_num_differences(0ull);
+
+inline bool difference_limit_reached()
+{
+  return g_max_num_differences && g_num_differences.load(std::memory_order_relaxed) >= g_max_num_differences;
+}
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw VCFDiffException(#X);
 
@@ -38,8 +51,14 @@ VCFDiffFile::VCFDiffFile(const std::string& filename, const std::string& regions
   m_regions = "";
   m_reader = bcf_sr_init();
   m_num_lines_read = 0ll;
+  m_min_line_position = -1ll;
+  m_max_line_position = -1ll;
   m_hdr = 0;
   m_line = 0;
+  m_diff_alleles_flag = false;
+  m_identity_alleles_lut = false;
+  m_identity_samples_lut = false;
+  m_QUAL_threshold = g_threshold;
   //Tmp buffer
   m_tmp_hts_string.m = 65536;    //64KB
   m_tmp_hts_string.s = (char*)malloc(m_tmp_hts_string.m*sizeof(char));
@@ -133,15 +152,50 @@ void VCFDiffFile::setup_luts(const VCFDiffFile& gold, const bool use_callsets_fi
   m_fields_in_gold_line.resize(std::max(gold.m_fields.size(), m_fields.size()));
   m_fields_in_test_line.resize(std::max(gold.m_fields.size(), m_fields.size()));
   reset_field_to_line_idx_mapping();
+  //Float thresholds
+  m_field_idx_to_threshold.resize(m_hdr->n[BCF_DT_ID]);
+  for(auto i=0;i<m_hdr->n[BCF_DT_ID];++i)
+  {
+    auto iter = g_field_to_threshold.find(bcf_hdr_int2id(m_hdr, BCF_DT_ID, i));
+    m_field_idx_to_threshold[i] = (iter != g_field_to_threshold.end()) ? (*iter).second : g_threshold;
+  }
+  auto iter = g_field_to_threshold.find("QUAL");
+  m_QUAL_threshold = (iter != g_field_to_threshold.end()) ? (*iter).second : g_threshold;
+}
+
+void VCFDiffFile::set_identity_samples_lut_flag(const VCFDiffFile& gold)
+{
+  m_identity_samples_lut = (bcf_hdr_nsamples(gold.m_hdr) == bcf_hdr_nsamples(m_hdr));
+  for(auto j=0;m_identity_samples_lut && j<bcf_hdr_nsamples(gold.m_hdr);++j)
+    m_identity_samples_lut = (m_samples_lut.get_test_idx_for_gold(0, j) == j);
 }
 
 void VCFDiffFile::set_regions_and_open_file()
 {
+  //Re-opened for every shard - drop the reader for the previous region
+  if(m_reader->nreaders > 0)
+  {
+    bcf_sr_destroy(m_reader);
+    m_reader = bcf_sr_init();
+  }
+  m_line = 0;
   bcf_sr_set_regions(m_reader, m_regions.c_str(), 0);
   if(bcf_sr_add_reader(m_reader, m_filename.c_str()) != 1)
     throw VCFDiffException(std::string("Could not open file ")+m_filename+" or its index doesn't exist - VCF/BCF files must be block compressed and indexed");
-  bcf_sr_next_line(m_reader);
-  m_line = bcf_sr_get_line(m_reader, 0);
+  read_next_line();
+}
+
+void VCFDiffFile::read_next_line()
+{
+  do
+  {
+    bcf_sr_next_line(m_reader);
+    m_line = bcf_sr_get_line(m_reader, 0);
+  }
+  while(m_line && m_line->pos < m_min_line_position);
+  //A line belongs to the shard in which it starts
+  if(m_line && m_max_line_position >= 0 && m_line->pos > m_max_line_position)
+    m_line = 0;
   if(m_line)
     ++m_num_lines_read;
 }
@@ -149,10 +203,7 @@ void VCFDiffFile::set_regions_and_open_file()
 void VCFDiffFile::read_and_advance()
 {
   assert(m_line);
-  bcf_sr_next_line(m_reader);
-  m_line = bcf_sr_get_line(m_reader, 0);
-  if(m_line)
-    ++m_num_lines_read;
+  read_next_line();
 }
 
 void VCFDiffFile::seek_and_read(const int rid, const int pos)
@@ -160,10 +211,7 @@ void VCFDiffFile::seek_and_read(const int rid, const int pos)
   assert(rid >= 0 && rid < m_hdr->n[BCF_DT_CTG]);
   auto contig = bcf_hdr_id2name(m_hdr, rid);
   bcf_sr_seek(m_reader, contig, pos);
-  bcf_sr_next_line(m_reader);
-  m_line = bcf_sr_get_line(m_reader, 0);
-  if(m_line)
-    ++m_num_lines_read;
+  read_next_line();
 }
 
 void VCFDiffFile::print_line(std::ostream& fptr)
@@ -324,7 +372,7 @@ bool bcf_is_empty_field(const bcf_hdr_t* hdr, const bcf1_t* line, const int bcf_
 }
 
 template<class T1, class T2>
-inline bool compare_unequal(const T1 a, const T2 b)
+inline bool compare_unequal(const T1 a, const T2 b, const double threshold=g_threshold)
 {
   return !(
       (a == b) ||
@@ -335,14 +383,14 @@ inline bool compare_unequal(const T1 a, const T2 b)
 
 //Specialization for float - values should be close
 template<>
-inline bool compare_unequal(const float a, const float b)
+inline bool compare_unequal(const float a, const float b, const double threshold)
 {
   if((is_bcf_missing_value<float>(a) && is_bcf_missing_value<float>(b)) ||
       (is_bcf_vector_end_value<float>(a) && is_bcf_vector_end_value<float>(b)))
     return false;
   float diff = fabsf(a-b);
   float rel_diff = ((a != 0) ? fabsf(diff/a) : 0);
-  return (diff > g_threshold && rel_diff > g_threshold);
+  return (diff > threshold && rel_diff > threshold);
 }
 
 template<class T1, class T2>
@@ -372,9 +420,20 @@ bool VCFDiffFile::compare_unequal_vector(const bcf_hdr_t* gold_hdr, const bcf1_t
   }
   //Vector lengths must be identical for these types of fields
   //Also, if the alleles don't match, don't bother checking further
-  if((length_descriptor == BCF_VL_G || length_descriptor == BCF_VL_R || length_descriptor == BCF_VL_A)
-    && (num_test_elements != num_gold_elements || m_diff_alleles_flag))
+  auto is_allele_dependent = (length_descriptor == BCF_VL_G || length_descriptor == BCF_VL_R || length_descriptor == BCF_VL_A);
+  if(is_allele_dependent && (num_test_elements != num_gold_elements || m_diff_alleles_flag))
     return true;
+  //Same type, same layout - compare the data of all samples as one block. Identical bytes are equal
+  //values, so the element-wise comparison below is needed only when the block comparison fails
+  if(std::is_same<T1, T2>::value && num_gold_elements == num_test_elements
+      && (bcf_field_type == BCF_HL_INFO || m_identity_samples_lut)
+      && (!is_allele_dependent || m_identity_alleles_lut)
+      && memcmp(GET_DATA_PTR<const T1*>(gold_line, bcf_field_type, gold_line_field_pos_idx, 0, num_gold_elements),
+        GET_DATA_PTR<const T2*>(m_line, bcf_field_type, test_line_field_pos_idx, 0, num_test_elements),
+        static_cast<size_t>(num_samples)*num_gold_elements*sizeof(T1)) == 0)
+    return false;
+  assert(static_cast<size_t>(test_field_idx) < m_field_idx_to_threshold.size());
+  auto threshold = m_field_idx_to_threshold[test_field_idx];
   for(auto j=0;j<num_samples;++j)
   {
     int lut_test_sample_idx = (bcf_field_type == BCF_HL_INFO) ? 0 : m_samples_lut.get_test_idx_for_gold(0, j);
@@ -400,7 +459,7 @@ bool VCFDiffFile::compare_unequal_vector(const bcf_hdr_t* gold_hdr, const bcf1_t
           break;        //test_vector_idx = k
       }
       assert(!CombineAllelesLUT::is_missing_value(test_vector_idx) && test_vector_idx < min_num_per_sample);
-      if(compare_unequal<T1, T2>(gold_ptr[k], test_ptr[test_vector_idx]))
+      if(compare_unequal<T1, T2>(gold_ptr[k], test_ptr[test_vector_idx], threshold))
         return true;    //unequal
     }
     if(num_test_elements > num_gold_elements)
@@ -419,8 +478,10 @@ bool VCFDiffFile::compare_unequal_vector(const bcf_hdr_t* gold_hdr, const bcf1_t
   return false;
 }
 
-bool VCFDiffFile::compare_unequal_fields(const bcf_hdr_t* gold_hdr, const bcf1_t* gold_line, const int bcf_field_type, std::string& error_message)
+bool VCFDiffFile::compare_unequal_fields(const bcf_hdr_t* gold_hdr, const bcf1_t* gold_line, const int bcf_field_type, std::string& error_message,
+    VCFDiffStats& stats)
 {
+  auto field_type_prefix = std::string(bcf_field_type == BCF_HL_INFO ? "INFO/" : "FORMAT/");
   reset_field_to_line_idx_mapping();
   auto diff_fields = false;
   for(auto i=0;i<GET_NUM_FIELDS(gold_line, bcf_field_type);++i)
@@ -455,6 +516,7 @@ bool VCFDiffFile::compare_unequal_fields(const bcf_hdr_t* gold_hdr, const bcf1_t
         diff_fields = true;
         error_message +=  (std::string("ERROR: ") + (bcf_field_type == BCF_HL_INFO ? "INFO" : "FORMAT")
            + " field " + bcf_hdr_int2id(gold_hdr, BCF_DT_ID, gold_field_idx) + " missing in test line\n");
+        stats.add_field_difference(field_type_prefix + bcf_hdr_int2id(gold_hdr, BCF_DT_ID, gold_field_idx));
       }
     }
     else
@@ -466,6 +528,7 @@ bool VCFDiffFile::compare_unequal_fields(const bcf_hdr_t* gold_hdr, const bcf1_t
         diff_fields = true;
         error_message += (std::string("ERROR: ") + (bcf_field_type == BCF_HL_INFO ? "INFO" : "FORMAT")
           + " field " + bcf_hdr_int2id(gold_hdr, BCF_DT_ID, gold_field_idx) + " type is different in gold and test\n");
+        stats.add_field_difference(field_type_prefix + bcf_hdr_int2id(gold_hdr, BCF_DT_ID, gold_field_idx));
         continue;
       }
       //Boolean field, both lines have the field - nothing to do
@@ -516,8 +579,11 @@ bool VCFDiffFile::compare_unequal_fields(const bcf_hdr_t* gold_hdr, const bcf1_t
       }
       diff_fields = diff_fields || field_vector_diff;
       if(field_vector_diff)
+      {
         error_message += (std::string("ERROR: Gold and test differ in the ")+(bcf_field_type == BCF_HL_INFO ? "INFO" : "FORMAT")
             +" field "+bcf_hdr_int2id(gold_hdr, BCF_DT_ID, gold_field_idx)+"\n");
+        stats.add_field_difference(field_type_prefix + bcf_hdr_int2id(gold_hdr, BCF_DT_ID, gold_field_idx));
+      }
     }
   }
   for(auto i=0;i<GET_NUM_FIELDS(m_line, bcf_field_type);++i)
@@ -537,13 +603,14 @@ bool VCFDiffFile::compare_unequal_fields(const bcf_hdr_t* gold_hdr, const bcf1_t
         diff_fields = true;
         error_message += (std::string("ERROR: ") + (bcf_field_type == BCF_HL_INFO ? "INFO" : "FORMAT")
           + " field " + bcf_hdr_int2id(m_hdr, BCF_DT_ID, test_field_idx) + " added in test line\n");
+        stats.add_field_difference(field_type_prefix + bcf_hdr_int2id(m_hdr, BCF_DT_ID, test_field_idx));
       }
     }
   }
   return diff_fields;
 }
 
-void VCFDiffFile::compare_line(const bcf_hdr_t* gold_hdr, bcf1_t* gold_line)
+void VCFDiffFile::compare_line(const bcf_hdr_t* gold_hdr, bcf1_t* gold_line, VCFDiffStats& stats, std::ostream& fptr)
 {
   //Ignore chr,pos as it's already handled previously
   bcf_unpack(m_line, BCF_UN_ALL);
@@ -553,9 +620,12 @@ void VCFDiffFile::compare_line(const bcf_hdr_t* gold_hdr, bcf1_t* gold_line)
   //ID field
   auto diff_ID_flag = (strcmp(m_line->d.id, gold_line->d.id) != 0);
   error_message += (diff_ID_flag ? "ID field different\n" : "");
+  if(diff_ID_flag)
+    stats.add_field_difference("ID");
   diff_line_flag = diff_ID_flag || diff_line_flag ;
   //REF + ALT
   m_diff_alleles_flag = (m_line->n_allele != gold_line->n_allele);
+  m_identity_alleles_lut = !m_diff_alleles_flag;
   if(!m_diff_alleles_flag)
   {
     m_alleles_lut.resize_luts_if_needed(1, m_line->n_allele);
@@ -574,6 +644,7 @@ void VCFDiffFile::compare_line(const bcf_hdr_t* gold_hdr, bcf1_t* gold_line)
         break;
       }
       m_alleles_lut.add_input_merged_idx_pair(0, i, (*iter).second);
+      m_identity_alleles_lut = m_identity_alleles_lut && ((*iter).second == i);
     }
     //Setup genotypes map
     if(!m_diff_alleles_flag)
@@ -593,10 +664,14 @@ void VCFDiffFile::compare_line(const bcf_hdr_t* gold_hdr, bcf1_t* gold_line)
     }
   }
   error_message += (m_diff_alleles_flag ? "Allele list different\n" : "");
+  if(m_diff_alleles_flag)
+    stats.add_field_difference("ALT");
   diff_line_flag = m_diff_alleles_flag || diff_line_flag;
   //QUAL
-  auto diff_QUAL_flag = compare_unequal<float>(m_line->qual, gold_line->qual);
+  auto diff_QUAL_flag = compare_unequal<float, float>(m_line->qual, gold_line->qual, m_QUAL_threshold);
   error_message += (diff_QUAL_flag ? "QUAL field different\n" : "");
+  if(diff_QUAL_flag)
+    stats.add_field_difference("QUAL");
   diff_line_flag = diff_QUAL_flag || diff_line_flag;
   //FILTER
   auto diff_FILTER_flag = (m_line->d.n_flt != gold_line->d.n_flt);
@@ -618,22 +693,26 @@ void VCFDiffFile::compare_line(const bcf_hdr_t* gold_hdr, bcf1_t* gold_line)
     }
   }
   error_message += (diff_FILTER_flag ? "FILTER list different\n" : "");
+  if(diff_FILTER_flag)
+    stats.add_field_difference("FILTER");
   diff_line_flag = diff_FILTER_flag || diff_line_flag;
   //INFO fields
-  auto  diff_INFO_fields = compare_unequal_fields(gold_hdr, gold_line, BCF_HL_INFO, error_message);
+  auto  diff_INFO_fields = compare_unequal_fields(gold_hdr, gold_line, BCF_HL_INFO, error_message, stats);
   diff_line_flag = diff_INFO_fields || diff_line_flag;
   //FORMAT fields
-  auto diff_FORMAT_fields = compare_unequal_fields(gold_hdr, gold_line, BCF_HL_FMT, error_message);
+  auto diff_FORMAT_fields = compare_unequal_fields(gold_hdr, gold_line, BCF_HL_FMT, error_message, stats);
   diff_line_flag = diff_FORMAT_fields || diff_line_flag;
+  ++(stats.m_num_lines_compared);
   if(diff_line_flag)
   {
-    std::cerr << "=====================================================================\n";
+    stats.add_line_difference();
+    fptr << "=====================================================================\n";
     m_tmp_hts_string.l = 0;
     vcf_format(gold_hdr, gold_line, &m_tmp_hts_string);
-    std::cerr << m_tmp_hts_string.s << "\n";
-    print_line();
-    std::cerr << error_message;
-    std::cerr << "=====================================================================\n";
+    fptr << m_tmp_hts_string.s << "\n";
+    print_line(fptr);
+    fptr << error_message;
+    fptr << "=====================================================================\n";
   }
 }
 
@@ -663,6 +742,85 @@ std::string VCFDiffFile::create_region(const std::string& regions,
     return (quoted_contig + ",");
 }
 
+void VCFDiffStats::add_line_difference()
+{
+  ++m_num_lines_different;
+  g_num_differences.fetch_add(1ull, std::memory_order_relaxed);
+}
+
+void VCFDiffStats::add_position_mismatch()
+{
+  ++m_num_position_mismatches;
+  g_num_differences.fetch_add(1ull, std::memory_order_relaxed);
+}
+
+void VCFDiffStats::add_extra_line_error(const bool is_gold)
+{
+  if(is_gold)
+    ++m_num_gold_extra_line_errors;
+  else
+    ++m_num_test_extra_line_errors;
+  g_num_differences.fetch_add(1ull, std::memory_order_relaxed);
+}
+
+void VCFDiffStats::merge(const VCFDiffStats& other)
+{
+  m_num_lines_compared += other.m_num_lines_compared;
+  m_num_lines_different += other.m_num_lines_different;
+  m_num_position_mismatches += other.m_num_position_mismatches;
+  m_num_gold_extra_line_errors += other.m_num_gold_extra_line_errors;
+  m_num_test_extra_line_errors += other.m_num_test_extra_line_errors;
+  for(const auto& x : other.m_field_to_num_diffs)
+    m_field_to_num_diffs[x.first] += x.second;
+}
+
+void VCFDiffStats::print(std::ostream& fptr, const bool print_fields) const
+{
+  fptr << m_name << "\tcompared "<< m_num_lines_compared << "\tdifferent " << m_num_lines_different
+    << "\tposition_mismatches " << m_num_position_mismatches
+    << "\textra_gold " << m_num_gold_extra_line_errors << "\textra_test " << m_num_test_extra_line_errors << "\n";
+  if(print_fields)
+    for(const auto& x : m_field_to_num_diffs)
+      fptr << "  " << x.first << "\t" << x.second << "\n";
+}
+
+/*
+   Parse one entry of the regions string - 'chr'|'chr:pos'|'chr:from-to'|'chr:from-'
+   Same format as bcftools, begin/end are 1-based
+*/
+void parse_region(const std::string& contig_region, std::string& contig, int64_t& begin, int64_t& end)
+{
+  begin = 1;
+  end = INT64_MAX;
+  std::istringstream f2(contig_region);
+  std::string tmp_s;
+  auto idx = 0u;
+  while(std::getline(f2, tmp_s, ':'))
+  {
+    if(idx == 0u)
+      contig = tmp_s;
+    else
+    {
+      std::istringstream f3(tmp_s);
+      std::string boundaries;
+      auto idx2 = 0u;
+      while(std::getline(f3, boundaries, '-'))
+      {
+        if(idx2 == 0u)
+        {
+          begin = strtoll(boundaries.c_str(), 0, 10);
+          if(tmp_s.find("-") == std::string::npos)      //"-" not found
+            end = begin;
+        }
+        else
+          end = strtoll(boundaries.c_str(), 0, 10);
+        ++idx2;
+      }
+    }
+    ++idx;
+  }
+}
+
 /*
    Set regions to traverse based on contigs in the header
 */
@@ -693,33 +851,7 @@ void set_regions(VCFDiffFile& gold, VCFDiffFile& test, const std::string& region
       std::string contig;
       int64_t begin = 1;
       int64_t end = INT64_MAX;
-      std::istringstream f2(contig_region);
-      std::string tmp_s;
-      auto idx = 0u;
-      while(std::getline(f2, tmp_s, ':'))
-      {
-        if(idx == 0u)
-          contig = tmp_s;
-        else
-        {
-          std::istringstream f3(tmp_s);
-          std::string boundaries;
-          auto idx2 = 0u;
-          while(std::getline(f3, boundaries, '-'))
-          {
-            if(idx2 == 0u)
-            {
-              begin = strtoll(boundaries.c_str(), 0, 10);
-              if(tmp_s.find("-") == std::string::npos)      //"-" not found
-                end = begin;
-            }
-            else
-              end = strtoll(boundaries.c_str(), 0, 10);
-            ++idx2;
-          }
-        }
-        ++idx;
-      }
+      parse_region(contig_region, contig, begin, end);
       if(regions_contig_set.find(contig) == regions_contig_set.end())
       {
         regions_contig_set.insert(contig);
@@ -822,7 +954,9 @@ void construct_regions_for_partitions(const std::string& loader_json_filename, V
 
 enum ArgsIdxEnum
 {
-  ARGS_USE_CALLSETS_FILE_FOR_SAMPLE_IDX=1000
+  ARGS_USE_CALLSETS_FILE_FOR_SAMPLE_IDX=1000,
+  ARGS_FIELD_THRESHOLD,
+  ARGS_PRINT_SUMMARY
 };
 
 void setup_samples_lut(const std::string& test_to_gold_callset_map_file, VCFDiffFile& gold, VCFDiffFile& test, const VidMapper* vid_mapper)
@@ -867,83 +1001,209 @@ void setup_samples_lut(const std::string& test_to_gold_callset_map_file, VCFDiff
   VERIFY_OR_THROW(num_samples_found == g_num_callsets && "Test-to-gold callset mapping file does not have mapping for all samples");
 }
 
-int main(int argc, char** argv)
+void setup_diff_files(VCFDiffFile& gold, VCFDiffFile& test, const bool use_loader_json_file,
+    const std::string& test_to_gold_callset_map_file, const VidMapper* vid_mapper)
 {
-#ifdef HTSDIR
-  //Initialize MPI environment
-  auto rc = MPI_Init(0, 0);
-  if (rc != MPI_SUCCESS) {
-    printf ("Error starting MPI program. Terminating.\n");
-    MPI_Abort(MPI_COMM_WORLD, rc);
-  }
-  //Get my world rank
-  int my_world_mpi_rank = 0;
-  MPI_Comm_rank(MPI_COMM_WORLD, &my_world_mpi_rank);
-  static struct option long_options[] =
+  auto use_callsets_file_for_samples = use_loader_json_file && (test_to_gold_callset_map_file.length() > 0u);
+  test.setup_luts(gold, use_callsets_file_for_samples);
+  if(use_callsets_file_for_samples)
+    setup_samples_lut(test_to_gold_callset_map_file, gold, test, vid_mapper);
+  test.set_identity_samples_lut_flag(gold);
+}
+
+VCFDiffIndexReader::VCFDiffIndexReader(const std::string& filename)
+{
+  m_filename = filename;
+  m_tbx = 0;
+  m_idx = 0;
+  m_tmp_hts_string = { 0, 0, 0 };
+  m_fptr = hts_open(filename.c_str(), "r");
+  VERIFY_OR_THROW(m_fptr);
+  m_hdr = bcf_hdr_read(m_fptr);
+  VERIFY_OR_THROW(m_hdr);
+  if(hts_get_format(m_fptr)->format == bcf)
+    m_idx = bcf_index_load(filename.c_str());
+  else
   {
-    {"threshold",1,0,'t'},
-    {"regions",1,0,'r'},
-    {"loader-config",1,0,'l'},
-    {"process-rank",1,0,'p'},
-    {"test_to_gold_callset_map_file",1,0, ARGS_USE_CALLSETS_FILE_FOR_SAMPLE_IDX}
-  };
-  int c = -1;
-  std::string regions = "";
-  std::string loader_json_filename = "";
-  std::string test_to_gold_callset_map_file = "";
-  while((c=getopt_long(argc, argv, "t:r:l:p:", long_options, NULL)) >= 0)
+    m_tbx = tbx_index_load(filename.c_str());
+    m_idx = m_tbx ? m_tbx->idx : 0;
+  }
+  if(m_idx == 0)
+    throw VCFDiffException(std::string("Could not load the index of file ")+filename);
+  m_line = bcf_init();
+}
+
+VCFDiffIndexReader::~VCFDiffIndexReader()
+{
+  if(m_tbx)
+    tbx_destroy(m_tbx);
+  else
+    hts_idx_destroy(m_idx);
+  bcf_destroy(m_line);
+  bcf_hdr_destroy(m_hdr);
+  hts_close(m_fptr);
+  free(m_tmp_hts_string.s);
+}
+
+int64_t VCFDiffIndexReader::get_end_of_lines_crossing(const std::string& contig, const int64_t position)
+{
+  auto end = position;
+  auto tid = m_tbx ? tbx_name2id(m_tbx, contig.c_str()) : bcf_hdr_name2id(m_hdr, contig.c_str());
+  if(tid < 0)
+    return end;
+  //0-based half open interval covering the 1-based position
+  auto* itr = m_tbx ? tbx_itr_queryi(m_tbx, tid, position-1, position) : bcf_itr_queryi(m_idx, tid, position-1, position);
+  if(itr == 0)
+    return end;
+  while(true)
   {
-    switch(c)
+    if(m_tbx)
     {
-      case 't':
-        g_threshold = strtod(optarg, 0);
+      if(tbx_itr_next(m_fptr, m_tbx, itr, &m_tmp_hts_string) < 0)
         break;
-      case 'r':
-        regions = std::move(std::string(optarg));
-        break;
-      case 'l':
-        loader_json_filename = std::move(std::string(optarg));
-        break;
-      case 'p':
-        my_world_mpi_rank = strtoll(optarg, 0, 10);
-        break;
-      case ARGS_USE_CALLSETS_FILE_FOR_SAMPLE_IDX:
-        test_to_gold_callset_map_file = std::move(std::string(optarg));
-        break;
-      default:
-        throw VCFDiffException(std::string("Unknown argument: ")+argv[optind-1]);
+      if(vcf_parse(&m_tmp_hts_string, m_hdr, m_line) != 0)
+        throw VCFDiffException(std::string("Could not parse line of file ")+m_filename);
+    }
+    else
+      if(bcf_itr_next(m_fptr, itr, m_line) < 0)
         break;
+    //Same end point as used by compare_files()
+    m_line->m_end_point = -1;
+    bcf_unpack(m_line, BCF_UN_INFO);
+    bcf_set_end_point_from_info(m_hdr, m_line);
+    auto line_end = std::max<int64_t>(m_line->m_end_point, static_cast<int64_t>(m_line->pos)+m_line->rlen-1) + 1;
+    end = std::max(end, line_end);
+  }
+  hts_itr_destroy(itr);
+  return end;
+}
+
+/*
+   Split the regions to compare into shards which are compared independently
+   Every entry of the regions string (every contig in the headers if no regions are specified) is a shard - with
+   shard_size > 0, it's further split into windows of about shard_size bases. A line belongs to the shard in which it
+   starts - a window is extended past the lines of either file that cross its end, so every line and any overlapping
+   line of the other file are compared within one shard, as in a single pass
+   Regions on contigs present in only one of the files are returned separately
+*/
+void build_shards(const VCFDiffFile& gold, const VCFDiffFile& test, const std::string& regions, const int64_t shard_size,
+    std::vector<VCFDiffShard>& shards, std::vector<VCFDiffShard>& only_gold_shards, std::vector<VCFDiffShard>& only_test_shards)
+{
+  std::vector<VCFDiffShard> regions_vec;
+  std::unique_ptr<VCFDiffIndexReader> gold_index;
+  std::unique_ptr<VCFDiffIndexReader> test_index;
+  if(shard_size > 0)
+  {
+    gold_index.reset(new VCFDiffIndexReader(gold.m_filename));
+    test_index.reset(new VCFDiffIndexReader(test.m_filename));
+  }
+  if(regions.length())
+  {
+    std::set<std::string> regions_contig_set;
+    std::istringstream f1(regions);
+    std::string contig_region;
+    while(std::getline(f1, contig_region, ','))
+    {
+      std::string contig;
+      int64_t begin = 1;
+      int64_t end = INT64_MAX;
+      parse_region(contig_region, contig, begin, end);
+      //First interval of a contig is used, same as set_regions()
+      if(regions_contig_set.find(contig) == regions_contig_set.end())
+      {
+        regions_contig_set.insert(contig);
+        regions_vec.emplace_back(contig, begin, end, false);
+      }
     }
+    std::sort(regions_vec.begin(), regions_vec.end(),
+        [](const VCFDiffShard& a, const VCFDiffShard& b) { return a.m_contig < b.m_contig; });
   }
-  if(optind+2 > argc)
+  else
   {
-    std::cerr << "Needs 2 VCF files as input <gold> <test>\n";
-    exit(-1);
+    std::set<std::string> all_contigs(gold.m_contigs);
+    all_contigs.insert(test.m_contigs.begin(), test.m_contigs.end());
+    for(const auto& x : all_contigs)
+      regions_vec.emplace_back(x, 1, INT64_MAX, false);
   }
-  VCFDiffFile gold(argv[optind]);
-  VCFDiffFile test(argv[optind+1]);
-  auto use_loader_json_file = (loader_json_filename.length() && regions.length() == 0u);
-  //Setup luts
-  test.setup_luts(gold, use_loader_json_file && (test_to_gold_callset_map_file.length() > 0u));
-  //Loader input json - compare partitions created by vcf2tiledb
-  VidMapper* vid_mapper = 0;
-  JSONConfigBase json_config_base;
-  if(use_loader_json_file)
+  for(const auto& region : regions_vec)
   {
-    construct_regions_for_partitions(loader_json_filename, vid_mapper, json_config_base, my_world_mpi_rank,
-        gold, test, regions);
-    if(test_to_gold_callset_map_file.length())
-      setup_samples_lut(test_to_gold_callset_map_file, gold, test, vid_mapper);
+    auto in_gold = (gold.m_contigs.find(region.m_contig) != gold.m_contigs.end());
+    auto in_test = (test.m_contigs.find(region.m_contig) != test.m_contigs.end());
+    if(!in_gold && !in_test)
+      continue;
+    //Open ended interval - use contig length from the header
+    auto end = region.m_end;
+    if(end == INT64_MAX)
+    {
+      auto hdr = in_gold ? gold.m_hdr : test.m_hdr;
+      auto contig_idx = bcf_hdr_name2id(hdr, region.m_contig.c_str());
+      VERIFY_OR_THROW(contig_idx >= 0);
+      auto contig_length = static_cast<int64_t>(bcf_hdr_id2contig_length(hdr, contig_idx));
+      end = (contig_length > 0) ? contig_length : INT32_MAX;
+    }
+    if(!in_gold || !in_test)
+      (in_gold ? only_gold_shards : only_test_shards).emplace_back(region.m_contig, region.m_begin, end, false);
+    else
+      if(shard_size <= 0)
+        shards.emplace_back(region.m_contig, region.m_begin, end, false);
+      else
+        for(auto begin=region.m_begin;begin<=end;)
+        {
+          auto shard_end = std::min(end, begin+shard_size-1);
+          while(shard_end < end)
+          {
+            auto crossing_end = std::min(end, std::max(gold_index->get_end_of_lines_crossing(region.m_contig, shard_end),
+                  test_index->get_end_of_lines_crossing(region.m_contig, shard_end)));
+            if(crossing_end == shard_end)
+              break;
+            shard_end = crossing_end;
+          }
+          shards.emplace_back(region.m_contig, begin, shard_end, begin != region.m_begin);
+          begin = shard_end+1;
+        }
+  }
+}
+
+/*
+   Lines on contigs present in only one of the files - print the first such line
+*/
+void report_extra_lines(VCFDiffFile& diff_file, const std::vector<VCFDiffShard>& extra_shards, const bool is_gold,
+    VCFDiffStats& stats)
+{
+  if(extra_shards.empty())
+    return;
+  diff_file.m_min_line_position = -1ll;
+  diff_file.m_max_line_position = -1ll;
+  diff_file.m_regions = "";
+  for(const auto& shard : extra_shards)
+    diff_file.m_regions += (shard.get_synced_reader_region() + ",");
+  diff_file.m_regions.pop_back();  //remove trailing ,
+  diff_file.set_regions_and_open_file();
+  if(diff_file.m_line)
+  {
+    std::cerr << "ERROR: "<< (is_gold ? "Gold" : "Test") << " vcf has extra line(s) - printing the first extra line\n";
+    diff_file.print_line();
+    stats.add_extra_line_error(is_gold);
   }
-  //Regions
-  set_regions(gold, test, regions);
+}
+
+/*
+   Traverse gold and test together over the regions they were opened with
+   Differences are printed to err_fptr, warnings to out_fptr
+   If state is specified, the traversal starts from and returns its state
+*/
+void compare_files(VCFDiffFile& gold, VCFDiffFile& test, const VidMapper* vid_mapper, const JSONConfigBase& json_config_base,
+    const int rank, VCFDiffStats& stats, std::ostream& err_fptr, std::ostream& out_fptr, VCFDiffTraversalState* state=0)
+{
   bool have_data = test.m_line && gold.m_line;
   //Control variables
   int curr_gold_contig_idx_in_vid = -1;
   ContigInfo info;
-  auto both_must_have_valid_lines = false;
-  while(have_data)
+  auto both_must_have_valid_lines = state ? state->m_both_must_have_valid_lines : false;
+  auto num_iterations = 0ull;
+  while(have_data && !difference_limit_reached())
   {
+    ++num_iterations;
     auto lut_gold_contig_idx = test.m_contigs_lut.get_gold_idx_for_test(0, test.m_line->rid);
     auto lut_test_contig_idx = test.m_contigs_lut.get_test_idx_for_gold(0, gold.m_line->rid);
     both_must_have_valid_lines = false;
@@ -953,29 +1213,33 @@ int main(int argc, char** argv)
       //Gold has reached a contig not in test
       if(GoldLUT::is_missing_value(lut_test_contig_idx))
       {
-        std::cerr << "ERROR: Gold vcf has extra line(s) - printing the first extra line\n";
-        gold.print_line();
+        err_fptr << "ERROR: Gold vcf has extra line(s) - printing the first extra line\n";
+        gold.print_line(err_fptr);
+        stats.add_extra_line_error(true);
         break;    //because common contigs are handled first
       }
       //test has reached a contig not in gold
       if(GoldLUT::is_missing_value(lut_gold_contig_idx))
       {
-        std::cerr << "ERROR: Test vcf has extra line(s) - printing the first extra line\n";
-        test.print_line();
+        err_fptr << "ERROR: Test vcf has extra line(s) - printing the first extra line\n";
+        test.print_line(err_fptr);
+        stats.add_extra_line_error(false);
         break;    //because common contigs are handled first
       }
       //Both have entries in common_contigs, gold is at "lower" contig
       if(std::string(bcf_hdr_id2name(gold.m_hdr, gold.m_line->rid)) < std::string(bcf_hdr_id2name(gold.m_hdr, lut_gold_contig_idx)))
       {
-        std::cerr << "ERROR: Gold vcf has extra line(s) - printing the first extra line\n";
-        gold.print_line();
+        err_fptr << "ERROR: Gold vcf has extra line(s) - printing the first extra line\n";
+        gold.print_line(err_fptr);
+        stats.add_extra_line_error(true);
         gold.seek_and_read(lut_gold_contig_idx, test.m_line->pos);  //gold seeks to test's position
         lut_test_contig_idx = gold.m_line ? test.m_contigs_lut.get_test_idx_for_gold(0, gold.m_line->rid) : lut_missing_value;
       }
       else      //test seeks to gold's position
       {
-        std::cerr << "ERROR: Test vcf has extra line(s) - printing the first extra line\n";
-        test.print_line();
+        err_fptr << "ERROR: Test vcf has extra line(s) - printing the first extra line\n";
+        test.print_line(err_fptr);
+        stats.add_extra_line_error(false);
         test.seek_and_read(lut_test_contig_idx, gold.m_line->pos);
         lut_gold_contig_idx = test.m_line ? test.m_contigs_lut.get_gold_idx_for_test(0, test.m_line->rid) : lut_missing_value; 
       }
@@ -1020,11 +1284,11 @@ int main(int argc, char** argv)
           {
             //Variant starts before column partition
             if((info.m_tiledb_column_offset + static_cast<int64_t>(gold.m_line->pos)) <
-                json_config_base.get_column_partition(my_world_mpi_rank).first)
+                json_config_base.get_column_partition(rank).first)
               before_begin = true;
             //Variant past the column interval
             if((info.m_tiledb_column_offset + static_cast<int64_t>(gold.m_line->m_end_point)) >
-                json_config_base.get_column_partition(my_world_mpi_rank).second)
+                json_config_base.get_column_partition(rank).second)
               after_end = true;
           }
         }
@@ -1033,10 +1297,10 @@ int main(int argc, char** argv)
         {
           if(!before_begin && !after_end)
           {
-            std::cout << "WARNING: Gold and test REF blocks overlap, but do not match exactly at position "<<
+            out_fptr << "WARNING: Gold and test REF blocks overlap, but do not match exactly at position "<<
               bcf_hdr_id2name(test.m_hdr, test.m_line->rid) << ","<< (std::min(test.m_line->pos, gold.m_line->pos)+1)<<"\n";
-            gold.print_line(std::cout);
-            test.print_line(std::cout);
+            gold.print_line(out_fptr);
+            test.print_line(out_fptr);
           }
           do_compare = true;
         }
@@ -1044,9 +1308,10 @@ int main(int argc, char** argv)
         {
           if(!before_begin)
           {
-            std::cerr << "ERROR: Lines with different positions found - resetting file ptr to next match position\n";
-            gold.print_line();
-            test.print_line();
+            err_fptr << "ERROR: Lines with different positions found - resetting file ptr to next match position\n";
+            gold.print_line(err_fptr);
+            test.print_line(err_fptr);
+            stats.add_position_mismatch();
           }
           //No overlap
           if(!partial_overlap)
@@ -1094,7 +1359,7 @@ int main(int argc, char** argv)
       }
       if(do_compare)
       {
-        test.compare_line(gold.m_hdr, gold.m_line);
+        test.compare_line(gold.m_hdr, gold.m_line, stats, err_fptr);
         if(full_overlap)
         {
           gold.read_and_advance();
@@ -1122,6 +1387,12 @@ int main(int argc, char** argv)
     else
       break;    //either no more data or moved to contigs not present in the other file
   }
+  if(state)
+  {
+    state->m_lines_left = (gold.m_line || test.m_line);
+    state->m_used_initial_state = (num_iterations == 0ull && state->m_lines_left);
+    state->m_both_must_have_valid_lines = both_must_have_valid_lines;
+  }
   have_data = test.m_line && gold.m_line;
   //Print error for the case where one of them has run out of lines, but the other has lines
   if(!have_data)
@@ -1134,20 +1405,318 @@ int main(int argc, char** argv)
       {
         if(both_must_have_valid_lines)
         {
-          std::cerr << "ERROR: "<< name << " vcf has extra line(s) - printing the first extra line\n";
-          diff_ref.print_line();
+          err_fptr << "ERROR: "<< name << " vcf has extra line(s) - printing the first extra line\n";
+          diff_ref.print_line(err_fptr);
+          stats.add_extra_line_error(i == 0u);
         }
         else
         {
           diff_ref.read_and_advance();
           if(diff_ref.m_line)
           {
-            std::cerr << "ERROR: "<< name << " vcf has extra line(s) - printing the first extra line\n";
-            diff_ref.print_line();
+            err_fptr << "ERROR: "<< name << " vcf has extra line(s) - printing the first extra line\n";
+            diff_ref.print_line(err_fptr);
+            stats.add_extra_line_error(i == 0u);
+          }
+        }
+      }
+    }
+  }
+}
+
+/*
+   Compare shards [first, last] of a region as one interval
+*/
+void compare_shards(VCFDiffFile& gold, VCFDiffFile& test, const std::vector<VCFDiffShard>& shards, const size_t first,
+    const size_t last, const VidMapper* vid_mapper, const JSONConfigBase& json_config_base, const int rank,
+    VCFDiffStats& stats, std::ostream& err_fptr, std::ostream& out_fptr, VCFDiffTraversalState& state)
+{
+  const auto& first_shard = shards[first];
+  const auto& last_shard = shards[last];
+  VCFDiffShard interval(first_shard.m_contig, first_shard.m_begin, last_shard.m_end, first_shard.m_skip_lines_before_begin);
+  for(auto diff_file : { &gold, &test })
+  {
+    diff_file->m_regions = interval.get_synced_reader_region();
+    diff_file->m_min_line_position = interval.m_skip_lines_before_begin ? interval.m_begin-1 : -1ll;
+    diff_file->m_max_line_position = interval.m_end-1;
+    diff_file->set_regions_and_open_file();
+  }
+  compare_files(gold, test, vid_mapper, json_config_base, rank, stats, err_fptr, out_fptr, &state);
+}
+
+int main(int argc, char** argv)
+{
+#ifdef HTSDIR
+  //Initialize MPI environment
+  auto rc = MPI_Init(0, 0);
+  if (rc != MPI_SUCCESS) {
+    printf ("Error starting MPI program. Terminating.\n");
+    MPI_Abort(MPI_COMM_WORLD, rc);
+  }
+  //Get my world rank
+  int my_world_mpi_rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_world_mpi_rank);
+  static struct option long_options[] =
+  {
+    {"threshold",1,0,'t'},
+    {"regions",1,0,'r'},
+    {"loader-config",1,0,'l'},
+    {"process-rank",1,0,'p'},
+    {"num-threads",1,0,'j'},
+    {"shard-size",1,0,'s'},
+    {"max-differences",1,0,'m'},
+    {"test_to_gold_callset_map_file",1,0, ARGS_USE_CALLSETS_FILE_FOR_SAMPLE_IDX},
+    {"field-threshold",1,0, ARGS_FIELD_THRESHOLD},
+    {"summary",0,0, ARGS_PRINT_SUMMARY},
+    {0,0,0,0}
+  };
+  int c = -1;
+  std::string regions = "";
+  std::string loader_json_filename = "";
+  std::string test_to_gold_callset_map_file = "";
+  auto num_threads = 1;
+  int64_t shard_size = 0ll;
+  auto print_summary = false;
+  while((c=getopt_long(argc, argv, "t:r:l:p:j:s:m:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 't':
+        g_threshold = strtod(optarg, 0);
+        break;
+      case 'r':
+        regions = std::move(std::string(optarg));
+        break;
+      case 'l':
+        loader_json_filename = std::move(std::string(optarg));
+        break;
+      case 'p':
+        my_world_mpi_rank = strtoll(optarg, 0, 10);
+        break;
+      case 'j':
+        num_threads = strtol(optarg, 0, 10);
+        VERIFY_OR_THROW(num_threads > 0);
+        break;
+      case 's':
+        shard_size = strtoll(optarg, 0, 10);
+        break;
+      case 'm':
+        g_max_num_differences = strtoull(optarg, 0, 10);
+        break;
+      case ARGS_USE_CALLSETS_FILE_FOR_SAMPLE_IDX:
+        test_to_gold_callset_map_file = std::move(std::string(optarg));
+        break;
+      case ARGS_FIELD_THRESHOLD:
+        {
+          //<field>=<threshold>, QUAL is accepted as a field name
+          std::string field_threshold = optarg;
+          auto idx = field_threshold.find('=');
+          if(idx == std::string::npos || idx == 0u)
+            throw VCFDiffException(std::string("Field threshold must be of the form <field>=<threshold>: ")+optarg);
+          g_field_to_threshold[field_threshold.substr(0u, idx)] = strtod(field_threshold.c_str()+idx+1u, 0);
+          break;
+        }
+      case ARGS_PRINT_SUMMARY:
+        print_summary = true;
+        break;
+      default:
+        throw VCFDiffException(std::string("Unknown argument: ")+argv[optind-1]);
+        break;
+    }
+  }
+  if(optind+2 > argc)
+  {
+    std::cerr << "Needs 2 VCF files as input <gold> <test>\n";
+    exit(-1);
+  }
+  VCFDiffFile gold(argv[optind]);
+  VCFDiffFile test(argv[optind+1]);
+  auto use_loader_json_file = (loader_json_filename.length() && regions.length() == 0u);
+  //Loader input json - compare partitions created by vcf2tiledb
+  VidMapper* vid_mapper = 0;
+  JSONConfigBase json_config_base;
+  if(use_loader_json_file)
+    construct_regions_for_partitions(loader_json_filename, vid_mapper, json_config_base, my_world_mpi_rank,
+        gold, test, regions);
+  //Setup luts
+  setup_diff_files(gold, test, use_loader_json_file, test_to_gold_callset_map_file, vid_mapper);
+  VCFDiffStats total_stats("total");
+  std::vector<VCFDiffStats> shard_stats;
+  if(num_threads > 1 || shard_size > 0)
+  {
+    std::vector<VCFDiffShard> shards;
+    std::vector<VCFDiffShard> only_gold_shards;
+    std::vector<VCFDiffShard> only_test_shards;
+    build_shards(gold, test, regions, shard_size, shards, only_gold_shards, only_test_shards);
+    for(const auto& shard : shards)
+      shard_stats.emplace_back(shard.get_name());
+    //Output of a shard is buffered and printed in shard order, so it doesn't depend on the thread schedule
+    std::vector<std::string> shard_err_output(shards.size());
+    std::vector<std::string> shard_out_output(shards.size());
+    std::vector<bool> shard_done(shards.size(), false);
+    std::vector<VCFDiffTraversalState> shard_states(shards.size());
+    auto next_shard_to_print = 0ull;
+    //State at the end of the last printed shard
+    auto prev_both_must_have_valid_lines = false;
+    std::string error_message;
+#pragma omp parallel default(shared) num_threads(num_threads)
+    {
+      //Readers are per thread, re-opened for every shard
+      VCFDiffFile* thread_gold = 0;
+      VCFDiffFile* thread_test = 0;
+      //Exceptions cannot propagate out of the parallel region
+      try
+      {
+        thread_gold = new VCFDiffFile(gold.m_filename);
+        thread_test = new VCFDiffFile(test.m_filename);
+        setup_diff_files(*thread_gold, *thread_test, use_loader_json_file, test_to_gold_callset_map_file, vid_mapper);
+      }
+      catch(const std::exception& e)
+      {
+#pragma omp critical
+        {
+          if(error_message.empty())
+            error_message = e.what();
+        }
+      }
+#pragma omp for schedule(dynamic)
+      for(auto i=0ull;i<shards.size();++i)
+      {
+        std::ostringstream err_fptr;
+        std::ostringstream out_fptr;
+        VCFDiffStats stats(shards[i].get_name());
+        //Compared assuming the traversal state at the start of a region
+        VCFDiffTraversalState state;
+        if(thread_gold && thread_test && !difference_limit_reached())
+        {
+          try
+          {
+            compare_shards(*thread_gold, *thread_test, shards, i, i, vid_mapper, json_config_base, my_world_mpi_rank,
+                stats, err_fptr, out_fptr, state);
+          }
+          catch(const std::exception& e)
+          {
+#pragma omp critical
+            {
+              if(error_message.empty())
+                error_message = e.what();
+            }
+          }
+        }
+#pragma omp critical(vcfdiff_output)
+        {
+          //Already compared as part of a longer interval
+          if(i < next_shard_to_print)
+            g_num_differences.fetch_sub(stats.get_num_differences(), std::memory_order_relaxed);
+          else
+          {
+            shard_err_output[i] = err_fptr.str();
+            shard_out_output[i] = out_fptr.str();
+            shard_stats[i] = stats;
+            shard_states[i] = state;
+          }
+          shard_done[i] = true;
+          while(next_shard_to_print<shards.size() && shard_done[next_shard_to_print])
+          {
+            auto first = next_shard_to_print;
+            auto last = first;
+            auto continues_in_next_shard = [&](const size_t idx) {
+              return idx+1u < shards.size() && shards[idx+1u].m_skip_lines_before_begin;
+            };
+            auto initial_both_must_have_valid_lines = shards[first].m_skip_lines_before_begin && prev_both_must_have_valid_lines;
+            const auto& first_state = shard_states[first];
+            //A single pass carries the traversal into the next shard if one of the files has lines left when the
+            //other runs out - compare the shards as one interval until the traversal ends at a shard end
+            if(thread_gold && thread_test
+                && ((first_state.m_lines_left && continues_in_next_shard(first))
+                  || (first_state.m_used_initial_state && initial_both_must_have_valid_lines)))
+            {
+              //The shard on its own was compared already
+              if(first_state.m_lines_left && continues_in_next_shard(first))
+                ++last;
+              try
+              {
+                while(true)
+                {
+                  VCFDiffShard interval(shards[first].m_contig, shards[first].m_begin, shards[last].m_end, false);
+                  VCFDiffStats interval_stats(interval.get_name());
+                  VCFDiffTraversalState interval_state;
+                  interval_state.m_both_must_have_valid_lines = initial_both_must_have_valid_lines;
+                  std::ostringstream interval_err_fptr;
+                  std::ostringstream interval_out_fptr;
+                  compare_shards(*thread_gold, *thread_test, shards, first, last, vid_mapper, json_config_base,
+                      my_world_mpi_rank, interval_stats, interval_err_fptr, interval_out_fptr, interval_state);
+                  if(interval_state.m_lines_left && continues_in_next_shard(last) && !difference_limit_reached())
+                  {
+                    g_num_differences.fetch_sub(interval_stats.get_num_differences(), std::memory_order_relaxed);
+                    ++last;
+                    continue;
+                  }
+                  //Results of the shards compared on their own are replaced
+                  for(auto j=first;j<=last;++j)
+                    if(shard_done[j])
+                    {
+                      g_num_differences.fetch_sub(shard_stats[j].get_num_differences(), std::memory_order_relaxed);
+                      shard_stats[j] = VCFDiffStats(shards[j].get_name());
+                    }
+                  shard_stats[first] = interval_stats;
+                  shard_states[first] = interval_state;
+                  shard_err_output[first] = interval_err_fptr.str();
+                  shard_out_output[first] = interval_out_fptr.str();
+                  break;
+                }
+              }
+              catch(const std::exception& e)
+              {
+#pragma omp critical
+                {
+                  if(error_message.empty())
+                    error_message = e.what();
+                }
+              }
+            }
+            prev_both_must_have_valid_lines = shard_states[first].m_both_must_have_valid_lines;
+            std::cout << shard_out_output[first];
+            std::cerr << shard_err_output[first];
+            for(auto j=first;j<=last;++j)
+            {
+              std::string().swap(shard_out_output[j]);
+              std::string().swap(shard_err_output[j]);
+            }
+            next_shard_to_print = last+1u;
           }
         }
       }
+      if(thread_gold)
+        delete thread_gold;
+      if(thread_test)
+        delete thread_test;
     }
+    if(!error_message.empty())
+      throw VCFDiffException(error_message);
+    for(const auto& stats : shard_stats)
+      total_stats.merge(stats);
+    if(!difference_limit_reached())
+    {
+      report_extra_lines(gold, only_gold_shards, true, total_stats);
+      report_extra_lines(test, only_test_shards, false, total_stats);
+    }
+  }
+  else
+  {
+    //Regions
+    set_regions(gold, test, regions);
+    compare_files(gold, test, vid_mapper, json_config_base, my_world_mpi_rank, total_stats, std::cerr, std::cout);
+  }
+  if(difference_limit_reached())
+    std::cerr << "Comparison stopped after " << g_max_num_differences << " differences\n";
+  if(print_summary)
+  {
+    std::cout << "Summary of differences\n";
+    for(const auto& stats : shard_stats)
+      if(stats.get_num_differences() > 0ull)
+        stats.print(std::cout, false);
+    total_stats.print(std::cout);
   }
   if(vid_mapper)
     delete vid_mapper;